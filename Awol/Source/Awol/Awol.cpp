@@ -1,5 +1,46 @@
 // Fill out your copyright notice in the Description page of Project Settings.
 
 #include "Awol.h"
+#include "SkateboardLoadout.h"
 
-IMPLEMENT_PRIMARY_GAME_MODULE( FDefaultGameModuleImpl, Awol, "Awol" );
+DEFINE_LOG_CATEGORY(LogSkateboardSim);
+
+/**
+* Starts the default board's assets streaming in as soon as a map starts loading, so they arrive alongside it rather
+* than when the first board asks for them.  Worlds that don't go through a map load (play in editor) start them as
+* they're initialized instead.
+*/
+class FAwolGameModule : public FDefaultGameModuleImpl
+{
+public:
+	virtual void StartupModule() override
+	{
+		m_PreLoadMapHandle = FCoreUObjectDelegates::PreLoadMap.AddStatic(&FAwolGameModule::OnPreLoadMap);
+		m_WorldInitHandle = FWorldDelegates::OnPostWorldInitialization.AddStatic(&FAwolGameModule::OnWorldInitialized);
+	}
+
+	virtual void ShutdownModule() override
+	{
+		FCoreUObjectDelegates::PreLoadMap.Remove(m_PreLoadMapHandle);
+		FWorldDelegates::OnPostWorldInitialization.Remove(m_WorldInitHandle);
+	}
+
+private:
+	static void OnPreLoadMap(const FString& mapName)
+	{
+		USkateboardLoadout::PreloadDefaults();
+	}
+
+	static void OnWorldInitialized(UWorld* world, const UWorld::InitializationValues initValues)
+	{
+		if (world != nullptr && world->IsGameWorld())
+		{
+			USkateboardLoadout::PreloadDefaults();
+		}
+	}
+
+	FDelegateHandle m_PreLoadMapHandle;
+	FDelegateHandle m_WorldInitHandle;
+};
+
+IMPLEMENT_PRIMARY_GAME_MODULE( FAwolGameModule, Awol, "Awol" );
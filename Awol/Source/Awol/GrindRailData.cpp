@@ -0,0 +1,229 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "GrindRailData.h"
+#include "SkateboardSimCoreConversions.h"
+
+#if WITH_EDITOR
+#include "Components/SplineMeshComponent.h"
+#endif
+
+static TAutoConsoleVariable<FString> CVarSkateboardGrindableMeshNames(
+	TEXT("skate.GrindableMeshNames"),
+	TEXT("Rail,GrindPlatform,WallPillar"),
+	TEXT("Comma-separated parts of static mesh names that make a mesh grindable without tagging it.  Meshes whose name\n")
+	TEXT("contains \"Rail\" are bars; the rest are ledges.  Read when rails are baked or extracted."),
+	ECVF_Default);
+
+
+FGrindRailData::FGrindRailData()
+{
+}
+
+bool FGrindRailData::Load(const FString& path)
+{
+	Unload();
+
+	if (!FFileHelper::LoadFileToArray(m_Data, *path, FILEREAD_Silent))
+		return false;
+
+	if (!m_Index.Init(m_Data.GetData(), (size_t)m_Data.Num()))
+	{
+		UE_LOG(LogSkateboardSim, Warning, TEXT("Ignoring grind rails in %s: bad header or version (expected version %u).  Re-bake with skate.BakeGrindRails."),
+			*path, SkateSim::GrindRailVersion);
+		Unload();
+		return false;
+	}
+
+	UE_LOG(LogSkateboardSim, Log, TEXT("Loaded %u grind rails (%u segments) from %s"), m_Index.NumRails(), m_Index.NumSegments(), *path);
+	return true;
+}
+
+void FGrindRailData::Unload()
+{
+	m_Index = SkateSim::FGrindRailView();
+	m_Data.Empty();
+}
+
+FString FGrindRailData::GetPathForWorld(const UWorld* world)
+{
+	FString mapName = UWorld::RemovePIEPrefix(world->GetMapName());
+	return FPaths::GameContentDir() / TEXT("Rideable") / (mapName + TEXT(".rsrail"));
+}
+
+#if WITH_EDITOR
+
+static const FName GrindableTag(TEXT("Grindable"));
+static const FName GrindRailTag(TEXT("GrindRail"));
+
+// Is this mesh grindable, and if so, what kind of rail does it make?
+static bool GetGrindableKind(const UStaticMeshComponent* comp, const TArray<FString>& meshNames, SkateSim::EGrindRailKind::Type& kindOut)
+{
+	const AActor* owner = comp->GetOwner();
+	if (comp->ComponentHasTag(GrindRailTag) || (owner != nullptr && owner->ActorHasTag(GrindRailTag)))
+	{
+		kindOut = SkateSim::EGrindRailKind::Rail;
+		return true;
+	}
+
+	const FString meshName = (comp->StaticMesh != nullptr ? comp->StaticMesh->GetName() : FString());
+	const bool railName = meshName.Contains(TEXT("Rail"));
+	if (comp->ComponentHasTag(GrindableTag) || (owner != nullptr && owner->ActorHasTag(GrindableTag)))
+	{
+		kindOut = (railName ? SkateSim::EGrindRailKind::Rail : SkateSim::EGrindRailKind::Ledge);
+		return true;
+	}
+
+	for (const FString& name : meshNames)
+	{
+		if (meshName.Contains(name))
+		{
+			kindOut = (railName ? SkateSim::EGrindRailKind::Rail : SkateSim::EGrindRailKind::Ledge);
+			return true;
+		}
+	}
+	return false;
+}
+
+static float& GetSplineAxisValue(FVector& v, ESplineMeshAxis::Type axis)
+{
+	return (axis == ESplineMeshAxis::X ? v.X : (axis == ESplineMeshAxis::Y ? v.Y : v.Z));
+}
+
+// The mesh's LOD 0 triangles in world space, bent along its spline if it's a spline mesh.
+static void AddGrindableMesh(SkateSim::FGrindRailBuilder& builder, const UStaticMeshComponent* comp, const FTransform& transform, SkateSim::EGrindRailKind::Type kind)
+{
+	const UStaticMesh* mesh = comp->StaticMesh;
+	if (mesh == nullptr || mesh->RenderData == nullptr || mesh->RenderData->LODResources.Num() == 0)
+		return;
+
+	const FStaticMeshLODResources& lod = mesh->RenderData->LODResources[0];
+	const FPositionVertexBuffer& positions = lod.PositionVertexBuffer;
+	const USplineMeshComponent* splineMesh = Cast<USplineMeshComponent>(comp);
+
+	TArray<SkateSim::FVec3> vertices;
+	vertices.SetNumUninitialized(positions.GetNumVertices());
+	for (uint32 i = 0; i < positions.GetNumVertices(); ++i)
+	{
+		FVector local = positions.VertexPosition(i);
+		if (splineMesh != nullptr)
+		{
+			float& along = GetSplineAxisValue(local, splineMesh->ForwardAxis);
+			const FTransform slice = splineMesh->CalcSliceTransform(along);
+			along = 0.0f;
+			local = slice.TransformPosition(local);
+		}
+		vertices[i] = SkateSim::ToSim(transform.TransformPosition(local));
+	}
+
+	TArray<uint32> indices;
+	lod.IndexBuffer.GetCopy(indices);
+	builder.AddMesh(vertices.GetData(), (uint32)vertices.Num(), indices.GetData(), (uint32)indices.Num(), kind);
+}
+
+bool FGrindRailData::BuildBlob(UWorld* world, TArray<uint8>& blobOut, int32& numMeshesOut)
+{
+	TArray<FString> meshNames;
+	CVarSkateboardGrindableMeshNames.GetValueOnGameThread().ParseIntoArray(meshNames, TEXT(","), true);
+
+	SkateSim::FGrindRailBuilder builder;
+	numMeshesOut = 0;
+	for (TActorIterator<AActor> it(world); it; ++it)
+	{
+		TInlineComponentArray<UStaticMeshComponent*> components;
+		it->GetComponents(components);
+		for (UStaticMeshComponent* comp : components)
+		{
+			SkateSim::EGrindRailKind::Type kind;
+			if (!comp->IsRegistered() || comp->Mobility != EComponentMobility::Static || !GetGrindableKind(comp, meshNames, kind))
+				continue;
+
+			if (UInstancedStaticMeshComponent* instanced = Cast<UInstancedStaticMeshComponent>(comp))
+			{
+				for (int32 i = 0; i < instanced->GetInstanceCount(); ++i)
+				{
+					FTransform instanceTransform;
+					if (instanced->GetInstanceTransform(i, instanceTransform, true))
+					{
+						AddGrindableMesh(builder, instanced, instanceTransform, kind);
+						++numMeshesOut;
+					}
+				}
+			}
+			else
+			{
+				AddGrindableMesh(builder, comp, comp->GetComponentTransform(), kind);
+				++numMeshesOut;
+			}
+		}
+	}
+
+	std::vector<uint8_t> blob;
+	if (!builder.Build(blob))
+		return false;
+
+	blobOut.Reset();
+	blobOut.Append(&blob[0], (int32)blob.size());
+	return true;
+}
+
+bool FGrindRailData::BuildFromWorld(UWorld* world)
+{
+	Unload();
+
+	int32 numMeshes = 0;
+	if (world == nullptr || !BuildBlob(world, m_Data, numMeshes) || !m_Index.Init(m_Data.GetData(), (size_t)m_Data.Num()))
+	{
+		Unload();
+		return false;
+	}
+
+	UE_LOG(LogSkateboardSim, Log, TEXT("Extracted %u grind rails (%u segments) from %d meshes; bake them with skate.BakeGrindRails to skip this"),
+		m_Index.NumRails(), m_Index.NumSegments(), numMeshes);
+	return true;
+}
+
+bool FGrindRailData::BakeWorld(UWorld* world, const FString& path, FString& errorOut)
+{
+	if (world == nullptr)
+	{
+		errorOut = TEXT("No world");
+		return false;
+	}
+
+	TArray<uint8> blob;
+	int32 numMeshes = 0;
+	if (!BuildBlob(world, blob, numMeshes))
+	{
+		errorOut = FString::Printf(TEXT("No grind rails found in %d grindable meshes"), numMeshes);
+		return false;
+	}
+
+	if (!FFileHelper::SaveArrayToFile(blob, *path))
+	{
+		errorOut = FString::Printf(TEXT("Couldn't write %s"), *path);
+		return false;
+	}
+
+	SkateSim::FGrindRailView index;
+	index.Init(blob.GetData(), (size_t)blob.Num());
+	UE_LOG(LogSkateboardSim, Display, TEXT("Baked %u grind rails (%u segments) from %d meshes to %s (%d bytes)"),
+		index.NumRails(), index.NumSegments(), numMeshes, *path, blob.Num());
+	return true;
+}
+
+static void BakeGrindRailsForWorld(UWorld* world)
+{
+	FString error;
+	if (!FGrindRailData::BakeWorld(world, FGrindRailData::GetPathForWorld(world), error))
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("skate.BakeGrindRails failed: %s"), *error);
+	}
+}
+
+static FAutoConsoleCommandWithWorld BakeGrindRailsCommand(
+	TEXT("skate.BakeGrindRails"),
+	TEXT("Bake the current level's grindable rails and ledges to Content/Rideable/<MapName>.rsrail."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&BakeGrindRailsForWorld));
+
+#endif
@@ -0,0 +1,58 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GrindRailIndex.h"
+
+/**
+* A level's grindable rails and ledges, loaded from Content/Rideable/<MapName>.rsrail.
+*
+* The file is written alongside the level's baked rideable surfaces, by the skate.BakeGrindRails console command or
+* the RideableBake commandlet, and is small enough to just read into memory.  In the editor, a level that hasn't
+* been baked has its rails extracted as it loads instead.
+*
+* A mesh is grindable if it or its actor is tagged Grindable (or GrindRail, for a bar rather than a ledge), or if its
+* static mesh's name contains one of skate.GrindableMeshNames.  Only static meshes are looked at; spline meshes are
+* bent along their splines first.
+*
+* Once loaded the index is immutable, so it can be queried from any thread.
+*
+* @see ASkateboardSimManager::GetGrindRails
+*/
+class AWOL_API FGrindRailData
+{
+public:
+	FGrindRailData();
+
+	// Read the given file.  Returns false (and leaves us empty) if it's missing, truncated or an old version.
+	bool Load(const FString& path);
+
+	void Unload();
+
+	bool IsLoaded() const { return m_Index.IsValid(); }
+
+	const SkateSim::FGrindRailView& GetIndex() const { return m_Index; }
+
+	// Where the rails for the given world live.
+	static FString GetPathForWorld(const UWorld* world);
+
+#if WITH_EDITOR
+	// Extract the rails from the given world's grindable meshes into this index.  Returns false if it has none.
+	bool BuildFromWorld(UWorld* world);
+
+	// Extract the rails from the given world and write them to the given path.  Returns false and fills in errorOut
+	// on failure.
+	static bool BakeWorld(UWorld* world, const FString& path, FString& errorOut);
+#endif
+
+private:
+	FGrindRailData(const FGrindRailData&);
+	FGrindRailData& operator=(const FGrindRailData&);
+
+#if WITH_EDITOR
+	static bool BuildBlob(UWorld* world, TArray<uint8>& blobOut, int32& numMeshesOut);
+#endif
+
+	SkateSim::FGrindRailView m_Index;
+	TArray<uint8> m_Data;
+};
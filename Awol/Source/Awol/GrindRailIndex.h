@@ -0,0 +1,741 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <map>
+#include <vector>
+
+/**
+* Engine-independent spatial index over a level's grindable rails and ledges.
+*
+* Rails and ledges are polylines, extracted from the triangles of meshes tagged as grindable: every convex edge along
+* the top of a mesh (between a face that points up and one that doesn't) is a grind edge, and runs of them are chained
+* into polylines, split at sharp corners.  A box gives its top edges.  A round bar gives a pair of edges either side of
+* its crown, where its facets stop facing up; for meshes extracted as rails, each such pair is replaced by the line
+* along the crown between them.  The segments are bucketed into a uniform grid over the XY plane, so finding the
+* nearest one to a point only looks at the handful of segments in the cells the query radius covers.
+*
+* The index is a single little-endian blob, used in place:
+*
+*   FGrindRailHeader
+*   FGrindRail[NumRails]
+*   FGrindSegment[NumSegments]           (each rail's segments are contiguous, in order along it)
+*   uint32_t CellStart[NumCells + 1]     (cell i's entries are CellEntries[CellStart[i], CellStart[i + 1]))
+*   uint32_t CellEntries[NumCellEntries] (segment indices)
+*
+* FGrindRailView only reads from the blob, so any number of threads can query it at once.  FGrindRailBuilder produces
+* it, at bake time or when a level without a baked index is loaded in the editor.
+*
+* @see FGrindRailData
+*/
+namespace SkateSim
+{
+	const uint32_t GrindRailMagic = 0x4C475253;	// 'SRGL'
+	const uint32_t GrindRailVersion = 2;
+
+	// What kind of thing a rail is: the top edge of something wide, or a bar.
+	namespace EGrindRailKind
+	{
+		enum Type
+		{
+			Ledge,
+			Rail,
+			Count
+		};
+	}
+
+	struct FGrindRailHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t NumRails;
+		uint32_t NumSegments;
+		uint32_t NumCells;
+		uint32_t NumCellEntries;
+		uint32_t RailsOffset;			// Byte offsets of each array from the start of the blob
+		uint32_t SegmentsOffset;
+		uint32_t CellStartsOffset;
+		uint32_t CellEntriesOffset;
+		float GridOrigin[2];			// XY of the corner of cell (0, 0)
+		float CellSize;
+		uint32_t GridSize[2];			// Cells along X and Y
+	};
+
+	struct FGrindRail
+	{
+		uint32_t FirstSegment;
+		uint32_t NumSegments;
+		uint32_t Kind;					// EGrindRailKind
+		float Length;
+	};
+
+	struct FGrindSegment
+	{
+		float Start[3];
+		float Direction[3];				// Unit length, along the rail
+		float Length;
+		float RailDistance;				// Distance along the rail to Start
+		uint32_t Rail;
+	};
+
+	// The nearest point on a rail to a query.
+	struct FGrindRailHit
+	{
+		uint32_t Rail;
+		uint32_t Segment;
+		EGrindRailKind::Type Kind;
+		float SegmentTime;				// How far along the segment, from 0 to 1
+		float RailDistance;				// How far along the rail, in cm
+		float RailLength;
+		float Distance;					// From the query point
+		FVec3 Position;
+		FVec3 Tangent;					// Unit direction of the rail there, from its start toward its end
+	};
+
+	// Read-only view of a baked blob.  Does not own the memory.
+	class FGrindRailView
+	{
+	public:
+		FGrindRailView() : m_Header(nullptr), m_Rails(nullptr), m_Segments(nullptr), m_CellStarts(nullptr), m_CellEntries(nullptr) {}
+
+		// Point the view at a blob, validating its header and sizes.  Returns false if the blob can't be used.
+		bool Init(const void* data, size_t size)
+		{
+			*this = FGrindRailView();
+			if (data == nullptr || size < sizeof(FGrindRailHeader))
+				return false;
+
+			const FGrindRailHeader* header = static_cast<const FGrindRailHeader*>(data);
+			if (header->Magic != GrindRailMagic || header->Version != GrindRailVersion || header->CellSize <= 0.0f
+				|| (uint64_t)header->GridSize[0] * header->GridSize[1] != header->NumCells)
+				return false;
+
+			if (!FitsIn(header->RailsOffset, header->NumRails, sizeof(FGrindRail), size)
+				|| !FitsIn(header->SegmentsOffset, header->NumSegments, sizeof(FGrindSegment), size)
+				|| !FitsIn(header->CellStartsOffset, header->NumCells + 1, sizeof(uint32_t), size)
+				|| !FitsIn(header->CellEntriesOffset, header->NumCellEntries, sizeof(uint32_t), size))
+				return false;
+
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			m_Header = header;
+			m_Rails = reinterpret_cast<const FGrindRail*>(bytes + header->RailsOffset);
+			m_Segments = reinterpret_cast<const FGrindSegment*>(bytes + header->SegmentsOffset);
+			m_CellStarts = reinterpret_cast<const uint32_t*>(bytes + header->CellStartsOffset);
+			m_CellEntries = reinterpret_cast<const uint32_t*>(bytes + header->CellEntriesOffset);
+			return true;
+		}
+
+		bool IsValid() const { return m_Header != nullptr; }
+		uint32_t NumRails() const { return (m_Header != nullptr ? m_Header->NumRails : 0); }
+		uint32_t NumSegments() const { return (m_Header != nullptr ? m_Header->NumSegments : 0); }
+		const FGrindRail& GetRail(uint32_t index) const { return m_Rails[index]; }
+		const FGrindSegment& GetSegment(uint32_t index) const { return m_Segments[index]; }
+
+		// Find the nearest point on any rail (of a kind in kindMask, a bit per EGrindRailKind) within radius of point.
+		// Only the grid cells the radius overlaps are searched, so keep it to about a cell or less.
+		bool FindNearest(const FVec3& point, float radius, FGrindRailHit& hitOut, uint32_t kindMask = 0xffffffffu) const
+		{
+			if (m_Header == nullptr)
+				return false;
+
+			int minCell[2], maxCell[2];
+			const float pointXY[2] = { point.X, point.Y };
+			const float invCellSize = 1.0f / m_Header->CellSize;
+			for (int axis = 0; axis < 2; ++axis)
+			{
+				const float lo = (pointXY[axis] - radius - m_Header->GridOrigin[axis]) * invCellSize;
+				const float hi = (pointXY[axis] + radius - m_Header->GridOrigin[axis]) * invCellSize;
+				const int last = (int)m_Header->GridSize[axis] - 1;
+				if (hi < 0.0f || lo > (float)last + 1.0f)
+					return false;
+				minCell[axis] = (lo > 0.0f ? (int)lo : 0);
+				maxCell[axis] = (hi < (float)last ? (int)hi : last);
+			}
+
+			float bestDistSq = radius * radius;
+			uint32_t bestSegment = UINT32_MAX;
+			float bestAlong = 0.0f;
+			for (int y = minCell[1]; y <= maxCell[1]; ++y)
+			{
+				for (int x = minCell[0]; x <= maxCell[0]; ++x)
+				{
+					const uint32_t cell = (uint32_t)y * m_Header->GridSize[0] + (uint32_t)x;
+					for (uint32_t entry = m_CellStarts[cell]; entry < m_CellStarts[cell + 1]; ++entry)
+					{
+						const uint32_t index = m_CellEntries[entry];
+						const FGrindSegment& segment = m_Segments[index];
+						if ((kindMask & (1u << m_Rails[segment.Rail].Kind)) == 0)
+							continue;
+
+						const FVec3 start = MakeVec3(segment.Start[0], segment.Start[1], segment.Start[2]);
+						const FVec3 dir = MakeVec3(segment.Direction[0], segment.Direction[1], segment.Direction[2]);
+						const float along = Clamp(Dot(point - start, dir), 0.0f, segment.Length);
+						const float distSq = SizeSquared(point - (start + dir * along));
+						if (distSq < bestDistSq)
+						{
+							bestDistSq = distSq;
+							bestSegment = index;
+							bestAlong = along;
+						}
+					}
+				}
+			}
+
+			if (bestSegment == UINT32_MAX)
+				return false;
+
+			const FGrindSegment& segment = m_Segments[bestSegment];
+			const FGrindRail& rail = m_Rails[segment.Rail];
+			hitOut.Rail = segment.Rail;
+			hitOut.Segment = bestSegment;
+			hitOut.Kind = (EGrindRailKind::Type)rail.Kind;
+			hitOut.SegmentTime = (segment.Length > 0.0f ? bestAlong / segment.Length : 0.0f);
+			hitOut.RailDistance = segment.RailDistance + bestAlong;
+			hitOut.RailLength = rail.Length;
+			hitOut.Distance = std::sqrt(bestDistSq);
+			hitOut.Tangent = MakeVec3(segment.Direction[0], segment.Direction[1], segment.Direction[2]);
+			hitOut.Position = MakeVec3(segment.Start[0], segment.Start[1], segment.Start[2]) + hitOut.Tangent * bestAlong;
+			return true;
+		}
+
+	private:
+		static bool FitsIn(uint32_t offset, uint64_t count, size_t elementSize, size_t size)
+		{
+			return ((offset % 4) == 0 && (uint64_t)offset + count * elementSize <= size);
+		}
+
+		const FGrindRailHeader* m_Header;
+		const FGrindRail* m_Rails;
+		const FGrindSegment* m_Segments;
+		const uint32_t* m_CellStarts;
+		const uint32_t* m_CellEntries;
+	};
+
+	// Extracts grind edges from meshes, chains them into rails, and builds a baked blob.
+	class FGrindRailBuilder
+	{
+	public:
+		FGrindRailBuilder()
+			: TopFacingCos(0.7f)
+			, MaxSlope(0.7f)
+			, CornerCos(0.7f)
+			, MinRailLength(50.0f)
+			, WeldDistance(0.1f)
+			, MaxBarWidth(20.0f)
+		{
+		}
+
+		// A face whose normal is within this (the cosine of the angle) of up is a top face, that can be ground along
+		// its edges.
+		float TopFacingCos;
+
+		// Edges climbing more steeply than this (the Z of their direction) aren't grindable.
+		float MaxSlope;
+
+		// Rails are split where they turn by more than this (the cosine of the angle between successive segments).
+		float CornerCos;
+
+		// Rails shorter than this are dropped.
+		float MinRailLength;
+
+		// Vertices closer than this are treated as one, so meshes split along seams still join up.
+		float WeldDistance;
+
+		// Rail meshes' pairs of parallel edges closer together than this are the two sides of one bar's crown.
+		float MaxBarWidth;
+
+		// Extract the grind edges from one mesh's triangles, in world space, and chain them into rails.
+		void AddMesh(const FVec3* vertices, uint32_t numVertices, const uint32_t* indices, uint32_t numIndices, EGrindRailKind::Type kind)
+		{
+			// Weld, so neighbouring triangles share vertex indices.
+			std::vector<uint32_t> welded(numVertices);
+			std::vector<FVec3> points;
+			std::map<FWeldKey, uint32_t> weldMap;
+			const float invWeld = 1.0f / WeldDistance;
+			for (uint32_t i = 0; i < numVertices; ++i)
+			{
+				const FWeldKey key = { (int64_t)std::floor(vertices[i].X * invWeld + 0.5f), (int64_t)std::floor(vertices[i].Y * invWeld + 0.5f), (int64_t)std::floor(vertices[i].Z * invWeld + 0.5f) };
+				std::map<FWeldKey, uint32_t>::iterator found = weldMap.find(key);
+				if (found == weldMap.end())
+				{
+					found = weldMap.insert(std::make_pair(key, (uint32_t)points.size())).first;
+					points.push_back(vertices[i]);
+				}
+				welded[i] = found->second;
+			}
+
+			// Which way round the triangles are wound: the mesh's signed volume comes out positive if the normals as
+			// we compute them face out.
+			const uint32_t numTriangles = numIndices / 3;
+			const FVec3 origin = (points.empty() ? ZeroVec3() : points[0]);
+			float volume = 0.0f;
+			for (uint32_t tri = 0; tri < numTriangles; ++tri)
+			{
+				const FVec3 a = points[welded[indices[tri * 3]]] - origin;
+				const FVec3 b = points[welded[indices[tri * 3 + 1]]] - origin;
+				const FVec3 c = points[welded[indices[tri * 3 + 2]]] - origin;
+				volume += Dot(a, Cross(b, c));
+			}
+			const float outward = (volume >= 0.0f ? 1.0f : -1.0f);
+
+			// Each edge and the (up to two) faces either side of it.
+			std::vector<FVec3> normals(numTriangles, ZeroVec3());
+			std::map<uint64_t, FEdgeFaces> edges;
+			for (uint32_t tri = 0; tri < numTriangles; ++tri)
+			{
+				const uint32_t v[3] = { welded[indices[tri * 3]], welded[indices[tri * 3 + 1]], welded[indices[tri * 3 + 2]] };
+				FVec3 normal = Cross(points[v[1]] - points[v[0]], points[v[2]] - points[v[0]]) * outward;
+				if (v[0] == v[1] || v[1] == v[2] || v[2] == v[0] || !Normalize(normal))
+					continue; // degenerate
+				normals[tri] = normal;
+
+				for (int e = 0; e < 3; ++e)
+				{
+					const uint32_t a = v[e];
+					const uint32_t b = v[(e + 1) % 3];
+					FEdgeFaces& faces = edges[EdgeKey(a, b)];
+					if (faces.Count < 2)
+					{
+						faces.Face[faces.Count] = tri;
+						faces.Opposite[faces.Count] = v[(e + 2) % 3];
+					}
+					++faces.Count;
+				}
+			}
+
+			// Grind edges: the convex edges between a top face and a face that isn't one, plus the open edges of
+			// top faces.  Edges shared by more than two faces are too tangled to judge.
+			std::vector<std::vector<uint32_t>> links(points.size());
+			for (std::map<uint64_t, FEdgeFaces>::const_iterator it = edges.begin(); it != edges.end(); ++it)
+			{
+				const uint32_t a = (uint32_t)(it->first >> 32);
+				const uint32_t b = (uint32_t)(it->first & 0xffffffffu);
+				const FEdgeFaces& faces = it->second;
+				if (faces.Count > 2 || !IsGrindable(points[a], points[b]))
+					continue;
+
+				if (faces.Count == 1)
+				{
+					if (normals[faces.Face[0]].Z < TopFacingCos)
+						continue;
+				}
+				else
+				{
+					const int top = (normals[faces.Face[0]].Z >= normals[faces.Face[1]].Z ? 0 : 1);
+					const FVec3& topNormal = normals[faces.Face[top]];
+					const FVec3& sideNormal = normals[faces.Face[1 - top]];
+					if (topNormal.Z < TopFacingCos || sideNormal.Z >= TopFacingCos)
+						continue;
+
+					// Convex: the far side of the other face drops away below the top face's plane.
+					if (Dot(points[faces.Opposite[1 - top]] - points[a], topNormal) > -WeldDistance)
+						continue;
+				}
+
+				links[a].push_back(b);
+				links[b].push_back(a);
+			}
+
+			const size_t firstPolyline = m_Polylines.size();
+			ChainEdges(points, links, kind);
+
+			if (kind == EGrindRailKind::Rail)
+			{
+				std::vector<uint32_t> triangles(numTriangles * 3);
+				for (uint32_t i = 0; i < numTriangles * 3; ++i)
+					triangles[i] = welded[indices[i]];
+				MergeBarEdges(firstPolyline, points, triangles, normals);
+			}
+		}
+
+		// Add a rail directly, e.g. from a spline.
+		void AddPolyline(const FVec3* points, uint32_t numPoints, EGrindRailKind::Type kind)
+		{
+			FPolyline polyline;
+			polyline.Kind = kind;
+			polyline.Points.assign(points, points + numPoints);
+			AddChain(polyline);
+		}
+
+		size_t NumRails() const { return m_Polylines.size(); }
+
+		size_t NumSegments() const
+		{
+			size_t count = 0;
+			for (size_t i = 0; i < m_Polylines.size(); ++i)
+				count += m_Polylines[i].Points.size() - 1;
+			return count;
+		}
+
+		// Bucket every rail's segments into a grid of cellSize cells and write the blob.  Returns false if there's
+		// nothing to bake.
+		bool Build(std::vector<uint8_t>& blobOut, float cellSize = 200.0f)
+		{
+			if (m_Polylines.empty() || cellSize <= 0.0f)
+				return false;
+
+			std::vector<FGrindRail> rails;
+			std::vector<FGrindSegment> segments;
+			float boundsMin[2] = { 1.e30f, 1.e30f };
+			float boundsMax[2] = { -1.e30f, -1.e30f };
+			for (size_t p = 0; p < m_Polylines.size(); ++p)
+			{
+				const FPolyline& polyline = m_Polylines[p];
+				FGrindRail rail;
+				rail.FirstSegment = (uint32_t)segments.size();
+				rail.Kind = (uint32_t)polyline.Kind;
+				rail.Length = 0.0f;
+				for (size_t i = 0; i + 1 < polyline.Points.size(); ++i)
+				{
+					const FVec3& a = polyline.Points[i];
+					FVec3 dir = polyline.Points[i + 1] - a;
+					const float length = Size(dir);
+					if (!Normalize(dir))
+						continue;
+
+					FGrindSegment segment;
+					StoreVec3(segment.Start, a);
+					StoreVec3(segment.Direction, dir);
+					segment.Length = length;
+					segment.RailDistance = rail.Length;
+					segment.Rail = (uint32_t)rails.size();
+					segments.push_back(segment);
+					rail.Length += length;
+
+					const FVec3 ends[2] = { a, polyline.Points[i + 1] };
+					for (int e = 0; e < 2; ++e)
+					{
+						boundsMin[0] = std::min(boundsMin[0], ends[e].X);
+						boundsMin[1] = std::min(boundsMin[1], ends[e].Y);
+						boundsMax[0] = std::max(boundsMax[0], ends[e].X);
+						boundsMax[1] = std::max(boundsMax[1], ends[e].Y);
+					}
+				}
+				rail.NumSegments = (uint32_t)segments.size() - rail.FirstSegment;
+				if (rail.NumSegments > 0)
+					rails.push_back(rail);
+			}
+			if (segments.empty())
+				return false;
+
+			// Keep the grid to a sensible size on huge levels by growing the cells.
+			const uint32_t maxCellsPerAxis = 1024;
+			while ((boundsMax[0] - boundsMin[0]) / cellSize >= (float)maxCellsPerAxis || (boundsMax[1] - boundsMin[1]) / cellSize >= (float)maxCellsPerAxis)
+				cellSize *= 2.0f;
+
+			FGrindRailHeader header;
+			memset(&header, 0, sizeof(header));
+			header.Magic = GrindRailMagic;
+			header.Version = GrindRailVersion;
+			header.GridOrigin[0] = boundsMin[0];
+			header.GridOrigin[1] = boundsMin[1];
+			header.CellSize = cellSize;
+			header.GridSize[0] = (uint32_t)((boundsMax[0] - boundsMin[0]) / cellSize) + 1;
+			header.GridSize[1] = (uint32_t)((boundsMax[1] - boundsMin[1]) / cellSize) + 1;
+			header.NumCells = header.GridSize[0] * header.GridSize[1];
+
+			// Count each cell's segments (every cell a segment's XY bounds overlap), then fill them in.
+			std::vector<uint32_t> cellStarts(header.NumCells + 1, 0);
+			std::vector<uint32_t> cellEntries;
+			for (int pass = 0; pass < 2; ++pass)
+			{
+				std::vector<uint32_t> cellFill;
+				if (pass == 1)
+				{
+					for (uint32_t cell = 0; cell < header.NumCells; ++cell)
+						cellStarts[cell + 1] += cellStarts[cell];
+					cellFill.assign(cellStarts.begin(), cellStarts.end() - 1);
+					cellEntries.assign(cellStarts[header.NumCells], 0);
+				}
+
+				for (uint32_t index = 0; index < (uint32_t)segments.size(); ++index)
+				{
+					const FGrindSegment& segment = segments[index];
+					const float end[2] = { segment.Start[0] + segment.Direction[0] * segment.Length, segment.Start[1] + segment.Direction[1] * segment.Length };
+					uint32_t minCell[2], maxCell[2];
+					for (int axis = 0; axis < 2; ++axis)
+					{
+						minCell[axis] = CellCoord(std::min(segment.Start[axis], end[axis]), header, axis);
+						maxCell[axis] = CellCoord(std::max(segment.Start[axis], end[axis]), header, axis);
+					}
+					for (uint32_t y = minCell[1]; y <= maxCell[1]; ++y)
+					{
+						for (uint32_t x = minCell[0]; x <= maxCell[0]; ++x)
+						{
+							const uint32_t cell = y * header.GridSize[0] + x;
+							if (pass == 0)
+								++cellStarts[cell + 1];
+							else
+								cellEntries[cellFill[cell]++] = index;
+						}
+					}
+				}
+			}
+
+			header.NumRails = (uint32_t)rails.size();
+			header.NumSegments = (uint32_t)segments.size();
+			header.NumCellEntries = (uint32_t)cellEntries.size();
+			header.RailsOffset = (uint32_t)sizeof(FGrindRailHeader);
+			header.SegmentsOffset = header.RailsOffset + header.NumRails * (uint32_t)sizeof(FGrindRail);
+			header.CellStartsOffset = header.SegmentsOffset + header.NumSegments * (uint32_t)sizeof(FGrindSegment);
+			header.CellEntriesOffset = header.CellStartsOffset + (header.NumCells + 1) * (uint32_t)sizeof(uint32_t);
+
+			blobOut.resize(header.CellEntriesOffset + header.NumCellEntries * sizeof(uint32_t));
+			memcpy(&blobOut[0], &header, sizeof(header));
+			memcpy(&blobOut[header.RailsOffset], &rails[0], rails.size() * sizeof(FGrindRail));
+			memcpy(&blobOut[header.SegmentsOffset], &segments[0], segments.size() * sizeof(FGrindSegment));
+			memcpy(&blobOut[header.CellStartsOffset], &cellStarts[0], cellStarts.size() * sizeof(uint32_t));
+			if (!cellEntries.empty())
+				memcpy(&blobOut[header.CellEntriesOffset], &cellEntries[0], cellEntries.size() * sizeof(uint32_t));
+			return true;
+		}
+
+	private:
+		struct FWeldKey
+		{
+			int64_t X, Y, Z;
+			bool operator<(const FWeldKey& other) const
+			{
+				return (X != other.X ? X < other.X : (Y != other.Y ? Y < other.Y : Z < other.Z));
+			}
+		};
+
+		struct FEdgeFaces
+		{
+			FEdgeFaces() : Count(0) {}
+			uint32_t Face[2];
+			uint32_t Opposite[2];	// The vertex of each face that isn't on the edge
+			int Count;
+		};
+
+		struct FPolyline
+		{
+			std::vector<FVec3> Points;
+			EGrindRailKind::Type Kind;
+		};
+
+		static uint64_t EdgeKey(uint32_t a, uint32_t b)
+		{
+			return (a < b ? ((uint64_t)a << 32) | b : ((uint64_t)b << 32) | a);
+		}
+
+		static void StoreVec3(float* f, const FVec3& v) { f[0] = v.X; f[1] = v.Y; f[2] = v.Z; }
+
+		static uint32_t CellCoord(float value, const FGrindRailHeader& header, int axis)
+		{
+			const float cell = (value - header.GridOrigin[axis]) / header.CellSize;
+			return (cell <= 0.0f ? 0 : std::min((uint32_t)cell, header.GridSize[axis] - 1));
+		}
+
+		bool IsGrindable(const FVec3& a, const FVec3& b) const
+		{
+			FVec3 dir = b - a;
+			return (Normalize(dir) && std::fabs(dir.Z) <= MaxSlope);
+		}
+
+		// Walk the linked edges into chains, starting from their ends (vertices not in the middle of a run), then
+		// around any closed loops that are left.
+		void ChainEdges(const std::vector<FVec3>& points, std::vector<std::vector<uint32_t>>& links, EGrindRailKind::Type kind)
+		{
+			for (int loops = 0; loops < 2; ++loops)
+			{
+				for (uint32_t start = 0; start < (uint32_t)points.size(); ++start)
+				{
+					while (!links[start].empty() && (loops == 1 || links[start].size() != 2))
+					{
+						FPolyline polyline;
+						polyline.Kind = kind;
+						polyline.Points.push_back(points[start]);
+
+						uint32_t current = start;
+						while (!links[current].empty())
+						{
+							const uint32_t next = links[current].back();
+							Unlink(links, current, next);
+							polyline.Points.push_back(points[next]);
+							current = next;
+							if (links[current].size() != 1)
+								break;	// A junction, or back where we started
+						}
+						AddChain(polyline);
+					}
+				}
+			}
+		}
+
+		static void Unlink(std::vector<std::vector<uint32_t>>& links, uint32_t a, uint32_t b)
+		{
+			for (int side = 0; side < 2; ++side)
+			{
+				std::vector<uint32_t>& list = links[side == 0 ? a : b];
+				const uint32_t other = (side == 0 ? b : a);
+				for (size_t i = 0; i < list.size(); ++i)
+				{
+					if (list[i] == other)
+					{
+						list[i] = list.back();
+						list.pop_back();
+						break;
+					}
+				}
+			}
+		}
+
+		// Split a chain at its sharp corners, merge runs of collinear segments, and keep the pieces long enough to
+		// ride.
+		void AddChain(const FPolyline& chain)
+		{
+			FPolyline piece;
+			piece.Kind = chain.Kind;
+			FVec3 prevDir = ZeroVec3();
+			for (size_t i = 0; i < chain.Points.size(); ++i)
+			{
+				if (piece.Points.empty())
+				{
+					piece.Points.push_back(chain.Points[i]);
+					continue;
+				}
+
+				FVec3 dir = chain.Points[i] - piece.Points.back();
+				if (!Normalize(dir))
+					continue;
+
+				if (piece.Points.size() >= 2)
+				{
+					const float turn = Dot(dir, prevDir);
+					if (turn < CornerCos)
+					{
+						// Corner: finish this piece, and start the next one from the corner.
+						const FVec3 corner = piece.Points.back();
+						KeepPiece(piece);
+						piece.Points.clear();
+						piece.Points.push_back(corner);
+					}
+					else if (turn > 0.99995f)
+					{
+						// Straight on: extend the last segment instead of adding another.
+						piece.Points.back() = chain.Points[i];
+						FVec3 merged = piece.Points.back() - piece.Points[piece.Points.size() - 2];
+						if (Normalize(merged))
+							prevDir = merged;
+						continue;
+					}
+				}
+
+				piece.Points.push_back(chain.Points[i]);
+				prevDir = dir;
+			}
+			KeepPiece(piece);
+		}
+
+		// A round bar's top edges come in pairs, one either side of its crown, and grinding either would put the board
+		// off centre.  Replace each pair among the polylines from first on with the crown line between them.
+		void MergeBarEdges(size_t first, const std::vector<FVec3>& points, const std::vector<uint32_t>& triangles, const std::vector<FVec3>& normals)
+		{
+			for (size_t i = first; i < m_Polylines.size(); ++i)
+			{
+				for (size_t j = i + 1; j < m_Polylines.size(); ++j)
+				{
+					FPolyline crown;
+					if (!FindCentreline(m_Polylines[i], m_Polylines[j], crown) && !FindCentreline(m_Polylines[j], m_Polylines[i], crown))
+						continue;
+
+					for (size_t p = 0; p < crown.Points.size(); ++p)
+						crown.Points[p].Z = FindTopHeight(crown.Points[p], points, triangles, normals);
+					m_Polylines[i] = crown;
+					m_Polylines.erase(m_Polylines.begin() + j);
+					break;
+				}
+			}
+		}
+
+		// If every point of a has a partner on b straight across from it and within MaxBarWidth, the line midway between
+		// them.  a should be the one whose ends are inside b's.
+		bool FindCentreline(const FPolyline& a, const FPolyline& b, FPolyline& centreOut) const
+		{
+			centreOut.Kind = a.Kind;
+			centreOut.Points.clear();
+			for (size_t p = 0; p < a.Points.size(); ++p)
+			{
+				const FVec3& point = a.Points[p];
+				FVec3 dir = a.Points[p + 1 < a.Points.size() ? p + 1 : p] - a.Points[p > 0 ? p - 1 : p];
+				if (!Normalize(dir))
+					return false;
+
+				// The nearest point on b.
+				float bestDistSq = MaxBarWidth * MaxBarWidth;
+				FVec3 partner = point;
+				bool found = false;
+				for (size_t s = 0; s + 1 < b.Points.size(); ++s)
+				{
+					FVec3 segmentDir = b.Points[s + 1] - b.Points[s];
+					const float length = Size(segmentDir);
+					if (!Normalize(segmentDir))
+						continue;
+					const FVec3 nearest = b.Points[s] + segmentDir * Clamp(Dot(point - b.Points[s], segmentDir), 0.0f, length);
+					const float distSq = SizeSquared(nearest - point);
+					if (distSq < bestDistSq)
+					{
+						bestDistSq = distSq;
+						partner = nearest;
+						found = true;
+					}
+				}
+
+				// Straight across (allowing for the ends being a weld apart), not off the end of b.
+				const FVec3 across = partner - point;
+				if (!found || std::fabs(Dot(across, dir)) > WeldDistance + 0.05f * std::sqrt(bestDistSq))
+					return false;
+				centreOut.Points.push_back(point + across * 0.5f);
+			}
+			return (centreOut.Points.size() >= 2);
+		}
+
+		// The height of the highest top face right above or below point, no further than MaxBarWidth above it; point's
+		// own height if there's none.
+		float FindTopHeight(const FVec3& point, const std::vector<FVec3>& points, const std::vector<uint32_t>& triangles, const std::vector<FVec3>& normals) const
+		{
+			float best = point.Z;
+			for (size_t tri = 0; tri < normals.size(); ++tri)
+			{
+				const FVec3& normal = normals[tri];
+				if (normal.Z < TopFacingCos)
+					continue;
+
+				const FVec3& a = points[triangles[tri * 3]];
+				const FVec3& b = points[triangles[tri * 3 + 1]];
+				const FVec3& c = points[triangles[tri * 3 + 2]];
+				const float area = (b.X - a.X) * (c.Y - a.Y) - (c.X - a.X) * (b.Y - a.Y);
+				if (std::fabs(area) < 1.e-6f)
+					continue;
+				const float u = ((b.X - point.X) * (c.Y - point.Y) - (c.X - point.X) * (b.Y - point.Y)) / area;
+				const float v = ((c.X - point.X) * (a.Y - point.Y) - (a.X - point.X) * (c.Y - point.Y)) / area;
+				const float w = 1.0f - u - v;
+				const float tolerance = -1.e-4f;
+				if (u < tolerance || v < tolerance || w < tolerance)
+					continue;
+
+				const float height = a.Z * u + b.Z * v + c.Z * w;
+				if (height > best && height <= point.Z + MaxBarWidth)
+					best = height;
+			}
+			return best;
+		}
+
+		void KeepPiece(const FPolyline& piece)
+		{
+			float length = 0.0f;
+			for (size_t i = 0; i + 1 < piece.Points.size(); ++i)
+				length += Size(piece.Points[i + 1] - piece.Points[i]);
+			if (piece.Points.size() >= 2 && length >= MinRailLength)
+				m_Polylines.push_back(piece);
+		}
+
+		std::vector<FPolyline> m_Polylines;
+	};
+}
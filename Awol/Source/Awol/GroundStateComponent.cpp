@@ -2,16 +2,93 @@
 
 #include "Awol.h"
 #include "GroundStateComponent.h"
-#include "SkateboardTune.h"
+#include "SkateboardSimProfile.h"
+#include "SkateboardSimProfiler.h"
+#include "SkateboardSimCoreConversions.h"
+#include "SkateboardSimContactPatch.h"
+#include "SkateboardSimContacts.h"
+#include "SkateboardSimFlight.h"
+#include "RideableSurfaceData.h"
+#include "PhysicsEngine/BodySetup.h"
+
+DECLARE_CYCLE_STAT(TEXT("Probe Ground (Sync)"), STAT_SkateboardProbeSync, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Probe Ground (Async)"), STAT_SkateboardProbeAsync, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Phase: ProbeGround (per trace)"), STAT_SkateboardPhaseProbeTrace, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Probe Ground (Reduced)"), STAT_SkateboardProbeReduced, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Traces Issued"), STAT_SkateboardTracesIssued, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Contact Patch Sweeps"), STAT_SkateboardContactPatchSweeps, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Contact Patch Candidates"), STAT_SkateboardContactPatchCandidates, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Contact Patch Wheel Traces"), STAT_SkateboardContactPatchWheelTraces, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Contact Supported Ground"), STAT_SkateboardContactSupport, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Probes Submitted"), STAT_SkateboardProbeAsyncSubmitted, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Probe Batches Missed"), STAT_SkateboardProbeAsyncMissed, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Async Probe Age (frames, summed)"), STAT_SkateboardProbeAgeFrames, STATGROUP_SkateboardSim);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Async Probe Age (ms, summed)"), STAT_SkateboardProbeAgeMs, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Baked Surface Probe Hits"), STAT_SkateboardProbeBakedHits, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Baked Surface Probe Fallbacks"), STAT_SkateboardProbeBakedFallbacks, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Probe Cache Hits"), STAT_SkateboardProbeCacheHits, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Probe Cache Misses"), STAT_SkateboardProbeCacheMisses, STATGROUP_SkateboardSim);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Probe Cache Traces Saved / s"), STAT_SkateboardProbeCacheTracesSavedPerSec, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Predict Flight"), STAT_SkateboardPredictFlight, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight Predictions"), STAT_SkateboardFlightPredictions, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight Predictions Redone (Drift)"), STAT_SkateboardFlightDrifted, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Flight Probes Skipped"), STAT_SkateboardFlightProbesSkipped, STATGROUP_SkateboardSim);
+
+namespace
+{
+	// How thick the contact patch box is, in cm.  Thin, so it touches where the probe rays would.
+	const float ContactPatchHalfThickness = 0.5f;
+
+	// Surfaces facing the probe less than this (the cosine of the angle between them) are walls or the sides of
+	// rails, not something to rest a wheel on.
+	const float ContactPatchMinFacing = 0.25f;
+
+	// The most components one patch sweep considers.
+	const int32 MaxContactPatchComponents = 8;
+
+	// Seconds over which GetProbeCacheHitRate() is measured.
+	const float ProbeCacheRateInterval = 1.0f;
 
+	// How closely a cached plane's normal must line up with an axis of a collision box to be one of its faces.
+	const float ProbeCacheBoxFaceDot = 0.999f;
+}
 
 // Sets default values for this component's properties
 UGroundStateComponent::UGroundStateComponent()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
+	// Set this component to be initialized when the game starts.  Our owner drives the probes, so we only tick
+	// for debug draw, which is off by default to save a tick dispatch per board.
 	bWantsBeginPlay = true;
 	PrimaryComponentTick.bCanEverTick = true;
+	PrimaryComponentTick.bStartWithTickEnabled = false;
+
+	UseContactPatchSweep = true;
+	UseAsyncProbes = false;
+	UseBakedSurfaces = true;
+	BakedProbesCheckDynamic = true;
+	UseProbeCache = true;
+	ProbeCacheTolerance = 0.5f;
+	ProbeCacheMaxFrames = 15;
+	UseFlightPrediction = true;
+	FlightPredictionTime = 2.0f;
+	FlightChordError = 5.0f;
+	FlightProbeLeadTime = 0.1f;
+	FlightDriftTolerance = 10.0f;
+	m_HasFlight = false;
+	m_FlightStartTime = 0.0f;
+	m_HadContacts = false;
+	m_HasPendingTraces = false;
+	m_HasAsyncResult = false;
+	m_CacheValid = false;
+	m_CacheHasFootprint = false;
+	m_NumCacheTriangles = 0;
+	m_CacheHasBox = false;
+	m_CacheLookups = 0;
+	m_CacheHits = 0;
+	m_CacheStatStartTime = 0.0f;
+	m_CacheHitRate = -1.0f;
+	m_Profile = nullptr;
+	m_BakedSurfaces = nullptr;
 }
 
 
@@ -21,6 +98,9 @@ void UGroundStateComponent::BeginPlay()
 	Super::BeginPlay();
 
 	ResetState();
+	m_RideableQueryParams = MakeRideableQueryParams();
+	m_DynamicQueryParams = m_RideableQueryParams;
+	m_DynamicQueryParams.MobilityType = EQueryMobilityType::Dynamic;
 
 	// DEBUG DRAW probes
 	// const FName traceTag("Rideable");
@@ -33,107 +113,821 @@ void UGroundStateComponent::TickComponent( float DeltaTime, ELevelTick TickType,
 {
 	Super::TickComponent( DeltaTime, TickType, ThisTickFunction );
 
+	INC_DWORD_STAT(STAT_SkateboardTickDispatches);
+
 	DebugDraw();
 }
 
-bool UGroundStateComponent::ProbeGround(const FVector & pos, const FVector & forward, const FVector & right)
+bool UGroundStateComponent::ProbeGround(const FVector & pos, const FVector & forward, const FVector & right, const FVector & velocity)
 {
-	bool retval = true;
-
+	/*
 	// NOTE: UE4 does LEFT-handed cross products!
 	FVector up = FVector::CrossProduct(forward, right);
-
-	/*
 	DrawDebugDirectionalArrow(GetWorld(), pos, pos + forward * 150.0f, 10.0f, FColor::Green, false, 1.0f, (uint8)'\000', 2.0f);
 	DrawDebugDirectionalArrow(GetWorld(), pos, pos + right * 150.0f, 10.0f, FColor::Red, false, 1.0f, (uint8)'\000', 2.0f);
 	DrawDebugDirectionalArrow(GetWorld(), pos, pos + up * 150.0f, 10.0f, FColor::Blue, false, 1.0f, (uint8)'\000', 2.0f);
 	*/
 
+	FProbeSet probes;
+	BuildProbeSet(pos, forward, right, probes);
+
+	// Debug draw probes, color-coded so we can tell them apart
+	/*
+	DrawDebugDirectionalArrow(GetWorld(), probes.Start[Probe_Front], probes.End[Probe_Front], 10.0f, FColor::Blue, false, 1.0f, (uint8)'\000', 2.0f);
+	DrawDebugDirectionalArrow(GetWorld(), probes.Start[Probe_Rear], probes.End[Probe_Rear], 10.0f, FColor::Cyan, false, 1.0f, (uint8)'\000', 2.0f);
+	DrawDebugDirectionalArrow(GetWorld(), probes.Start[Probe_Right], probes.End[Probe_Right], 10.0f, FColor::Red, false, 1.0f, (uint8)'\000', 2.0f);
+	DrawDebugDirectionalArrow(GetWorld(), probes.Start[Probe_Left], probes.End[Probe_Left], 10.0f, FColor::Green, false, 1.0f, (uint8)'\000', 2.0f);
+	*/
+
+	if (UseAsyncProbes)
+	{
+		return ProbeGroundAsync(probes, velocity);
+	}
+
+	// Drop any batch still in flight from async mode, so stale results aren't picked up if we switch back.
+	m_HasPendingTraces = false;
+	m_HasAsyncResult = false;
+	return ProbeGroundSync(probes);
+}
+
+bool UGroundStateComponent::QueryGround(const FVector & pos, const FVector & forward, const FVector & right, FVector& groundPosOut, FVector& groundNormalOut)
+{
+	FProbeSet probes;
+	BuildProbeSet(pos, forward, right, probes);
+
+	FHitResult hitResults[Probe_Count];
+	bool hit[Probe_Count];
+	return TraceProbes(probes, hitResults, hit, groundPosOut, groundNormalOut);
+}
+
+bool UGroundStateComponent::ProbeGroundReduced(const FVector & pos, const FVector & forward, const FVector & right, int32 numProbes)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardProbeReduced);
+
+	m_HasPendingTraces = false;
+	m_HasAsyncResult = false;
+
+	FProbeSet probes;
+	BuildProbeSet(pos, forward, right, probes);
+
+	// A cached plane answers any number of probes for free.
+	if (UseProbeCache && m_CacheValid && LookUpProbeCache(probes, numProbes))
+		return m_IsOnGround;
+
+	FHitResult hitResults[Probe_Count];
+	bool hit[Probe_Count];
+	if (numProbes <= 1)
+	{
+		const FVector halfProbe = (probes.Start[Probe_Front] - probes.End[Probe_Front]) * 0.5f;
+		hit[0] = ProbeRideable(pos + halfProbe, pos - halfProbe, hitResults[0]);
+		m_IsOnGround = hit[0];
+		if (m_IsOnGround)
+		{
+			m_GroundPosition = hitResults[0].ImpactPoint;
+			m_GroundNormal = hitResults[0].ImpactNormal;
+		}
+		if (UseProbeCache)
+		{
+			UpdateProbeCache(hitResults, hit, 1, hitResults[0].ImpactPoint, hitResults[0].ImpactNormal);
+		}
+		return m_IsOnGround;
+	}
+
+	// Front and rear only; put the side contacts level with the middle of those, across the board.
+	FVector contactPos[Probe_Count];
+	for (int32 i = Probe_Front; i <= Probe_Rear; ++i)
+	{
+		hit[i] = ProbeRideable(probes.Start[i], probes.End[i], hitResults[i]);
+		contactPos[i] = (hit[i] ? hitResults[i].ImpactPoint : probes.End[i]);
+	}
+	const FVector middle = FMath::Lerp(contactPos[Probe_Front], contactPos[Probe_Rear], 0.5f);
+	const FVector halfAcross = (probes.End[Probe_Right] - probes.End[Probe_Left]) * 0.5f;
+	contactPos[Probe_Right] = middle + halfAcross;
+	contactPos[Probe_Left] = middle - halfAcross;
+	hit[Probe_Right] = hit[Probe_Left] = false;
+
+	m_IsOnGround = ResolveProbes(contactPos, hit, m_GroundPosition, m_GroundNormal);
+
+	// Cache the surface the two hits found, not the tilt we made up across the board.
+	if (UseProbeCache)
+	{
+		UpdateProbeCache(hitResults, hit, 2, hitResults[Probe_Front].ImpactPoint, hitResults[Probe_Front].ImpactNormal);
+	}
+	return m_IsOnGround;
+}
+
+void UGroundStateComponent::SetGroundState(bool isOnGround, const FVector& groundPos, const FVector& groundNormal)
+{
+	m_HasFlight = false;
+	m_IsOnGround = isOnGround;
+	m_GroundPosition = groundPos;
+	m_GroundNormal = groundNormal;
+}
+
+void UGroundStateComponent::BuildProbeSet(const FVector & pos, const FVector & forward, const FVector & right, FProbeSet & probesOut) const
+{
+	// NOTE: UE4 does LEFT-handed cross products!
+	FVector up = FVector::CrossProduct(forward, right);
+
+	// Derived once, when the profile was compiled.
 	float probeLength = 40.0f;
-	float probeSpacingFwd = 55.0f;
-	float probeSpacingLat = 20.0f;
-	float deckHeight = 10.0f;
-	if (m_SkateboardTune != nullptr)
+	float halfSpacingFwd = 27.5f;
+	float halfSpacingLat = 10.0f;
+	if (m_Profile != nullptr)
 	{
-		deckHeight = m_SkateboardTune->DeckHeight;
-		probeLength = deckHeight * 6.0f;
-		probeSpacingFwd = m_SkateboardTune->TruckSpacing;
-		probeSpacingLat = m_SkateboardTune->AxleLength;
+		probeLength = m_Profile->ProbeLength;
+		halfSpacingFwd = m_Profile->HalfTruckSpacing;
+		halfSpacingLat = m_Profile->HalfAxleLength;
 	}
 
-	FVector frontProbePos = pos + (forward * 0.5f * probeSpacingFwd);
-	FVector rearProbePos = pos - (forward * 0.5f * probeSpacingFwd);
-	FVector rightProbePos = pos + (right * 0.5f * probeSpacingLat);
-	FVector leftProbePos = pos - (right * 0.5f * probeSpacingLat);
+	FVector probePos[Probe_Count];
+	probePos[Probe_Front] = pos + (forward * halfSpacingFwd);
+	probePos[Probe_Rear] = pos - (forward * halfSpacingFwd);
+	probePos[Probe_Right] = pos + (right * halfSpacingLat);
+	probePos[Probe_Left] = pos - (right * halfSpacingLat);
 
 	FVector probeStart = up * (0.5f * probeLength);
 	FVector probeEnd = up * (-0.5f * probeLength);
 
-	FHitResult frontHitResult;
-	FHitResult rearHitResult;
-	FHitResult rightHitResult;
-	FHitResult leftHitResult;
-
-	// Debug draw probes, color-coded so we can tell them apart
-	/*
-	DrawDebugDirectionalArrow(GetWorld(), frontProbePos + probeStart, frontProbePos + probeEnd, 10.0f, FColor::Blue, false, 1.0f, (uint8)'\000', 2.0f);
-	DrawDebugDirectionalArrow(GetWorld(), rearProbePos + probeStart, rearProbePos + probeEnd, 10.0f, FColor::Cyan, false, 1.0f, (uint8)'\000', 2.0f);
-	DrawDebugDirectionalArrow(GetWorld(), rightProbePos + probeStart, rightProbePos + probeEnd, 10.0f, FColor::Red, false, 1.0f, (uint8)'\000', 2.0f);
-	DrawDebugDirectionalArrow(GetWorld(), leftProbePos + probeStart, leftProbePos + probeEnd, 10.0f, FColor::Green, false, 1.0f, (uint8)'\000', 2.0f);
-	*/
-
-	bool frontProbeHit = ProbeRideable(frontProbePos + probeStart, frontProbePos + probeEnd, frontHitResult);
-	bool rearProbeHit = ProbeRideable(rearProbePos + probeStart, rearProbePos + probeEnd, rearHitResult);
-	bool rightProbeHit = ProbeRideable(rightProbePos + probeStart, rightProbePos + probeEnd, rightHitResult);
-	bool leftProbeHit = ProbeRideable(leftProbePos + probeStart, leftProbePos + probeEnd, leftHitResult);
+	for (int32 i = 0; i < Probe_Count; ++i)
+	{
+		probesOut.Start[i] = probePos[i] + probeStart;
+		probesOut.End[i] = probePos[i] + probeEnd;
+	}
 
-	FVector newFrontPos = (frontProbeHit ? frontHitResult.ImpactPoint : frontProbePos + probeEnd);
-	FVector newRearPos = (rearProbeHit ? rearHitResult.ImpactPoint : rearProbePos + probeEnd);
-	FVector newRightPos = (rightProbeHit ? rightHitResult.ImpactPoint : rightProbePos + probeEnd);
-	FVector newLeftPos = (leftProbeHit ? leftHitResult.ImpactPoint : leftProbePos + probeEnd);
+	// The patch covers all four probe points, its top face where they start.
+	probesOut.PatchStart = pos + probeStart - (up * ContactPatchHalfThickness);
+	probesOut.PatchEnd = pos + probeEnd - (up * ContactPatchHalfThickness);
+	probesOut.PatchRotation = FMatrix(forward, right, up, FVector::ZeroVector).ToQuat();
+	probesOut.PatchHalfExtent = FVector(halfSpacingFwd, halfSpacingLat, ContactPatchHalfThickness);
+}
 
-	m_GroundPosition = FMath::Lerp(newFrontPos, newRearPos, 0.5f);
+bool UGroundStateComponent::ResolveProbes(const FVector contactPos[Probe_Count], const bool hit[Probe_Count], FVector & groundPosOut, FVector & groundNormalOut)
+{
+	groundPosOut = FMath::Lerp(contactPos[Probe_Front], contactPos[Probe_Rear], 0.5f);
 
-	FVector newFwd = newFrontPos - newRearPos;
+	FVector newFwd = contactPos[Probe_Front] - contactPos[Probe_Rear];
 	newFwd.Normalize();
-	FVector newRight = newRightPos - newLeftPos;
+	FVector newRight = contactPos[Probe_Right] - contactPos[Probe_Left];
 	newRight.Normalize();
 
-	m_GroundNormal = FVector::CrossProduct(newFwd, newRight);
-	m_GroundNormal.Normalize();
+	groundNormalOut = FVector::CrossProduct(newFwd, newRight);
+	groundNormalOut.Normalize();
+
+	return (hit[Probe_Front] || hit[Probe_Rear] || hit[Probe_Right] || hit[Probe_Left]);
+}
+
+bool UGroundStateComponent::ProbeGroundSync(const FProbeSet & probes)
+{
+	if (UseProbeCache && !UseAsyncProbes && m_CacheValid && LookUpProbeCache(probes, Probe_Count))
+		return m_IsOnGround;
+
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardProbeSync);
+
+	FHitResult hitResults[Probe_Count];
+	bool hit[Probe_Count];
+	m_IsOnGround = TraceProbes(probes, hitResults, hit, m_GroundPosition, m_GroundNormal);
+
+	if (UseProbeCache && !UseAsyncProbes)
+	{
+		UpdateProbeCache(hitResults, hit, Probe_Count, m_GroundPosition, m_GroundNormal);
+	}
+
+	return m_IsOnGround;
+}
+
+bool UGroundStateComponent::TraceProbes(const FProbeSet& probes, FHitResult hitResultsOut[Probe_Count], bool hitOut[Probe_Count], FVector& groundPosOut, FVector& groundNormalOut)
+{
+	if (UseContactPatchSweep && !CanProbeBakedSurfaces())
+	{
+		ProbeContactPatch(probes, hitResultsOut, hitOut);
+	}
+	else
+	{
+		// The baked surfaces answer rays without touching the physics scene, so there's nothing to save by sweeping.
+		for (int32 i = 0; i < Probe_Count; ++i)
+		{
+			hitOut[i] = ProbeRideable(probes.Start[i], probes.End[i], hitResultsOut[i]);
+		}
+	}
+
+	FVector contactPos[Probe_Count];
+	for (int32 i = 0; i < Probe_Count; ++i)
+	{
+		contactPos[i] = (hitOut[i] ? hitResultsOut[i].ImpactPoint : probes.End[i]);
+	}
+
+	return ResolveProbes(contactPos, hitOut, groundPosOut, groundNormalOut);
+}
+
+bool UGroundStateComponent::LookUpProbeCache(const FProbeSet& probes, int32 numTraces)
+{
+	const bool cacheHit = ProbeGroundCached(probes);
+	CountCacheLookup(cacheHit);
+	if (!cacheHit)
+	{
+		INC_DWORD_STAT(STAT_SkateboardProbeCacheMisses);
+		return false;
+	}
+
+	INC_DWORD_STAT(STAT_SkateboardProbeCacheHits);
+	UWorld* world = GetWorld();
+	if (world != nullptr && world->GetDeltaSeconds() > 0.0f)
+	{
+		INC_FLOAT_STAT_BY(STAT_SkateboardProbeCacheTracesSavedPerSec, numTraces / world->GetDeltaSeconds());
+	}
+	return true;
+}
+
+bool UGroundStateComponent::ProbeGroundCached(const FProbeSet & probes)
+{
+	// Re-probe if the primitive we're standing on has gone away or moved, or we've used up our budget.
+	const UPrimitiveComponent* cachedComp = m_CacheComponent.Get();
+	if (cachedComp == nullptr || !cachedComp->GetComponentTransform().Equals(m_CacheComponentTransform) || m_CacheFramesLeft <= 0)
+	{
+		m_CacheValid = false;
+		return false;
+	}
+
+	// Intersect each probe with the cached plane.  The hit has to be within probe reach, and on the part of the plane
+	// we know the surface covers, or we can't be sure it's the same surface: a step or lip just past it would be
+	// ridden straight through.
+	FVector contactPos[Probe_Count];
+	bool hit[Probe_Count];
+	for (int32 i = 0; i < Probe_Count; ++i)
+	{
+		FVector probeDir = probes.End[i] - probes.Start[i];
+		float denom = FVector::DotProduct(probeDir, m_CachePlaneNormal);
+		if (FMath::Abs(denom) < KINDA_SMALL_NUMBER)
+		{
+			m_CacheValid = false;
+			return false;
+		}
+
+		float t = FVector::DotProduct(m_CachePlanePoint - probes.Start[i], m_CachePlaneNormal) / denom;
+		contactPos[i] = probes.Start[i] + probeDir * t;
+		if (t < 0.0f || t > 1.0f || !IsInCacheExtent(contactPos[i]))
+		{
+			m_CacheValid = false;
+			return false;
+		}
+		hit[i] = true;
+	}
+
+	m_IsOnGround = ResolveProbes(contactPos, hit, m_GroundPosition, m_GroundNormal);
+	--m_CacheFramesLeft;
+
+	return true;
+}
+
+void UGroundStateComponent::UpdateProbeCache(const FHitResult* hitResults, const bool* hit, int32 numProbes, const FVector& planePoint, const FVector& planeNormal)
+{
+	m_CacheValid = false;
+
+	// Every probe has to hit the same static primitive...
+	UPrimitiveComponent* comp = hitResults[0].Component.Get();
+	if (comp == nullptr || comp->Mobility != EComponentMobility::Static)
+		return;
+
+	for (int32 i = 0; i < numProbes; ++i)
+	{
+		if (!hit[i] || hitResults[i].Component.Get() != comp)
+			return;
+	}
+
+	// ...and every hit has to lie on the plane.
+	for (int32 i = 0; i < numProbes; ++i)
+	{
+		float dist = FVector::DotProduct(hitResults[i].ImpactPoint - planePoint, planeNormal);
+		if (FMath::Abs(dist) > ProbeCacheTolerance)
+			return;
+	}
+
+	m_CachePlanePoint = planePoint;
+	m_CachePlaneNormal = planeNormal;
+
+	// Wound round the board, so the footprint is a convex polygon.
+	m_CacheHasFootprint = (numProbes == Probe_Count);
+	if (m_CacheHasFootprint)
+	{
+		m_CacheFootprint[0] = hitResults[Probe_Front].ImpactPoint;
+		m_CacheFootprint[1] = hitResults[Probe_Right].ImpactPoint;
+		m_CacheFootprint[2] = hitResults[Probe_Rear].ImpactPoint;
+		m_CacheFootprint[3] = hitResults[Probe_Left].ImpactPoint;
+	}
+
+	// With fewer hits than that, all we know is flat is whatever we can find out about the surface itself.
+	CacheSurfaceExtent(comp, hitResults, numProbes);
+	if (!m_CacheHasFootprint && m_NumCacheTriangles == 0 && !m_CacheHasBox)
+		return;
+
+	m_CacheValid = true;
+	m_CacheComponent = comp;
+	m_CacheComponentTransform = comp->GetComponentTransform();
+	m_CacheFramesLeft = ProbeCacheMaxFrames;
+}
+
+void UGroundStateComponent::CacheSurfaceExtent(UPrimitiveComponent* comp, const FHitResult* hitResults, int32 numProbes)
+{
+	// The baked triangles under the hits that lie in the plane.  A PhysX hit's face index isn't one of ours, but any
+	// baked triangle of the same primitive lying in the plane is still part of the surface.
+	m_NumCacheTriangles = 0;
+	if (CanProbeBakedSurfaces())
+	{
+		const SkateSim::FRideableBVHView& bvh = m_BakedSurfaces->GetBVH();
+		for (int32 i = 0; i < numProbes; ++i)
+		{
+			const int32 triangle = hitResults[i].FaceIndex;
+			if (triangle < 0 || (uint32)triangle >= bvh.NumTriangles())
+				continue;
+
+			const SkateSim::FRideableBVHTriangle& tri = bvh.GetTriangle(triangle);
+			if (m_BakedSurfaces->GetSource(tri.Source).Component.Get() != comp)
+				continue;
+
+			const FVector v0 = SkateSim::FromSim(SkateSim::LoadVec3(tri.V0));
+			const FVector verts[3] = { v0, v0 + SkateSim::FromSim(SkateSim::LoadVec3(tri.Edge1)), v0 + SkateSim::FromSim(SkateSim::LoadVec3(tri.Edge2)) };
+			bool inPlane = true;
+			for (const FVector& vert : verts)
+			{
+				inPlane &= (FMath::Abs(FVector::DotProduct(vert - m_CachePlanePoint, m_CachePlaneNormal)) <= ProbeCacheTolerance);
+			}
+
+			bool known = false;
+			for (int32 j = 0; j < m_NumCacheTriangles; ++j)
+			{
+				known |= (m_CacheTriangles[j] == (uint32)triangle);
+			}
+			if (inPlane && !known)
+			{
+				m_CacheTriangles[m_NumCacheTriangles++] = (uint32)triangle;
+			}
+		}
+	}
+
+	// The primitive's collision box, if that's all its collision is and the plane lies on one of its faces: the plane
+	// point is on that face, and the plane normal is along the box's axis through it.
+	m_CacheHasBox = false;
+	const UBodySetup* bodySetup = comp->GetBodySetup();
+	if (bodySetup != nullptr && bodySetup->AggGeom.GetElementCount() == 1 && bodySetup->AggGeom.BoxElems.Num() == 1)
+	{
+		const FKBoxElem& box = bodySetup->AggGeom.BoxElems[0];
+		m_CacheBoxTransform = box.GetTransform() * comp->GetComponentTransform();
+		m_CacheBoxHalfExtent = FVector(box.X, box.Y, box.Z) * 0.5f;
+
+		const FVector localNormal = m_CacheBoxTransform.InverseTransformVectorNoScale(m_CachePlaneNormal);
+		const FVector localPoint = m_CacheBoxTransform.InverseTransformPosition(m_CachePlanePoint);
+		const FVector scale = m_CacheBoxTransform.GetScale3D().GetAbs();
+		for (int32 axis = 0; axis < 3; ++axis)
+		{
+			const float fromFace = (FMath::Abs(localPoint[axis]) - m_CacheBoxHalfExtent[axis]) * scale[axis];
+			if (FMath::Abs(localNormal[axis]) >= ProbeCacheBoxFaceDot && FMath::Abs(fromFace) <= ProbeCacheTolerance)
+			{
+				m_CacheHasBox = true;
+			}
+		}
+	}
+}
+
+bool UGroundStateComponent::IsInCacheExtent(const FVector& point) const
+{
+	if (m_CacheHasFootprint && IsInCacheFootprint(point))
+		return true;
+
+	if (m_NumCacheTriangles > 0 && CanProbeBakedSurfaces())
+	{
+		const SkateSim::FRideableBVHView& bvh = m_BakedSurfaces->GetBVH();
+		for (int32 i = 0; i < m_NumCacheTriangles; ++i)
+		{
+			if (SkateSim::DistanceOutsideTriangle(bvh.GetTriangle(m_CacheTriangles[i]), SkateSim::ToSim(point)) <= ProbeCacheTolerance)
+				return true;
+		}
+	}
+
+	// On the box's face: no further outside the box than the tolerance.
+	if (m_CacheHasBox)
+	{
+		const FVector local = m_CacheBoxTransform.InverseTransformPosition(point);
+		const FVector clamped(
+			FMath::Clamp(local.X, -m_CacheBoxHalfExtent.X, m_CacheBoxHalfExtent.X),
+			FMath::Clamp(local.Y, -m_CacheBoxHalfExtent.Y, m_CacheBoxHalfExtent.Y),
+			FMath::Clamp(local.Z, -m_CacheBoxHalfExtent.Z, m_CacheBoxHalfExtent.Z));
+		if (m_CacheBoxTransform.TransformVector(local - clamped).Size() <= ProbeCacheTolerance)
+			return true;
+	}
+
+	return false;
+}
+
+bool UGroundStateComponent::IsInCacheFootprint(const FVector& point) const
+{
+	// Inside (or within ProbeCacheTolerance of) every edge, whichever way round the edges wind about the normal.
+	float side = 0.0f;
+	for (int32 i = 0; i < Probe_Count; ++i)
+	{
+		const FVector& a = m_CacheFootprint[i];
+		const FVector edge = m_CacheFootprint[(i + 1) % Probe_Count] - a;
+		const float edgeLength = edge.Size();
+		if (edgeLength < KINDA_SMALL_NUMBER)
+			continue;
+
+		if (side == 0.0f)
+		{
+			// Inside is the side the far corner is on.
+			const FVector opposite = m_CacheFootprint[(i + 2) % Probe_Count] - a;
+			side = FMath::Sign(FVector::DotProduct(FVector::CrossProduct(edge, opposite), m_CachePlaneNormal));
+			if (side == 0.0f)
+				return false;
+		}
+
+		const float inside = side * FVector::DotProduct(FVector::CrossProduct(edge, point - a), m_CachePlaneNormal) / edgeLength;
+		if (inside < -ProbeCacheTolerance)
+			return false;
+	}
+	return true;
+}
+
+void UGroundStateComponent::CountCacheLookup(bool hit)
+{
+	// Counted over ProbeCacheRateInterval at a time, so the rate follows what the board is doing now.
+	const UWorld* world = GetWorld();
+	const float now = (world != nullptr ? world->GetTimeSeconds() : 0.0f);
+	if (now - m_CacheStatStartTime >= ProbeCacheRateInterval)
+	{
+		if (m_CacheLookups > 0)
+		{
+			m_CacheHitRate = (float)m_CacheHits / (float)m_CacheLookups;
+		}
+		m_CacheLookups = 0;
+		m_CacheHits = 0;
+		m_CacheStatStartTime = now;
+	}
+
+	++m_CacheLookups;
+	m_CacheHits += (hit ? 1 : 0);
+}
+
+bool UGroundStateComponent::ProbeGroundAsync(const FProbeSet & probes, const FVector & velocity)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardProbeAsync);
+
+	UWorld* world = GetWorld();
+	if (world == nullptr)
+		return false;
+
+	if (!ConsumeAsyncProbes() && m_HasAsyncResult)
+	{
+		// Last frame's batch wasn't available (e.g. we skipped a frame); keep extrapolating from the older result.
+		INC_DWORD_STAT(STAT_SkateboardProbeAsyncMissed);
+	}
+
+	if (!m_HasAsyncResult)
+	{
+		// Nothing to extrapolate from yet (first frame in async mode), so seed with a blocking probe.
+		ProbeGroundSync(probes);
+		StoreAsyncResult(m_IsOnGround, m_GroundPosition, m_GroundNormal, GFrameCounter, world->GetTimeSeconds());
+	}
+
+	SubmitAsyncProbes(probes);
+
+	// Extrapolate the last result up to now.  Position slides along the contact plane with our velocity, and the
+	// normal keeps rotating at the rate it was rotating between the last two results.
+	const float maxExtrapolationAngleDeg = 30.0f;
+	float age = GetProbeAgeSeconds();
+
+	m_IsOnGround = m_AsyncIsOnGround;
+	m_GroundNormal = m_AsyncGroundNormal;
+	m_GroundPosition = m_AsyncGroundPosition;
+
+	if (age > 0.0f)
+	{
+		FVector planarVel = velocity - (m_AsyncGroundNormal * FVector::DotProduct(velocity, m_AsyncGroundNormal));
+		m_GroundPosition += planarVel * age;
+
+		float sampleInterval = m_AsyncResultTime - m_AsyncPrevResultTime;
+		FVector axis = FVector::CrossProduct(m_AsyncPrevGroundNormal, m_AsyncGroundNormal);
+		float sinAngle = axis.Size();
+		if (sinAngle > KINDA_SMALL_NUMBER && sampleInterval > KINDA_SMALL_NUMBER)
+		{
+			float angleDeg = FMath::RadiansToDegrees(FMath::Asin(FMath::Min(sinAngle, 1.0f)));
+			float extrapolatedDeg = FMath::Min(angleDeg * (age / sampleInterval), maxExtrapolationAngleDeg);
+			m_GroundNormal = m_AsyncGroundNormal.RotateAngleAxis(extrapolatedDeg, axis / sinAngle);
+			m_GroundNormal.Normalize();
+		}
+	}
 
-	m_IsOnGround = (frontProbeHit || rearProbeHit || rightProbeHit || leftProbeHit);
+	INC_DWORD_STAT_BY(STAT_SkateboardProbeAgeFrames, GetProbeAgeFrames());
+	INC_FLOAT_STAT_BY(STAT_SkateboardProbeAgeMs, age * 1000.0f);
 
 	return m_IsOnGround;
 }
 
-void UGroundStateComponent::NotifyCollision(AActor * SelfActor, AActor * OtherActor, FVector NormalImpulse, const FHitResult & Hit)
+void UGroundStateComponent::SubmitAsyncProbes(const FProbeSet & probes)
+{
+	UWorld* world = GetWorld();
+	FCollisionResponseParams crp;
+
+	// Still four rays: async sweeps can't be rotated to the board.
+	for (int32 i = 0; i < Probe_Count; ++i)
+	{
+		m_PendingTraces[i] = world->AsyncLineTraceByChannel(EAsyncTraceType::Single, probes.Start[i], probes.End[i], ECollisionChannel::ECC_WorldStatic, m_RideableQueryParams, crp);
+		m_PendingProbeEnds[i] = probes.End[i];
+	}
+	m_HasPendingTraces = true;
+	m_PendingFrame = GFrameCounter;
+	m_PendingTime = world->GetTimeSeconds();
+
+	INC_DWORD_STAT_BY(STAT_SkateboardProbeAsyncSubmitted, Probe_Count);
+	SKATE_INC_COUNTER(TracesIssued, STAT_SkateboardTracesIssued, Probe_Count);
+}
+
+bool UGroundStateComponent::ConsumeAsyncProbes()
+{
+	if (!m_HasPendingTraces)
+		return false;
+
+	UWorld* world = GetWorld();
+	FVector contactPos[Probe_Count];
+	bool hit[Probe_Count];
+	for (int32 i = 0; i < Probe_Count; ++i)
+	{
+		FTraceDatum datum;
+		if (!world->QueryTraceData(m_PendingTraces[i], datum))
+		{
+			// Results are only kept for one frame; if any are gone, the whole batch is unusable.
+			m_HasPendingTraces = false;
+			return false;
+		}
+
+		hit[i] = (datum.OutHits.Num() > 0 && datum.OutHits[0].bBlockingHit);
+		contactPos[i] = (hit[i] ? datum.OutHits[0].ImpactPoint : m_PendingProbeEnds[i]);
+	}
+	m_HasPendingTraces = false;
+
+	FVector groundPos;
+	FVector groundNormal;
+	bool isOnGround = ResolveProbes(contactPos, hit, groundPos, groundNormal);
+	StoreAsyncResult(isOnGround, groundPos, groundNormal, m_PendingFrame, m_PendingTime);
+
+	return true;
+}
+
+void UGroundStateComponent::StoreAsyncResult(bool isOnGround, const FVector & groundPos, const FVector & groundNormal, uint64 frame, float time)
+{
+	// Only carry the previous normal forward if it's from a continuous run of ground contact.
+	bool continuous = (m_HasAsyncResult && m_AsyncIsOnGround && isOnGround);
+	m_AsyncPrevGroundNormal = (continuous ? m_AsyncGroundNormal : groundNormal);
+	m_AsyncPrevResultTime = (continuous ? m_AsyncResultTime : time);
+
+	m_HasAsyncResult = true;
+	m_AsyncIsOnGround = isOnGround;
+	m_AsyncGroundPosition = groundPos;
+	m_AsyncGroundNormal = groundNormal;
+	m_AsyncResultFrame = frame;
+	m_AsyncResultTime = time;
+}
+
+void UGroundStateComponent::NotifyContacts(const SkateSim::FContactSummary& contacts)
 {
-	// TODO
+	// Something knocked us; don't trust the cached ground plane, or the arc we were flying along.
+	m_HadContacts = (contacts.NumContacts > 0);
+	if (m_HadContacts)
+	{
+		m_CacheValid = false;
+		m_HasFlight = false;
+	}
+}
+
+bool UGroundStateComponent::SkipProbesInFlight(const FVector& pos, const FVector& velocity)
+{
+	if (!UseFlightPrediction || !m_HasFlight)
+		return false;
+
+	const float now = GetWorld()->GetTimeSeconds();
+	float time = now - m_FlightStartTime;
+	if (SkateSim::GetFlightDrift(m_Flight, time, SkateSim::ToSim(pos), SkateSim::ToSim(velocity)) > FlightDriftTolerance)
+	{
+		INC_DWORD_STAT(STAT_SkateboardFlightDrifted);
+		PredictFlight(pos, velocity, now);
+		time = 0.0f;
+	}
+
+	if (time + FlightProbeLeadTime >= m_Flight.EndTime)
+		return false;
+
+	// Anything in flight from before the jump would be stale by the time we probe again.
+	m_IsOnGround = false;
+	m_HasPendingTraces = false;
+	m_HasAsyncResult = false;
+	INC_DWORD_STAT(STAT_SkateboardFlightProbesSkipped);
+	return true;
+}
+
+void UGroundStateComponent::UpdateFlightPrediction(const FVector& pos, const FVector& velocity)
+{
+	if (!UseFlightPrediction || m_IsOnGround)
+	{
+		m_HasFlight = false;
+		return;
+	}
+
+	const float now = GetWorld()->GetTimeSeconds();
+	if (!m_HadContacts && (!m_HasFlight || now - m_FlightStartTime >= m_Flight.EndTime))
+	{
+		PredictFlight(pos, velocity, now);
+	}
+}
+
+bool UGroundStateComponent::GetPredictedLanding(FVector& positionOut, FVector& normalOut, float& timeLeftOut) const
+{
+	if (!m_HasFlight || !m_Flight.Lands)
+		return false;
+
+	positionOut = SkateSim::FromSim(m_Flight.LandingPosition);
+	normalOut = SkateSim::FromSim(m_Flight.LandingNormal);
+	timeLeftOut = FMath::Max(0.0f, m_Flight.EndTime - (GetWorld()->GetTimeSeconds() - m_FlightStartTime));
+	return true;
+}
+
+void UGroundStateComponent::PredictFlight(const FVector& pos, const FVector& velocity, float now)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardPredictFlight);
+	INC_DWORD_STAT(STAT_SkateboardFlightPredictions);
+
+	m_HasFlight = true;
+	m_FlightStartTime = now;
+	m_Flight.Arc.Origin = SkateSim::ToSim(pos);
+	m_Flight.Arc.Velocity = SkateSim::ToSim(velocity);
+	m_Flight.Arc.GravityZ = GetWorld()->GetGravityZ();
+	m_Flight.Lands = false;
+	m_Flight.EndTime = FlightPredictionTime;
+
+	// The probes reach half their length below us; follow that point along the arc, one chord at a time.
+	const float probeLength = (m_Profile != nullptr ? m_Profile->ProbeLength : 40.0f);
+	const FVector reach(0.0f, 0.0f, -0.5f * probeLength);
+	const float chordTime = SkateSim::GetFlightChordTime(m_Flight.Arc.GravityZ, FlightChordError);
+	float chordStartTime = 0.0f;
+	FVector chordStart = pos + reach;
+	while (chordStartTime < FlightPredictionTime)
+	{
+		const float chordEndTime = FMath::Min(chordStartTime + chordTime, FlightPredictionTime);
+		const FVector chordEnd = SkateSim::FromSim(m_Flight.Arc.PositionAt(chordEndTime)) + reach;
+		FHitResult hitResult;
+		if (ProbeRideable(chordStart, chordEnd, hitResult))
+		{
+			m_Flight.Lands = true;
+			m_Flight.EndTime = chordStartTime + (chordEndTime - chordStartTime) * hitResult.Time;
+			m_Flight.LandingPosition = SkateSim::ToSim(hitResult.ImpactPoint);
+			m_Flight.LandingNormal = SkateSim::ToSim(hitResult.ImpactNormal);
+			return;
+		}
+		chordStartTime = chordEndTime;
+		chordStart = chordEnd;
+	}
+}
+
+void UGroundStateComponent::ApplyContactSupport(const SkateSim::FContactSummary& contacts)
+{
+	if (m_IsOnGround || contacts.NumContacts == 0 || !contacts.HasSupport)
+		return;
+
+	INC_DWORD_STAT(STAT_SkateboardContactSupport);
+	m_IsOnGround = true;
+	m_GroundPosition = SkateSim::FromSim(contacts.Support.Position);
+	m_GroundNormal = SkateSim::FromSim(contacts.Support.Normal);
 }
 
 bool UGroundStateComponent::ProbeRideable(const FVector& start, const FVector& end, FHitResult& hitOut)
 {
+	SKATE_SCOPE_PHASE(ProbeTrace, STAT_SkateboardPhaseProbeTrace);
+
 	if (!GetWorld())
 		return false;
 
-	const FName traceTag("Rideable");
-	FCollisionQueryParams cqp;
-	cqp.TraceTag = traceTag;
-	cqp.AddIgnoredActor(GetOwner());
+	const FCollisionQueryParams& cqp = m_RideableQueryParams;
 	FCollisionResponseParams crp;
 
+	if (CanProbeBakedSurfaces())
+	{
+		SkateSim::FRideableHit bakedHit;
+		if (m_BakedSurfaces->GetBVH().RaycastSegment(SkateSim::ToSim(start), SkateSim::ToSim(end), bakedHit))
+		{
+			INC_DWORD_STAT(STAT_SkateboardProbeBakedHits);
+			m_BakedSurfaces->MakeHitResult(bakedHit, start, end, hitOut);
+
+			// Only static geometry is baked, so look for anything movable in front of it, on the same channel as the
+			// PhysX probe would.
+			if (BakedProbesCheckDynamic)
+			{
+				FHitResult dynamicHit;
+				SKATE_INC_COUNTER(TracesIssued, STAT_SkateboardTracesIssued, 1);
+				if (GetWorld()->LineTraceSingleByChannel(dynamicHit, start, hitOut.ImpactPoint, ECollisionChannel::ECC_WorldStatic, m_DynamicQueryParams, crp))
+				{
+					hitOut = dynamicHit;
+				}
+			}
+			return true;
+		}
+
+		// Off the baked geometry, or on something movable.
+		INC_DWORD_STAT(STAT_SkateboardProbeBakedFallbacks);
+	}
+
+	SKATE_INC_COUNTER(TracesIssued, STAT_SkateboardTracesIssued, 1);
+
 	return GetWorld()->LineTraceSingleByChannel(hitOut, start, end, ECollisionChannel::ECC_WorldStatic, cqp, crp);
 }
 
-const USkateboardTune * UGroundStateComponent::GetSkateboardTune() const
+void UGroundStateComponent::ProbeContactPatch(const FProbeSet& probes, FHitResult hitResultsOut[Probe_Count], bool hitOut[Probe_Count])
+{
+	SKATE_SCOPE_PHASE(ProbeTrace, STAT_SkateboardPhaseProbeTrace);
+
+	for (int32 i = 0; i < Probe_Count; ++i)
+	{
+		hitOut[i] = false;
+	}
+	if (!GetWorld())
+		return;
+
+	// Everything the box passes through comes back as a touch, rather than stopping at the first.  That's one touch
+	// per shape, not per face, so it only tells us which components to look at.
+	SKATE_INC_COUNTER(TracesIssued, STAT_SkateboardTracesIssued, 1);
+	INC_DWORD_STAT(STAT_SkateboardContactPatchSweeps);
+	m_PatchHits.Reset();
+	GetWorld()->SweepMultiByChannel(m_PatchHits, probes.PatchStart, probes.PatchEnd, probes.PatchRotation, ECollisionChannel::ECC_WorldStatic,
+		FCollisionShape::MakeBox(probes.PatchHalfExtent), m_RideableQueryParams, FCollisionResponseParams(ECR_Overlap));
+
+	// Including ones we started inside: the wheels' own traces can still start outside them.
+	UPrimitiveComponent* candidates[MaxContactPatchComponents];
+	int32 numCandidates = 0;
+	for (int32 i = 0; i < m_PatchHits.Num() && numCandidates < MaxContactPatchComponents; ++i)
+	{
+		UPrimitiveComponent* component = m_PatchHits[i].Component.Get();
+		bool seen = (component == nullptr);
+		for (int32 c = 0; c < numCandidates && !seen; ++c)
+		{
+			seen = (candidates[c] == component);
+		}
+		if (!seen)
+		{
+			candidates[numCandidates++] = component;
+		}
+	}
+	INC_DWORD_STAT_BY(STAT_SkateboardContactPatchCandidates, numCandidates);
+	if (numCandidates == 0)
+		return;
+
+	// Trace each wheel's probe line against each candidate on its own, and rest it on the nearest face it can ride.
+	INC_DWORD_STAT_BY(STAT_SkateboardContactPatchWheelTraces, numCandidates * Probe_Count);
+	for (int32 i = 0; i < Probe_Count; ++i)
+	{
+		const FVector probe = probes.End[i] - probes.Start[i];
+		FHitResult wheelHits[MaxContactPatchComponents];
+		SkateSim::FWheelTraceHit traceHits[MaxContactPatchComponents];
+		int32 numHits = 0;
+		for (int32 c = 0; c < numCandidates; ++c)
+		{
+			FHitResult& wheelHit = wheelHits[numHits];
+			if (!candidates[c]->LineTraceComponent(wheelHit, probes.Start[i], probes.End[i], m_RideableQueryParams))
+				continue;
+
+			traceHits[numHits].Time = wheelHit.Time;
+			traceHits[numHits].Normal = SkateSim::ToSim(wheelHit.ImpactNormal);
+			++numHits;
+		}
+
+		const int best = SkateSim::SelectWheelContact(traceHits, numHits, SkateSim::ToSim(probe), ContactPatchMinFacing);
+		hitOut[i] = (best >= 0);
+		if (hitOut[i])
+		{
+			hitResultsOut[i] = wheelHits[best];
+			hitResultsOut[i].bBlockingHit = true;
+		}
+	}
+}
+
+bool UGroundStateComponent::CanProbeBakedSurfaces() const
 {
-	return m_SkateboardTune;
+	return (UseBakedSurfaces && m_BakedSurfaces != nullptr && m_BakedSurfaces->IsLoaded());
+}
+
+FCollisionQueryParams UGroundStateComponent::MakeRideableQueryParams() const
+{
+	const FName traceTag("Rideable");
+	FCollisionQueryParams cqp;
+	cqp.TraceTag = traceTag;
+	cqp.AddIgnoredActor(GetOwner());
+	return cqp;
 }
 
 void UGroundStateComponent::ResetState()
 {
 	m_IsOnGround = false;
+	m_HasPendingTraces = false;
+	m_HasAsyncResult = false;
+	m_CacheValid = false;
+	m_HasFlight = false;
+	m_HadContacts = false;
 }
 
 void UGroundStateComponent::DebugDraw() const
@@ -155,3 +949,26 @@ FVector UGroundStateComponent::GetGroundNormal() const
 {
 	return m_GroundNormal;
 }
+
+int32 UGroundStateComponent::GetProbeAgeFrames() const
+{
+	if (!UseAsyncProbes || !m_HasAsyncResult)
+		return 0;
+	return (int32)(GFrameCounter - m_AsyncResultFrame);
+}
+
+float UGroundStateComponent::GetProbeCacheHitRate() const
+{
+	if (m_CacheHitRate >= 0.0f)
+		return m_CacheHitRate;
+
+	// Still in the first interval.
+	return (m_CacheLookups > 0 ? (float)m_CacheHits / (float)m_CacheLookups : 0.0f);
+}
+
+float UGroundStateComponent::GetProbeAgeSeconds() const
+{
+	if (!UseAsyncProbes || !m_HasAsyncResult || GetWorld() == nullptr)
+		return 0.0f;
+	return GetWorld()->GetTimeSeconds() - m_AsyncResultTime;
+}
@@ -3,9 +3,11 @@
 #pragma once
 
 #include "Components/ActorComponent.h"
+#include "SkateboardSimFlight.h"
 #include "GroundStateComponent.generated.h"
 
-class USkateboardTune;
+namespace SkateSim { struct FBoardProfile; struct FContactSummary; }
+class FRideableSurfaceData;
 
 /**
 * This component is responsible for resolving a SkateboardSimPawn's interaction with the ground.
@@ -15,27 +17,63 @@ class AWOL_API UGroundStateComponent : public UActorComponent
 {
 	GENERATED_BODY()
 
-public:	
+public:
 	// Sets default values for this component's properties
 	UGroundStateComponent();
 
-	// Called after construction
-	void SetSkateboardTune(const USkateboardTune* tune) { m_SkateboardTune = tune; }
+	// Called when our owner picks its tuning profile.  Shared with other boards; must outlive us.
+	void SetBoardProfile(const SkateSim::FBoardProfile* profile) { m_Profile = profile; }
+
+	// Called when the level's baked rideable surfaces are loaded or unloaded.  May be null.
+	void SetBakedSurfaces(const FRideableSurfaceData* bakedSurfaces) { m_BakedSurfaces = bakedSurfaces; m_CacheValid = false; }
 
 	// Called when the game starts
 	virtual void BeginPlay() override;
-	
+
 	// Called every frame
 	virtual void TickComponent( float DeltaTime, ELevelTick TickType, FActorComponentTickFunction* ThisTickFunction ) override;
 
 	// Probe for the ground based on our current position and forward/right vectors, where the forward vector is our direction of motion.
+	// velocity is only used in async mode, to extrapolate last frame's probe results up to the current frame.
 	// Returns true if the ground was found, false otherwise.
-	bool ProbeGround(const FVector &pos, const FVector &forward, const FVector &right);
+	bool ProbeGround(const FVector &pos, const FVector &forward, const FVector &right, const FVector &velocity);
+
+	// Probe with blocking traces whatever UseAsyncProbes says, and just report the ground found, e.g. to re-run past
+	// ticks during a resimulation.  Our own ground state, probe cache and any async batch in flight are left alone.
+	bool QueryGround(const FVector &pos, const FVector &forward, const FVector &right, FVector& groundPosOut, FVector& groundNormalOut);
+
+	// Probe with fewer blocking traces, for boards that don't need the full ground model (see ESkateSimTier).  With
+	// two probes, only the front and rear are traced and the sideways tilt is taken from the right vector; with one,
+	// a single probe under pos takes the surface normal as it finds it.  Any async batch in flight is dropped.  Uses and
+	// fills the probe cache like full probes do (see UseProbeCache).
+	bool ProbeGroundReduced(const FVector &pos, const FVector &forward, const FVector &right, int32 numProbes);
+
+	// Overwrite the current ground state, e.g. when the pawn is put back to an earlier snapshot.
+	void SetGroundState(bool isOnGround, const FVector& groundPos, const FVector& groundNormal);
+
+	// Called once per tick, before probing, with the collision contacts reported since the last tick.  Any contact
+	// drops our flight prediction, since whatever we hit has changed the arc.
+	void NotifyContacts(const SkateSim::FContactSummary& contacts);
+
+	// Called before probing.  Returns true if we're in the air on a predicted arc (see UseFlightPrediction) that won't
+	// bring the probes down to the ground for a while yet, in which case we stay in the air and this tick's probes
+	// can be skipped.  If we've drifted off the arc, it's predicted again from here first.
+	bool SkipProbesInFlight(const FVector& pos, const FVector& velocity);
+
+	// Called after probing.  Predicts our flight when we've just left the ground (or outlived the last prediction
+	// without landing), and forgets it once we're back down.  Not on a tick we hit something; see NotifyContacts().
+	void UpdateFlightPrediction(const FVector& pos, const FVector& velocity);
 
-	// Called to notify us that a collision has occurred
-	void NotifyCollision(AActor* SelfActor, AActor* OtherActor, FVector NormalImpulse, const FHitResult& Hit);
+	// Where, on what surface, and in how many seconds our flight prediction says we'll land.  Returns false if we're
+	// not in predicted flight, or the arc didn't come down within FlightPredictionTime.
+	bool GetPredictedLanding(FVector& positionOut, FVector& normalOut, float& timeLeftOut) const;
 
-	// Helper function to do a physics probe for rideable surfaces
+	// Called after probing with the same contacts.  If the probes found nothing but a contact is holding us up (e.g.
+	// a rail thin enough to pass between them), we're on the ground there.
+	void ApplyContactSupport(const SkateSim::FContactSummary& contacts);
+
+	// Helper function to do a physics probe for rideable surfaces.  Checks the level's baked surfaces first, if it has
+	// any, and only falls back to a PhysX trace when they miss.
 	bool ProbeRideable(const FVector& start, const FVector& end, FHitResult& hitOut);
 
 	// Is this pawn touching the ground?
@@ -50,19 +88,230 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|GroundState")
 	FVector GetGroundNormal() const;
 
+	// Is our flight prediction (if any) letting us skip probes?
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|GroundState")
+	bool IsInPredictedFlight() const { return m_HasFlight; }
+
+	// How many frames old the probe results behind the current ground state are.  Always 0 for synchronous probes.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|GroundState")
+	int32 GetProbeAgeFrames() const;
+
+	// How many seconds old the probe results behind the current ground state are.  Always 0 for synchronous probes.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|GroundState")
+	float GetProbeAgeSeconds() const;
+
+	// Fraction of cache lookups that were answered without tracing, over the last second.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|GroundState")
+	float GetProbeCacheHitRate() const;
+
+	// If true, blocking probes off the baked surfaces sweep one thin box the size of the wheelbase down through the
+	// probe range to find the components under the board, then trace each probe against just those (see
+	// SkateboardSimContactPatch.h), instead of tracing four separate rays through the scene.  One scene query instead
+	// of four, and the board rests on edges it overhangs.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	bool UseContactPatchSweep;
+
+	// If true, the four ground probes are submitted as one asynchronous batch and consumed on the next frame,
+	// with the result extrapolated by the pawn's velocity.  If false, the probes block the game thread.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	bool UseAsyncProbes;
+
+	// If true, and the level has baked rideable surfaces, blocking probes query those (without locking the physics
+	// scene) and only trace through PhysX when they miss.  Async probes always go through PhysX.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	bool UseBakedSurfaces;
+
+	// If true, a probe that hits a baked surface also traces for movable objects between the probe start and that
+	// hit, so e.g. a physics prop lying on a ramp or a moving platform is still ridden over.  Costs a PhysX query per
+	// probe, against movable objects only.  Only turn it off in levels with nothing movable to ride.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	bool BakedProbesCheckDynamic;
+
+	// If true (and not using async probes), when the probes all hit the same flat, static primitive we remember that
+	// plane and intersect the next frames' probes with it instead of tracing, for as long as they stay on the part of
+	// it known to be flat: the baked triangles the hits were on, the face of the primitive's collision box if that's
+	// all its collision is, or at least the footprint of four hits.  So a board rolling across a slab keeps using it.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	bool UseProbeCache;
+
+	// How far, in cm, the hits may be from a common plane (and still be cached), and how far outside the flat part of
+	// it the probes may then move before we trace again.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	float ProbeCacheTolerance;
+
+	// The most frames in a row we'll answer from the cache before tracing again anyway.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	int32 ProbeCacheMaxFrames;
+
+	// If true, when we leave the ground we follow our ballistic arc with a few queries to find where the probes will
+	// next reach it, and don't probe again until shortly before then (see SkateboardSimFlight.h).
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	bool UseFlightPrediction;
+
+	// How far ahead, in seconds, to follow the arc looking for the ground.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	float FlightPredictionTime;
+
+	// How far, in cm, each straight query along the arc may stray from it.  Fewer queries the larger it is.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	float FlightChordError;
+
+	// How many seconds before the predicted landing to start probing again.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	float FlightProbeLeadTime;
+
+	// How far, in cm, our actual flight may be heading from the predicted landing before we predict it again.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|GroundState")
+	float FlightDriftTolerance;
+
 private:
-	const USkateboardTune* GetSkateboardTune() const;
+	// The four probes, one per side of the board.
+	enum EProbe
+	{
+		Probe_Front,
+		Probe_Rear,
+		Probe_Right,
+		Probe_Left,
+		Probe_Count
+	};
+
+	// Start and end positions for one set of probes, and the box that sweeps them all at once.
+	struct FProbeSet
+	{
+		FVector Start[Probe_Count];
+		FVector End[Probe_Count];
+		FVector PatchStart;
+		FVector PatchEnd;
+		FQuat PatchRotation;
+		FVector PatchHalfExtent;
+	};
 
 	// Reset our internal state
 	void ResetState();
 
 	void DebugDraw() const;
 
+	// Compute the probe positions for the given position and basis.
+	void BuildProbeSet(const FVector &pos, const FVector &forward, const FVector &right, FProbeSet& probesOut) const;
+
+	// Compute the ground position and normal from the four contact points, writing them to the given outputs.
+	// Returns true if any of the probes hit.
+	static bool ResolveProbes(const FVector contactPos[Probe_Count], const bool hit[Probe_Count], FVector& groundPosOut, FVector& groundNormalOut);
+
+	// Query params shared by all of our rideable probes.  Built once, into m_RideableQueryParams, at BeginPlay.
+	FCollisionQueryParams MakeRideableQueryParams() const;
+
+	// Are the level's baked surfaces there to answer our probes?
+	bool CanProbeBakedSurfaces() const;
+
+	// All four probes with one multi-hit box sweep.  Fills in a hit for each probe that found the ground.
+	void ProbeContactPatch(const FProbeSet& probes, FHitResult hitResultsOut[Probe_Count], bool hitOut[Probe_Count]);
+
+	// Blocking probes; results are used immediately.
+	bool ProbeGroundSync(const FProbeSet& probes);
+
+	// Trace all four probes and resolve the ground they found, without storing it.
+	bool TraceProbes(const FProbeSet& probes, FHitResult hitResultsOut[Probe_Count], bool hitOut[Probe_Count], FVector& groundPosOut, FVector& groundNormalOut);
+
+	// Non-blocking probes; results from the previous frame are extrapolated to the current one.
+	bool ProbeGroundAsync(const FProbeSet& probes, const FVector& velocity);
+
+	// Queue a batch of async traces that will be ready next frame.
+	void SubmitAsyncProbes(const FProbeSet& probes);
+
+	// Read back the batch submitted last frame, if it's ready.  Returns true if a new result was stored.
+	bool ConsumeAsyncProbes();
+
+	// Look this frame's probes up in the cache, counting the lookup, and the given number of traces saved if it hits.
+	bool LookUpProbeCache(const FProbeSet& probes, int32 numTraces);
+
+	// Answer this frame's probes by intersecting them with the cached contact plane.  Returns false (and drops the
+	// cache) if the probes have left the cached region or the budget has run out.
+	bool ProbeGroundCached(const FProbeSet& probes);
+
+	// Cache the given plane if the given probes all hit it, on the same static primitive, and we know some of that
+	// primitive's extent on it.  All four probes' hits also give us their footprint.
+	void UpdateProbeCache(const FHitResult* hitResults, const bool* hit, int32 numProbes, const FVector& planePoint, const FVector& planeNormal);
+
+	// Work out how much of comp lies on the cached plane: the baked triangles under the given hits, and the face of
+	// its collision box.
+	void CacheSurfaceExtent(UPrimitiveComponent* comp, const FHitResult* hitResults, int32 numProbes);
+
+	// Does a point on the cached plane lie on the part of it we know is flat?
+	bool IsInCacheExtent(const FVector& point) const;
+
+	// Does a point on the cached plane lie within the footprint the four hits made when we cached it?
+	bool IsInCacheFootprint(const FVector& point) const;
+
+	// Count a cache lookup toward GetProbeCacheHitRate().
+	void CountCacheLookup(bool hit);
+
+	// Follow our arc from here until the probes would reach the ground, and remember what we find.
+	void PredictFlight(const FVector& pos, const FVector& velocity, float now);
+
+	// Store a newly resolved async result, sampled at the given frame and time.
+	void StoreAsyncResult(bool isOnGround, const FVector& groundPos, const FVector& groundNormal, uint64 frame, float time);
+
 private:
 	bool m_IsOnGround;
 	FVector m_GroundPosition;
 	FVector m_GroundNormal;
 
-	// Non-custodial pointer
-	const USkateboardTune* m_SkateboardTune;
+	FCollisionQueryParams m_RideableQueryParams;
+	FCollisionQueryParams m_DynamicQueryParams;	// The same, against movable objects only
+
+	// The contact patch sweep's hits, kept to save reallocating them every probe.
+	TArray<FHitResult> m_PatchHits;
+
+	// Async probe state: the batch in flight.
+	FTraceHandle m_PendingTraces[Probe_Count];
+	FVector m_PendingProbeEnds[Probe_Count];
+	bool m_HasPendingTraces;
+	uint64 m_PendingFrame;
+	float m_PendingTime;
+
+	// Async probe state: the most recent resolved batch, and the normal from the one before it (for extrapolation).
+	bool m_HasAsyncResult;
+	bool m_AsyncIsOnGround;
+	FVector m_AsyncGroundPosition;
+	FVector m_AsyncGroundNormal;
+	FVector m_AsyncPrevGroundNormal;
+	float m_AsyncPrevResultTime;
+	uint64 m_AsyncResultFrame;
+	float m_AsyncResultTime;
+
+	// Probe cache: the plane the probes last hit, the primitive it belongs to, and where that was when we cached it.
+	bool m_CacheValid;
+	FVector m_CachePlanePoint;
+	FVector m_CachePlaneNormal;
+	TWeakObjectPtr<UPrimitiveComponent> m_CacheComponent;
+	FTransform m_CacheComponentTransform;
+	int32 m_CacheFramesLeft;
+
+	// Probe cache: where on the plane we know it holds.  The four hits, if we had them; the baked triangles the hits
+	// were on; and the primitive's collision box, if the plane is one of its faces.
+	bool m_CacheHasFootprint;
+	FVector m_CacheFootprint[Probe_Count];
+	int32 m_NumCacheTriangles;
+	uint32 m_CacheTriangles[Probe_Count];
+	bool m_CacheHasBox;
+	FTransform m_CacheBoxTransform;
+	FVector m_CacheBoxHalfExtent;
+
+	// Probe cache hit rate: lookups and hits since m_CacheStatStartTime, and the last full interval's rate (negative
+	// until there's been one).
+	uint32 m_CacheLookups;
+	uint32 m_CacheHits;
+	float m_CacheStatStartTime;
+	float m_CacheHitRate;
+
+	// Flight prediction: the arc we're on, when (in world time) it starts, and whether we hit anything this tick.
+	bool m_HasFlight;
+	SkateSim::FFlightPrediction m_Flight;
+	float m_FlightStartTime;
+	bool m_HadContacts;
+
+	// Non-custodial pointers
+	const SkateSim::FBoardProfile* m_Profile;
+	const FRideableSurfaceData* m_BakedSurfaces;
 };
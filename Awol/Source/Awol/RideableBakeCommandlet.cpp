@@ -0,0 +1,71 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "RideableBakeCommandlet.h"
+#include "RideableSurfaceData.h"
+#include "GrindRailData.h"
+
+
+URideableBakeCommandlet::URideableBakeCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+}
+
+int32 URideableBakeCommandlet::Main(const FString& Params)
+{
+#if WITH_EDITOR
+	FString mapList;
+	if (!FParse::Value(*Params, TEXT("-map="), mapList))
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("Usage: -run=RideableBake -map=/Game/Path/To/Map[+/Game/Path/To/OtherMap...]"));
+		return 1;
+	}
+
+	TArray<FString> mapNames;
+	mapList.ParseIntoArray(mapNames, TEXT("+"), true);
+
+	int32 numFailed = 0;
+	for (const FString& mapName : mapNames)
+	{
+		UPackage* package = LoadPackage(nullptr, *mapName, LOAD_None);
+		UWorld* world = (package != nullptr ? UWorld::FindWorldInPackage(package) : nullptr);
+		if (world == nullptr)
+		{
+			UE_LOG(LogSkateboardSim, Error, TEXT("Couldn't load map %s"), *mapName);
+			++numFailed;
+			continue;
+		}
+
+		// Components need registering (and bodies creating) before we can read their transforms or trace them.
+		world->WorldType = EWorldType::Editor;
+		world->AddToRoot();
+		world->InitWorld(UWorld::InitializationValues().AllowAudioPlayback(false).CreatePhysicsScene(true).RequiresHitProxies(false).CreateNavigation(false).CreateAISystem(false).ShouldSimulatePhysics(false));
+		world->UpdateWorldComponents(true, false);
+
+		FString error;
+		if (!FRideableSurfaceData::BakeWorld(world, FRideableSurfaceData::GetPathForWorld(world), error))
+		{
+			UE_LOG(LogSkateboardSim, Error, TEXT("Baking %s failed: %s"), *mapName, *error);
+			++numFailed;
+		}
+
+		// Not every level has anything to grind, so that's not a failure.
+		if (!FGrindRailData::BakeWorld(world, FGrindRailData::GetPathForWorld(world), error))
+		{
+			UE_LOG(LogSkateboardSim, Warning, TEXT("No grind rails baked for %s: %s"), *mapName, *error);
+		}
+
+		world->DestroyWorld(false);
+		world->RemoveFromRoot();
+		CollectGarbage(RF_NoFlags);
+	}
+
+	return (numFailed > 0 ? 1 : 0);
+#else
+	UE_LOG(LogSkateboardSim, Error, TEXT("RideableBake needs editor data; run it from the editor executable."));
+	return 1;
+#endif
+}
@@ -0,0 +1,26 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "RideableBakeCommandlet.generated.h"
+
+/**
+* Bakes each listed map's rideable surfaces and grind rails, for running before a cook:
+*
+*   UE4Editor-Cmd.exe Awol.uproject -run=RideableBake -map=/Game/AWOL/Map/VeniceBeachSkatePark+/Game/AWOL/SkateboardTestFiles/testMap
+*
+* Writes the same files as the skate.BakeRideableSurfaces and skate.BakeGrindRails console commands.
+*
+* @see FRideableSurfaceData, FGrindRailData
+*/
+UCLASS()
+class URideableBakeCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	URideableBakeCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+};
@@ -0,0 +1,488 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+#include <stdint.h>
+#include <string.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+
+/**
+* Engine-independent bounding volume hierarchy over a level's rideable static triangles.
+*
+* The baked file is a single little-endian blob that is used in place, straight out of a memory-mapped file:
+*
+*   FRideableBVHHeader
+*   FRideableBVHNode[NumNodes]       (node 0 is the root)
+*   FRideableBVHTriangle[NumTriangles]
+*   uint32_t[NumSources]             (byte offset of each source's name)
+*   char[]                           (the names, each null-terminated)
+*
+* Each triangle records which source (the primitive it was baked from) it came from, by index into the name table,
+* so a hit can be traced back to its component.  SourceHash is whatever the baker made of those primitives' names
+* and placements, so the loader can tell when the level has changed since the bake.
+*
+* FRideableBVHView only reads from that blob, so any number of threads can query it at once without locks.
+* FRideableBVHBuilder produces the blob at bake time.
+*
+* @see FRideableSurfaceData
+*/
+namespace SkateSim
+{
+	const uint32_t RideableBVHMagic = 0x48425352;	// 'RSBH'
+	const uint32_t RideableBVHVersion = 2;
+
+	struct FRideableBVHHeader
+	{
+		uint32_t Magic;
+		uint32_t Version;
+		uint32_t NumNodes;
+		uint32_t NumTriangles;
+		uint32_t NodesOffset;		// Byte offset of the node array from the start of the blob
+		uint32_t TrianglesOffset;	// Byte offset of the triangle array from the start of the blob
+		uint32_t NumSources;
+		uint32_t SourcesOffset;		// Byte offset of the source name offsets from the start of the blob
+		uint32_t SourceHash;
+		float BoundsMin[3];
+		float BoundsMax[3];
+	};
+
+	struct FRideableBVHNode
+	{
+		float Min[3];
+		float Max[3];
+		uint32_t First;		// Leaf: first triangle.  Interior: index of the left child (the right child follows it).
+		uint32_t Count;		// Leaf: number of triangles.  Interior: 0.
+	};
+
+	// Triangles are stored as a vertex and two edges, ready for the ray/triangle test.
+	struct FRideableBVHTriangle
+	{
+		float V0[3];
+		float Edge1[3];
+		float Edge2[3];
+		float Normal[3];
+		uint32_t Source;
+	};
+
+	struct FRideableHit
+	{
+		float Time;		// Fraction along the segment, in [0, 1]
+		FVec3 Position;
+		FVec3 Normal;	// Unit normal, facing back toward the segment start
+		uint32_t Triangle;
+		uint32_t Source;
+	};
+
+	inline FVec3 LoadVec3(const float* f) { return MakeVec3(f[0], f[1], f[2]); }
+
+	// How far outside the triangle's edges point lies, measured in its plane; 0 if it's over the triangle.
+	inline float DistanceOutsideTriangle(const FRideableBVHTriangle& tri, const FVec3& point)
+	{
+		const FVec3 v0 = LoadVec3(tri.V0);
+		const FVec3 verts[3] = { v0, v0 + LoadVec3(tri.Edge1), v0 + LoadVec3(tri.Edge2) };
+		const FVec3 normal = LoadVec3(tri.Normal);
+		float outside = 0.0f;
+		for (int i = 0; i < 3; ++i)
+		{
+			// The edge crossed with the normal points out of the triangle, whichever way it's wound.
+			const FVec3 out = Cross(verts[(i + 1) % 3] - verts[i], normal);
+			const float length = Size(out);
+			if (length <= 0.0f)
+				continue;
+
+			const float distance = Dot(point - verts[i], out) / length;
+			outside = (distance > outside ? distance : outside);
+		}
+		return outside;
+	}
+
+	// Read-only view of a baked blob.  Does not own the memory.
+	class FRideableBVHView
+	{
+	public:
+		FRideableBVHView() : m_Header(nullptr), m_Nodes(nullptr), m_Triangles(nullptr), m_Sources(nullptr), m_Data(nullptr) {}
+
+		// Point the view at a blob, validating its header and sizes.  Returns false if the blob can't be used.
+		bool Init(const void* data, size_t size)
+		{
+			*this = FRideableBVHView();
+
+			if (data == nullptr || size < sizeof(FRideableBVHHeader))
+				return false;
+
+			const FRideableBVHHeader* header = static_cast<const FRideableBVHHeader*>(data);
+			if (header->Magic != RideableBVHMagic || header->Version != RideableBVHVersion || header->NumNodes == 0)
+				return false;
+
+			const uint64_t nodesEnd = (uint64_t)header->NodesOffset + (uint64_t)header->NumNodes * sizeof(FRideableBVHNode);
+			const uint64_t trianglesEnd = (uint64_t)header->TrianglesOffset + (uint64_t)header->NumTriangles * sizeof(FRideableBVHTriangle);
+			const uint64_t sourcesEnd = (uint64_t)header->SourcesOffset + (uint64_t)header->NumSources * sizeof(uint32_t);
+			if (nodesEnd > size || trianglesEnd > size || sourcesEnd > size
+				|| (header->NodesOffset % 4) != 0 || (header->TrianglesOffset % 4) != 0 || (header->SourcesOffset % 4) != 0)
+				return false;
+
+			// Every name has to start inside the blob, and the blob has to end in a terminator so none runs off it.
+			const uint8_t* bytes = static_cast<const uint8_t*>(data);
+			const uint32_t* sources = reinterpret_cast<const uint32_t*>(bytes + header->SourcesOffset);
+			if (header->NumSources > 0 && bytes[size - 1] != 0)
+				return false;
+			for (uint32_t i = 0; i < header->NumSources; ++i)
+			{
+				if (sources[i] < sourcesEnd || sources[i] >= size)
+					return false;
+			}
+
+			const FRideableBVHTriangle* triangles = reinterpret_cast<const FRideableBVHTriangle*>(bytes + header->TrianglesOffset);
+			for (uint32_t i = 0; i < header->NumTriangles; ++i)
+			{
+				if (triangles[i].Source >= header->NumSources)
+					return false;
+			}
+
+			m_Header = header;
+			m_Nodes = reinterpret_cast<const FRideableBVHNode*>(bytes + header->NodesOffset);
+			m_Triangles = triangles;
+			m_Sources = sources;
+			m_Data = reinterpret_cast<const char*>(bytes);
+			return true;
+		}
+
+		bool IsValid() const { return m_Header != nullptr; }
+		uint32_t NumTriangles() const { return (m_Header != nullptr ? m_Header->NumTriangles : 0); }
+		uint32_t NumNodes() const { return (m_Header != nullptr ? m_Header->NumNodes : 0); }
+		uint32_t NumSources() const { return (m_Header != nullptr ? m_Header->NumSources : 0); }
+		uint32_t GetSourceHash() const { return (m_Header != nullptr ? m_Header->SourceHash : 0); }
+
+		// The given triangle, e.g. the one a hit found.  triangle must be below NumTriangles().
+		const FRideableBVHTriangle& GetTriangle(uint32_t triangle) const { return m_Triangles[triangle]; }
+
+		// Name of the primitive the given source's triangles were baked from.
+		const char* GetSourceName(uint32_t source) const { return m_Data + m_Sources[source]; }
+
+		// Find the closest triangle hit by the segment from start to end.  Triangles are two-sided.
+		bool RaycastSegment(const FVec3& start, const FVec3& end, FRideableHit& hitOut) const
+		{
+			if (m_Header == nullptr)
+				return false;
+
+			const FVec3 dir = end - start;
+			const float invDir[3] = { SafeInverse(dir.X), SafeInverse(dir.Y), SafeInverse(dir.Z) };
+			const float origin[3] = { start.X, start.Y, start.Z };
+
+			float bestTime = 1.0f;
+			uint32_t bestTriangle = UINT32_MAX;
+
+			// Depth is bounded by the builder, which never makes trees deeper than this.
+			uint32_t stack[MaxDepth];
+			int stackSize = 0;
+			stack[stackSize++] = 0;
+
+			while (stackSize > 0)
+			{
+				const FRideableBVHNode& node = m_Nodes[stack[--stackSize]];
+				float tEntry;
+				if (!IntersectBox(node, origin, invDir, bestTime, tEntry))
+					continue;
+
+				if (node.Count > 0)
+				{
+					for (uint32_t i = node.First; i < node.First + node.Count; ++i)
+					{
+						float t;
+						if (IntersectTriangle(m_Triangles[i], start, dir, t) && t < bestTime)
+						{
+							bestTime = t;
+							bestTriangle = i;
+						}
+					}
+				}
+				else if (stackSize + 2 <= MaxDepth)
+				{
+					// Push the nearer child last so it's visited first, and the far one can be culled against its hit.
+					const uint32_t left = node.First;
+					const uint32_t right = node.First + 1;
+					float tLeft, tRight;
+					const bool hitLeft = IntersectBox(m_Nodes[left], origin, invDir, bestTime, tLeft);
+					const bool hitRight = IntersectBox(m_Nodes[right], origin, invDir, bestTime, tRight);
+					if (hitLeft && hitRight)
+					{
+						const bool leftFirst = (tLeft <= tRight);
+						stack[stackSize++] = (leftFirst ? right : left);
+						stack[stackSize++] = (leftFirst ? left : right);
+					}
+					else if (hitLeft)
+					{
+						stack[stackSize++] = left;
+					}
+					else if (hitRight)
+					{
+						stack[stackSize++] = right;
+					}
+				}
+			}
+
+			if (bestTriangle == UINT32_MAX)
+				return false;
+
+			const FRideableBVHTriangle& tri = m_Triangles[bestTriangle];
+			hitOut.Time = bestTime;
+			hitOut.Position = start + dir * bestTime;
+			hitOut.Normal = LoadVec3(tri.Normal);
+			if (Dot(hitOut.Normal, dir) > 0.0f)
+				hitOut.Normal = -hitOut.Normal;
+			hitOut.Triangle = bestTriangle;
+			hitOut.Source = tri.Source;
+			return true;
+		}
+
+		static const int MaxDepth = 64;
+
+	private:
+		static float SafeInverse(float x)
+		{
+			return (x != 0.0f ? 1.0f / x : (x >= 0.0f ? 1.e30f : -1.e30f));
+		}
+
+		// Slab test against the segment's [0, maxTime] range.
+		static bool IntersectBox(const FRideableBVHNode& node, const float origin[3], const float invDir[3], float maxTime, float& tEntryOut)
+		{
+			float tMin = 0.0f;
+			float tMax = maxTime;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				float t0 = (node.Min[axis] - origin[axis]) * invDir[axis];
+				float t1 = (node.Max[axis] - origin[axis]) * invDir[axis];
+				if (t0 > t1)
+					std::swap(t0, t1);
+				tMin = (t0 > tMin ? t0 : tMin);
+				tMax = (t1 < tMax ? t1 : tMax);
+				if (tMin > tMax)
+					return false;
+			}
+			tEntryOut = tMin;
+			return true;
+		}
+
+		// Moller-Trumbore, two-sided.
+		static bool IntersectTriangle(const FRideableBVHTriangle& tri, const FVec3& start, const FVec3& dir, float& tOut)
+		{
+			const FVec3 e1 = LoadVec3(tri.Edge1);
+			const FVec3 e2 = LoadVec3(tri.Edge2);
+			const FVec3 p = Cross(dir, e2);
+			const float det = Dot(e1, p);
+			if (std::fabs(det) < 1.e-12f)
+				return false;
+
+			const float invDet = 1.0f / det;
+			const FVec3 s = start - LoadVec3(tri.V0);
+			const float u = Dot(s, p) * invDet;
+			if (u < 0.0f || u > 1.0f)
+				return false;
+
+			const FVec3 q = Cross(s, e1);
+			const float v = Dot(dir, q) * invDet;
+			if (v < 0.0f || u + v > 1.0f)
+				return false;
+
+			tOut = Dot(e2, q) * invDet;
+			return (tOut >= 0.0f && tOut <= 1.0f);
+		}
+
+		const FRideableBVHHeader* m_Header;
+		const FRideableBVHNode* m_Nodes;
+		const FRideableBVHTriangle* m_Triangles;
+		const uint32_t* m_Sources;
+		const char* m_Data;
+	};
+
+	// Builds a baked blob from a triangle soup.
+	class FRideableBVHBuilder
+	{
+	public:
+		FRideableBVHBuilder() : SourceHash(0) {}
+
+		// Written to the header as is, for the loader to check the level against.
+		uint32_t SourceHash;
+
+		// Add a primitive that triangles can be baked from.  Returns its index, to pass to AddTriangle.
+		uint32_t AddSource(const char* name)
+		{
+			m_SourceNames.push_back(name);
+			return (uint32_t)(m_SourceNames.size() - 1);
+		}
+
+		void AddTriangle(const FVec3& a, const FVec3& b, const FVec3& c, uint32_t source)
+		{
+			FVec3 normal = Cross(b - a, c - a);
+			if (!Normalize(normal))
+				return; // degenerate
+
+			FRideableBVHTriangle tri;
+			StoreVec3(tri.V0, a);
+			StoreVec3(tri.Edge1, b - a);
+			StoreVec3(tri.Edge2, c - a);
+			StoreVec3(tri.Normal, normal);
+			tri.Source = source;
+			m_Triangles.push_back(tri);
+		}
+
+		size_t NumTriangles() const { return m_Triangles.size(); }
+
+		// Build the tree and write the blob.  Returns false if there's nothing to bake.
+		bool Build(std::vector<uint8_t>& blobOut, uint32_t maxLeafTriangles = 4)
+		{
+			if (m_Triangles.empty())
+				return false;
+
+			m_MaxLeafTriangles = (maxLeafTriangles > 0 ? maxLeafTriangles : 1);
+			m_Nodes.clear();
+			m_Order.resize(m_Triangles.size());
+			m_Centroids.resize(m_Triangles.size());
+			for (size_t i = 0; i < m_Triangles.size(); ++i)
+			{
+				m_Order[i] = (uint32_t)i;
+				const FRideableBVHTriangle& tri = m_Triangles[i];
+				const FVec3 v0 = LoadVec3(tri.V0);
+				m_Centroids[i] = v0 + (LoadVec3(tri.Edge1) + LoadVec3(tri.Edge2)) * (1.0f / 3.0f);
+			}
+
+			m_Nodes.push_back(FRideableBVHNode());
+			BuildNode(0, 0, (uint32_t)m_Triangles.size(), 1);
+
+			// Triangles go in leaf order, so each leaf's triangles are contiguous.
+			FRideableBVHHeader header;
+			header.Magic = RideableBVHMagic;
+			header.Version = RideableBVHVersion;
+			header.NumNodes = (uint32_t)m_Nodes.size();
+			header.NumTriangles = (uint32_t)m_Triangles.size();
+			header.NodesOffset = (uint32_t)sizeof(FRideableBVHHeader);
+			header.TrianglesOffset = header.NodesOffset + header.NumNodes * (uint32_t)sizeof(FRideableBVHNode);
+			header.NumSources = (uint32_t)m_SourceNames.size();
+			header.SourcesOffset = header.TrianglesOffset + header.NumTriangles * (uint32_t)sizeof(FRideableBVHTriangle);
+			header.SourceHash = SourceHash;
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				header.BoundsMin[axis] = m_Nodes[0].Min[axis];
+				header.BoundsMax[axis] = m_Nodes[0].Max[axis];
+			}
+
+			uint32_t namesSize = 0;
+			for (size_t i = 0; i < m_SourceNames.size(); ++i)
+			{
+				namesSize += (uint32_t)m_SourceNames[i].size() + 1;
+			}
+
+			const uint32_t namesOffset = header.SourcesOffset + header.NumSources * (uint32_t)sizeof(uint32_t);
+			blobOut.assign(namesOffset + namesSize, 0);
+			memcpy(&blobOut[0], &header, sizeof(header));
+			memcpy(&blobOut[header.NodesOffset], &m_Nodes[0], m_Nodes.size() * sizeof(FRideableBVHNode));
+			FRideableBVHTriangle* trianglesOut = reinterpret_cast<FRideableBVHTriangle*>(&blobOut[header.TrianglesOffset]);
+			for (size_t i = 0; i < m_Order.size(); ++i)
+			{
+				trianglesOut[i] = m_Triangles[m_Order[i]];
+			}
+			uint32_t* sourcesOut = reinterpret_cast<uint32_t*>(&blobOut[header.SourcesOffset]);
+			uint32_t nameOffset = namesOffset;
+			for (size_t i = 0; i < m_SourceNames.size(); ++i)
+			{
+				sourcesOut[i] = nameOffset;
+				memcpy(&blobOut[nameOffset], m_SourceNames[i].c_str(), m_SourceNames[i].size());
+				nameOffset += (uint32_t)m_SourceNames[i].size() + 1;
+			}
+			return true;
+		}
+
+	private:
+		static void StoreVec3(float* f, const FVec3& v) { f[0] = v.X; f[1] = v.Y; f[2] = v.Z; }
+
+		void ComputeBounds(uint32_t first, uint32_t count, FRideableBVHNode& node) const
+		{
+			for (int axis = 0; axis < 3; ++axis)
+			{
+				node.Min[axis] = 1.e30f;
+				node.Max[axis] = -1.e30f;
+			}
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const FRideableBVHTriangle& tri = m_Triangles[m_Order[i]];
+				const FVec3 v0 = LoadVec3(tri.V0);
+				const FVec3 verts[3] = { v0, v0 + LoadVec3(tri.Edge1), v0 + LoadVec3(tri.Edge2) };
+				for (int v = 0; v < 3; ++v)
+				{
+					const float p[3] = { verts[v].X, verts[v].Y, verts[v].Z };
+					for (int axis = 0; axis < 3; ++axis)
+					{
+						node.Min[axis] = std::min(node.Min[axis], p[axis]);
+						node.Max[axis] = std::max(node.Max[axis], p[axis]);
+					}
+				}
+			}
+		}
+
+		// Median split along the longest axis of the centroid bounds.
+		void BuildNode(uint32_t nodeIndex, uint32_t first, uint32_t count, int depth)
+		{
+			FRideableBVHNode node;
+			ComputeBounds(first, count, node);
+
+			if (count <= m_MaxLeafTriangles || depth >= FRideableBVHView::MaxDepth - 2)
+			{
+				node.First = first;
+				node.Count = count;
+				m_Nodes[nodeIndex] = node;
+				return;
+			}
+
+			float cMin[3] = { 1.e30f, 1.e30f, 1.e30f };
+			float cMax[3] = { -1.e30f, -1.e30f, -1.e30f };
+			for (uint32_t i = first; i < first + count; ++i)
+			{
+				const FVec3& c = m_Centroids[m_Order[i]];
+				const float p[3] = { c.X, c.Y, c.Z };
+				for (int axis = 0; axis < 3; ++axis)
+				{
+					cMin[axis] = std::min(cMin[axis], p[axis]);
+					cMax[axis] = std::max(cMax[axis], p[axis]);
+				}
+			}
+			int splitAxis = 0;
+			for (int axis = 1; axis < 3; ++axis)
+			{
+				if (cMax[axis] - cMin[axis] > cMax[splitAxis] - cMin[splitAxis])
+					splitAxis = axis;
+			}
+
+			const uint32_t half = count / 2;
+			const std::vector<FVec3>& centroids = m_Centroids;
+			std::nth_element(m_Order.begin() + first, m_Order.begin() + first + half, m_Order.begin() + first + count,
+				[&centroids, splitAxis](uint32_t a, uint32_t b)
+				{
+					const float* ca = &centroids[a].X;
+					const float* cb = &centroids[b].X;
+					return ca[splitAxis] < cb[splitAxis];
+				});
+
+			const uint32_t leftIndex = (uint32_t)m_Nodes.size();
+			m_Nodes.push_back(FRideableBVHNode());
+			m_Nodes.push_back(FRideableBVHNode());
+
+			node.First = leftIndex;
+			node.Count = 0;
+			m_Nodes[nodeIndex] = node;
+
+			BuildNode(leftIndex, first, half, depth + 1);
+			BuildNode(leftIndex + 1, first + half, count - half, depth + 1);
+		}
+
+		std::vector<FRideableBVHTriangle> m_Triangles;
+		std::vector<std::string> m_SourceNames;
+		std::vector<FRideableBVHNode> m_Nodes;
+		std::vector<uint32_t> m_Order;
+		std::vector<FVec3> m_Centroids;
+		uint32_t m_MaxLeafTriangles;
+	};
+}
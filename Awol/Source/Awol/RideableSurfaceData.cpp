@@ -0,0 +1,399 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "RideableSurfaceData.h"
+#include "SkateboardSimCoreConversions.h"
+
+#include "Components/InstancedStaticMeshComponent.h"
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "HideWindowsPlatformTypes.h"
+#define RIDEABLE_MMAP_WINDOWS 1
+#elif PLATFORM_LINUX || PLATFORM_MAC
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <fcntl.h>
+#include <unistd.h>
+#define RIDEABLE_MMAP_POSIX 1
+#endif
+
+
+// Would UGroundStateComponent::ProbeRideable() hit this, and will it never move?
+static bool IsBakeableRideable(const UPrimitiveComponent* comp)
+{
+	return (comp->Mobility == EComponentMobility::Static
+		&& comp->IsQueryCollisionEnabled()
+		&& comp->GetCollisionResponseToChannel(ECC_WorldStatic) == ECR_Block);
+}
+
+// What the bake calls a primitive.  The same in the editor, in play in editor and in a cooked build.
+static FString GetRideableSourceName(const UPrimitiveComponent* comp)
+{
+	return UWorld::RemovePIEPrefix(comp->GetPathName());
+}
+
+static uint32 HashVector(const FVector& v, float scale, uint32 crc)
+{
+	// Quantized, so float noise between the editor and a cooked build doesn't count as a change.
+	const int32 quantized[3] = { FMath::RoundToInt(v.X * scale), FMath::RoundToInt(v.Y * scale), FMath::RoundToInt(v.Z * scale) };
+	return FCrc::MemCrc32(quantized, sizeof(quantized), crc);
+}
+
+// Hash of everything about a primitive that would change its baked triangles: its name, mesh, placement and bounds.
+static uint32 HashRideableSource(const UPrimitiveComponent* comp)
+{
+	uint32 crc = FCrc::StrCrc32(*GetRideableSourceName(comp));
+	const FTransform& transform = comp->GetComponentTransform();
+	crc = HashVector(transform.GetLocation(), 10.0f, crc);
+	crc = HashVector(transform.Rotator().Euler(), 100.0f, crc);
+	crc = HashVector(transform.GetScale3D(), 1000.0f, crc);
+	crc = HashVector(comp->Bounds.Origin, 10.0f, crc);
+	crc = HashVector(comp->Bounds.BoxExtent, 10.0f, crc);
+
+	if (const UStaticMeshComponent* staticMesh = Cast<UStaticMeshComponent>(comp))
+	{
+		if (staticMesh->StaticMesh != nullptr)
+			crc = FCrc::StrCrc32(*staticMesh->StaticMesh->GetPathName(), crc);
+	}
+	if (const UInstancedStaticMeshComponent* instanced = Cast<UInstancedStaticMeshComponent>(comp))
+	{
+		const int32 numInstances = instanced->GetInstanceCount();
+		crc = FCrc::MemCrc32(&numInstances, sizeof(numInstances), crc);
+	}
+	return crc;
+}
+
+// Combine the primitives' hashes so the order they're found in doesn't matter.
+static uint32 CombineRideableSourceHash(uint32 hash, const UPrimitiveComponent* comp)
+{
+	return hash + HashRideableSource(comp);
+}
+
+
+FRideableSurfaceData::FRideableSurfaceData()
+	: m_MappedData(nullptr)
+	, m_MappedSize(0)
+	, m_FileHandle(nullptr)
+	, m_MappingHandle(nullptr)
+{
+}
+
+FRideableSurfaceData::~FRideableSurfaceData()
+{
+	Unload();
+}
+
+bool FRideableSurfaceData::Load(const FString& path, UWorld* world)
+{
+	Unload();
+
+	const FString fullPath = FPaths::ConvertRelativePathToFull(path);
+
+#if RIDEABLE_MMAP_WINDOWS
+	HANDLE file = CreateFileW(*fullPath, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr);
+	if (file != INVALID_HANDLE_VALUE)
+	{
+		LARGE_INTEGER size;
+		HANDLE mapping = (GetFileSizeEx(file, &size) && size.QuadPart > 0) ? CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr) : nullptr;
+		const void* view = (mapping != nullptr) ? MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0) : nullptr;
+		if (view != nullptr)
+		{
+			m_MappedData = view;
+			m_MappedSize = size.QuadPart;
+			m_FileHandle = file;
+			m_MappingHandle = mapping;
+		}
+		else
+		{
+			if (mapping != nullptr)
+				CloseHandle(mapping);
+			CloseHandle(file);
+		}
+	}
+#elif RIDEABLE_MMAP_POSIX
+	int fd = open(TCHAR_TO_UTF8(*fullPath), O_RDONLY);
+	if (fd >= 0)
+	{
+		struct stat st;
+		if (fstat(fd, &st) == 0 && st.st_size > 0)
+		{
+			void* view = mmap(nullptr, st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+			if (view != MAP_FAILED)
+			{
+				m_MappedData = view;
+				m_MappedSize = st.st_size;
+			}
+		}
+		// The mapping keeps the file alive.
+		close(fd);
+	}
+#endif
+
+	const void* data = m_MappedData;
+	int64 size = m_MappedSize;
+	if (data == nullptr)
+	{
+		// No mapping on this platform, or the file is inside a pak; read it instead.
+		if (!FFileHelper::LoadFileToArray(m_FileData, *path, FILEREAD_Silent))
+			return false;
+		data = m_FileData.GetData();
+		size = m_FileData.Num();
+	}
+
+	if (!m_BVH.Init(data, (size_t)size))
+	{
+		UE_LOG(LogSkateboardSim, Warning, TEXT("Ignoring baked rideable surfaces in %s: bad header or version (expected version %u).  Re-bake with skate.BakeRideableSurfaces."),
+			*path, SkateSim::RideableBVHVersion);
+		Unload();
+		return false;
+	}
+
+	// Check the level hasn't changed since the bake, and find the primitives it was baked from.
+	uint32 sourceHash = 0;
+	TMap<FString, UPrimitiveComponent*> components;
+	for (TActorIterator<AActor> it(world); it; ++it)
+	{
+		TInlineComponentArray<UPrimitiveComponent*> actorComponents;
+		it->GetComponents(actorComponents);
+		for (UPrimitiveComponent* comp : actorComponents)
+		{
+			if (!comp->IsRegistered() || !IsBakeableRideable(comp))
+				continue;
+
+			sourceHash = CombineRideableSourceHash(sourceHash, comp);
+			components.Add(GetRideableSourceName(comp), comp);
+		}
+	}
+
+	if (sourceHash != m_BVH.GetSourceHash())
+	{
+		UE_LOG(LogSkateboardSim, Warning, TEXT("Ignoring baked rideable surfaces in %s: the level's static geometry has changed since they were baked.  Re-bake with skate.BakeRideableSurfaces."),
+			*path);
+		Unload();
+		return false;
+	}
+
+	m_Sources.SetNum(m_BVH.NumSources());
+	for (uint32 i = 0; i < m_BVH.NumSources(); ++i)
+	{
+		UPrimitiveComponent* const* comp = components.Find(UTF8_TO_TCHAR(m_BVH.GetSourceName(i)));
+		if (comp != nullptr)
+		{
+			const FBodyInstance* bodyInstance = (*comp)->GetBodyInstance();
+			m_Sources[i].Component = *comp;
+			m_Sources[i].Actor = (*comp)->GetOwner();
+			m_Sources[i].PhysMaterial = (bodyInstance != nullptr ? bodyInstance->GetSimplePhysicalMaterial() : nullptr);
+		}
+	}
+
+	UE_LOG(LogSkateboardSim, Log, TEXT("Loaded %u baked rideable triangles from %s (%s)"), m_BVH.NumTriangles(), *path, (m_MappedData != nullptr ? TEXT("mapped") : TEXT("read")));
+	return true;
+}
+
+void FRideableSurfaceData::MakeHitResult(const SkateSim::FRideableHit& bakedHit, const FVector& start, const FVector& end, FHitResult& hitOut) const
+{
+	hitOut = FHitResult(start, end);
+	hitOut.bBlockingHit = true;
+	hitOut.Time = bakedHit.Time;
+	hitOut.Distance = FVector::Dist(start, end) * bakedHit.Time;
+	hitOut.Location = SkateSim::FromSim(bakedHit.Position);
+	hitOut.ImpactPoint = hitOut.Location;
+	hitOut.Normal = SkateSim::FromSim(bakedHit.Normal);
+	hitOut.ImpactNormal = hitOut.Normal;
+	hitOut.FaceIndex = (int32)bakedHit.Triangle;
+
+	const FSource& source = m_Sources[bakedHit.Source];
+	hitOut.Component = source.Component;
+	hitOut.Actor = source.Actor;
+	hitOut.PhysMaterial = source.PhysMaterial;
+}
+
+void FRideableSurfaceData::Unload()
+{
+	m_BVH = SkateSim::FRideableBVHView();
+	m_Sources.Empty();
+
+#if RIDEABLE_MMAP_WINDOWS
+	if (m_MappedData != nullptr)
+	{
+		UnmapViewOfFile(m_MappedData);
+		CloseHandle((HANDLE)m_MappingHandle);
+		CloseHandle((HANDLE)m_FileHandle);
+	}
+#elif RIDEABLE_MMAP_POSIX
+	if (m_MappedData != nullptr)
+	{
+		munmap(const_cast<void*>(m_MappedData), (size_t)m_MappedSize);
+	}
+#endif
+
+	m_MappedData = nullptr;
+	m_MappedSize = 0;
+	m_FileHandle = nullptr;
+	m_MappingHandle = nullptr;
+	m_FileData.Empty();
+}
+
+FString FRideableSurfaceData::GetPathForWorld(const UWorld* world)
+{
+	FString mapName = UWorld::RemovePIEPrefix(world->GetMapName());
+	return FPaths::GameContentDir() / TEXT("Rideable") / (mapName + TEXT(".rsbvh"));
+}
+
+#if WITH_EDITOR
+
+// Distance between heightfield samples for primitives that aren't static meshes.
+static const float HeightfieldSampleSpacing = 50.0f;
+static const int32 HeightfieldMaxSamplesPerAxis = 4096;
+
+static void AddStaticMeshTriangles(SkateSim::FRideableBVHBuilder& builder, const UStaticMesh* mesh, const FTransform& transform, uint32 source)
+{
+	if (mesh == nullptr || mesh->RenderData == nullptr || mesh->RenderData->LODResources.Num() == 0)
+		return;
+
+	const FStaticMeshLODResources& lod = mesh->RenderData->LODResources[0];
+	const FPositionVertexBuffer& positions = lod.PositionVertexBuffer;
+	FIndexArrayView indices = lod.IndexBuffer.GetArrayView();
+	for (int32 i = 0; i + 2 < indices.Num(); i += 3)
+	{
+		builder.AddTriangle(
+			SkateSim::ToSim(transform.TransformPosition(positions.VertexPosition(indices[i]))),
+			SkateSim::ToSim(transform.TransformPosition(positions.VertexPosition(indices[i + 1]))),
+			SkateSim::ToSim(transform.TransformPosition(positions.VertexPosition(indices[i + 2]))),
+			source);
+	}
+}
+
+// Trace straight down onto just this primitive over a grid covering its bounds, and triangulate the cells whose
+// four corners all hit.  Good enough for landscape; overhangs are lost.
+static void AddSampledHeightfield(SkateSim::FRideableBVHBuilder& builder, UPrimitiveComponent* comp, uint32 source)
+{
+	const FBox bounds = comp->Bounds.GetBox();
+	const int32 numX = FMath::Clamp(FMath::CeilToInt((bounds.Max.X - bounds.Min.X) / HeightfieldSampleSpacing) + 1, 2, HeightfieldMaxSamplesPerAxis);
+	const int32 numY = FMath::Clamp(FMath::CeilToInt((bounds.Max.Y - bounds.Min.Y) / HeightfieldSampleSpacing) + 1, 2, HeightfieldMaxSamplesPerAxis);
+	const float stepX = (bounds.Max.X - bounds.Min.X) / (numX - 1);
+	const float stepY = (bounds.Max.Y - bounds.Min.Y) / (numY - 1);
+
+	TArray<FVector> samples;
+	TArray<bool> sampleHit;
+	samples.SetNumUninitialized(numX * numY);
+	sampleHit.SetNumUninitialized(numX * numY);
+
+	FCollisionQueryParams cqp(FName(TEXT("RideableBake")), true);
+	for (int32 y = 0; y < numY; ++y)
+	{
+		for (int32 x = 0; x < numX; ++x)
+		{
+			const float px = bounds.Min.X + x * stepX;
+			const float py = bounds.Min.Y + y * stepY;
+			FHitResult hit;
+			const int32 index = y * numX + x;
+			sampleHit[index] = comp->LineTraceComponent(hit, FVector(px, py, bounds.Max.Z + 10.0f), FVector(px, py, bounds.Min.Z - 10.0f), cqp);
+			samples[index] = hit.ImpactPoint;
+		}
+	}
+
+	for (int32 y = 0; y + 1 < numY; ++y)
+	{
+		for (int32 x = 0; x + 1 < numX; ++x)
+		{
+			const int32 i00 = y * numX + x;
+			const int32 i10 = i00 + 1;
+			const int32 i01 = i00 + numX;
+			const int32 i11 = i01 + 1;
+			if (!sampleHit[i00] || !sampleHit[i10] || !sampleHit[i01] || !sampleHit[i11])
+				continue;
+
+			builder.AddTriangle(SkateSim::ToSim(samples[i00]), SkateSim::ToSim(samples[i10]), SkateSim::ToSim(samples[i11]), source);
+			builder.AddTriangle(SkateSim::ToSim(samples[i00]), SkateSim::ToSim(samples[i11]), SkateSim::ToSim(samples[i01]), source);
+		}
+	}
+}
+
+bool FRideableSurfaceData::BakeWorld(UWorld* world, const FString& path, FString& errorOut)
+{
+	if (world == nullptr)
+	{
+		errorOut = TEXT("No world");
+		return false;
+	}
+
+	SkateSim::FRideableBVHBuilder builder;
+	int32 numMeshes = 0;
+	int32 numHeightfields = 0;
+
+	for (TActorIterator<AActor> it(world); it; ++it)
+	{
+		TInlineComponentArray<UPrimitiveComponent*> components;
+		it->GetComponents(components);
+		for (UPrimitiveComponent* comp : components)
+		{
+			if (!comp->IsRegistered() || !IsBakeableRideable(comp))
+				continue;
+
+			// Every bakeable primitive counts toward the hash, whether it gives us triangles or not, as Load() sees it.
+			builder.SourceHash = CombineRideableSourceHash(builder.SourceHash, comp);
+			const uint32 source = builder.AddSource(TCHAR_TO_UTF8(*GetRideableSourceName(comp)));
+
+			if (UInstancedStaticMeshComponent* instanced = Cast<UInstancedStaticMeshComponent>(comp))
+			{
+				for (int32 i = 0; i < instanced->GetInstanceCount(); ++i)
+				{
+					FTransform instanceTransform;
+					if (instanced->GetInstanceTransform(i, instanceTransform, true))
+					{
+						AddStaticMeshTriangles(builder, instanced->StaticMesh, instanceTransform, source);
+						++numMeshes;
+					}
+				}
+			}
+			else if (UStaticMeshComponent* staticMesh = Cast<UStaticMeshComponent>(comp))
+			{
+				AddStaticMeshTriangles(builder, staticMesh->StaticMesh, staticMesh->GetComponentTransform(), source);
+				++numMeshes;
+			}
+			else if (comp->GetBodySetup() != nullptr)
+			{
+				AddSampledHeightfield(builder, comp, source);
+				++numHeightfields;
+			}
+		}
+	}
+
+	std::vector<uint8_t> blob;
+	if (!builder.Build(blob))
+	{
+		errorOut = TEXT("No static rideable geometry found");
+		return false;
+	}
+
+	TArray<uint8> fileData;
+	fileData.Append(&blob[0], (int32)blob.size());
+	if (!FFileHelper::SaveArrayToFile(fileData, *path))
+	{
+		errorOut = FString::Printf(TEXT("Couldn't write %s"), *path);
+		return false;
+	}
+
+	UE_LOG(LogSkateboardSim, Display, TEXT("Baked %d triangles from %d meshes and %d sampled heightfields to %s (%d bytes)"),
+		(int32)builder.NumTriangles(), numMeshes, numHeightfields, *path, fileData.Num());
+	return true;
+}
+
+static void BakeRideableSurfacesForWorld(UWorld* world)
+{
+	FString error;
+	if (!FRideableSurfaceData::BakeWorld(world, FRideableSurfaceData::GetPathForWorld(world), error))
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("skate.BakeRideableSurfaces failed: %s"), *error);
+	}
+}
+
+static FAutoConsoleCommandWithWorld BakeRideableSurfacesCommand(
+	TEXT("skate.BakeRideableSurfaces"),
+	TEXT("Bake the current level's static rideable geometry to Content/Rideable/<MapName>.rsbvh, for lock-free ground probes."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&BakeRideableSurfacesForWorld));
+
+#endif
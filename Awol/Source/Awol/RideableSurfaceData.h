@@ -0,0 +1,80 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "RideableSurfaceBVH.h"
+
+/**
+* A level's baked rideable surfaces, memory-mapped from Content/Rideable/<MapName>.rsbvh.
+*
+* The file is written at edit time by the skate.BakeRideableSurfaces console command or the RideableBake commandlet,
+* and staged loose (see DirectoriesToAlwaysStageAsNonUFS in DefaultGame.ini) so it can be mapped straight from disk
+* in cooked builds.  If mapping isn't available on a platform the file is read into memory instead.
+*
+* Once loaded the data is immutable, so ground probes can query it from any thread without taking the physics
+* scene lock.  Only static geometry is baked; anything movable still has to be traced through PhysX.
+*
+* The bake records each primitive it took triangles from, and a hash of their names, meshes and placements.  Load()
+* checks that hash against the level as it is now, and ignores a stale bake (so probes fall back to PhysX) rather than
+* have boards ride geometry that has moved.  It also finds each of those primitives again, so a baked hit can carry
+* its component, actor and physical material like a PhysX one.
+*
+* @see UGroundStateComponent::ProbeRideable
+*/
+class AWOL_API FRideableSurfaceData
+{
+public:
+	FRideableSurfaceData();
+	~FRideableSurfaceData();
+
+	// Where a baked triangle came from.
+	struct FSource
+	{
+		TWeakObjectPtr<UPrimitiveComponent> Component;
+		TWeakObjectPtr<AActor> Actor;
+		TWeakObjectPtr<UPhysicalMaterial> PhysMaterial;	// The component's simple collision material
+	};
+
+	// Map the given file, baked from the given world.  Returns false (and leaves us empty) if it's missing, truncated,
+	// an old version, or out of date with the world.
+	bool Load(const FString& path, UWorld* world);
+
+	// Release the mapping.
+	void Unload();
+
+	bool IsLoaded() const { return m_BVH.IsValid(); }
+
+	const SkateSim::FRideableBVHView& GetBVH() const { return m_BVH; }
+
+	// The primitive behind a hit's Source.  Its pointers are null if it's since been destroyed.
+	const FSource& GetSource(uint32 source) const { return m_Sources[source]; }
+
+	// Fill in a hit result from a baked hit along the segment from start to end.
+	void MakeHitResult(const SkateSim::FRideableHit& bakedHit, const FVector& start, const FVector& end, FHitResult& hitOut) const;
+
+	// Where the baked surfaces for the given world live.
+	static FString GetPathForWorld(const UWorld* world);
+
+#if WITH_EDITOR
+	// Gather every static, world-static-blocking primitive in the world and write its triangles to the given path.
+	// Static meshes contribute their LOD 0 triangles; anything else (e.g. landscape) is sampled into a heightfield
+	// with traces against just that primitive.  Returns false and fills in errorOut on failure.
+	static bool BakeWorld(UWorld* world, const FString& path, FString& errorOut);
+#endif
+
+private:
+	FRideableSurfaceData(const FRideableSurfaceData&);
+	FRideableSurfaceData& operator=(const FRideableSurfaceData&);
+
+	SkateSim::FRideableBVHView m_BVH;
+	TArray<FSource> m_Sources;
+
+	// Either a platform mapping...
+	const void* m_MappedData;
+	int64 m_MappedSize;
+	void* m_FileHandle;
+	void* m_MappingHandle;
+
+	// ...or, if mapping isn't supported, a plain copy of the file.
+	TArray<uint8> m_FileData;
+};
@@ -0,0 +1,516 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "SkateboardBenchCommandlet.h"
+#include "SkateboardSimPawn.h"
+#include "SkateboardBotSpawner.h"
+#include "SkateboardLoadout.h"
+#include "SkateboardSimProfiler.h"
+#include "Json.h"
+
+#if PLATFORM_WINDOWS
+#include "AllowWindowsPlatformTypes.h"
+#include <windows.h>
+#include "HideWindowsPlatformTypes.h"
+#elif PLATFORM_LINUX || PLATFORM_MAC
+#include <time.h>
+#endif
+
+namespace
+{
+	// CPU time used by the calling thread, so time spent blocked waiting on physics or workers isn't counted.
+	double GetThreadCPUSeconds()
+	{
+#if PLATFORM_WINDOWS
+		FILETIME creationTime, exitTime, kernelTime, userTime;
+		if (GetThreadTimes(GetCurrentThread(), &creationTime, &exitTime, &kernelTime, &userTime))
+		{
+			const uint64 kernel = ((uint64)kernelTime.dwHighDateTime << 32) | kernelTime.dwLowDateTime;
+			const uint64 user = ((uint64)userTime.dwHighDateTime << 32) | userTime.dwLowDateTime;
+			return (kernel + user) * 1.e-7;
+		}
+		return FPlatformTime::Seconds();
+#elif PLATFORM_LINUX || PLATFORM_MAC
+		timespec ts;
+		clock_gettime(CLOCK_THREAD_CPUTIME_ID, &ts);
+		return ts.tv_sec + ts.tv_nsec * 1.e-9;
+#else
+		return FPlatformTime::Seconds();
+#endif
+	}
+
+	// Nearest-rank percentile of an already sorted array.
+	double Percentile(const TArray<double>& sorted, double percent)
+	{
+		if (sorted.Num() == 0)
+			return 0.0;
+		const int32 rank = FMath::Clamp(FMath::CeilToInt(percent * 0.01 * sorted.Num()) - 1, 0, sorted.Num() - 1);
+		return sorted[rank];
+	}
+
+	TSharedPtr<FJsonObject> MakeDistribution(TArray<double> samples)
+	{
+		samples.Sort();
+		double sum = 0.0;
+		for (double sample : samples)
+		{
+			sum += sample;
+		}
+
+		TSharedPtr<FJsonObject> dist = MakeShareable(new FJsonObject);
+		dist->SetNumberField(TEXT("mean"), samples.Num() > 0 ? sum / samples.Num() : 0.0);
+		dist->SetNumberField(TEXT("p50"), Percentile(samples, 50.0));
+		dist->SetNumberField(TEXT("p90"), Percentile(samples, 90.0));
+		dist->SetNumberField(TEXT("p99"), Percentile(samples, 99.0));
+		dist->SetNumberField(TEXT("max"), samples.Num() > 0 ? samples.Last() : 0.0);
+		return dist;
+	}
+
+	// Seeded stick input for one board: throttle held for a random stretch of frames, with a sinusoidal carve on top.
+	struct FBoardScript
+	{
+		FRandomStream Stream;
+		int32 FramesLeft;
+		float Forward;
+		float SteerAmplitude;
+		float SteerPeriodFrames;
+		float SteerPhase;
+
+		void Init(int32 seed)
+		{
+			Stream.Initialize(seed);
+			FramesLeft = 0;
+		}
+
+		void Next(int32 frame, float& forwardOut, float& rightOut)
+		{
+			if (FramesLeft <= 0)
+			{
+				FramesLeft = Stream.RandRange(30, 120);
+				const float roll = Stream.FRand();
+				Forward = (roll < 0.7f ? 1.0f : (roll < 0.85f ? 0.5f : (roll < 0.95f ? 0.0f : -0.5f)));
+				SteerAmplitude = Stream.FRand();
+				SteerPeriodFrames = Stream.FRandRange(60.0f, 240.0f);
+				SteerPhase = Stream.FRandRange(0.0f, 2.0f * PI);
+			}
+			--FramesLeft;
+
+			forwardOut = Forward;
+			rightOut = SteerAmplitude * FMath::Sin(SteerPhase + 2.0f * PI * frame / SteerPeriodFrames);
+		}
+	};
+}
+
+
+USkateboardBenchCommandlet::USkateboardBenchCommandlet()
+{
+	IsClient = false;
+	IsServer = false;
+	IsEditor = true;
+	LogToConsole = true;
+
+	m_PawnClass = nullptr;
+	m_Frames = 1200;
+	m_WarmupFrames = 60;
+	m_DeltaTime = 1.0f / 60.0f;
+	m_Seed = 1;
+	m_DriveBots = false;
+	m_BotWanderRadius = 5000.0f;
+}
+
+int32 USkateboardBenchCommandlet::Main(const FString& Params)
+{
+	FString boardsList = TEXT("1,4,16,64,256");
+	FString level = TEXT("flat");
+	FString mapName = TEXT("/Game/AWOL/SkateboardTestFiles/testMap");
+	FString pawnClassName;
+	FString movement = TEXT("physics");
+	FString drive = TEXT("script");
+	FString outPath = FPaths::ProfilingDir() / TEXT("SkateboardBench") / FString::Printf(TEXT("SkateboardBench-%s.json"), *FDateTime::Now().ToString());
+
+	FParse::Value(*Params, TEXT("-boards="), boardsList);
+	FParse::Value(*Params, TEXT("-level="), level);
+	FParse::Value(*Params, TEXT("-map="), mapName);
+	FParse::Value(*Params, TEXT("-pawnclass="), pawnClassName);
+	FParse::Value(*Params, TEXT("-out="), outPath);
+	FParse::Value(*Params, TEXT("-frames="), m_Frames);
+	FParse::Value(*Params, TEXT("-warmup="), m_WarmupFrames);
+	FParse::Value(*Params, TEXT("-dt="), m_DeltaTime);
+	FParse::Value(*Params, TEXT("-seed="), m_Seed);
+	FParse::Value(*Params, TEXT("-movement="), movement);
+	FParse::Value(*Params, TEXT("-drive="), drive);
+	FParse::Value(*Params, TEXT("-botradius="), m_BotWanderRadius);
+	m_DriveBots = (drive == TEXT("bots"));
+
+	const bool ridePhysics = (movement == TEXT("physics") || movement == TEXT("both"));
+	const bool rideKinematic = (movement == TEXT("kinematic") || movement == TEXT("both"));
+
+	m_PawnClass = ASkateboardSimPawn::StaticClass();
+	if (!pawnClassName.IsEmpty())
+	{
+		m_PawnClass = LoadClass<ASkateboardSimPawn>(nullptr, *pawnClassName);
+		if (m_PawnClass == nullptr)
+		{
+			UE_LOG(LogSkateboardSim, Error, TEXT("Couldn't load pawn class %s"), *pawnClassName);
+			return 1;
+		}
+	}
+
+	TArray<FString> boardCounts;
+	boardsList.ParseIntoArray(boardCounts, TEXT(","), true);
+	if (boardCounts.Num() == 0 || m_Frames <= 0 || m_DeltaTime <= 0.0f || !(ridePhysics || rideKinematic) || !(m_DriveBots || drive == TEXT("script")))
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("Usage: -run=SkateboardBench [-boards=1,4,16] [-frames=N] [-warmup=N] [-dt=S] [-seed=N] [-level=flat|ramps|map] [-map=Package] [-pawnclass=Path] [-movement=physics|kinematic|both] [-drive=script|bots] [-botradius=cm] [-out=File.json]"));
+		return 1;
+	}
+
+	UWorld* world = CreateBenchWorld(level, mapName);
+	if (world == nullptr)
+		return 1;
+
+	// Boards wait for their loadout's assets before riding, and nothing streams them in while we tick the world by
+	// hand, so load them up front.  This is only the load itself; the cold start, from process start to the first
+	// board riding, is recorded as coldStartToFirstBoardMs once the boards are spawned.
+	const double assetLoadStart = FPlatformTime::Seconds();
+	USkateboardLoadout::PreloadDefaults();
+	m_PawnClass->GetDefaultObject<ASkateboardSimPawn>()->GetLoadout()->RequestLoad(FStreamableDelegate());
+	FlushAsyncLoading();
+	const double boardAssetLoadMs = (FPlatformTime::Seconds() - assetLoadStart) * 1000.0;
+	UE_LOG(LogSkateboardSim, Display, TEXT("Board assets loaded in %.1fms"), boardAssetLoadMs);
+
+	// The per-phase numbers come from the profiler, which only accumulates while capturing.
+	IConsoleVariable* profileCsv = IConsoleManager::Get().FindConsoleVariable(TEXT("skate.ProfileCsv"));
+	if (profileCsv != nullptr)
+	{
+		profileCsv->Set(TEXT("1"));
+	}
+
+	TArray<TSharedPtr<FJsonValue>> runs;
+	bool succeeded = true;
+	for (const FString& count : boardCounts)
+	{
+		const int32 numBoards = FCString::Atoi(*count);
+		TArray<FVector> physicsPositions;
+		TArray<FVector> kinematicPositions;
+		if (ridePhysics)
+		{
+			succeeded &= RunBoards(world, numBoards, false, runs, physicsPositions);
+		}
+		if (rideKinematic)
+		{
+			succeeded &= RunBoards(world, numBoards, true, runs, kinematicPositions);
+		}
+
+		// Same spawn points and inputs both ways, so any difference in where the boards ended up is down to how
+		// they were moved.
+		if (physicsPositions.Num() > 0 && physicsPositions.Num() == kinematicPositions.Num())
+		{
+			TArray<double> divergence;
+			for (int32 i = 0; i < physicsPositions.Num(); ++i)
+			{
+				divergence.Add(FVector::Dist(physicsPositions[i], kinematicPositions[i]));
+			}
+			TSharedPtr<FJsonObject> divergenceDist = MakeDistribution(divergence);
+			runs.Last()->AsObject()->SetObjectField(TEXT("finalPositionDivergenceCm"), divergenceDist);
+
+			UE_LOG(LogSkateboardSim, Display, TEXT("%4d boards: kinematic finished %.1f cm from physics on average (max %.1f cm)"),
+				numBoards, divergenceDist->GetNumberField(TEXT("mean")), divergenceDist->GetNumberField(TEXT("max")));
+		}
+	}
+
+	if (profileCsv != nullptr)
+	{
+		profileCsv->Set(TEXT("0"));
+	}
+	FSkateboardSimProfiler::Get().StopCapture();
+
+	DestroyBenchWorld(world);
+
+	TSharedPtr<FJsonObject> root = MakeShareable(new FJsonObject);
+	root->SetStringField(TEXT("level"), level == TEXT("map") ? mapName : level);
+	root->SetStringField(TEXT("pawnClass"), m_PawnClass->GetPathName());
+	root->SetNumberField(TEXT("frames"), m_Frames);
+	root->SetNumberField(TEXT("warmupFrames"), m_WarmupFrames);
+	root->SetNumberField(TEXT("deltaTime"), m_DeltaTime);
+	root->SetNumberField(TEXT("seed"), m_Seed);
+	root->SetStringField(TEXT("movement"), movement);
+	root->SetStringField(TEXT("drive"), drive);
+	root->SetNumberField(TEXT("boardAssetLoadMs"), boardAssetLoadMs);
+	const double firstBoardReadyTime = ASkateboardSimPawn::GetFirstBoardReadyTime();
+	if (firstBoardReadyTime >= 0.0)
+	{
+		root->SetNumberField(TEXT("coldStartToFirstBoardMs"), firstBoardReadyTime * 1000.0);
+		UE_LOG(LogSkateboardSim, Display, TEXT("First board ready %.1fms after process start"), firstBoardReadyTime * 1000.0);
+	}
+	root->SetStringField(TEXT("platform"), FPlatformProperties::IniPlatformName());
+	root->SetStringField(TEXT("buildConfiguration"), EBuildConfigurations::ToString(FApp::GetBuildConfiguration()));
+	root->SetArrayField(TEXT("runs"), runs);
+
+	FString json;
+	TSharedRef<TJsonWriter<>> writer = TJsonWriterFactory<>::Create(&json);
+	FJsonSerializer::Serialize(root.ToSharedRef(), writer);
+	if (!FFileHelper::SaveStringToFile(json, *outPath))
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("Couldn't write %s"), *outPath);
+		return 1;
+	}
+
+	UE_LOG(LogSkateboardSim, Display, TEXT("Wrote %s"), *outPath);
+	return (succeeded ? 0 : 1);
+}
+
+UWorld* USkateboardBenchCommandlet::CreateBenchWorld(const FString& level, const FString& mapName)
+{
+	UWorld* world = nullptr;
+	if (level == TEXT("map"))
+	{
+		UPackage* package = LoadPackage(nullptr, *mapName, LOAD_None);
+		world = (package != nullptr ? UWorld::FindWorldInPackage(package) : nullptr);
+		if (world == nullptr)
+		{
+			UE_LOG(LogSkateboardSim, Error, TEXT("Couldn't load map %s"), *mapName);
+			return nullptr;
+		}
+		world->WorldType = EWorldType::Game;
+		world->InitWorld();
+	}
+	else if (level == TEXT("flat") || level == TEXT("ramps"))
+	{
+		world = UWorld::CreateWorld(EWorldType::Game, false);
+	}
+	else
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("Unknown -level=%s (expected flat, ramps or map)"), *level);
+		return nullptr;
+	}
+
+	world->AddToRoot();
+	FWorldContext& context = GEngine->CreateNewWorldContext(EWorldType::Game);
+	context.SetCurrentWorld(world);
+
+	if (level != TEXT("map"))
+	{
+		BuildGeneratedLevel(world, level == TEXT("ramps"));
+	}
+
+	// No game mode: nobody needs possessing, and we drive the pawns' inputs ourselves.
+	world->InitializeActorsForPlay(FURL());
+	world->GetWorldSettings()->NotifyBeginPlay();
+	return world;
+}
+
+void USkateboardBenchCommandlet::DestroyBenchWorld(UWorld* world)
+{
+	world->DestroyWorld(false);
+	GEngine->DestroyWorldContext(world);
+	world->RemoveFromRoot();
+	CollectGarbage(RF_NoFlags);
+}
+
+void USkateboardBenchCommandlet::BuildGeneratedLevel(UWorld* world, bool ramps)
+{
+	UStaticMesh* cube = LoadObject<UStaticMesh>(nullptr, TEXT("/Engine/BasicShapes/Cube.Cube"));
+	if (cube == nullptr)
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("Couldn't load /Engine/BasicShapes/Cube"));
+		return;
+	}
+
+	auto addBlock = [world, cube](const FVector& location, const FRotator& rotation, const FVector& scale)
+	{
+		AStaticMeshActor* block = world->SpawnActor<AStaticMeshActor>(location, rotation);
+		block->SetActorScale3D(scale);
+		UStaticMeshComponent* meshComp = block->GetStaticMeshComponent();
+		meshComp->SetMobility(EComponentMobility::Static);
+		meshComp->SetStaticMesh(cube);
+	};
+
+	// The cube is 100cm on a side, centred on its origin: a 400m square floor with its top at z = 0.
+	addBlock(FVector(0.0f, 0.0f, -50.0f), FRotator::ZeroRotator, FVector(400.0f, 400.0f, 1.0f));
+
+	if (ramps)
+	{
+		// Rows of shallow ramps across the direction of travel, half buried in the floor.
+		for (int32 row = -6; row <= 6; ++row)
+		{
+			addBlock(FVector(row * 3000.0f + 1500.0f, 0.0f, 0.0f), FRotator(15.0f, 0.0f, 0.0f), FVector(8.0f, 380.0f, 1.0f));
+		}
+	}
+}
+
+FVector USkateboardBenchCommandlet::FindSpawnOrigin(UWorld* world) const
+{
+	for (TActorIterator<APlayerStart> it(world); it; ++it)
+	{
+		return it->GetActorLocation();
+	}
+	return FVector(0.0f, 0.0f, 100.0f);
+}
+
+bool USkateboardBenchCommandlet::RunBoards(UWorld* world, int32 numBoards, bool kinematic, TArray<TSharedPtr<FJsonValue>>& runsOut, TArray<FVector>& finalPositionsOut)
+{
+	if (numBoards <= 0)
+		return false;
+
+	// Spawn in a square grid, 3m apart.
+	const int32 gridSide = FMath::CeilToInt(FMath::Sqrt((float)numBoards));
+	const float spacing = 300.0f;
+	const FVector origin = FindSpawnOrigin(world);
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	// Bots all wander the same points, picked once per run from the seed.
+	TSharedPtr<const FSkateboardBotPath> botPath;
+	if (m_DriveBots)
+	{
+		botPath = ASkateboardBotSpawner::BuildWanderPath(world, origin, m_BotWanderRadius, 64, m_Seed);
+	}
+
+	TArray<ASkateboardSimPawn*> pawns;
+	TArray<FBoardScript> scripts;
+	scripts.SetNum(numBoards);
+	for (int32 i = 0; i < numBoards; ++i)
+	{
+		const FVector offset((i % gridSide - 0.5f * (gridSide - 1)) * spacing, (i / gridSide - 0.5f * (gridSide - 1)) * spacing, 0.0f);
+		ASkateboardSimPawn* pawn = world->SpawnActor<ASkateboardSimPawn>(m_PawnClass, origin + offset, FRotator::ZeroRotator, spawnParams);
+		if (pawn == nullptr)
+		{
+			UE_LOG(LogSkateboardSim, Error, TEXT("Couldn't spawn %s"), *m_PawnClass->GetName());
+			return false;
+		}
+		pawn->SetKinematicMovement(kinematic);
+		pawns.Add(pawn);
+		scripts[i].Init(m_Seed * 7919 + i);
+
+		if (m_DriveBots)
+		{
+			ASkateboardBotController* controller = world->SpawnActor<ASkateboardBotController>(origin + offset, FRotator::ZeroRotator, spawnParams);
+			if (controller == nullptr)
+			{
+				UE_LOG(LogSkateboardSim, Error, TEXT("Couldn't spawn a bot controller"));
+				return false;
+			}
+			controller->Possess(pawn);
+			controller->SetPath(botPath, m_Seed * 7919 + i);
+		}
+	}
+
+	for (ASkateboardSimPawn* pawn : pawns)
+	{
+		if (!pawn->HasLoadedAssets())
+		{
+			UE_LOG(LogSkateboardSim, Error, TEXT("%s spawned without its assets loaded"), *pawn->GetName());
+			return false;
+		}
+	}
+
+	TArray<double> frameMs;
+	TArray<double> gameThreadMs;
+	double phaseMs[ESkateProfilePhase::Count] = {};
+	int64 counts[ESkateProfileCounter::Count] = {};
+	double speedSum = 0.0;
+	int64 airborneSamples = 0;
+	TArray<FVector> startPositions;
+
+	for (int32 frame = 0; frame < m_WarmupFrames + m_Frames; ++frame)
+	{
+		// Bots drive themselves, from timers the world tick runs.
+		for (int32 i = 0; i < numBoards && !m_DriveBots; ++i)
+		{
+			float forward, right;
+			scripts[i].Next(frame, forward, right);
+			pawns[i]->Input_MoveForward(forward);
+			pawns[i]->Input_MoveRight(right);
+		}
+
+		const double wallStart = FPlatformTime::Seconds();
+		const double cpuStart = GetThreadCPUSeconds();
+		world->Tick(LEVELTICK_All, m_DeltaTime);
+		const double cpuEnd = GetThreadCPUSeconds();
+		const double wallEnd = FPlatformTime::Seconds();
+		++GFrameCounter;
+
+		if (frame < m_WarmupFrames)
+			continue;
+
+		if (frame == m_WarmupFrames)
+		{
+			for (ASkateboardSimPawn* pawn : pawns)
+			{
+				startPositions.Add(pawn->GetActorLocation());
+			}
+		}
+		for (ASkateboardSimPawn* pawn : pawns)
+		{
+			speedSum += pawn->GetBodyVelocity().Size();
+			airborneSamples += (pawn->GroundStateComp->IsOnGround() ? 0 : 1);
+		}
+
+		frameMs.Add((wallEnd - wallStart) * 1000.0);
+		gameThreadMs.Add((cpuEnd - cpuStart) * 1000.0);
+
+		const FSkateboardSimProfiler::FFrameTotals& totals = FSkateboardSimProfiler::Get().GetLastFrame();
+		for (int32 p = 0; p < ESkateProfilePhase::Count; ++p)
+		{
+			phaseMs[p] += totals.PhaseMs[p];
+		}
+		for (int32 c = 0; c < ESkateProfileCounter::Count; ++c)
+		{
+			counts[c] += totals.Counts[c];
+		}
+	}
+
+	TArray<double> distances;
+	for (int32 i = 0; i < numBoards; ++i)
+	{
+		finalPositionsOut.Add(pawns[i]->GetActorLocation());
+		distances.Add(FVector::Dist(startPositions[i], finalPositionsOut[i]));
+	}
+
+	for (ASkateboardSimPawn* pawn : pawns)
+	{
+		if (pawn->GetController() != nullptr)
+		{
+			pawn->GetController()->Destroy();
+		}
+		pawn->Destroy();
+	}
+	world->Tick(LEVELTICK_All, m_DeltaTime);
+
+	TSharedPtr<FJsonObject> phases = MakeShareable(new FJsonObject);
+	for (int32 p = 0; p < ESkateProfilePhase::Count; ++p)
+	{
+		phases->SetNumberField(FSkateboardSimProfiler::GetPhaseName((ESkateProfilePhase::Type)p), phaseMs[p] / m_Frames);
+	}
+
+	TSharedPtr<FJsonObject> counters = MakeShareable(new FJsonObject);
+	for (int32 c = 0; c < ESkateProfileCounter::Count; ++c)
+	{
+		counters->SetNumberField(FSkateboardSimProfiler::GetCounterName((ESkateProfileCounter::Type)c), (double)counts[c] / m_Frames);
+	}
+
+	const double tracesPerFrame = (double)counts[ESkateProfileCounter::TracesIssued] / m_Frames;
+
+	TSharedPtr<FJsonObject> frameDist = MakeDistribution(frameMs);
+	TSharedPtr<FJsonObject> gameThreadDist = MakeDistribution(gameThreadMs);
+
+	TSharedPtr<FJsonObject> run = MakeShareable(new FJsonObject);
+	run->SetNumberField(TEXT("boards"), numBoards);
+	run->SetStringField(TEXT("movement"), kinematic ? TEXT("kinematic") : TEXT("physics"));
+	run->SetStringField(TEXT("drive"), m_DriveBots ? TEXT("bots") : TEXT("script"));
+	run->SetObjectField(TEXT("frameMs"), frameDist);
+	run->SetObjectField(TEXT("gameThreadMs"), gameThreadDist);
+	run->SetObjectField(TEXT("phaseMsPerFrame"), phases);
+	run->SetObjectField(TEXT("countersPerFrame"), counters);
+	run->SetNumberField(TEXT("tracesTotal"), (double)counts[ESkateProfileCounter::TracesIssued]);
+	run->SetNumberField(TEXT("tracesPerBoardPerFrame"), tracesPerFrame / numBoards);
+	run->SetNumberField(TEXT("meanSpeed"), speedSum / ((double)m_Frames * numBoards));
+	run->SetNumberField(TEXT("airborneFraction"), (double)airborneSamples / ((double)m_Frames * numBoards));
+	run->SetObjectField(TEXT("distanceCm"), MakeDistribution(distances));
+	runsOut.Add(MakeShareable(new FJsonValueObject(run)));
+
+	UE_LOG(LogSkateboardSim, Display, TEXT("%4d boards (%s): frame p50 %.3f ms, p99 %.3f ms, game thread mean %.3f ms, %.1f traces/frame"),
+		numBoards, kinematic ? TEXT("kinematic") : TEXT("physics"), frameDist->GetNumberField(TEXT("p50")), frameDist->GetNumberField(TEXT("p99")), gameThreadDist->GetNumberField(TEXT("mean")), tracesPerFrame);
+	return true;
+}
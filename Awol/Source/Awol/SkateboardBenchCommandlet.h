@@ -0,0 +1,79 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Commandlets/Commandlet.h"
+#include "SkateboardBenchCommandlet.generated.h"
+
+class ASkateboardSimPawn;
+class FJsonValue;
+
+/**
+* Headless performance benchmark for skateboard pawns.
+*
+*   UE4Editor Awol.uproject -run=SkateboardBench -nullrhi -boards=1,4,16,64,256 -frames=1200 -seed=1 -level=ramps
+*
+* For each board count, spawns that many pawns in a grid, drives them through Input_MoveForward/Input_MoveRight with
+* a seeded input pattern, and ticks the world at a fixed step.  Results go to -out=<path> (default
+* Saved/Profiling/SkateboardBench/SkateboardBench-<date>.json): frame time percentiles, game-thread CPU time, the
+* per-phase times from FSkateboardSimProfiler, and trace counts, plus how the boards rode: their mean speed, how
+* much of the time they spent in the air, and how far they got.  Before any of that, the pawn's loadout (see
+* USkateboardLoadout) is loaded, and the time it took recorded as boardAssetLoadMs.  The cold start, from process
+* start until the first board has its assets and starts riding (ASkateboardSimPawn::GetFirstBoardReadyTime()), is
+* recorded as coldStartToFirstBoardMs; compare runs with skate.AsyncBoardAssets 0 and 1 for the before and after.
+*
+* -movement=both rides every board count once with rigid bodies and once with kinematic movement (see
+* ASkateboardSimPawn::UseKinematicMovement), from the same spawn points with the same inputs, and records how far
+* each kinematic board finished from its rigid body twin.
+*
+* -drive=bots hands each board to an ASkateboardBotController wandering between seeded points on the ground around
+* the spawn grid, instead of the scripted input, for a repeatable crowd on a real level:
+*
+*   UE4Editor Awol.uproject -run=SkateboardBench -nullrhi -level=map -map=/Game/AWOL/Map/VeniceBeachSkatePark -boards=128,256 -drive=bots
+*
+* Options:
+*   -level=flat|ramps|map   Generated flat floor, generated floor with rows of ramps, or load -map (default flat)
+*   -map=<package>          Map for -level=map (default /Game/AWOL/SkateboardTestFiles/testMap)
+*   -pawnclass=<path>       Pawn class to spawn, e.g. a Blueprint's generated class (default ASkateboardSimPawn)
+*   -warmup=<frames>        Frames to run before measuring (default 60)
+*   -dt=<seconds>           Fixed tick step (default 1/60)
+*   -movement=physics|kinematic|both   How the boards are moved (default physics)
+*   -drive=script|bots      Seeded stick input, or bot controllers (default script)
+*   -botradius=<cm>         How far from the spawn grid bots wander (default 5000)
+*
+* @see FSkateboardSimProfiler
+*/
+UCLASS()
+class USkateboardBenchCommandlet : public UCommandlet
+{
+	GENERATED_BODY()
+
+public:
+	USkateboardBenchCommandlet();
+
+	virtual int32 Main(const FString& Params) override;
+
+private:
+	// Load or generate the level to ride in.  Returns null on failure.
+	UWorld* CreateBenchWorld(const FString& level, const FString& mapName);
+
+	void DestroyBenchWorld(UWorld* world);
+
+	// Floor (and optionally ramps) built from engine cubes.
+	void BuildGeneratedLevel(UWorld* world, bool ramps);
+
+	// Spawn, ride and destroy one set of pawns, appending the results to runsOut and each board's final position to
+	// finalPositionsOut.
+	bool RunBoards(UWorld* world, int32 numBoards, bool kinematic, TArray<TSharedPtr<FJsonValue>>& runsOut, TArray<FVector>& finalPositionsOut);
+
+	// Where to centre the grid of pawns.
+	FVector FindSpawnOrigin(UWorld* world) const;
+
+	UClass* m_PawnClass;
+	int32 m_Frames;
+	int32 m_WarmupFrames;
+	float m_DeltaTime;
+	int32 m_Seed;
+	bool m_DriveBots;
+	float m_BotWanderRadius;
+};
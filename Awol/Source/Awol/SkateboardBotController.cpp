@@ -0,0 +1,182 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "SkateboardBotController.h"
+#include "SkateboardSimPawn.h"
+#include "SkateboardSimCoreConversions.h"
+#include "Navigation/PathFollowingComponent.h"
+
+DECLARE_CYCLE_STAT(TEXT("Bot Decide"), STAT_SkateboardBotDecide, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bot Decisions"), STAT_SkateboardBotDecisions, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Bots Stuck"), STAT_SkateboardBotsStuck, STATGROUP_SkateboardSim);
+
+
+// Sets default values
+ASkateboardBotController::ASkateboardBotController()
+{
+	// Decisions run on a timer; there's nothing to do every frame.
+	PrimaryActorTick.bCanEverTick = false;
+	bWantsPlayerState = false;
+
+	const SkateSim::FBotTune tune = SkateSim::DefaultBotTune();
+	DecisionInterval = 0.25f;
+	FullSteerAngle = tune.FullSteerAngleDeg;
+	SharpTurnAngle = tune.SharpTurnAngleDeg;
+	CruiseSpeed = tune.CruiseSpeed;
+	MinRollSpeed = tune.MinRollSpeed;
+	ArrivalRadius = tune.ArrivalRadius;
+	StuckTime = 3.0f;
+	StuckSpeed = 50.0f;
+	m_Waypoint = INDEX_NONE;
+	m_StuckTimer = 0.0f;
+	m_SkatePawn = nullptr;
+}
+
+void ASkateboardBotController::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// We steer with stick input, not navigation paths.
+	UPathFollowingComponent* pathFollowing = GetPathFollowingComponent();
+	if (pathFollowing != nullptr)
+	{
+		pathFollowing->SetComponentTickEnabled(false);
+	}
+}
+
+void ASkateboardBotController::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopDeciding();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+void ASkateboardBotController::Possess(APawn* InPawn)
+{
+	Super::Possess(InPawn);
+
+	m_SkatePawn = Cast<ASkateboardSimPawn>(InPawn);
+	StartDeciding();
+}
+
+void ASkateboardBotController::UnPossess()
+{
+	if (m_SkatePawn != nullptr)
+	{
+		m_SkatePawn->Input_MoveForward(0.0f);
+		m_SkatePawn->Input_MoveRight(0.0f);
+	}
+	StopDeciding();
+	m_SkatePawn = nullptr;
+
+	Super::UnPossess();
+}
+
+void ASkateboardBotController::SetPath(TSharedPtr<const FSkateboardBotPath> path, int32 seed)
+{
+	m_Path = path;
+	m_Random.Initialize(seed);
+	m_Waypoint = INDEX_NONE;
+	m_StuckTimer = 0.0f;
+	StartDeciding();
+}
+
+void ASkateboardBotController::StartDeciding()
+{
+	UWorld* world = GetWorld();
+	if (world == nullptr || m_SkatePawn == nullptr || !m_Path.IsValid() || m_Path->Points.Num() == 0 || DecisionInterval <= 0.0f)
+		return;
+
+	// Spread the first decisions over one interval, so a crowd spawned together doesn't all decide on the same frame.
+	const float firstDelay = m_Random.FRandRange(0.0f, DecisionInterval) + KINDA_SMALL_NUMBER;
+	world->GetTimerManager().SetTimer(m_DecisionTimer, this, &ASkateboardBotController::Decide, DecisionInterval, true, firstDelay);
+}
+
+void ASkateboardBotController::StopDeciding()
+{
+	UWorld* world = GetWorld();
+	if (world != nullptr)
+	{
+		world->GetTimerManager().ClearTimer(m_DecisionTimer);
+	}
+}
+
+void ASkateboardBotController::PickNextWaypoint()
+{
+	const int32 numPoints = m_Path->Points.Num();
+	if (m_Waypoint == INDEX_NONE)
+	{
+		// Join a loop wherever we're nearest it; wander off toward anywhere.
+		if (m_Path->Loop)
+		{
+			const FVector location = m_SkatePawn->GetActorLocation();
+			float bestDistSq = MAX_FLT;
+			for (int32 i = 0; i < numPoints; ++i)
+			{
+				const float distSq = FVector::DistSquared2D(location, m_Path->Points[i]);
+				if (distSq < bestDistSq)
+				{
+					bestDistSq = distSq;
+					m_Waypoint = i;
+				}
+			}
+		}
+		else
+		{
+			m_Waypoint = m_Random.RandHelper(numPoints);
+		}
+	}
+	else if (m_Path->Loop)
+	{
+		m_Waypoint = (m_Waypoint + 1) % numPoints;
+	}
+	else if (numPoints > 1)
+	{
+		// Any point but the one we're at.
+		m_Waypoint = (m_Waypoint + 1 + m_Random.RandHelper(numPoints - 1)) % numPoints;
+	}
+	m_StuckTimer = 0.0f;
+}
+
+void ASkateboardBotController::Decide()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardBotDecide);
+	INC_DWORD_STAT(STAT_SkateboardBotDecisions);
+
+	if (m_SkatePawn == nullptr || !m_Path.IsValid() || m_Path->Points.Num() == 0)
+	{
+		StopDeciding();
+		return;
+	}
+
+	SkateSim::FBotTune tune;
+	tune.FullSteerAngleDeg = FullSteerAngle;
+	tune.SharpTurnAngleDeg = SharpTurnAngle;
+	tune.CruiseSpeed = CruiseSpeed;
+	tune.MinRollSpeed = MinRollSpeed;
+	tune.ArrivalRadius = ArrivalRadius;
+
+	const SkateSim::FVec3 position = SkateSim::ToSim(m_SkatePawn->GetActorLocation());
+	const SkateSim::FVec3 velocity = SkateSim::ToSim(m_SkatePawn->GetBodyVelocity());
+
+	// Move on once we're there, or when we've been stuck against something on the way for too long.
+	m_StuckTimer = (SkateSim::Size(velocity) < StuckSpeed ? m_StuckTimer + DecisionInterval : 0.0f);
+	if (m_StuckTimer >= StuckTime)
+	{
+		INC_DWORD_STAT(STAT_SkateboardBotsStuck);
+		PickNextWaypoint();
+	}
+	if (m_Waypoint == INDEX_NONE || SkateSim::HasReachedWaypoint(position, SkateSim::ToSim(m_Path->Points[m_Waypoint]), tune))
+	{
+		PickNextWaypoint();
+	}
+
+	const FVector forward = m_SkatePawn->GetForwardVector2D();
+	const FVector right(-forward.Y, forward.X, 0.0f);
+	float forwardInput, rightInput;
+	SkateSim::ComputeBotInput(position, SkateSim::ToSim(forward), SkateSim::ToSim(right), velocity, SkateSim::ToSim(m_Path->Points[m_Waypoint]),
+		tune, forwardInput, rightInput);
+
+	m_SkatePawn->Input_MoveForward(forwardInput);
+	m_SkatePawn->Input_MoveRight(rightInput);
+}
@@ -0,0 +1,112 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "AIController.h"
+#include "SkateboardBotSteering.h"
+#include "SkateboardBotController.generated.h"
+
+class ASkateboardSimPawn;
+
+/**
+* Waypoints shared by every bot following the same route or wandering the same area.  Built once (see
+* ASkateboardBotSpawner) and never changed after, so any number of bots can hold on to it.
+*/
+struct FSkateboardBotPath
+{
+	TArray<FVector> Points;
+
+	// If true, bots ride Points in order, round and round.  Otherwise each bot heads for one point after another,
+	// picked at random from its own seed.
+	bool Loop;
+
+	FSkateboardBotPath() : Loop(false) {}
+};
+
+/**
+* Rides an ASkateboardSimPawn along a shared FSkateboardBotPath, for load testing with many more boards than players.
+*
+* Decisions are made on a timer every DecisionInterval seconds, staggered across bots so they don't all decide on the
+* same frame, and in between the pawn just holds the last input.  A decision is one call to SkateSim::ComputeBotInput()
+* plus, on reaching a waypoint, picking the next.  The controller doesn't tick, and its path following component is
+* switched off; nothing here uses the navigation system.
+*
+* Bots aren't player-controlled, so ASkateboardSimManager drops them to cheaper simulation tiers as usual when no
+* player is near.
+*
+* @see ASkateboardBotSpawner
+*/
+UCLASS()
+class AWOL_API ASkateboardBotController : public AAIController
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this controller's properties
+	ASkateboardBotController();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when this actor is being removed from the level
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	virtual void Possess(APawn* InPawn) override;
+	virtual void UnPossess() override;
+
+	// Follow the given path, with our random choices (where to start, which point next) made from seed.  Takes effect
+	// at our next decision.
+	void SetPath(TSharedPtr<const FSkateboardBotPath> path, int32 seed);
+
+	// Seconds between decisions.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float DecisionInterval;
+
+	// Bearing error, in degrees, at which we steer as hard as we can.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float FullSteerAngle;
+
+	// Bearing error, in degrees, beyond which we stop pushing and just carve round, once we're rolling.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float SharpTurnAngle;
+
+	// Speed, in cm/s, above which we stop pushing.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float CruiseSpeed;
+
+	// Speed, in cm/s, below which we push whatever the bearing, since the board can't turn without rolling.  Keep it
+	// above StuckSpeed, or a bot facing away from its waypoint counts as stuck instead of pushing off.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float MinRollSpeed;
+
+	// How close, in cm, counts as reaching a waypoint.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float ArrivalRadius;
+
+	// How long, in seconds, we may crawl along below StuckSpeed before giving up on the waypoint we're heading for.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float StuckTime;
+
+	// Speed, in cm/s, below which we count as stuck.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float StuckSpeed;
+
+private:
+	// Pick our next input, and our next waypoint if we've reached this one.
+	void Decide();
+
+	// Move on to the next waypoint: the next along a loop, or a random other one.
+	void PickNextWaypoint();
+
+	void StartDeciding();
+	void StopDeciding();
+
+	TSharedPtr<const FSkateboardBotPath> m_Path;
+	FRandomStream m_Random;
+	int32 m_Waypoint;
+	float m_StuckTimer;
+	FTimerHandle m_DecisionTimer;
+
+	UPROPERTY()
+	ASkateboardSimPawn* m_SkatePawn;
+};
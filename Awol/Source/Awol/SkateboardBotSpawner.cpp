@@ -0,0 +1,268 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "SkateboardBotSpawner.h"
+#include "SkateboardSimPawn.h"
+#include "Components/SplineComponent.h"
+
+namespace
+{
+	// How far above and below a spot to look for the ground under it, in cm.
+	const float GroundSearchUp = 1000.0f;
+	const float GroundSearchDown = 5000.0f;
+
+	// How high above the ground to spawn a board, in cm.
+	const float SpawnHeight = 100.0f;
+
+	bool FindGroundBelow(UWorld* world, const FVector& location, FVector& groundOut)
+	{
+		static const FName traceTag(TEXT("SkateboardBotGround"));
+		FHitResult hit;
+		if (!world->LineTraceSingleByChannel(hit, location + FVector(0.0f, 0.0f, GroundSearchUp), location - FVector(0.0f, 0.0f, GroundSearchDown),
+			ECC_WorldStatic, FCollisionQueryParams(traceTag, false)))
+			return false;
+
+		groundOut = hit.ImpactPoint;
+		return true;
+	}
+}
+
+
+// Sets default values
+ASkateboardBotSpawner::ASkateboardBotSpawner()
+{
+	PrimaryActorTick.bCanEverTick = false;
+
+	Route = CreateDefaultSubobject<USplineComponent>(TEXT("Route"));
+	RootComponent = Route;
+	// An empty route: with no points we wander.
+	Route->ClearSplinePoints();
+	Route->SetClosedLoop(true);
+
+	PawnClass = ASkateboardSimPawn::StaticClass();
+	ControllerClass = ASkateboardBotController::StaticClass();
+	NumBots = 128;
+	SpawnOnBeginPlay = false;
+	Seed = 1;
+	SpawnSpacing = 300.0f;
+	WanderRadius = 5000.0f;
+	NumWanderPoints = 64;
+	RouteSampleSpacing = 500.0f;
+}
+
+void ASkateboardBotSpawner::BeginPlay()
+{
+	Super::BeginPlay();
+
+	if (SpawnOnBeginPlay)
+	{
+		SpawnBots(NumBots);
+	}
+}
+
+void ASkateboardBotSpawner::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	DestroyBots();
+	m_Path.Reset();
+
+	Super::EndPlay(EndPlayReason);
+}
+
+TSharedPtr<const FSkateboardBotPath> ASkateboardBotSpawner::GetPath()
+{
+	if (m_Path.IsValid())
+		return m_Path;
+
+	if (Route != nullptr && Route->GetNumberOfSplinePoints() > 1)
+	{
+		TSharedPtr<FSkateboardBotPath> path = MakeShareable(new FSkateboardBotPath);
+		path->Loop = true;
+		const float length = Route->GetSplineLength();
+		const int32 numSamples = FMath::Max(2, FMath::CeilToInt(length / FMath::Max(RouteSampleSpacing, 1.0f)));
+		for (int32 i = 0; i < numSamples; ++i)
+		{
+			path->Points.Add(Route->GetLocationAtDistanceAlongSpline(length * i / numSamples, ESplineCoordinateSpace::World));
+		}
+		m_Path = path;
+	}
+	else
+	{
+		m_Path = BuildWanderPath(GetWorld(), GetActorLocation(), WanderRadius, NumWanderPoints, Seed);
+	}
+
+	UE_LOG(LogSkateboardSim, Log, TEXT("%s: bots %s %d points"), *GetName(), m_Path->Loop ? TEXT("loop through") : TEXT("wander between"), m_Path->Points.Num());
+	return m_Path;
+}
+
+TSharedPtr<const FSkateboardBotPath> ASkateboardBotSpawner::BuildWanderPath(UWorld* world, const FVector& center, float radius, int32 numPoints, int32 seed)
+{
+	TSharedPtr<FSkateboardBotPath> path = MakeShareable(new FSkateboardBotPath);
+	path->Loop = false;
+
+	FRandomStream random(seed);
+	for (int32 i = 0; i < numPoints; ++i)
+	{
+		// Uniform over the disc.
+		const float distance = radius * FMath::Sqrt(random.FRand());
+		const float angle = random.FRandRange(0.0f, 2.0f * PI);
+		FVector ground;
+		if (FindGroundBelow(world, center + FVector(distance * FMath::Cos(angle), distance * FMath::Sin(angle), 0.0f), ground))
+		{
+			path->Points.Add(ground);
+		}
+	}
+
+	// Nowhere to go but where we are.
+	if (path->Points.Num() == 0)
+	{
+		path->Points.Add(center);
+	}
+	return path;
+}
+
+FVector ASkateboardBotSpawner::GetSpawnLocation(UWorld* world, const FVector& center, int32 index, float spacing)
+{
+	// Square spiral out from the centre, so each index keeps its spot however many bots there are.
+	int32 x = 0, y = 0, dx = 0, dy = -1;
+	for (int32 i = 0; i < index; ++i)
+	{
+		if (x == y || (x < 0 && x == -y) || (x > 0 && x == 1 - y))
+		{
+			const int32 turn = dx;
+			dx = -dy;
+			dy = turn;
+		}
+		x += dx;
+		y += dy;
+	}
+
+	const FVector location = center + FVector(x * spacing, y * spacing, 0.0f);
+	FVector ground;
+	return (FindGroundBelow(world, location, ground) ? ground + FVector(0.0f, 0.0f, SpawnHeight) : location);
+}
+
+int32 ASkateboardBotSpawner::SpawnBots(int32 count)
+{
+	UWorld* world = GetWorld();
+	if (world == nullptr || count <= 0)
+		return 0;
+
+	TSharedPtr<const FSkateboardBotPath> path = GetPath();
+	UClass* pawnClass = (PawnClass != nullptr ? *PawnClass : ASkateboardSimPawn::StaticClass());
+	UClass* controllerClass = (ControllerClass != nullptr ? *ControllerClass : ASkateboardBotController::StaticClass());
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+
+	int32 numSpawned = 0;
+	for (int32 i = 0; i < count; ++i)
+	{
+		const int32 index = m_Bots.Num();
+		const FVector location = GetSpawnLocation(world, GetActorLocation(), index, SpawnSpacing);
+		FRandomStream random(Seed * 7919 + index);
+		const FRotator rotation(0.0f, random.FRandRange(-180.0f, 180.0f), 0.0f);
+
+		ASkateboardSimPawn* pawn = world->SpawnActor<ASkateboardSimPawn>(pawnClass, location, rotation, spawnParams);
+		ASkateboardBotController* controller = (pawn != nullptr ? world->SpawnActor<ASkateboardBotController>(controllerClass, location, rotation, spawnParams) : nullptr);
+		if (controller == nullptr)
+		{
+			UE_LOG(LogSkateboardSim, Error, TEXT("%s: couldn't spawn bot %d"), *GetName(), index);
+			if (pawn != nullptr)
+			{
+				pawn->Destroy();
+			}
+			break;
+		}
+
+		controller->Possess(pawn);
+		controller->SetPath(path, Seed * 7919 + index);
+		m_Bots.Add(pawn);
+		++numSpawned;
+	}
+
+	UE_LOG(LogSkateboardSim, Display, TEXT("%s: spawned %d bots (%d in all)"), *GetName(), numSpawned, m_Bots.Num());
+	return numSpawned;
+}
+
+void ASkateboardBotSpawner::DestroyBots()
+{
+	for (ASkateboardSimPawn* pawn : m_Bots)
+	{
+		if (pawn == nullptr || pawn->IsPendingKill())
+			continue;
+
+		AController* controller = pawn->GetController();
+		if (controller != nullptr)
+		{
+			controller->UnPossess();
+			controller->Destroy();
+		}
+		pawn->Destroy();
+	}
+	m_Bots.Empty();
+}
+
+static ASkateboardBotSpawner* FindOrSpawnBotSpawner(UWorld* world)
+{
+	for (TActorIterator<ASkateboardBotSpawner> it(world); it; ++it)
+	{
+		if (!it->IsPendingKill())
+			return *it;
+	}
+
+	// None placed: put one where the first player is, or failing that, where they'd start.
+	FVector location = FVector::ZeroVector;
+	APlayerController* player = world->GetFirstPlayerController();
+	if (player != nullptr && player->GetPawn() != nullptr)
+	{
+		location = player->GetPawn()->GetActorLocation();
+	}
+	else
+	{
+		for (TActorIterator<APlayerStart> it(world); it; ++it)
+		{
+			location = it->GetActorLocation();
+			break;
+		}
+	}
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	spawnParams.ObjectFlags |= RF_Transient;
+	return world->SpawnActor<ASkateboardBotSpawner>(location, FRotator::ZeroRotator, spawnParams);
+}
+
+static void SpawnBotsInWorld(const TArray<FString>& args, UWorld* world)
+{
+	ASkateboardBotSpawner* spawner = (world != nullptr ? FindOrSpawnBotSpawner(world) : nullptr);
+	if (spawner == nullptr)
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("skate.SpawnBots: couldn't find or spawn a bot spawner"));
+		return;
+	}
+
+	// Only re-seed a spawner with no bots, so the crowd it's already made stays consistent.
+	if (args.Num() > 1 && spawner->GetNumBots() == 0)
+	{
+		spawner->Seed = FCString::Atoi(*args[1]);
+	}
+	spawner->SpawnBots(args.Num() > 0 ? FCString::Atoi(*args[0]) : spawner->NumBots);
+}
+
+static void DestroyBotsInWorld(UWorld* world)
+{
+	for (TActorIterator<ASkateboardBotSpawner> it(world); it; ++it)
+	{
+		it->DestroyBots();
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs SpawnBotsCommand(
+	TEXT("skate.SpawnBots"),
+	TEXT("skate.SpawnBots [count] [seed]: spawn bot riders from the level's first ASkateboardBotSpawner, or one at the first player."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&SpawnBotsInWorld));
+
+static FAutoConsoleCommandWithWorld DestroyBotsCommand(
+	TEXT("skate.DestroyBots"),
+	TEXT("Destroy every bot rider spawned by an ASkateboardBotSpawner."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&DestroyBotsInWorld));
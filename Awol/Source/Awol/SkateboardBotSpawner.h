@@ -0,0 +1,108 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "SkateboardBotController.h"
+#include "SkateboardBotSpawner.generated.h"
+
+class ASkateboardSimPawn;
+class USplineComponent;
+
+/**
+* Fills a level with bot riders (see ASkateboardBotController), for load testing.
+*
+* If Route has more than one point, every bot rides it as a loop.  Otherwise the spawner scatters NumWanderPoints
+* points over the ground within WanderRadius of itself and each bot rides from one to another at random.  Either way
+* the path is built once, the first time it's needed, and shared by every bot this spawner makes.  Bots are spawned
+* in a grid around the spawner, dropped onto the ground, and everything random comes from Seed, so the same spawner
+* makes the same crowd every time.
+*
+* Place one in a level and set SpawnOnBeginPlay, or use the console:
+*
+*   skate.SpawnBots <count> [seed]   Spawn bots from the level's first spawner (or one at the first player)
+*   skate.DestroyBots                Remove every spawner's bots
+*
+* The SkateboardBench commandlet's -drive=bots uses the same wandering path and controllers.
+*/
+UCLASS()
+class AWOL_API ASkateboardBotSpawner : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASkateboardBotSpawner();
+
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when this actor is being removed from the level
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Spawn count more bots.  Returns how many were spawned.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Bot")
+	int32 SpawnBots(int32 count);
+
+	// Destroy every bot (and its controller) we've spawned.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Bot")
+	void DestroyBots();
+
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Bot")
+	int32 GetNumBots() const { return m_Bots.Num(); }
+
+	// The path our bots ride, built on first use.
+	TSharedPtr<const FSkateboardBotPath> GetPath();
+
+	// numPoints points scattered over the ground within radius of center, for bots to wander between.  Points that
+	// don't find any ground are dropped.
+	static TSharedPtr<const FSkateboardBotPath> BuildWanderPath(UWorld* world, const FVector& center, float radius, int32 numPoints, int32 seed);
+
+	// Where the index'th bot of a grid spacing apart, spiralling out from center, should spawn: on the ground under its
+	// grid position, or at center's height if there's none.
+	static FVector GetSpawnLocation(UWorld* world, const FVector& center, int32 index, float spacing);
+
+	// Loop for the bots to ride; ignored unless it has at least two points.
+	UPROPERTY(VisibleAnywhere, BlueprintReadOnly, Category = "SkateboardSim|Bot")
+	USplineComponent* Route;
+
+	// Pawn class to spawn, e.g. a Blueprint's generated class.  ASkateboardSimPawn if none.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	TSubclassOf<ASkateboardSimPawn> PawnClass;
+
+	// Controller class to drive them.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	TSubclassOf<ASkateboardBotController> ControllerClass;
+
+	// How many bots to spawn at BeginPlay, if SpawnOnBeginPlay is set.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	int32 NumBots;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	bool SpawnOnBeginPlay;
+
+	// Seeds the wander points and every bot's choices.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	int32 Seed;
+
+	// Distance, in cm, between bots in the spawn grid.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float SpawnSpacing;
+
+	// Without a route, how far from the spawner (in cm) to scatter the wander points, and how many.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float WanderRadius;
+
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	int32 NumWanderPoints;
+
+	// Distance, in cm, between the points sampled along Route.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Bot")
+	float RouteSampleSpacing;
+
+private:
+	UPROPERTY()
+	TArray<ASkateboardSimPawn*> m_Bots;
+
+	TSharedPtr<const FSkateboardBotPath> m_Path;
+};
@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+#include <cmath>
+
+/**
+* Engine-independent half of a bot rider's decisions: which stick input gets the board to its next waypoint.
+*
+* ASkateboardBotController calls this a few times a second, not every frame, and holds the answer in between, so the
+* input has to make sense for a while: the steering is proportional to how far off the target's bearing is, and the
+* throttle lets off in sharp turns and once the board is up to speed rather than pumping on and off.  A board can't
+* turn without rolling, so below MinRollSpeed it pushes whatever the bearing.
+*/
+namespace SkateSim
+{
+	struct FBotTune
+	{
+		float FullSteerAngleDeg;	// Bearing error at which the stick is all the way over
+		float SharpTurnAngleDeg;	// Bearing error beyond which we stop pushing, to carve round
+		float CruiseSpeed;			// Stop pushing above this speed, in cm/s
+		float MinRollSpeed;			// Push below this speed, in cm/s, even in a sharp turn
+		float ArrivalRadius;		// How close, in cm, counts as reaching a waypoint
+	};
+
+	inline FBotTune DefaultBotTune()
+	{
+		FBotTune tune;
+		tune.FullSteerAngleDeg = 45.0f;
+		tune.SharpTurnAngleDeg = 60.0f;
+		tune.CruiseSpeed = 800.0f;
+		tune.MinRollSpeed = 150.0f;
+		tune.ArrivalRadius = 300.0f;
+		return tune;
+	}
+
+	// Has the board come within the tune's arrival radius of the target, ignoring height?
+	inline bool HasReachedWaypoint(const FVec3& position, const FVec3& target, const FBotTune& tune)
+	{
+		const FVec3 toTarget = MakeVec3(target.X - position.X, target.Y - position.Y, 0.0f);
+		return SizeSquared(toTarget) <= tune.ArrivalRadius * tune.ArrivalRadius;
+	}
+
+	// Stick input that turns the board toward target and keeps it rolling.  forward and right are the board's basis;
+	// only their horizontal parts are used.
+	inline void ComputeBotInput(const FVec3& position, const FVec3& forward, const FVec3& right, const FVec3& velocity, const FVec3& target,
+		const FBotTune& tune, float& forwardOut, float& rightOut)
+	{
+		const FVec3 toTarget = MakeVec3(target.X - position.X, target.Y - position.Y, 0.0f);
+		const float ahead = toTarget.X * forward.X + toTarget.Y * forward.Y;
+		const float side = toTarget.X * right.X + toTarget.Y * right.Y;
+		const float bearingDeg = std::atan2(side, ahead) * (180.0f / 3.14159265f);
+
+		rightOut = Clamp(bearingDeg / tune.FullSteerAngleDeg, -1.0f, 1.0f);
+
+		const float speed = std::sqrt(velocity.X * velocity.X + velocity.Y * velocity.Y);
+		const bool carving = (std::fabs(bearingDeg) >= tune.SharpTurnAngleDeg && speed >= tune.MinRollSpeed);
+		forwardOut = (!carving && speed < tune.CruiseSpeed ? 1.0f : 0.0f);
+	}
+}
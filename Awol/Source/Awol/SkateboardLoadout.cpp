@@ -0,0 +1,125 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "SkateboardLoadout.h"
+#include "SkateboardTune.h"
+
+static TAutoConsoleVariable<int32> CVarSkateboardAsyncBoardAssets(
+	TEXT("skate.AsyncBoardAssets"),
+	1,
+	TEXT("1: stream board and rider assets in asynchronously; boards wait, frozen, until theirs arrive (default).\n")
+	TEXT("0: load them synchronously when a board begins play, blocking the game thread, for comparison."),
+	ECVF_Default);
+
+namespace
+{
+	void AddReference(TArray<FStringAssetReference>& referencesOut, const FStringAssetReference& reference)
+	{
+		if (reference.IsValid())
+		{
+			referencesOut.AddUnique(reference);
+		}
+	}
+
+	// The loadouts in PreloadLoadouts have arrived; now stream in what they reference.
+	void OnPreloadLoadoutsLoaded()
+	{
+		for (const FStringAssetReference& reference : USkateboardLoadout::GetDefaultLoadout()->PreloadLoadouts)
+		{
+			const USkateboardLoadout* loadout = Cast<USkateboardLoadout>(reference.ResolveObject());
+			if (loadout != nullptr)
+			{
+				loadout->RequestLoad(FStreamableDelegate());
+			}
+			else
+			{
+				UE_LOG(LogSkateboardSim, Warning, TEXT("Couldn't preload skateboard loadout %s"), *reference.ToString());
+			}
+		}
+	}
+}
+
+
+// Sets default values for this asset's properties
+USkateboardLoadout::USkateboardLoadout()
+{
+	// The default board: a capsule bound with the mover's material, and the pawn's own models.
+	BoundMesh = FStringAssetReference(TEXT("/Game/StarterContent/Shapes/Shape_NarrowCapsule.Shape_NarrowCapsule"));
+	BoundPhysMtl = FStringAssetReference(TEXT("/Game/AWOL/Character/Mover/MoverPhysMtl.MoverPhysMtl"));
+}
+
+FStreamableManager& USkateboardLoadout::GetStreamableManager()
+{
+	// Never freed: it's an FGCObject, and mustn't outlive the garbage collector at exit.
+	static FStreamableManager* streamableManager = new FStreamableManager;
+	return *streamableManager;
+}
+
+void USkateboardLoadout::PreloadDefaults()
+{
+	static bool preloaded = false;
+	if (preloaded)
+		return;
+	preloaded = true;
+
+	const USkateboardLoadout* defaults = GetDefaultLoadout();
+	defaults->RequestLoad(FStreamableDelegate());
+	if (defaults->PreloadLoadouts.Num() > 0)
+	{
+		GetStreamableManager().RequestAsyncLoad(defaults->PreloadLoadouts, FStreamableDelegate::CreateStatic(&OnPreloadLoadoutsLoaded));
+	}
+}
+
+void USkateboardLoadout::GetAssetReferences(TArray<FStringAssetReference>& referencesOut) const
+{
+	AddReference(referencesOut, BoundMesh.ToStringReference());
+	AddReference(referencesOut, BoundPhysMtl.ToStringReference());
+	AddReference(referencesOut, Tune.ToStringReference());
+	AddReference(referencesOut, BoardMesh.ToStringReference());
+	AddReference(referencesOut, RiderMesh.ToStringReference());
+	AddReference(referencesOut, RiderAnimClass.ToStringReference());
+	for (const TAssetPtr<UObject>& asset : ExtraAssets)
+	{
+		AddReference(referencesOut, asset.ToStringReference());
+	}
+}
+
+bool USkateboardLoadout::IsLoaded() const
+{
+	TArray<FStringAssetReference> references;
+	GetAssetReferences(references);
+	for (const FStringAssetReference& reference : references)
+	{
+		if (reference.ResolveObject() == nullptr)
+			return false;
+	}
+	return true;
+}
+
+void USkateboardLoadout::RequestLoad(const FStreamableDelegate& onLoaded) const
+{
+	TArray<FStringAssetReference> references;
+	GetAssetReferences(references);
+
+	FStreamableManager& streamableManager = GetStreamableManager();
+	if (CVarSkateboardAsyncBoardAssets.GetValueOnGameThread() == 0)
+	{
+		for (const FStringAssetReference& reference : references)
+		{
+			streamableManager.SynchronousLoad(reference);
+		}
+		onLoaded.ExecuteIfBound();
+		return;
+	}
+
+	// Still requested when it's all in memory, so the streamable manager keeps it there.
+	const bool loaded = IsLoaded();
+	if (references.Num() > 0)
+	{
+		streamableManager.RequestAsyncLoad(references, loaded ? FStreamableDelegate() : onLoaded);
+	}
+	if (loaded)
+	{
+		onLoaded.ExecuteIfBound();
+	}
+}
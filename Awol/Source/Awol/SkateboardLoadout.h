@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Engine/DataAsset.h"
+#include "Engine/StreamableManager.h"
+#include "SkateboardLoadout.generated.h"
+
+class USkateboardTune;
+
+/**
+* Everything a board and its rider need besides the pawn itself: collision bound, tuning, models.  It's all held by
+* soft reference, so none of it is loaded along with the pawn class or with a level that places one.
+*
+* At BeginPlay a pawn asks for its loadout (ASkateboardSimPawn::Loadout, or these class defaults if it has none).  If
+* everything is already in memory the board starts riding straight away.  Otherwise it's streamed in through
+* GetStreamableManager(), and the board waits, hidden and frozen, until it arrives, so spawning a new variant never
+* blocks the game thread.  Streamed assets stay resident, and the next board with the same loadout starts at once.
+*
+* The class defaults (the default board) and every loadout in PreloadLoadouts are requested as soon as a map starts
+* loading, so they stream in alongside it; see PreloadDefaults().
+*
+* skate.AsyncBoardAssets 0 loads loadouts synchronously instead, as the pawn's constructor used to, for comparison.
+*
+* @see ASkateboardSimPawn
+*/
+UCLASS(BlueprintType, Config = Game)
+class AWOL_API USkateboardLoadout : public UDataAsset
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this asset's properties
+	USkateboardLoadout();
+
+	// The loadout of boards without one.
+	static const USkateboardLoadout* GetDefaultLoadout() { return GetDefault<USkateboardLoadout>(); }
+
+	// The streamable manager every board asset is loaded through.  Keeps what it's loaded resident.
+	static FStreamableManager& GetStreamableManager();
+
+	// Start streaming in the default loadout and every loadout in PreloadLoadouts.  Only the first call does anything.
+	static void PreloadDefaults();
+
+	// Every asset we reference.
+	void GetAssetReferences(TArray<FStringAssetReference>& referencesOut) const;
+
+	// Is every asset we reference in memory?
+	bool IsLoaded() const;
+
+	// Load every asset we reference, then call onLoaded on the game thread.  If they're all in memory already (or
+	// skate.AsyncBoardAssets is 0), onLoaded is called before this returns.
+	void RequestLoad(const FStreamableDelegate& onLoaded) const;
+
+	// Shape of the board's physical bound; never drawn.  Unused if the pawn's MeshComp already has a mesh.
+	UPROPERTY(EditAnywhere, Category = "Board")
+	TAssetPtr<UStaticMesh> BoundMesh;
+
+	// Physical material of the bound.  Unused if the pawn has its own BoundPhysMtl.
+	UPROPERTY(EditAnywhere, Category = "Board")
+	TAssetPtr<UPhysicalMaterial> BoundPhysMtl;
+
+	// Unused if the pawn has its own SkateboardTune.  If neither does, USkateboardTune's defaults are used.
+	UPROPERTY(EditAnywhere, Category = "Board")
+	TAssetPtr<USkateboardTune> Tune;
+
+	// Board model, put on the first skeletal mesh component under the pawn's SkateboardModelPivot.  If none, the
+	// pawn's own model is kept.
+	UPROPERTY(EditAnywhere, Category = "Board")
+	TAssetPtr<USkeletalMesh> BoardMesh;
+
+	// Rider model and animation, put on the first skeletal mesh component under the pawn's RiderModelPivot.  If none,
+	// the pawn's own are kept.
+	UPROPERTY(EditAnywhere, Category = "Rider")
+	TAssetPtr<USkeletalMesh> RiderMesh;
+
+	UPROPERTY(EditAnywhere, Category = "Rider")
+	TAssetSubclassOf<UAnimInstance> RiderAnimClass;
+
+	// Anything else the board needs loaded before it rides, e.g. its wheel variant.
+	UPROPERTY(EditAnywhere, Category = "Board")
+	TArray<TAssetPtr<UObject>> ExtraAssets;
+
+	// Loadouts to stream in whenever a map starts loading, besides the class defaults.  Set under
+	// [/Script/Awol.SkateboardLoadout] in DefaultGame.ini, e.g. +PreloadLoadouts=/Game/Path/Loadout.Loadout
+	UPROPERTY(Config)
+	TArray<FStringAssetReference> PreloadLoadouts;
+};
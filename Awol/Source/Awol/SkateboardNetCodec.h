@@ -0,0 +1,597 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+#include <stdint.h>
+#include <string.h>
+
+/**
+* Engine-independent wire format for replicated skateboard movement.
+*
+* A board's replicated state is quantized to integers (FNetBoardQuantized), and each update is written as the
+* difference from a base state the receiver already has:
+*
+*   4 bits                      which groups changed: position, velocity, orientation, controls
+*   per changed group           each component's delta, zigzagged, as a 2-bit width class then 4/10/16/32 bits
+*
+* Orientation is packed as the ground normal (octahedral, two int16s) plus the heading of the longitudinal axis
+* around it (uint16), rather than two full vectors.  The lateral axis is rebuilt from those, the same way
+* SkateSim::UpdateOrientation() derives it.
+*
+* Bit streams are template parameters, so the engine can write straight into an FBitWriter and the headless bench
+* into FNetBitPacker.  A writer needs WriteBits(uint32_t value, int numBits); a reader needs
+* uint32_t ReadBits(int numBits), returning 0 once it runs out of data.
+*
+* @see FSkateboardRepMovement
+*/
+namespace SkateSim
+{
+	const float NetPositionScale = 10.0f;		// Quantization steps per cm (1mm)
+	const float NetVelocityScale = 1.0f;		// Quantization steps per cm/s
+	const float NetAxisScale = 127.0f;			// Steering/input, [-1, 1]
+	const float NetNormalScale = 32767.0f;		// Octahedral normal components, [-1, 1]
+
+	enum ENetBoardFlags
+	{
+		NetFlag_Reverse = 1 << 0,
+		NetFlag_OnGround = 1 << 1,
+	};
+
+	enum ENetBoardGroups
+	{
+		NetGroup_Position = 1 << 0,
+		NetGroup_Velocity = 1 << 1,
+		NetGroup_Orientation = 1 << 2,
+		NetGroup_Controls = 1 << 3,
+		NetGroup_Count = 4
+	};
+
+	// Everything another machine needs to reproduce a board: its body and its simulation state.
+	struct FNetBoardSample
+	{
+		FVec3 Position;
+		FVec3 Velocity;
+		FVec3 LongitudinalVector;
+		FVec3 LateralVector;
+		bool Reverse;
+		bool IsOnGround;
+		float Steering;			// Also the right input, see SkateSim::UpdateSteering()
+		float InputForward;
+	};
+
+	struct FNetBoardQuantized
+	{
+		int32_t Position[3];
+		int32_t Velocity[3];
+		int16_t Normal[2];
+		uint16_t Heading;		// Longitudinal axis around the normal, 65536 steps per turn
+		int8_t Steering;
+		int8_t InputForward;
+		uint8_t Flags;			// ENetBoardFlags
+	};
+
+	inline bool operator==(const FNetBoardQuantized& a, const FNetBoardQuantized& b)
+	{
+		return memcmp(a.Position, b.Position, sizeof(a.Position)) == 0
+			&& memcmp(a.Velocity, b.Velocity, sizeof(a.Velocity)) == 0
+			&& a.Normal[0] == b.Normal[0] && a.Normal[1] == b.Normal[1] && a.Heading == b.Heading
+			&& a.Steering == b.Steering && a.InputForward == b.InputForward && a.Flags == b.Flags;
+	}
+	inline bool operator!=(const FNetBoardQuantized& a, const FNetBoardQuantized& b) { return !(a == b); }
+
+	// The base for the first update, before anything has been received.
+	inline FNetBoardQuantized ZeroNetBoard()
+	{
+		FNetBoardQuantized q;
+		memset(&q, 0, sizeof(q));
+		return q;
+	}
+
+	// Size of a full-precision update (every field as a float), for comparison.
+	const int NetRawSampleBits = (4 * 3 * 32) + (2 * 32) + 2;
+
+	///// Quantization /////
+
+	inline int32_t NetQuantize(float value, float scale, float limit)
+	{
+		const float scaled = Clamp(value * scale, -limit, limit);
+		return (int32_t)std::floor(scaled + 0.5f);
+	}
+
+	// Octahedral mapping of a unit vector onto the [-1, 1] square.
+	inline void NetEncodeNormal(const FVec3& n, int16_t out[2])
+	{
+		const float sum = std::fabs(n.X) + std::fabs(n.Y) + std::fabs(n.Z);
+		float u = n.X / sum;
+		float v = n.Y / sum;
+		if (n.Z < 0.0f)
+		{
+			const float fu = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+			const float fv = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+			u = fu;
+			v = fv;
+		}
+		out[0] = (int16_t)NetQuantize(u, NetNormalScale, NetNormalScale);
+		out[1] = (int16_t)NetQuantize(v, NetNormalScale, NetNormalScale);
+	}
+
+	inline FVec3 NetDecodeNormal(const int16_t in[2])
+	{
+		float u = in[0] / NetNormalScale;
+		float v = in[1] / NetNormalScale;
+		FVec3 n = MakeVec3(u, v, 1.0f - std::fabs(u) - std::fabs(v));
+		if (n.Z < 0.0f)
+		{
+			n.X = (1.0f - std::fabs(v)) * (u >= 0.0f ? 1.0f : -1.0f);
+			n.Y = (1.0f - std::fabs(u)) * (v >= 0.0f ? 1.0f : -1.0f);
+		}
+		if (!Normalize(n))
+			n = UpVec3();
+		return n;
+	}
+
+	// A tangent basis that only depends on the (quantized) normal, so both ends measure the heading the same way.
+	inline void NetHeadingBasis(const FVec3& normal, FVec3& tangentOut, FVec3& bitangentOut)
+	{
+		const FVec3 ref = (std::fabs(normal.X) < 0.9f ? MakeVec3(1.0f, 0.0f, 0.0f) : MakeVec3(0.0f, 1.0f, 0.0f));
+		tangentOut = ref - normal * Dot(ref, normal);
+		Normalize(tangentOut);
+		bitangentOut = Cross(normal, tangentOut);
+	}
+
+	inline void NetQuantize(const FNetBoardSample& sample, FNetBoardQuantized& out)
+	{
+		const float posLimit = 2.0e9f;
+		out.Position[0] = NetQuantize(sample.Position.X, NetPositionScale, posLimit);
+		out.Position[1] = NetQuantize(sample.Position.Y, NetPositionScale, posLimit);
+		out.Position[2] = NetQuantize(sample.Position.Z, NetPositionScale, posLimit);
+		out.Velocity[0] = NetQuantize(sample.Velocity.X, NetVelocityScale, posLimit);
+		out.Velocity[1] = NetQuantize(sample.Velocity.Y, NetVelocityScale, posLimit);
+		out.Velocity[2] = NetQuantize(sample.Velocity.Z, NetVelocityScale, posLimit);
+
+		// LongitudinalVector X LateralVector is the ground normal the board was last aligned to.
+		FVec3 normal = Cross(sample.LongitudinalVector, sample.LateralVector);
+		if (!Normalize(normal))
+			normal = UpVec3();
+		NetEncodeNormal(normal, out.Normal);
+
+		FVec3 tangent, bitangent;
+		NetHeadingBasis(NetDecodeNormal(out.Normal), tangent, bitangent);
+		const float heading = std::atan2(Dot(sample.LongitudinalVector, bitangent), Dot(sample.LongitudinalVector, tangent));
+		out.Heading = (uint16_t)(int32_t)std::floor(heading * (65536.0f / (2.0f * 3.1415926535897932f)) + 0.5f);
+
+		out.Steering = (int8_t)NetQuantize(sample.Steering, NetAxisScale, NetAxisScale);
+		out.InputForward = (int8_t)NetQuantize(sample.InputForward, NetAxisScale, NetAxisScale);
+		out.Flags = (uint8_t)((sample.Reverse ? NetFlag_Reverse : 0) | (sample.IsOnGround ? NetFlag_OnGround : 0));
+	}
+
+	inline void NetDequantize(const FNetBoardQuantized& q, FNetBoardSample& out)
+	{
+		out.Position = MakeVec3(q.Position[0] / NetPositionScale, q.Position[1] / NetPositionScale, q.Position[2] / NetPositionScale);
+		out.Velocity = MakeVec3(q.Velocity[0] / NetVelocityScale, q.Velocity[1] / NetVelocityScale, q.Velocity[2] / NetVelocityScale);
+
+		const FVec3 normal = NetDecodeNormal(q.Normal);
+		FVec3 tangent, bitangent;
+		NetHeadingBasis(normal, tangent, bitangent);
+		const float heading = q.Heading * ((2.0f * 3.1415926535897932f) / 65536.0f);
+		out.LongitudinalVector = tangent * std::cos(heading) + bitangent * std::sin(heading);
+		out.LateralVector = Cross(normal, out.LongitudinalVector);
+
+		out.Steering = q.Steering / NetAxisScale;
+		out.InputForward = q.InputForward / NetAxisScale;
+		out.Reverse = ((q.Flags & NetFlag_Reverse) != 0);
+		out.IsOnGround = ((q.Flags & NetFlag_OnGround) != 0);
+	}
+
+	///// Delta encoding /////
+
+	// Bits per width class of a zigzagged delta.
+	const int NetDeltaWidths[4] = { 4, 10, 16, 32 };
+
+	template<typename TWriter>
+	inline void NetWriteDelta(TWriter& writer, int32_t value, int32_t base)
+	{
+		const int32_t delta = (int32_t)((uint32_t)value - (uint32_t)base);
+		const uint32_t zigzag = ((uint32_t)delta << 1) ^ (uint32_t)(delta >> 31);
+		int widthClass = 0;
+		while (widthClass < 3 && (zigzag >> NetDeltaWidths[widthClass]) != 0)
+			++widthClass;
+		writer.WriteBits((uint32_t)widthClass, 2);
+		writer.WriteBits(zigzag, NetDeltaWidths[widthClass]);
+	}
+
+	template<typename TReader>
+	inline int32_t NetReadDelta(TReader& reader, int32_t base)
+	{
+		const uint32_t widthClass = reader.ReadBits(2);
+		const uint32_t zigzag = reader.ReadBits(NetDeltaWidths[widthClass & 3]);
+		const int32_t delta = (int32_t)((zigzag >> 1) ^ (0u - (zigzag & 1)));
+		return (int32_t)((uint32_t)base + (uint32_t)delta);
+	}
+
+	template<typename TWriter>
+	inline void NetWriteBoardDelta(TWriter& writer, const FNetBoardQuantized& base, const FNetBoardQuantized& state)
+	{
+		uint32_t groups = 0;
+		if (memcmp(state.Position, base.Position, sizeof(state.Position)) != 0)
+			groups |= NetGroup_Position;
+		if (memcmp(state.Velocity, base.Velocity, sizeof(state.Velocity)) != 0)
+			groups |= NetGroup_Velocity;
+		if (state.Normal[0] != base.Normal[0] || state.Normal[1] != base.Normal[1] || state.Heading != base.Heading)
+			groups |= NetGroup_Orientation;
+		if (state.Steering != base.Steering || state.InputForward != base.InputForward || state.Flags != base.Flags)
+			groups |= NetGroup_Controls;
+		writer.WriteBits(groups, NetGroup_Count);
+
+		if (groups & NetGroup_Position)
+		{
+			for (int i = 0; i < 3; ++i)
+				NetWriteDelta(writer, state.Position[i], base.Position[i]);
+		}
+		if (groups & NetGroup_Velocity)
+		{
+			for (int i = 0; i < 3; ++i)
+				NetWriteDelta(writer, state.Velocity[i], base.Velocity[i]);
+		}
+		if (groups & NetGroup_Orientation)
+		{
+			NetWriteDelta(writer, state.Normal[0], base.Normal[0]);
+			NetWriteDelta(writer, state.Normal[1], base.Normal[1]);
+			// The heading wraps, so send the short way round.
+			NetWriteDelta(writer, (int16_t)(uint16_t)(state.Heading - base.Heading), 0);
+		}
+		if (groups & NetGroup_Controls)
+		{
+			NetWriteDelta(writer, state.Steering, base.Steering);
+			NetWriteDelta(writer, state.InputForward, base.InputForward);
+			writer.WriteBits(state.Flags, 2);
+		}
+	}
+
+	template<typename TReader>
+	inline void NetReadBoardDelta(TReader& reader, const FNetBoardQuantized& base, FNetBoardQuantized& stateOut)
+	{
+		stateOut = base;
+		const uint32_t groups = reader.ReadBits(NetGroup_Count);
+
+		if (groups & NetGroup_Position)
+		{
+			for (int i = 0; i < 3; ++i)
+				stateOut.Position[i] = NetReadDelta(reader, base.Position[i]);
+		}
+		if (groups & NetGroup_Velocity)
+		{
+			for (int i = 0; i < 3; ++i)
+				stateOut.Velocity[i] = NetReadDelta(reader, base.Velocity[i]);
+		}
+		if (groups & NetGroup_Orientation)
+		{
+			stateOut.Normal[0] = (int16_t)NetReadDelta(reader, base.Normal[0]);
+			stateOut.Normal[1] = (int16_t)NetReadDelta(reader, base.Normal[1]);
+			stateOut.Heading = (uint16_t)(base.Heading + (uint16_t)NetReadDelta(reader, 0));
+		}
+		if (groups & NetGroup_Controls)
+		{
+			stateOut.Steering = (int8_t)NetReadDelta(reader, base.Steering);
+			stateOut.InputForward = (int8_t)NetReadDelta(reader, base.InputForward);
+			stateOut.Flags = (uint8_t)reader.ReadBits(2);
+		}
+	}
+
+	///// Update header /////
+
+	// Every update starts with this.  Sequences number the sender's distinct quantized states; the receiver keeps
+	// the last few it received, so it can find the base an update was encoded against (or tell that it never got it).
+	struct FNetUpdateHeader
+	{
+		bool Compressed;			// Delta-encoded quantized state, rather than full-precision floats
+		bool HasBase;				// Compressed only: encoded against BaseSequence rather than ZeroNetBoard()
+		uint16_t Sequence;
+		uint16_t BaseSequence;
+	};
+
+	template<typename TWriter>
+	inline void NetWriteUpdateHeader(TWriter& writer, const FNetUpdateHeader& header)
+	{
+		writer.WriteBits(header.Compressed ? 1 : 0, 1);
+		writer.WriteBits(header.Sequence, 16);
+		if (header.Compressed)
+		{
+			writer.WriteBits(header.HasBase ? 1 : 0, 1);
+			if (header.HasBase)
+				NetWriteDelta(writer, (uint16_t)(header.Sequence - header.BaseSequence), 0);
+		}
+	}
+
+	template<typename TReader>
+	inline void NetReadUpdateHeader(TReader& reader, FNetUpdateHeader& headerOut)
+	{
+		headerOut.Compressed = (reader.ReadBits(1) != 0);
+		headerOut.Sequence = (uint16_t)reader.ReadBits(16);
+		headerOut.HasBase = (headerOut.Compressed && reader.ReadBits(1) != 0);
+		headerOut.BaseSequence = (headerOut.HasBase ? (uint16_t)(headerOut.Sequence - (uint16_t)NetReadDelta(reader, 0)) : 0);
+	}
+
+	// What the receiver keeps for decoding: its most recently received quantized states, by sequence.
+	class FNetReceivedStates
+	{
+	public:
+		enum { Capacity = 64 };
+
+		FNetReceivedStates() : m_Num(0), m_Next(0) {}
+
+		void Reset() { m_Num = 0; m_Next = 0; }
+
+		void Add(uint16_t sequence, const FNetBoardQuantized& state)
+		{
+			m_Sequences[m_Next] = sequence;
+			m_States[m_Next] = state;
+			m_Next = (m_Next + 1) % Capacity;
+			if (m_Num < Capacity)
+				++m_Num;
+		}
+
+		const FNetBoardQuantized* Find(uint16_t sequence) const
+		{
+			for (int i = 0; i < m_Num; ++i)
+			{
+				if (m_Sequences[i] == sequence)
+					return &m_States[i];
+			}
+			return nullptr;
+		}
+
+	private:
+		uint16_t m_Sequences[Capacity];
+		FNetBoardQuantized m_States[Capacity];
+		int m_Num;
+		int m_Next;
+	};
+
+	// Every this many delta-encoded updates to a receiver, send one against ZeroNetBoard() instead, so a receiver that
+	// somehow lost its base recovers.
+	const int NetFullStateInterval = 64;
+
+	// What the sender knows about one receiver: the newest state the receiver has acknowledged (the delta base), and
+	// the states sent since then that haven't been acknowledged yet, by the packet they went out in.
+	struct FNetSenderState
+	{
+		enum { MaxPending = 16 };
+
+		bool HasConfirmed;
+		uint16_t ConfirmedSequence;
+		FNetBoardQuantized Confirmed;
+
+		int NumPending;
+		int32_t PendingPackets[MaxPending];
+		uint16_t PendingSequences[MaxPending];
+		FNetBoardQuantized PendingStates[MaxPending];
+
+		bool HasSent;
+		uint16_t LastSentSequence;
+		int SendsSinceFull;
+	};
+
+	inline void NetInitSenderState(FNetSenderState& sender)
+	{
+		memset(&sender, 0, sizeof(sender));
+	}
+
+	// Promote every pending state that went out in a packet up to and including ackedPacket.  Pending states are in
+	// send order, so the newest one acknowledged becomes the base.
+	inline void NetConfirmAcked(FNetSenderState& sender, int32_t ackedPacket)
+	{
+		int numAcked = 0;
+		while (numAcked < sender.NumPending && sender.PendingPackets[numAcked] <= ackedPacket)
+			++numAcked;
+		if (numAcked == 0)
+			return;
+
+		sender.HasConfirmed = true;
+		sender.ConfirmedSequence = sender.PendingSequences[numAcked - 1];
+		sender.Confirmed = sender.PendingStates[numAcked - 1];
+
+		sender.NumPending -= numAcked;
+		memmove(sender.PendingPackets, sender.PendingPackets + numAcked, sender.NumPending * sizeof(sender.PendingPackets[0]));
+		memmove(sender.PendingSequences, sender.PendingSequences + numAcked, sender.NumPending * sizeof(sender.PendingSequences[0]));
+		memmove(sender.PendingStates, sender.PendingStates + numAcked, sender.NumPending * sizeof(sender.PendingStates[0]));
+	}
+
+	// Forget every unacknowledged state, e.g. because one of the packets they went out in was lost and we can't tell
+	// which.  Only ever acknowledged states are used as a base, so this is always safe.
+	inline void NetForgetPending(FNetSenderState& sender)
+	{
+		sender.NumPending = 0;
+	}
+
+	// Remember a compressed state sent in the given packet.  If too many are unacknowledged, the oldest is forgotten.
+	inline void NetAddPending(FNetSenderState& sender, int32_t packet, uint16_t sequence, const FNetBoardQuantized& state)
+	{
+		if (sender.NumPending == FNetSenderState::MaxPending)
+		{
+			--sender.NumPending;
+			memmove(sender.PendingPackets, sender.PendingPackets + 1, sender.NumPending * sizeof(sender.PendingPackets[0]));
+			memmove(sender.PendingSequences, sender.PendingSequences + 1, sender.NumPending * sizeof(sender.PendingSequences[0]));
+			memmove(sender.PendingStates, sender.PendingStates + 1, sender.NumPending * sizeof(sender.PendingStates[0]));
+		}
+
+		sender.PendingPackets[sender.NumPending] = packet;
+		sender.PendingSequences[sender.NumPending] = sequence;
+		sender.PendingStates[sender.NumPending] = state;
+		++sender.NumPending;
+	}
+
+	///// Full-precision encoding, for comparison /////
+
+	template<typename TWriter>
+	inline void NetWriteFloat(TWriter& writer, float value)
+	{
+		uint32_t bits;
+		memcpy(&bits, &value, sizeof(bits));
+		writer.WriteBits(bits, 32);
+	}
+
+	template<typename TReader>
+	inline float NetReadFloat(TReader& reader)
+	{
+		const uint32_t bits = reader.ReadBits(32);
+		float value;
+		memcpy(&value, &bits, sizeof(value));
+		return value;
+	}
+
+	template<typename TWriter>
+	inline void NetWriteBoardRaw(TWriter& writer, const FNetBoardSample& sample)
+	{
+		const FVec3* vectors[4] = { &sample.Position, &sample.Velocity, &sample.LongitudinalVector, &sample.LateralVector };
+		for (int i = 0; i < 4; ++i)
+		{
+			NetWriteFloat(writer, vectors[i]->X);
+			NetWriteFloat(writer, vectors[i]->Y);
+			NetWriteFloat(writer, vectors[i]->Z);
+		}
+		NetWriteFloat(writer, sample.Steering);
+		NetWriteFloat(writer, sample.InputForward);
+		writer.WriteBits((sample.Reverse ? NetFlag_Reverse : 0) | (sample.IsOnGround ? NetFlag_OnGround : 0), 2);
+	}
+
+	template<typename TReader>
+	inline void NetReadBoardRaw(TReader& reader, FNetBoardSample& sampleOut)
+	{
+		FVec3* vectors[4] = { &sampleOut.Position, &sampleOut.Velocity, &sampleOut.LongitudinalVector, &sampleOut.LateralVector };
+		for (int i = 0; i < 4; ++i)
+		{
+			vectors[i]->X = NetReadFloat(reader);
+			vectors[i]->Y = NetReadFloat(reader);
+			vectors[i]->Z = NetReadFloat(reader);
+		}
+		sampleOut.Steering = NetReadFloat(reader);
+		sampleOut.InputForward = NetReadFloat(reader);
+		const uint32_t flags = reader.ReadBits(2);
+		sampleOut.Reverse = ((flags & NetFlag_Reverse) != 0);
+		sampleOut.IsOnGround = ((flags & NetFlag_OnGround) != 0);
+	}
+
+	///// Updates /////
+
+	// Write an update carrying state (numbered sequence) to one receiver, and record it in sender.  ackedPacket is the
+	// newest packet the receiver has acknowledged, and packet the one this update will go out in.  If rawSample is
+	// given, it's sent at full precision instead.  Returns false, writing nothing, if the receiver is already up to date.
+	template<typename TWriter>
+	inline bool NetWriteUpdate(TWriter& writer, FNetSenderState& sender, int32_t ackedPacket, int32_t packet,
+		uint16_t sequence, const FNetBoardQuantized& state, const FNetBoardSample* rawSample)
+	{
+		NetConfirmAcked(sender, ackedPacket);
+		if (sender.HasSent && sender.LastSentSequence == sequence)
+			return false;
+
+		FNetUpdateHeader header;
+		header.Compressed = (rawSample == nullptr);
+		// The receiver only keeps its last FNetReceivedStates::Capacity states, and every one it could have received
+		// since the base has a newer sequence, so a base less than that many sequences old is still there.
+		header.HasBase = (header.Compressed && sender.HasConfirmed && sender.SendsSinceFull < NetFullStateInterval
+			&& (uint16_t)(sequence - sender.ConfirmedSequence) < FNetReceivedStates::Capacity);
+		header.Sequence = sequence;
+		header.BaseSequence = (header.HasBase ? sender.ConfirmedSequence : 0);
+		NetWriteUpdateHeader(writer, header);
+
+		if (header.Compressed)
+		{
+			NetWriteBoardDelta(writer, (header.HasBase ? sender.Confirmed : ZeroNetBoard()), state);
+			NetAddPending(sender, packet, sequence, state);
+			sender.SendsSinceFull = (header.HasBase ? sender.SendsSinceFull + 1 : 0);
+		}
+		else
+		{
+			NetWriteBoardRaw(writer, *rawSample);
+		}
+
+		sender.HasSent = true;
+		sender.LastSentSequence = sequence;
+		return true;
+	}
+
+	// Read an update into sampleOut.  Returns false if it was delta-encoded against a state the receiver doesn't have,
+	// in which case it's skipped.
+	template<typename TReader>
+	inline bool NetReadUpdate(TReader& reader, FNetReceivedStates& received, FNetBoardSample& sampleOut, FNetUpdateHeader& headerOut)
+	{
+		NetReadUpdateHeader(reader, headerOut);
+		if (!headerOut.Compressed)
+		{
+			NetReadBoardRaw(reader, sampleOut);
+			return true;
+		}
+
+		const FNetBoardQuantized zero = ZeroNetBoard();
+		const FNetBoardQuantized* base = (headerOut.HasBase ? received.Find(headerOut.BaseSequence) : &zero);
+		FNetBoardQuantized state;
+		NetReadBoardDelta(reader, (base != nullptr ? *base : zero), state);
+		if (base == nullptr)
+			return false;
+
+		received.Add(headerOut.Sequence, state);
+		NetDequantize(state, sampleOut);
+		return true;
+	}
+
+	///// Plain bit streams /////
+
+	// Largest possible update, with room to spare for a small header.
+	const int NetMaxUpdateBytes = 80;
+
+	// Fixed-size bit writer, least significant bit first.
+	class FNetBitPacker
+	{
+	public:
+		FNetBitPacker() : m_NumBits(0) { memset(m_Buffer, 0, sizeof(m_Buffer)); }
+
+		void WriteBits(uint32_t value, int numBits)
+		{
+			for (int i = 0; i < numBits && m_NumBits < NetMaxUpdateBytes * 8; ++i, ++m_NumBits)
+			{
+				if ((value >> i) & 1)
+					m_Buffer[m_NumBits >> 3] |= (uint8_t)(1 << (m_NumBits & 7));
+			}
+		}
+
+		const uint8_t* GetData() const { return m_Buffer; }
+		int GetNumBits() const { return m_NumBits; }
+
+	private:
+		uint8_t m_Buffer[NetMaxUpdateBytes];
+		int m_NumBits;
+	};
+
+	class FNetBitUnpacker
+	{
+	public:
+		FNetBitUnpacker(const uint8_t* data, int numBits) : m_Data(data), m_NumBits(numBits), m_Pos(0), m_Overflow(false) {}
+
+		uint32_t ReadBits(int numBits)
+		{
+			uint32_t value = 0;
+			for (int i = 0; i < numBits; ++i, ++m_Pos)
+			{
+				if (m_Pos >= m_NumBits)
+				{
+					m_Overflow = true;
+					return 0;
+				}
+				value |= (uint32_t)((m_Data[m_Pos >> 3] >> (m_Pos & 7)) & 1) << i;
+			}
+			return value;
+		}
+
+		bool IsOverflowed() const { return m_Overflow; }
+		int GetPos() const { return m_Pos; }
+
+	private:
+		const uint8_t* m_Data;
+		int m_NumBits;
+		int m_Pos;
+		bool m_Overflow;
+	};
+}
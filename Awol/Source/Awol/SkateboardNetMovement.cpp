@@ -0,0 +1,191 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "SkateboardNetMovement.h"
+#include "Engine/PackageMapClient.h"
+
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Movement Updates Sent"), STAT_SkateboardNetUpdatesSent, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Movement Updates Received"), STAT_SkateboardNetUpdatesReceived, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Movement Updates Missing Base"), STAT_SkateboardNetMissingBase, STATGROUP_SkateboardSim);
+
+static TAutoConsoleVariable<int32> CVarSkateboardNetCompression(
+	TEXT("skate.NetCompression"),
+	1,
+	TEXT("1: replicate skateboard movement quantized and delta-encoded (default).\n")
+	TEXT("0: replicate it as full-precision floats, for comparison.  Read on the server."),
+	ECVF_Default);
+
+namespace
+{
+	// The codec's bit stream interface over the engine's bit archives.  Values go through a byte array so the bit
+	// order is the same on any platform.
+	struct FBitWriterStream
+	{
+		explicit FBitWriterStream(FBitWriter& writer) : Writer(writer) {}
+
+		void WriteBits(uint32 value, int numBits)
+		{
+			uint8 bytes[4] = { (uint8)value, (uint8)(value >> 8), (uint8)(value >> 16), (uint8)(value >> 24) };
+			Writer.SerializeBits(bytes, numBits);
+		}
+
+		FBitWriter& Writer;
+	};
+
+	struct FBitReaderStream
+	{
+		explicit FBitReaderStream(FBitReader& reader) : Reader(reader) {}
+
+		uint32 ReadBits(int numBits)
+		{
+			uint8 bytes[4] = { 0, 0, 0, 0 };
+			Reader.SerializeBits(bytes, numBits);
+			return (uint32)bytes[0] | ((uint32)bytes[1] << 8) | ((uint32)bytes[2] << 16) | ((uint32)bytes[3] << 24);
+		}
+
+		FBitReader& Reader;
+	};
+
+	// What the header costs when sending at full precision.
+	const int32 RawUpdateBits = 1 + 16 + SkateSim::NetRawSampleBits;
+}
+
+/**
+* Per-connection base state: what the server knows about the connection's copy of the movement.
+*
+* The engine keeps the one from our last update to each connection, and if it learns that the packet carrying an
+* update was lost, it goes back to the one from before it.
+*/
+class FSkateboardRepMovementBaseState : public INetDeltaBaseState
+{
+public:
+	explicit FSkateboardRepMovementBaseState(const SkateSim::FNetSenderState& sender)
+		: m_Sender(sender)
+		, m_Superseded(false)
+	{
+	}
+
+	virtual bool IsStateEqual(INetDeltaBaseState* otherState) override
+	{
+		const FSkateboardRepMovementBaseState* other = static_cast<FSkateboardRepMovementBaseState*>(otherState);
+		return (m_Sender.HasSent == other->m_Sender.HasSent && m_Sender.LastSentSequence == other->m_Sender.LastSentSequence);
+	}
+
+	const SkateSim::FNetSenderState& GetSender() const { return m_Sender; }
+
+	// Set once another update has been sent on top of this one.  If we're handed it again after that, the engine
+	// went back to it because a packet was lost.
+	bool IsSuperseded() const { return m_Superseded; }
+	void MarkSuperseded() { m_Superseded = true; }
+
+private:
+	SkateSim::FNetSenderState m_Sender;
+	bool m_Superseded;
+};
+
+
+FSkateboardRepMovement::FSkateboardRepMovement()
+	: m_Sequence(0)
+	, m_HasState(false)
+	, m_NumReceived(0)
+	, m_SentBits(0)
+	, m_RawBits(0)
+{
+	FMemory::Memzero(m_Sample);
+	m_Quantized = SkateSim::ZeroNetBoard();
+}
+
+void FSkateboardRepMovement::SetState(const SkateSim::FNetBoardSample& sample)
+{
+	SkateSim::FNetBoardQuantized quantized;
+	SkateSim::NetQuantize(sample, quantized);
+
+	m_Sample = sample;
+	if (!m_HasState || quantized != m_Quantized)
+	{
+		m_Quantized = quantized;
+		++m_Sequence;
+		m_HasState = true;
+	}
+}
+
+void FSkateboardRepMovement::ConsumeBitCounts(int64& sentBitsOut, int64& rawBitsOut)
+{
+	sentBitsOut = m_SentBits;
+	rawBitsOut = m_RawBits;
+	m_SentBits = 0;
+	m_RawBits = 0;
+}
+
+bool FSkateboardRepMovement::NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms)
+{
+	if (DeltaParms.Writer != nullptr)
+	{
+		// Acknowledgements are tracked by packet, so we need the connection we're writing for.
+		UPackageMapClient* packageMap = Cast<UPackageMapClient>(DeltaParms.Map);
+		UNetConnection* connection = (packageMap != nullptr ? packageMap->GetConnection() : nullptr);
+		if (connection == nullptr || !m_HasState)
+			return false;
+
+		FSkateboardRepMovementBaseState* oldState = static_cast<FSkateboardRepMovementBaseState*>(DeltaParms.OldState);
+		SkateSim::FNetSenderState sender;
+		if (oldState != nullptr)
+		{
+			sender = oldState->GetSender();
+			// The engine only goes back one state per lost packet, so after more than one loss it can hand us a state
+			// that still lists an earlier lost update as pending.  We can't tell which, so forget them all.
+			if (oldState->IsSuperseded())
+				SkateSim::NetForgetPending(sender);
+		}
+		else
+		{
+			SkateSim::NetInitSenderState(sender);
+		}
+
+		// The update goes out in the packet being built, or in the next one if this one fills up first.  Assuming the
+		// later one is safe: a lost packet is always reported before any later packet is acknowledged.
+		const bool compressed = (CVarSkateboardNetCompression.GetValueOnGameThread() != 0);
+		FBitWriter& writer = *DeltaParms.Writer;
+		const int64 startBits = writer.GetNumBits();
+		FBitWriterStream stream(writer);
+		if (!SkateSim::NetWriteUpdate(stream, sender, connection->OutAckPacketId, connection->OutPacketId + 1,
+			m_Sequence, m_Quantized, (compressed ? nullptr : &m_Sample)))
+		{
+			return false;
+		}
+
+		m_SentBits += writer.GetNumBits() - startBits;
+		m_RawBits += RawUpdateBits;
+		INC_DWORD_STAT(STAT_SkateboardNetUpdatesSent);
+
+		if (oldState != nullptr)
+			oldState->MarkSuperseded();
+		*DeltaParms.NewState = MakeShareable(new FSkateboardRepMovementBaseState(sender));
+		return true;
+	}
+
+	if (DeltaParms.Reader != nullptr)
+	{
+		FBitReaderStream stream(*DeltaParms.Reader);
+		SkateSim::FNetUpdateHeader header;
+		SkateSim::FNetBoardSample sample;
+		const bool decoded = SkateSim::NetReadUpdate(stream, m_Received, sample, header);
+		if (DeltaParms.Reader->IsError())
+			return false;
+
+		if (!decoded)
+		{
+			// Shouldn't happen, but if it does the server falls back to a full update within NetFullStateInterval.
+			INC_DWORD_STAT(STAT_SkateboardNetMissingBase);
+			return true;
+		}
+
+		m_Sample = sample;
+		m_Sequence = header.Sequence;
+		++m_NumReceived;
+		INC_DWORD_STAT(STAT_SkateboardNetUpdatesReceived);
+		return true;
+	}
+
+	return false;
+}
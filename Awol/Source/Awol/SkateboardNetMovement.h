@@ -0,0 +1,69 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardNetCodec.h"
+#include "SkateboardNetMovement.generated.h"
+
+/**
+* A skateboard pawn's replicated movement: its body and simulation state, quantized and delta-encoded against the
+* newest state each connection has acknowledged (see SkateboardNetCodec.h for the format).
+*
+* The server calls SetState() at the end of every tick.  The engine calls NetDeltaSerialize() whenever the pawn is
+* considered for replication to a connection, which happens at the pawn's NetUpdateFrequency; ASkateboardSimManager
+* adapts that to how close the board is to each player.  Nothing is written if the connection is already up to date.
+*
+* skate.NetCompression 0 sends full-precision floats instead.  Either way, the bits written and what full precision
+* would have cost are both counted, for skate.NetReport and 'stat SkateboardSim'.
+*
+* To try it on loopback, run a dedicated server and connect clients to it:
+*
+*   UE4Editor Awol.uproject /Game/AWOL/SkateboardTestFiles/testMap -server -log
+*   UE4Editor Awol.uproject 127.0.0.1 -game -windowed -resx=1280 -resy=720
+*
+* and use skate.NetReport on the server ('net PktLoss=5' on either end simulates a lossy link).  The headless
+* SkateboardSimBench -mode=net measures the same encoding without the engine.
+*/
+USTRUCT()
+struct AWOL_API FSkateboardRepMovement
+{
+	GENERATED_USTRUCT_BODY()
+
+	FSkateboardRepMovement();
+
+	// Server: the state to replicate from now on.
+	void SetState(const SkateSim::FNetBoardSample& sample);
+
+	// Client: the most recently received state.
+	const SkateSim::FNetBoardSample& GetState() const { return m_Sample; }
+
+	// Client: how many states have been received; changes whenever GetState() does.
+	uint32 GetNumReceived() const { return m_NumReceived; }
+
+	// Server: payload bits written since the last call, and what the same updates would have cost at full precision.
+	void ConsumeBitCounts(int64& sentBitsOut, int64& rawBitsOut);
+
+	bool NetDeltaSerialize(FNetDeltaSerializeInfo& DeltaParms);
+
+private:
+	SkateSim::FNetBoardSample m_Sample;
+	SkateSim::FNetBoardQuantized m_Quantized;
+	uint16 m_Sequence;
+	bool m_HasState;
+
+	// Client: recently received states, the bases for the server's deltas.
+	SkateSim::FNetReceivedStates m_Received;
+	uint32 m_NumReceived;
+
+	int64 m_SentBits;
+	int64 m_RawBits;
+};
+
+template<>
+struct TStructOpsTypeTraits<FSkateboardRepMovement> : public TStructOpsTypeTraitsBase
+{
+	enum
+	{
+		WithNetDeltaSerializer = true,
+	};
+};
@@ -0,0 +1,336 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "SkateboardRecording.h"
+#include "SkateboardSimPawn.h"
+
+using namespace SkateRecording;
+
+
+FSkateboardRecorder::FSkateboardRecorder()
+	: m_RingMask(0)
+	, m_WriteCount(0)
+	, m_ReadCount(0)
+	, m_Writer(nullptr)
+	, m_Thread(nullptr)
+	, m_WakeEvent(nullptr)
+	, m_StopRequested(0)
+	, m_DroppedBytes(0)
+{
+	FMemory::Memzero(m_PrevFields);
+}
+
+FSkateboardRecorder::~FSkateboardRecorder()
+{
+	Finish();
+}
+
+bool FSkateboardRecorder::Start(const FString& path, int32 ringBytes, uint32 keyframeInterval)
+{
+	Finish();
+
+	m_Writer = IFileManager::Get().CreateFileWriter(*path);
+	if (m_Writer == nullptr)
+		return false;
+
+	FHeader header;
+	header.Magic = SkateRecording::Magic;
+	header.Version = SkateRecording::Version;
+	header.KeyframeInterval = keyframeInterval;
+	header.Reserved = 0;
+	m_Writer->Serialize(&header, sizeof(header));
+
+	// All of the memory we'll need, up front.
+	const int32 capacity = (int32)FMath::RoundUpToPowerOfTwo((uint32)FMath::Max(ringBytes, MaxTickBytes * 4));
+	m_Ring.SetNumUninitialized(capacity);
+	m_RingMask = capacity - 1;
+	m_WriteCount = 0;
+	m_ReadCount = 0;
+	m_DroppedBytes = 0;
+	m_StopRequested = 0;
+	FMemory::Memzero(m_PrevFields);
+
+	m_WakeEvent = FPlatformProcess::GetSynchEventFromPool(false);
+	m_Thread = FRunnableThread::Create(this, TEXT("SkateboardRecorder"), 0, TPri_BelowNormal);
+	return true;
+}
+
+void FSkateboardRecorder::Finish()
+{
+	if (m_Thread != nullptr)
+	{
+		Stop();
+		m_Thread->WaitForCompletion();
+		delete m_Thread;
+		m_Thread = nullptr;
+	}
+
+	if (m_WakeEvent != nullptr)
+	{
+		FPlatformProcess::ReturnSynchEventToPool(m_WakeEvent);
+		m_WakeEvent = nullptr;
+	}
+
+	if (m_Writer != nullptr)
+	{
+		Drain();
+		m_Writer->Close();
+		delete m_Writer;
+		m_Writer = nullptr;
+
+		if (m_DroppedBytes > 0)
+		{
+			UE_LOG(LogSkateboardSim, Warning, TEXT("Skateboard recording dropped %lld bytes; the flush thread couldn't keep up.  Try a bigger RecordingBufferKB."), m_DroppedBytes);
+		}
+	}
+}
+
+void FSkateboardRecorder::RecordTick(float deltaTime, const FVector2D& move, const FVector2D& camera, const FKeyframe* keyframe)
+{
+	if (m_Writer == nullptr)
+		return;
+
+	uint8 encoded[MaxTickBytes];
+	int32 size = 1;
+	uint8 mask = 0;
+
+	const float fields[5] = { deltaTime, move.X, move.Y, camera.X, camera.Y };
+	for (int32 i = 0; i < 5; ++i)
+	{
+		// Compare bit patterns, so e.g. -0 vs 0 is still replayed exactly.
+		if (FMemory::Memcmp(&fields[i], &m_PrevFields[i], sizeof(float)) != 0)
+		{
+			mask |= (1 << i);
+			FMemory::Memcpy(encoded + size, &fields[i], sizeof(float));
+			size += sizeof(float);
+		}
+	}
+
+	if (keyframe != nullptr)
+	{
+		mask |= Field_Keyframe;
+		FMemory::Memcpy(encoded + size, keyframe, sizeof(FKeyframe));
+		size += sizeof(FKeyframe);
+	}
+	encoded[0] = mask;
+
+	const int64 writeCount = m_WriteCount;
+	FPlatformMisc::MemoryBarrier();
+	const int64 readCount = m_ReadCount;
+	const int64 capacity = m_RingMask + 1;
+	if (capacity - (writeCount - readCount) < size)
+	{
+		// Drop the whole tick rather than block.  The next tick is still delta-encoded against this one, so don't
+		// advance m_PrevFields: the values we failed to write must be written again.
+		m_DroppedBytes += size;
+		m_WakeEvent->Trigger();
+		return;
+	}
+
+	const int64 start = writeCount & m_RingMask;
+	const int64 firstSpan = FMath::Min<int64>(size, capacity - start);
+	FMemory::Memcpy(m_Ring.GetData() + start, encoded, firstSpan);
+	FMemory::Memcpy(m_Ring.GetData(), encoded + firstSpan, size - firstSpan);
+	FPlatformMisc::MemoryBarrier();
+	m_WriteCount = writeCount + size;
+
+	FMemory::Memcpy(m_PrevFields, fields, sizeof(fields));
+
+	// Wake the flush thread early if we're more than half full.
+	if ((writeCount + size - readCount) * 2 > capacity)
+	{
+		m_WakeEvent->Trigger();
+	}
+}
+
+uint32 FSkateboardRecorder::Run()
+{
+	while (m_StopRequested == 0)
+	{
+		m_WakeEvent->Wait(100);
+		Drain();
+	}
+	return 0;
+}
+
+void FSkateboardRecorder::Stop()
+{
+	FPlatformAtomics::InterlockedExchange(&m_StopRequested, 1);
+	if (m_WakeEvent != nullptr)
+	{
+		m_WakeEvent->Trigger();
+	}
+}
+
+void FSkateboardRecorder::Drain()
+{
+	const int64 readCount = m_ReadCount;
+	const int64 writeCount = m_WriteCount;
+	FPlatformMisc::MemoryBarrier();
+	if (writeCount == readCount)
+		return;
+
+	const int64 capacity = m_RingMask + 1;
+	const int64 size = writeCount - readCount;
+	const int64 start = readCount & m_RingMask;
+	const int64 firstSpan = FMath::Min(size, capacity - start);
+	m_Writer->Serialize(m_Ring.GetData() + start, firstSpan);
+	if (size > firstSpan)
+	{
+		m_Writer->Serialize(m_Ring.GetData(), size - firstSpan);
+	}
+
+	FPlatformMisc::MemoryBarrier();
+	m_ReadCount = writeCount;
+}
+
+
+FSkateboardReplay::FSkateboardReplay()
+	: m_NextTick(0)
+{
+}
+
+bool FSkateboardReplay::Load(const FString& path)
+{
+	m_Ticks.Reset();
+	m_Keyframes.Reset();
+	m_NextTick = 0;
+
+	TArray<uint8> data;
+	if (!FFileHelper::LoadFileToArray(data, *path))
+		return false;
+
+	FHeader header;
+	if (data.Num() < (int32)sizeof(header))
+		return false;
+	FMemory::Memcpy(&header, data.GetData(), sizeof(header));
+	if (header.Magic != SkateRecording::Magic || header.Version != SkateRecording::Version)
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("%s isn't a version %u skateboard recording"), *path, SkateRecording::Version);
+		return false;
+	}
+
+	float fields[5] = {};
+	int32 offset = sizeof(header);
+	while (offset < data.Num())
+	{
+		const uint8 mask = data[offset++];
+		for (int32 i = 0; i < 5; ++i)
+		{
+			if ((mask & (1 << i)) == 0)
+				continue;
+			if (offset + (int32)sizeof(float) > data.Num())
+				return (m_Ticks.Num() > 0);
+			FMemory::Memcpy(&fields[i], data.GetData() + offset, sizeof(float));
+			offset += sizeof(float);
+		}
+
+		FTick tick;
+		tick.DeltaTime = fields[0];
+		tick.Move = FVector2D(fields[1], fields[2]);
+		tick.Camera = FVector2D(fields[3], fields[4]);
+		tick.KeyframeIndex = INDEX_NONE;
+
+		if ((mask & Field_Keyframe) != 0)
+		{
+			// A truncated trailing keyframe just means the recording was cut off mid-write.
+			if (offset + (int32)sizeof(FKeyframe) > data.Num())
+				return (m_Ticks.Num() > 0);
+			tick.KeyframeIndex = m_Keyframes.AddUninitialized();
+			FMemory::Memcpy(&m_Keyframes[tick.KeyframeIndex], data.GetData() + offset, sizeof(FKeyframe));
+			offset += sizeof(FKeyframe);
+		}
+
+		m_Ticks.Add(tick);
+	}
+
+	return (m_Ticks.Num() > 0);
+}
+
+const FTick* FSkateboardReplay::Next()
+{
+	if (m_NextTick >= m_Ticks.Num())
+		return nullptr;
+	return &m_Ticks[m_NextTick++];
+}
+
+const FTick* FSkateboardReplay::Peek() const
+{
+	return (m_NextTick < m_Ticks.Num() ? &m_Ticks[m_NextTick] : nullptr);
+}
+
+
+// Console commands.  These act on every skateboard pawn in the world (recording) or one of them (replay).
+
+static void RecordAllPawns(const TArray<FString>& args, UWorld* world)
+{
+	const FString dir = (args.Num() > 0 ? args[0] : FPaths::GameSavedDir() / TEXT("SkateRecordings"));
+	const FString stamp = FDateTime::Now().ToString();
+	for (TActorIterator<ASkateboardSimPawn> it(world); it; ++it)
+	{
+		const FString path = dir / FString::Printf(TEXT("%s-%s.skrec"), *stamp, *it->GetName());
+		if (it->StartRecording(path))
+		{
+			UE_LOG(LogSkateboardSim, Display, TEXT("Recording %s to %s"), *it->GetName(), *path);
+		}
+	}
+}
+
+static void StopRecordingAllPawns(UWorld* world)
+{
+	for (TActorIterator<ASkateboardSimPawn> it(world); it; ++it)
+	{
+		it->StopRecording();
+	}
+}
+
+static void ReplayOnPawn(const TArray<FString>& args, UWorld* world)
+{
+	if (args.Num() == 0)
+	{
+		UE_LOG(LogSkateboardSim, Display, TEXT("Usage: skate.Replay <file.skrec> [pawn index]"));
+		return;
+	}
+
+	int32 pawnIndex = (args.Num() > 1 ? FCString::Atoi(*args[1]) : 0);
+	for (TActorIterator<ASkateboardSimPawn> it(world); it; ++it)
+	{
+		if (pawnIndex-- == 0)
+		{
+			if (!it->StartReplay(args[0]))
+			{
+				UE_LOG(LogSkateboardSim, Error, TEXT("Couldn't replay %s"), *args[0]);
+			}
+			return;
+		}
+	}
+	UE_LOG(LogSkateboardSim, Error, TEXT("skate.Replay: no skateboard pawn with that index"));
+}
+
+static void StopReplayAllPawns(UWorld* world)
+{
+	for (TActorIterator<ASkateboardSimPawn> it(world); it; ++it)
+	{
+		it->StopReplay();
+	}
+}
+
+static FAutoConsoleCommandWithWorldAndArgs RecordCommand(
+	TEXT("skate.Record"),
+	TEXT("Record every skateboard pawn's inputs to <dir>/<time>-<pawn>.skrec (default Saved/SkateRecordings)."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&RecordAllPawns));
+
+static FAutoConsoleCommandWithWorld StopRecordingCommand(
+	TEXT("skate.StopRecording"),
+	TEXT("Stop every skateboard recording and flush it to disk."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&StopRecordingAllPawns));
+
+static FAutoConsoleCommandWithWorldAndArgs ReplayCommand(
+	TEXT("skate.Replay"),
+	TEXT("skate.Replay <file.skrec> [pawn index]: replay a recording's inputs through a skateboard pawn."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ReplayOnPawn));
+
+static FAutoConsoleCommandWithWorld StopReplayCommand(
+	TEXT("skate.StopReplay"),
+	TEXT("Stop every skateboard replay."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&StopReplayAllPawns));
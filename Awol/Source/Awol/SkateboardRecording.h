@@ -0,0 +1,150 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+* Recording and replay of a skateboard pawn's per-tick inputs.
+*
+* A recording (.skrec) is a header followed by one record per simulation tick:
+*
+*   uint8 mask                  which of the fields below follow (SkateRecording::EField)
+*   float fields...             delta time, move X/Y, camera X/Y; only the ones that changed since the last tick
+*   FKeyframe                   only if Field_Keyframe is set
+*
+* Inputs are stored exactly (not quantized) so a replay feeds the pawn bit-identical values.  Keyframes snapshot the
+* pawn's transform, body velocity, simulation state and ground state every few ticks: the first one places the pawn
+* at the start of the run, and the rest are used to measure (or correct) divergence during replay.
+*
+* @see ASkateboardSimPawn::StartRecording, ASkateboardSimPawn::StartReplay
+*/
+namespace SkateRecording
+{
+	const uint32 Magic = 0x43524B53;	// 'SKRC'
+	const uint32 Version = 1;
+
+	struct FHeader
+	{
+		uint32 Magic;
+		uint32 Version;
+		uint32 KeyframeInterval;
+		uint32 Reserved;
+	};
+
+	enum EField
+	{
+		Field_DeltaTime = 1 << 0,
+		Field_MoveX = 1 << 1,
+		Field_MoveY = 1 << 2,
+		Field_CameraX = 1 << 3,
+		Field_CameraY = 1 << 4,
+		Field_Keyframe = 1 << 5,
+	};
+
+	// Fixed layout: plain floats only, so it can be copied straight in and out of the stream.
+	struct FKeyframe
+	{
+		uint32 Tick;
+		float Location[3];
+		float Rotation[4];
+		float LinearVelocity[3];
+		float AngularVelocity[3];
+		float LongitudinalVector[3];
+		float LateralVector[3];
+		float PrevVelocity[3];
+		float Steering;
+		uint8 Reverse;
+		uint8 IsOnGround;
+		uint8 Pad[2];
+		float GroundPosition[3];
+		float GroundNormal[3];
+	};
+
+	// One decoded tick.
+	struct FTick
+	{
+		float DeltaTime;
+		FVector2D Move;
+		FVector2D Camera;
+		int32 KeyframeIndex;	// Into FSkateboardReplay's keyframes, or INDEX_NONE
+	};
+
+	// The largest a single encoded tick can be.
+	const int32 MaxTickBytes = 1 + 5 * sizeof(float) + sizeof(FKeyframe);
+}
+
+/**
+* Writes a recording without allocating or touching the disk on the game thread: ticks are encoded into a fixed-size
+* ring buffer, and a background thread drains it to the file.  If the flush thread falls behind and the ring fills
+* up, ticks are dropped (and counted) rather than blocking the game.
+*/
+class AWOL_API FSkateboardRecorder : public FRunnable
+{
+public:
+	FSkateboardRecorder();
+	virtual ~FSkateboardRecorder();
+
+	// Open the file and start the flush thread.  ringBytes is rounded up to a power of two.
+	bool Start(const FString& path, int32 ringBytes, uint32 keyframeInterval);
+
+	// Flush whatever is left, close the file and join the thread.
+	void Finish();
+
+	bool IsRecording() const { return m_Writer != nullptr; }
+
+	// Encode one tick.  Game thread only.  keyframe may be null.
+	void RecordTick(float deltaTime, const FVector2D& move, const FVector2D& camera, const SkateRecording::FKeyframe* keyframe);
+
+	// Bytes of ticks that didn't fit in the ring.
+	int64 GetDroppedBytes() const { return m_DroppedBytes; }
+
+	// FRunnable
+	virtual uint32 Run() override;
+	virtual void Stop() override;
+
+private:
+	// Copy everything currently in the ring to the file.  Flush thread only.
+	void Drain();
+
+	// Ring buffer, single producer (game thread) and single consumer (flush thread).  The counts only ever grow;
+	// positions in the buffer are the counts masked by the capacity.
+	TArray<uint8> m_Ring;
+	int64 m_RingMask;
+	volatile int64 m_WriteCount;
+	volatile int64 m_ReadCount;
+
+	FArchive* m_Writer;
+	FRunnableThread* m_Thread;
+	FEvent* m_WakeEvent;
+	volatile int32 m_StopRequested;
+	int64 m_DroppedBytes;
+
+	// The last values written, for delta encoding.
+	float m_PrevFields[5];
+};
+
+/**
+* A recording decoded into memory for replay.
+*/
+class AWOL_API FSkateboardReplay
+{
+public:
+	FSkateboardReplay();
+
+	bool Load(const FString& path);
+
+	// The next tick to play, or null when the recording is finished.
+	const SkateRecording::FTick* Next();
+
+	// The tick after the one last returned by Next(), without advancing.  Null at the end.
+	const SkateRecording::FTick* Peek() const;
+
+	const SkateRecording::FKeyframe& GetKeyframe(int32 index) const { return m_Keyframes[index]; }
+
+	int32 GetNumTicks() const { return m_Ticks.Num(); }
+	int32 GetCurrentTick() const { return m_NextTick - 1; }
+
+private:
+	TArray<SkateRecording::FTick> m_Ticks;
+	TArray<SkateRecording::FKeyframe> m_Keyframes;
+	int32 m_NextTick;
+};
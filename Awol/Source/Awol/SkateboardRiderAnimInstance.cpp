@@ -0,0 +1,119 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "SkateboardRiderAnimInstance.h"
+#include "SkateboardSimPawn.h"
+#include "SkateboardSimStats.h"
+
+DECLARE_CYCLE_STAT(TEXT("Rider Pose Solve"), STAT_SkateboardRiderPoseSolve, STATGROUP_SkateboardSim);
+
+
+FSkateboardRiderAnimInstanceProxy::FSkateboardRiderAnimInstanceProxy(UAnimInstance* InAnimInstance)
+	: FAnimInstanceProxy(InAnimInstance)
+	, m_Tune(SkateSim::DefaultRiderPoseTune())
+	, m_Rotation(FQuat::Identity)
+	, m_HasSim(false)
+	, m_HasPose(false)
+{
+	FMemory::Memzero(m_Sim);
+	FMemory::Memzero(m_Pose);
+	SkateSim::ResetRiderPose(m_State);
+}
+
+void FSkateboardRiderAnimInstanceProxy::Initialize(UAnimInstance* InAnimInstance)
+{
+	FAnimInstanceProxy::Initialize(InAnimInstance);
+
+	SkateSim::ResetRiderPose(m_State);
+	m_HasSim = false;
+	m_HasPose = false;
+}
+
+void FSkateboardRiderAnimInstanceProxy::PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds)
+{
+	FAnimInstanceProxy::PreUpdate(InAnimInstance, DeltaSeconds);
+
+	// Game thread: everything Update() reads is copied here.
+	const ASkateboardSimPawn* pawn = Cast<ASkateboardSimPawn>(InAnimInstance->TryGetPawnOwner());
+	m_HasSim = (pawn != nullptr);
+	if (m_HasSim)
+	{
+		pawn->GetRiderSimSnapshot(m_Sim);
+		m_Tune = static_cast<USkateboardRiderAnimInstance*>(InAnimInstance)->m_Tune;
+	}
+}
+
+void FSkateboardRiderAnimInstanceProxy::Update(float DeltaSeconds)
+{
+	FAnimInstanceProxy::Update(DeltaSeconds);
+
+	if (!m_HasSim)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardRiderPoseSolve);
+
+	SkateSim::UpdateRiderPose(m_State, m_Sim, m_Tune, DeltaSeconds, m_Pose);
+	FMatrix rotMatrix(SkateSim::FromSim(m_Pose.Forward), SkateSim::FromSim(m_Pose.Right), SkateSim::FromSim(m_Pose.Up), FVector::ZeroVector);
+	m_Rotation = FQuat(rotMatrix);
+	m_HasPose = true;
+}
+
+void FSkateboardRiderAnimInstanceProxy::PostUpdate(UAnimInstance* InAnimInstance) const
+{
+	FAnimInstanceProxy::PostUpdate(InAnimInstance);
+
+	// Game thread again: hand the results to the instance.
+	USkateboardRiderAnimInstance* instance = static_cast<USkateboardRiderAnimInstance*>(InAnimInstance);
+	instance->m_HasRiderPose = m_HasPose;
+	if (m_HasPose)
+	{
+		instance->Lean = m_Pose.Lean;
+		instance->Crouch = m_Pose.Crouch;
+		instance->m_RiderRotation = m_Rotation;
+	}
+}
+
+
+// Sets default values for this instance's properties
+USkateboardRiderAnimInstance::USkateboardRiderAnimInstance()
+{
+	const SkateSim::FRiderPoseTune defaults = SkateSim::DefaultRiderPoseTune();
+	CenterOfMassHeight = defaults.CenterOfMassHeight;
+	LeanTimeConstant = defaults.LeanTimeConstant;
+	MaxLeanDeg = 35.0f;
+	CrouchTimeConstant = defaults.CrouchTimeConstant;
+	CrouchPerG = defaults.CrouchPerG;
+	CrouchDepth = defaults.CrouchDepth;
+
+	Lean = 0.0f;
+	Crouch = 0.0f;
+	m_Tune = defaults;
+	m_RiderRotation = FQuat::Identity;
+	m_HasRiderPose = false;
+}
+
+void USkateboardRiderAnimInstance::NativeInitializeAnimation()
+{
+	Super::NativeInitializeAnimation();
+
+	m_Tune.CenterOfMassHeight = CenterOfMassHeight;
+	m_Tune.LeanTimeConstant = LeanTimeConstant;
+	m_Tune.MaxLeanTan = FMath::Tan(FMath::DegreesToRadians(MaxLeanDeg));
+	m_Tune.CrouchTimeConstant = CrouchTimeConstant;
+	m_Tune.CrouchPerG = CrouchPerG;
+	m_Tune.CrouchDepth = CrouchDepth;
+
+	const UWorld* world = GetWorld();
+	const float gravityZ = (world != nullptr ? world->GetGravityZ() : 0.0f);
+	m_Tune.Gravity = (gravityZ < 0.0f ? -gravityZ : SkateSim::DefaultRiderPoseTune().Gravity);
+
+	Lean = 0.0f;
+	Crouch = 0.0f;
+	m_HasRiderPose = false;
+}
+
+FAnimInstanceProxy* USkateboardRiderAnimInstance::CreateAnimInstanceProxy()
+{
+	// The base class deletes it, through DestroyAnimInstanceProxy().
+	return new FSkateboardRiderAnimInstanceProxy(this);
+}
@@ -0,0 +1,104 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "Animation/AnimInstance.h"
+#include "Animation/AnimInstanceProxy.h"
+#include "SkateboardRiderPose.h"
+#include "SkateboardRiderAnimInstance.generated.h"
+
+class USkateboardRiderAnimInstance;
+
+// The worker thread half of USkateboardRiderAnimInstance.  PreUpdate() copies the board's snapshot on the game
+// thread, Update() solves the pose on whichever thread the engine updates animation on, and PostUpdate() hands the
+// results back to the instance on the game thread.
+struct FSkateboardRiderAnimInstanceProxy : public FAnimInstanceProxy
+{
+	FSkateboardRiderAnimInstanceProxy(UAnimInstance* InAnimInstance);
+
+protected:
+	virtual void Initialize(UAnimInstance* InAnimInstance) override;
+	virtual void PreUpdate(UAnimInstance* InAnimInstance, float DeltaSeconds) override;
+	virtual void Update(float DeltaSeconds) override;
+	virtual void PostUpdate(UAnimInstance* InAnimInstance) const override;
+
+private:
+	SkateSim::FRiderSimSnapshot m_Sim;
+	SkateSim::FRiderPoseTune m_Tune;
+	SkateSim::FRiderPoseState m_State;
+	SkateSim::FRiderPose m_Pose;
+	FQuat m_Rotation;
+	bool m_HasSim;
+	bool m_HasPose;
+};
+
+/**
+* Anim instance for the rider, which leans them into turns and crouches them into the deck (see SkateboardRiderPose.h).
+*
+* The pose is solved alongside the rest of the rider's animation, on the animation worker threads when the engine
+* runs it in parallel, from a snapshot of the board taken at the start of the update; the game thread only copies
+* the snapshot in and the results out.  Reparent the rider's Animation Blueprint to this class and read Lean and
+* Crouch in its graph.  ASkateboardSimPawn finds it under RiderModelPivot, and points the pivot along the solved
+* orientation from then on, a frame behind the simulation.
+*/
+UCLASS(transient, Blueprintable)
+class AWOL_API USkateboardRiderAnimInstance : public UAnimInstance
+{
+	GENERATED_BODY()
+
+	friend struct FSkateboardRiderAnimInstanceProxy;
+
+public:
+	// Sets default values for this instance's properties
+	USkateboardRiderAnimInstance();
+
+	// Has a pose been solved yet?  Not until the owner is a board and the instance has updated once.
+	bool HasRiderPose() const { return m_HasRiderPose; }
+
+	// The rider's solved world rotation.
+	const FQuat& GetRiderRotation() const { return m_RiderRotation; }
+
+	// How far the rider leans into the current turn, from -1 (fully left) to 1 (fully right).
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "SkateboardSim|Rider")
+	float Lean;
+
+	// How far the rider is crouched, from 0 (standing) to 1.
+	UPROPERTY(Transient, BlueprintReadOnly, Category = "SkateboardSim|Rider")
+	float Crouch;
+
+	// Height of the rider's center of mass above the board's center when standing, in cm.
+	UPROPERTY(EditDefaultsOnly, Category = "SkateboardSim|Rider")
+	float CenterOfMassHeight;
+
+	// How quickly the lean follows the board's lateral acceleration, in seconds.
+	UPROPERTY(EditDefaultsOnly, Category = "SkateboardSim|Rider", meta = (ClampMin = "0.0"))
+	float LeanTimeConstant;
+
+	// The furthest the rider leans from upright, in degrees.
+	UPROPERTY(EditDefaultsOnly, Category = "SkateboardSim|Rider", meta = (ClampMin = "0.0", ClampMax = "80.0"))
+	float MaxLeanDeg;
+
+	// How quickly the crouch follows the board's acceleration into the deck, in seconds.
+	UPROPERTY(EditDefaultsOnly, Category = "SkateboardSim|Rider", meta = (ClampMin = "0.0"))
+	float CrouchTimeConstant;
+
+	// Crouch per g of acceleration into the deck; 1 is a full crouch.
+	UPROPERTY(EditDefaultsOnly, Category = "SkateboardSim|Rider", meta = (ClampMin = "0.0"))
+	float CrouchPerG;
+
+	// How far the center of mass drops at a full crouch, in cm.
+	UPROPERTY(EditDefaultsOnly, Category = "SkateboardSim|Rider", meta = (ClampMin = "0.0"))
+	float CrouchDepth;
+
+protected:
+	virtual void NativeInitializeAnimation() override;
+	virtual FAnimInstanceProxy* CreateAnimInstanceProxy() override;
+
+private:
+	// The tuning values in the form the pose solver expects, worked out when the instance is initialized.
+	SkateSim::FRiderPoseTune m_Tune;
+
+	// Copied from the proxy after each update.
+	FQuat m_RiderRotation;
+	bool m_HasRiderPose;
+};
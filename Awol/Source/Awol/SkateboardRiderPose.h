@@ -0,0 +1,134 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+/**
+* Engine-independent rider pose: lean into turns and crouch into the deck.
+*
+* The rider's center of mass goes where gravity plus the board's acceleration puts it, so the rider leans into a turn
+* by the same amount a real one would.  Rather than working the acceleration out from the turn's radius (an acos and
+* a sin per board per frame, see ComputeCentripetalAccel()), it's taken straight from the change in velocity over the
+* last step and low-pass filtered: the lateral part leans the rider, and the part into the deck crouches them.
+* Filtering uses alpha = dt / (tau + dt), so a pose update has no transcendentals at all.
+*
+* Everything a pose needs is in FRiderSimSnapshot, copied from the board once per frame on the game thread, so the
+* update itself can run anywhere; USkateboardRiderAnimInstance runs it on the animation worker threads.
+*
+* @see USkateboardRiderAnimInstance
+*/
+namespace SkateSim
+{
+	// What the rider pose needs to know about the board.
+	struct FRiderSimSnapshot
+	{
+		FVec3 Velocity;			// At the start of the board's last step
+		FVec3 PrevVelocity;		// At the start of the step before
+		float StepDeltaTime;	// Time between the two, in seconds
+		FVec3 Position;			// The board's center
+		FVec3 Forward;			// The board's basis
+		FVec3 Right;
+		FGroundContact Ground;
+		float DeckHeight;
+	};
+
+	// Tuning values, mirrored from USkateboardRiderAnimInstance.
+	struct FRiderPoseTune
+	{
+		float CenterOfMassHeight;	// Standing, above the board's center, in cm
+		float LeanTimeConstant;		// Smoothing of the lateral acceleration, in seconds
+		float MaxLeanTan;			// Tangent of the furthest the rider leans from upright
+		float CrouchTimeConstant;	// Smoothing of the acceleration into the deck, in seconds
+		float CrouchPerG;			// Crouch per g of acceleration into the deck; 1 is a full crouch
+		float CrouchDepth;			// How far the center of mass drops at a full crouch, in cm
+		float Gravity;				// In cm/s^2, positive
+	};
+
+	// Defaults, matching USkateboardRiderAnimInstance's.
+	inline FRiderPoseTune DefaultRiderPoseTune()
+	{
+		FRiderPoseTune tune;
+		tune.CenterOfMassHeight = 100.0f;
+		tune.LeanTimeConstant = 0.15f;
+		tune.MaxLeanTan = 0.7002075f;		// 35 degrees
+		tune.CrouchTimeConstant = 0.1f;
+		tune.CrouchPerG = 0.5f;
+		tune.CrouchDepth = 30.0f;
+		tune.Gravity = 980.0f;
+		return tune;
+	}
+
+	// Filter state carried from frame to frame.
+	struct FRiderPoseState
+	{
+		float LateralAccel;		// Along the board's right vector, in cm/s^2
+		float NormalAccel;		// Into the deck (along the ground normal), in cm/s^2
+	};
+
+	// The solved pose.  Up, Forward and Right are an orthonormal basis for the rider.
+	struct FRiderPose
+	{
+		float Lean;			// -1 (fully left) to 1 (fully right)
+		float Crouch;		// 0 (standing) to 1
+		FVec3 Forward;
+		FVec3 Right;
+		FVec3 Up;
+	};
+
+	inline void ResetRiderPose(FRiderPoseState& state)
+	{
+		state.LateralAccel = 0.0f;
+		state.NormalAccel = 0.0f;
+	}
+
+	// Advance the filters by deltaTime and solve the pose.
+	inline void UpdateRiderPose(FRiderPoseState& state, const FRiderSimSnapshot& sim, const FRiderPoseTune& tune, float deltaTime, FRiderPose& poseOut)
+	{
+		const FVec3 groundUp = (sim.Ground.IsOnGround ? sim.Ground.Normal : UpVec3());
+
+		// The board's acceleration over its last step.  Unchanged until it steps again, which is fine: the filters
+		// just keep converging on it.
+		float lateralAccel = 0.0f;
+		float normalAccel = 0.0f;
+		if (sim.StepDeltaTime > 0.0f)
+		{
+			const FVec3 accel = (sim.Velocity - sim.PrevVelocity) * (1.0f / sim.StepDeltaTime);
+			lateralAccel = Dot(accel, sim.Right);
+			normalAccel = (sim.Ground.IsOnGround ? Dot(accel, groundUp) : 0.0f);
+		}
+
+		// First-order low-pass filters
+		if (deltaTime > 0.0f)
+		{
+			state.LateralAccel += (lateralAccel - state.LateralAccel) * (deltaTime / (tune.LeanTimeConstant + deltaTime));
+			state.NormalAccel += (normalAccel - state.NormalAccel) * (deltaTime / (tune.CrouchTimeConstant + deltaTime));
+		}
+
+		const float maxLateralAccel = tune.Gravity * tune.MaxLeanTan;
+		const float lean = Clamp(state.LateralAccel, -maxLateralAccel, maxLateralAccel);
+		const float crouch = Clamp(state.NormalAccel * (tune.CrouchPerG / tune.Gravity), 0.0f, 1.0f);
+
+		// The center of mass hangs along gravity plus the acceleration into the turn.
+		FVec3 toCenterOfMass = UpVec3() * tune.Gravity + sim.Right * lean;
+		Normalize(toCenterOfMass);
+		const FVec3 centerOfMass = sim.Position + toCenterOfMass * (tune.CenterOfMassHeight - crouch * tune.CrouchDepth);
+
+		const FVec3 base = (sim.Ground.IsOnGround ? sim.Ground.Position : sim.Position);
+		const FVec3 topOfDeck = base + groundUp * sim.DeckHeight;
+
+		FVec3 up = centerOfMass - topOfDeck;
+		if (!Normalize(up))
+			up = UpVec3();
+
+		FVec3 right = Cross(up, sim.Forward);
+		if (!Normalize(right))
+			right = sim.Right;
+
+		poseOut.Lean = (maxLateralAccel > 0.0f ? lean / maxLateralAccel : 0.0f);
+		poseOut.Crouch = crouch;
+		poseOut.Forward = Cross(right, up);
+		poseOut.Right = right;
+		poseOut.Up = up;
+	}
+}
@@ -0,0 +1,464 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+#include <vector>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+	#define SKATESIM_USE_SSE 1
+	#include <emmintrin.h>
+#else
+	#define SKATESIM_USE_SSE 0
+#endif
+
+/**
+* Structure-of-arrays batch of boards for the engine-independent sim core.
+*
+* Every board's hot state (orientation, steering, previous velocity) lives in contiguous per-field streams, along
+* with the per-frame inputs gathered from the engine (ground contact, body velocity, stick input) and the outputs
+* to apply back to each body.  Step() runs orientation, steering and force computation for all boards in one pass,
+* four boards at a time with SSE where available, and falls back to the scalar core (SkateboardSimCore.h) otherwise.
+*
+* The SIMD kernel evaluates sin/cos with a polynomial that is accurate to ~1e-7 for steer angles within +/-90 degrees,
+* which covers any sane MinMaxTurnAngleDeg.
+*/
+namespace SkateSim
+{
+	class FBoardBatch
+	{
+	public:
+		FBoardBatch() : m_Num(0) {}
+
+		// Add a board to the batch, returning its index.
+		int Add(const FBoardState& state, const FBoardTune& tune)
+		{
+			int index = m_Num++;
+			Resize(m_Num);
+			SetState(index, state);
+			SetTune(index, tune);
+			return index;
+		}
+
+		// Remove a board by moving the last board into its slot.  Returns the old index of the board that moved (or -1).
+		int RemoveAtSwap(int index)
+		{
+			int last = m_Num - 1;
+			if (index != last)
+			{
+				for (int s = 0; s < Stream_Count; ++s)
+					m_Streams[s][index] = m_Streams[s][last];
+			}
+			for (int s = 0; s < Stream_Count; ++s)
+				m_Streams[s][last] = 0.0f;
+			m_Num = last;
+			return (index != last ? last : -1);
+		}
+
+		int Num() const { return m_Num; }
+
+		void SetTune(int i, const FBoardTune& tune)
+		{
+			m_Streams[Stream_MaxSpeed][i] = tune.MaxSpeed;
+			m_Streams[Stream_TurnAngleDeg][i] = tune.MinMaxTurnAngleDeg;
+			m_Streams[Stream_ForceScale][i] = tune.ForceScale;
+		}
+
+		void SetState(int i, const FBoardState& state)
+		{
+			Store(Stream_LongX, i, state.LongitudinalVector);
+			Store(Stream_LatX, i, state.LateralVector);
+			Store(Stream_PrevVelX, i, state.PrevVelocity);
+			m_Streams[Stream_Reverse][i] = (state.Reverse ? 1.0f : 0.0f);
+			m_Streams[Stream_Steering][i] = state.Steering;
+		}
+
+		void GetState(int i, FBoardState& stateOut) const
+		{
+			stateOut.LongitudinalVector = Load(Stream_LongX, i);
+			stateOut.LateralVector = Load(Stream_LatX, i);
+			stateOut.PrevVelocity = Load(Stream_PrevVelX, i);
+			stateOut.Reverse = (m_Streams[Stream_Reverse][i] != 0.0f);
+			stateOut.Steering = m_Streams[Stream_Steering][i];
+		}
+
+		// Gather this frame's inputs for a board.
+		void SetFrameInput(int i, const FGroundContact& ground, const FBoardInput& input, const FVec3& velocity, float mass)
+		{
+			m_Streams[Stream_OnGround][i] = (ground.IsOnGround ? 1.0f : 0.0f);
+			Store(Stream_NormalX, i, ground.Normal);
+			Store(Stream_VelX, i, velocity);
+			m_Streams[Stream_InputForward][i] = input.Forward;
+			m_Streams[Stream_InputRight][i] = input.Right;
+			m_Streams[Stream_Mass][i] = mass;
+		}
+
+		// Read back the force/impulse computed by the last Step().
+		FBoardOutput GetOutput(int i) const
+		{
+			FBoardOutput output;
+			output.Force = Load(Stream_ForceX, i);
+			output.Impulse = Load(Stream_ImpulseX, i);
+			output.HasForce = (m_Streams[Stream_HasForce][i] != 0.0f);
+			output.HasImpulse = (m_Streams[Stream_HasImpulse][i] != 0.0f);
+			return output;
+		}
+
+		// Store each board's velocity as its previous velocity; the batch equivalent of UpdatePrevVelocity().
+		void UpdatePrevVelocities()
+		{
+			for (int c = 0; c < 3; ++c)
+			{
+				const std::vector<float>& vel = m_Streams[Stream_VelX + c];
+				std::vector<float>& prev = m_Streams[Stream_PrevVelX + c];
+				for (int i = 0; i < m_Num; ++i)
+					prev[i] = vel[i];
+			}
+		}
+
+		// Step every board in the batch.
+		void Step(float deltaTime)
+		{
+			StepRange(0, m_Num, deltaTime);
+		}
+
+		// Step boards [begin, end).  Ranges that start on a multiple of four touch disjoint SIMD lanes, so they can be
+		// stepped concurrently from different threads.
+		void StepRange(int begin, int end, float deltaTime)
+		{
+#if SKATESIM_USE_SSE
+			StepSSE(begin, end, deltaTime);
+#else
+			StepScalar(begin, end, deltaTime);
+#endif
+		}
+
+		// Step every board through the scalar core, one at a time.  This is the reference the SIMD kernel must match.
+		void StepScalar(float deltaTime)
+		{
+			StepScalar(0, m_Num, deltaTime);
+		}
+
+		void StepScalar(int begin, int end, float deltaTime)
+		{
+			for (int i = begin; i < end; ++i)
+			{
+				FBoardState state;
+				GetState(i, state);
+
+				FGroundContact ground;
+				ground.IsOnGround = (m_Streams[Stream_OnGround][i] != 0.0f);
+				ground.Normal = Load(Stream_NormalX, i);
+				ground.Position = ZeroVec3();
+
+				FBoardInput input;
+				input.Forward = m_Streams[Stream_InputForward][i];
+				input.Right = m_Streams[Stream_InputRight][i];
+
+				FBoardTune tune = DefaultBoardTune();
+				tune.MaxSpeed = m_Streams[Stream_MaxSpeed][i];
+				tune.MinMaxTurnAngleDeg = m_Streams[Stream_TurnAngleDeg][i];
+				tune.ForceScale = m_Streams[Stream_ForceScale][i];
+
+				FBoardOutput output = SkateSim::Step(state, ground, tune, input, Load(Stream_VelX, i), m_Streams[Stream_Mass][i], deltaTime);
+
+				SetState(i, state);
+				Store(Stream_ForceX, i, output.Force);
+				Store(Stream_ImpulseX, i, output.Impulse);
+				m_Streams[Stream_HasForce][i] = (output.HasForce ? 1.0f : 0.0f);
+				m_Streams[Stream_HasImpulse][i] = (output.HasImpulse ? 1.0f : 0.0f);
+			}
+		}
+
+#if SKATESIM_USE_SSE
+		// Step boards [begin, end), four at a time.  Streams are padded to a multiple of four with zeroed boards, which
+		// are off the ground with no input, so the padding lanes are harmless.
+		void StepSSE(int begin, int end, float deltaTime);
+#endif
+
+	private:
+		// One float stream per field.  Vector fields use three consecutive streams (X, Y, Z).
+		enum EStream
+		{
+			// Persistent state
+			Stream_LongX, Stream_LongY, Stream_LongZ,
+			Stream_LatX, Stream_LatY, Stream_LatZ,
+			Stream_PrevVelX, Stream_PrevVelY, Stream_PrevVelZ,
+			Stream_Reverse,
+			Stream_Steering,
+
+			// Tuning
+			Stream_MaxSpeed,
+			Stream_TurnAngleDeg,
+			Stream_ForceScale,
+
+			// Per-frame inputs
+			Stream_OnGround,
+			Stream_NormalX, Stream_NormalY, Stream_NormalZ,
+			Stream_VelX, Stream_VelY, Stream_VelZ,
+			Stream_InputForward,
+			Stream_InputRight,
+			Stream_Mass,
+
+			// Per-frame outputs
+			Stream_ForceX, Stream_ForceY, Stream_ForceZ,
+			Stream_ImpulseX, Stream_ImpulseY, Stream_ImpulseZ,
+			Stream_HasForce,
+			Stream_HasImpulse,
+
+			Stream_Count
+		};
+
+		void Resize(int num)
+		{
+			// Keep every stream padded to a whole number of SIMD lanes.
+			size_t padded = (size_t)((num + 3) & ~3);
+			if (m_Streams[0].size() < padded)
+			{
+				for (int s = 0; s < Stream_Count; ++s)
+					m_Streams[s].resize(padded, 0.0f);
+			}
+		}
+
+		void Store(int stream, int i, const FVec3& v)
+		{
+			m_Streams[stream][i] = v.X;
+			m_Streams[stream + 1][i] = v.Y;
+			m_Streams[stream + 2][i] = v.Z;
+		}
+
+		FVec3 Load(int stream, int i) const
+		{
+			return MakeVec3(m_Streams[stream][i], m_Streams[stream + 1][i], m_Streams[stream + 2][i]);
+		}
+
+		std::vector<float> m_Streams[Stream_Count];
+		int m_Num;
+	};
+
+#if SKATESIM_USE_SSE
+	namespace SSE
+	{
+		// Four 3D vectors, one per lane.
+		struct FVec3x4
+		{
+			__m128 X;
+			__m128 Y;
+			__m128 Z;
+		};
+
+		inline FVec3x4 Load3(const std::vector<float>* streams, int i)
+		{
+			FVec3x4 v = { _mm_loadu_ps(&streams[0][i]), _mm_loadu_ps(&streams[1][i]), _mm_loadu_ps(&streams[2][i]) };
+			return v;
+		}
+
+		inline void Store3(std::vector<float>* streams, int i, const FVec3x4& v)
+		{
+			_mm_storeu_ps(&streams[0][i], v.X);
+			_mm_storeu_ps(&streams[1][i], v.Y);
+			_mm_storeu_ps(&streams[2][i], v.Z);
+		}
+
+		inline FVec3x4 Add(const FVec3x4& a, const FVec3x4& b) { FVec3x4 r = { _mm_add_ps(a.X, b.X), _mm_add_ps(a.Y, b.Y), _mm_add_ps(a.Z, b.Z) }; return r; }
+		inline FVec3x4 Sub(const FVec3x4& a, const FVec3x4& b) { FVec3x4 r = { _mm_sub_ps(a.X, b.X), _mm_sub_ps(a.Y, b.Y), _mm_sub_ps(a.Z, b.Z) }; return r; }
+		inline FVec3x4 Scale(const FVec3x4& a, __m128 s) { FVec3x4 r = { _mm_mul_ps(a.X, s), _mm_mul_ps(a.Y, s), _mm_mul_ps(a.Z, s) }; return r; }
+
+		inline __m128 Dot(const FVec3x4& a, const FVec3x4& b)
+		{
+			return _mm_add_ps(_mm_add_ps(_mm_mul_ps(a.X, b.X), _mm_mul_ps(a.Y, b.Y)), _mm_mul_ps(a.Z, b.Z));
+		}
+
+		inline FVec3x4 Cross(const FVec3x4& a, const FVec3x4& b)
+		{
+			FVec3x4 r = {
+				_mm_sub_ps(_mm_mul_ps(a.Y, b.Z), _mm_mul_ps(a.Z, b.Y)),
+				_mm_sub_ps(_mm_mul_ps(a.Z, b.X), _mm_mul_ps(a.X, b.Z)),
+				_mm_sub_ps(_mm_mul_ps(a.X, b.Y), _mm_mul_ps(a.Y, b.X)) };
+			return r;
+		}
+
+		// mask ? a : b, per lane
+		inline __m128 Select(__m128 mask, __m128 a, __m128 b) { return _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b)); }
+		inline FVec3x4 Select(__m128 mask, const FVec3x4& a, const FVec3x4& b)
+		{
+			FVec3x4 r = { Select(mask, a.X, b.X), Select(mask, a.Y, b.Y), Select(mask, a.Z, b.Z) };
+			return r;
+		}
+
+		inline FVec3x4 Negate(const FVec3x4& a)
+		{
+			const __m128 signBit = _mm_set1_ps(-0.0f);
+			FVec3x4 r = { _mm_xor_ps(a.X, signBit), _mm_xor_ps(a.Y, signBit), _mm_xor_ps(a.Z, signBit) };
+			return r;
+		}
+
+		// sin/cos of x (radians) for |x| <= pi/2, via Taylor series through x^11 / x^12.
+		inline void SinCos(__m128 x, __m128& sinOut, __m128& cosOut)
+		{
+			const __m128 x2 = _mm_mul_ps(x, x);
+
+			__m128 s = _mm_set1_ps(-1.0f / 39916800.0f);
+			s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(1.0f / 362880.0f));
+			s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.0f / 5040.0f));
+			s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(1.0f / 120.0f));
+			s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(-1.0f / 6.0f));
+			s = _mm_add_ps(_mm_mul_ps(s, x2), _mm_set1_ps(1.0f));
+			sinOut = _mm_mul_ps(s, x);
+
+			__m128 c = _mm_set1_ps(1.0f / 479001600.0f);
+			c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-1.0f / 3628800.0f));
+			c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(1.0f / 40320.0f));
+			c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-1.0f / 720.0f));
+			c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(1.0f / 24.0f));
+			c = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(-0.5f));
+			cosOut = _mm_add_ps(_mm_mul_ps(c, x2), _mm_set1_ps(1.0f));
+		}
+
+		// Same formula as SkateSim::RotateAngleAxis(), with sin/cos precomputed.
+		inline FVec3x4 RotateAxis(const FVec3x4& v, __m128 S, __m128 C, const FVec3x4& axis)
+		{
+			const __m128 XX = _mm_mul_ps(axis.X, axis.X);
+			const __m128 YY = _mm_mul_ps(axis.Y, axis.Y);
+			const __m128 ZZ = _mm_mul_ps(axis.Z, axis.Z);
+			const __m128 XY = _mm_mul_ps(axis.X, axis.Y);
+			const __m128 YZ = _mm_mul_ps(axis.Y, axis.Z);
+			const __m128 ZX = _mm_mul_ps(axis.Z, axis.X);
+			const __m128 XS = _mm_mul_ps(axis.X, S);
+			const __m128 YS = _mm_mul_ps(axis.Y, S);
+			const __m128 ZS = _mm_mul_ps(axis.Z, S);
+			const __m128 OMC = _mm_sub_ps(_mm_set1_ps(1.0f), C);
+
+			FVec3x4 r;
+			r.X = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(OMC, XX), C), v.X),
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(OMC, XY), ZS), v.Y)),
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(OMC, ZX), YS), v.Z));
+			r.Y = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(OMC, XY), ZS), v.X),
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(OMC, YY), C), v.Y)),
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(OMC, YZ), XS), v.Z));
+			r.Z = _mm_add_ps(_mm_add_ps(
+				_mm_mul_ps(_mm_sub_ps(_mm_mul_ps(OMC, ZX), YS), v.X),
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(OMC, YZ), XS), v.Y)),
+				_mm_mul_ps(_mm_add_ps(_mm_mul_ps(OMC, ZZ), C), v.Z));
+			return r;
+		}
+
+		inline __m128 Clamp(__m128 x, __m128 lo, __m128 hi) { return _mm_min_ps(_mm_max_ps(x, lo), hi); }
+	}
+
+	inline void FBoardBatch::StepSSE(int begin, int end, float deltaTime)
+	{
+		using namespace SSE;
+
+		const __m128 zero = _mm_setzero_ps();
+		const __m128 one = _mm_set1_ps(1.0f);
+		const __m128 minusOne = _mm_set1_ps(-1.0f);
+		const __m128 half = _mm_set1_ps(0.5f);
+		const __m128 dt = _mm_set1_ps(deltaTime);
+		const __m128 speedThresh = _mm_set1_ps(5.0f);
+		const __m128 steerSpeedThresh = _mm_set1_ps(1.0f);
+		const __m128 degToRad = _mm_set1_ps(3.1415926535897932f / 180.0f);
+		const __m128 normalizeThresh = _mm_set1_ps(1.e-8f);
+
+		std::vector<float>* s = m_Streams;
+
+		for (int i = begin; i < end; i += 4)
+		{
+			// Gather
+			FVec3x4 longVec = Load3(&s[Stream_LongX], i);
+			FVec3x4 latVec = Load3(&s[Stream_LatX], i);
+			FVec3x4 normal = Load3(&s[Stream_NormalX], i);
+			FVec3x4 vel = Load3(&s[Stream_VelX], i);
+			__m128 reverse = _mm_cmpneq_ps(_mm_loadu_ps(&s[Stream_Reverse][i]), zero);
+			__m128 onGround = _mm_cmpneq_ps(_mm_loadu_ps(&s[Stream_OnGround][i]), zero);
+			__m128 inputFwd = _mm_loadu_ps(&s[Stream_InputForward][i]);
+			__m128 inputRight = _mm_loadu_ps(&s[Stream_InputRight][i]);
+
+			///// UpdateOrientation /////
+
+			// Velocity with the component toward the ground normal removed.
+			FVec3x4 planarVel = Sub(vel, Scale(normal, Dot(vel, normal)));
+			__m128 planarSpeed = _mm_sqrt_ps(Dot(planarVel, planarVel));
+			__m128 moving = _mm_and_ps(onGround, _mm_cmpgt_ps(planarSpeed, speedThresh));
+			__m128 stopped = _mm_andnot_ps(moving, onGround);
+
+			// Moving: point along the direction of travel.
+			__m128 movingReverse = _mm_cmplt_ps(Dot(planarVel, longVec), zero);
+			FVec3x4 movingLong = Scale(planarVel, _mm_div_ps(one, planarSpeed));
+			movingLong = Select(movingReverse, Negate(movingLong), movingLong);
+			FVec3x4 movingLat = Cross(normal, movingLong);
+
+			// Stopped: keep the lateral vector and re-derive longitudinal from the ground normal.
+			FVec3x4 stoppedLong = Cross(latVec, normal);
+
+			longVec = Select(moving, movingLong, Select(stopped, stoppedLong, longVec));
+			latVec = Select(moving, movingLat, latVec);
+			reverse = Select(moving, movingReverse, reverse);
+
+			///// UpdateSteering /////
+
+			__m128 steering = Clamp(inputRight, minusOne, one);
+
+			///// Forces /////
+
+			FVec3x4 fwd = Select(reverse, Negate(longVec), longVec);
+			FVec3x4 right = Select(reverse, Negate(latVec), latVec);
+			FVec3x4 up = Cross(fwd, right);
+
+			__m128 turnAngle = _mm_loadu_ps(&s[Stream_TurnAngleDeg][i]);
+			__m128 steerDeg = _mm_add_ps(_mm_sub_ps(zero, turnAngle), _mm_mul_ps(_mm_mul_ps(_mm_add_ps(inputRight, one), half), _mm_add_ps(turnAngle, turnAngle)));
+			__m128 sinSteer, cosSteer;
+			SinCos(_mm_mul_ps(steerDeg, degToRad), sinSteer, cosSteer);
+
+			// Forward force: only when pushing forward on the ground.
+			__m128 pushing = _mm_and_ps(onGround, _mm_cmpgt_ps(inputFwd, zero));
+			FVec3x4 fwdForce = Scale(RotateAxis(fwd, sinSteer, cosSteer, up), Clamp(inputFwd, zero, one));
+			fwdForce.X = _mm_and_ps(pushing, fwdForce.X);
+			fwdForce.Y = _mm_and_ps(pushing, fwdForce.Y);
+			fwdForce.Z = _mm_and_ps(pushing, fwdForce.Z);
+
+			// Right force: turn the velocity toward the steering direction.
+			__m128 speedSq = Dot(vel, vel);
+			__m128 speed = _mm_sqrt_ps(speedSq);
+			__m128 steerable = _mm_and_ps(onGround, _mm_cmpgt_ps(speed, steerSpeedThresh));
+			FVec3x4 rightForce = Scale(Sub(RotateAxis(vel, sinSteer, cosSteer, up), vel), dt);
+			rightForce.X = _mm_and_ps(steerable, rightForce.X);
+			rightForce.Y = _mm_and_ps(steerable, rightForce.Y);
+			rightForce.Z = _mm_and_ps(steerable, rightForce.Z);
+
+			///// Movement /////
+
+			__m128 maxSpeed = _mm_loadu_ps(&s[Stream_MaxSpeed][i]);
+			__m128 forceScale = _mm_mul_ps(_mm_loadu_ps(&s[Stream_ForceScale][i]), _mm_loadu_ps(&s[Stream_Mass][i]));
+			__m128 overSpeed = _mm_cmpgt_ps(speed, maxSpeed);
+			__m128 hasInput = _mm_or_ps(_mm_cmpneq_ps(inputFwd, zero), _mm_cmpneq_ps(inputRight, zero));
+
+			// Over max speed: impulse back down to max speed, plus steering only.
+			__m128 invSpeed = Select(_mm_cmpgt_ps(speedSq, normalizeThresh), _mm_div_ps(one, speed), one);
+			FVec3x4 impulse = Scale(vel, _mm_mul_ps(invSpeed, _mm_sub_ps(maxSpeed, speed)));
+			impulse.X = _mm_and_ps(overSpeed, impulse.X);
+			impulse.Y = _mm_and_ps(overSpeed, impulse.Y);
+			impulse.Z = _mm_and_ps(overSpeed, impulse.Z);
+
+			__m128 hasForce = _mm_or_ps(overSpeed, hasInput);
+			FVec3x4 force = Scale(Select(overSpeed, rightForce, SSE::Add(fwdForce, rightForce)), forceScale);
+			force.X = _mm_and_ps(hasForce, force.X);
+			force.Y = _mm_and_ps(hasForce, force.Y);
+			force.Z = _mm_and_ps(hasForce, force.Z);
+
+			// Scatter
+			Store3(&s[Stream_LongX], i, longVec);
+			Store3(&s[Stream_LatX], i, latVec);
+			_mm_storeu_ps(&s[Stream_Reverse][i], _mm_and_ps(reverse, one));
+			_mm_storeu_ps(&s[Stream_Steering][i], steering);
+			Store3(&s[Stream_ForceX], i, force);
+			Store3(&s[Stream_ImpulseX], i, impulse);
+			_mm_storeu_ps(&s[Stream_HasForce][i], _mm_and_ps(hasForce, one));
+			_mm_storeu_ps(&s[Stream_HasImpulse][i], _mm_and_ps(overSpeed, one));
+		}
+	}
+#endif
+}
@@ -0,0 +1,48 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+/**
+* Engine-independent half of the wheel contact query.
+*
+* UGroundStateComponent sweeps one thin box, the size of the board's wheelbase, down through the probe range, and
+* takes every component it touches as a candidate.  The scene returns at most one touch per shape, so a whole park
+* mesh or landscape comes back as a single hit; the sweep only says which components are worth looking at.  Each
+* wheel's probe line is then traced against each candidate alone, which is cheap (no scene query), and finds the face
+* actually under that wheel.  The wheel rests on the nearest of those hits it can ride on.  So a board half over a
+* ledge or rail stays held up by the edge it's resting on, wheels follow ramp transitions and lips face by face, and
+* the broad phase is walked once instead of four times.
+*/
+namespace SkateSim
+{
+	// Where one wheel's probe line met one candidate surface.
+	struct FWheelTraceHit
+	{
+		float Time;			// Along the probe, from 0 at its start to 1 at its end
+		FVec3 Normal;		// The surface normal there
+	};
+
+	// Which of a wheel's hits along probe it rests on: the nearest one facing the probe by at least minFacing (the
+	// cosine of the angle between the probe and the surface normal, reversed).  Anything steeper is a wall or the
+	// side of a rail, and is passed over.  Returns the hit's index, or -1 if there's none.
+	inline int SelectWheelContact(const FWheelTraceHit* hits, int numHits, const FVec3& probe, float minFacing)
+	{
+		const float maxAlong = -minFacing * Size(probe);
+		float bestTime = 2.0f;
+		int bestHit = -1;
+		for (int i = 0; i < numHits; ++i)
+		{
+			if (Dot(probe, hits[i].Normal) >= maxAlong)
+				continue;	// Too steep to ride, or facing away
+
+			if (hits[i].Time >= 0.0f && hits[i].Time <= 1.0f && hits[i].Time < bestTime)
+			{
+				bestTime = hits[i].Time;
+				bestHit = i;
+			}
+		}
+		return bestHit;
+	}
+}
@@ -0,0 +1,174 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+#include <stdint.h>
+
+/**
+* Collision contacts, gathered as they're reported and boiled down once per tick.
+*
+* Grinding along a rail or scraping a wall reports a contact every physics step, often several, and mostly the same
+* one over and over.  ASkateboardSimPawn appends each to an FContactBuffer as a compact record and, once per tick
+* before probing the ground, merges the records against the same primitive and surface with near enough the same
+* normal into one.  What's left is summed up for the ground state in an FContactSummary.
+*/
+namespace SkateSim
+{
+	// One contact, as reported.
+	struct FContactRecord
+	{
+		FVec3 Normal;		// Pointing away from what we hit
+		FVec3 Position;
+		float Impulse;		// Size of the impulse that resolved it; 0 for swept (kinematic) contacts
+		uint32_t OtherId;	// Identifies the primitive we hit
+		uint32_t SurfaceId;	// Identifies its surface (physical material); 0 if none
+		int Count;			// How many reported contacts were merged into this one
+	};
+
+	// The contacts one tick's ground state needs to know about.
+	struct FContactSummary
+	{
+		int NumContacts;		// After merging
+		int NumReported;		// Before merging
+
+		// The contact that took the largest impulse (or, with none, the last one reported).  Only valid if
+		// NumContacts > 0.
+		FContactRecord Strongest;
+
+		// The contact best placed to hold the board up: the one whose normal is closest to up.  Only valid if
+		// HasSupport is true.
+		bool HasSupport;
+		FContactRecord Support;
+	};
+
+	// Contacts reported since the last tick, up to Capacity of them.
+	class FContactBuffer
+	{
+	public:
+		enum { Capacity = 16 };
+
+		FContactBuffer() { Reset(); }
+
+		void Reset()
+		{
+			m_Num = 0;
+			m_Reported = 0;
+			m_Dropped = 0;
+		}
+
+		int Num() const { return m_Num; }
+		const FContactRecord& operator[](int index) const { return m_Records[index]; }
+
+		// How many contacts were reported, and how many of those had to be thrown away for lack of room, since the
+		// last Reset().
+		int NumReported() const { return m_Reported; }
+		int NumDropped() const { return m_Dropped; }
+
+		// Record a contact.  When the buffer is full, it's merged down to make room; if that doesn't, the contact
+		// replaces the weakest one recorded, if it's stronger.
+		void Add(const FVec3& normal, const FVec3& position, float impulse, uint32_t otherId, uint32_t surfaceId, float mergeCos)
+		{
+			++m_Reported;
+			if (m_Num == Capacity)
+				Merge(mergeCos);
+
+			int slot = m_Num;
+			if (slot == Capacity)
+			{
+				slot = 0;
+				for (int i = 1; i < m_Num; ++i)
+				{
+					if (m_Records[i].Impulse < m_Records[slot].Impulse)
+						slot = i;
+				}
+				++m_Dropped;
+				if (m_Records[slot].Impulse > impulse)
+					return;
+			}
+			else
+			{
+				++m_Num;
+			}
+
+			FContactRecord& record = m_Records[slot];
+			record.Normal = normal;
+			record.Position = position;
+			record.Impulse = impulse;
+			record.OtherId = otherId;
+			record.SurfaceId = surfaceId;
+			record.Count = 1;
+		}
+
+		// Merge records against the same primitive and surface whose normals are within mergeCos (the cosine of the
+		// angle between them) of each other.  Normals are averaged, weighted by impulse; the impulses are summed, and
+		// the position is the latest one's.
+		void Merge(float mergeCos)
+		{
+			int num = 0;
+			for (int i = 0; i < m_Num; ++i)
+			{
+				const FContactRecord& record = m_Records[i];
+				int into = -1;
+				for (int j = 0; j < num; ++j)
+				{
+					const FContactRecord& merged = m_Records[j];
+					if (merged.OtherId == record.OtherId && merged.SurfaceId == record.SurfaceId && Dot(merged.Normal, record.Normal) >= mergeCos)
+					{
+						into = j;
+						break;
+					}
+				}
+
+				if (into < 0)
+				{
+					m_Records[num++] = record;
+					continue;
+				}
+
+				FContactRecord& merged = m_Records[into];
+				const float weight = (merged.Impulse + record.Impulse > 0.0f ? record.Impulse / (merged.Impulse + record.Impulse) : 1.0f / (merged.Count + 1));
+				FVec3 normal = merged.Normal + (record.Normal - merged.Normal) * weight;
+				if (Normalize(normal))
+					merged.Normal = normal;
+				merged.Position = record.Position;
+				merged.Impulse += record.Impulse;
+				merged.Count += record.Count;
+			}
+			m_Num = num;
+		}
+
+		// Merge, then sum up what's left.  A contact supports the board if its normal is within supportCos of up.
+		void Summarize(float mergeCos, const FVec3& up, float supportCos, FContactSummary& summaryOut)
+		{
+			Merge(mergeCos);
+
+			summaryOut.NumContacts = m_Num;
+			summaryOut.NumReported = m_Reported;
+			summaryOut.HasSupport = false;
+
+			float bestSupport = supportCos;
+			for (int i = 0; i < m_Num; ++i)
+			{
+				const FContactRecord& record = m_Records[i];
+				if (i == 0 || record.Impulse >= summaryOut.Strongest.Impulse)
+					summaryOut.Strongest = record;
+
+				const float support = Dot(record.Normal, up);
+				if (support >= bestSupport)
+				{
+					bestSupport = support;
+					summaryOut.Support = record;
+					summaryOut.HasSupport = true;
+				}
+			}
+		}
+
+	private:
+		FContactRecord m_Records[Capacity];
+		int m_Num;
+		int m_Reported;
+		int m_Dropped;
+	};
+}
@@ -0,0 +1,427 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include <cmath>
+
+/**
+* Engine-independent skateboard simulation core.
+*
+* Everything in here is plain C++ with no UObject, UWorld or physics dependencies, so that it can be stepped
+* from ASkateboardSimPawn and from headless tools (see Source/Programs/SkateboardSimBench) alike.  The pawn
+* is responsible for gathering the ground contact and body velocity, calling into the core, and applying the
+* resulting force/impulse to its physics body.
+*
+* Conventions match UE4: +X forward, +Y right, +Z up, centimeters, and LEFT-handed cross products
+* (i.e. forward X right = up).
+*
+* @see ASkateboardSimPawn
+*/
+namespace SkateSim
+{
+	///// Vector math /////
+
+	// Minimal 3D vector; layout-compatible with FVector.
+	struct FVec3
+	{
+		float X;
+		float Y;
+		float Z;
+	};
+
+	inline FVec3 MakeVec3(float x, float y, float z) { FVec3 v = { x, y, z }; return v; }
+	inline FVec3 ZeroVec3() { return MakeVec3(0.0f, 0.0f, 0.0f); }
+	inline FVec3 UpVec3() { return MakeVec3(0.0f, 0.0f, 1.0f); }
+
+	inline FVec3 operator+(const FVec3& a, const FVec3& b) { return MakeVec3(a.X + b.X, a.Y + b.Y, a.Z + b.Z); }
+	inline FVec3 operator-(const FVec3& a, const FVec3& b) { return MakeVec3(a.X - b.X, a.Y - b.Y, a.Z - b.Z); }
+	inline FVec3 operator-(const FVec3& a) { return MakeVec3(-a.X, -a.Y, -a.Z); }
+	inline FVec3 operator*(const FVec3& a, float s) { return MakeVec3(a.X * s, a.Y * s, a.Z * s); }
+	inline FVec3& operator+=(FVec3& a, const FVec3& b) { a.X += b.X; a.Y += b.Y; a.Z += b.Z; return a; }
+	inline FVec3& operator-=(FVec3& a, const FVec3& b) { a.X -= b.X; a.Y -= b.Y; a.Z -= b.Z; return a; }
+
+	inline float Dot(const FVec3& a, const FVec3& b) { return a.X * b.X + a.Y * b.Y + a.Z * b.Z; }
+
+	inline FVec3 Cross(const FVec3& a, const FVec3& b)
+	{
+		return MakeVec3(a.Y * b.Z - a.Z * b.Y, a.Z * b.X - a.X * b.Z, a.X * b.Y - a.Y * b.X);
+	}
+
+	inline float SizeSquared(const FVec3& v) { return Dot(v, v); }
+	inline float Size(const FVec3& v) { return std::sqrt(SizeSquared(v)); }
+	inline bool IsZero(const FVec3& v) { return v.X == 0.0f && v.Y == 0.0f && v.Z == 0.0f; }
+
+	// Same semantics as FVector::Normalize(): leaves the vector untouched and returns false if it's too small.
+	inline bool Normalize(FVec3& v)
+	{
+		const float squareSum = SizeSquared(v);
+		if (squareSum > 1.e-8f)
+		{
+			const float scale = 1.0f / std::sqrt(squareSum);
+			v = v * scale;
+			return true;
+		}
+		return false;
+	}
+
+	inline float Clamp(float x, float lo, float hi) { return (x < lo ? lo : (x < hi ? x : hi)); }
+	inline float Lerp(float a, float b, float alpha) { return a + alpha * (b - a); }
+	inline float DegreesToRadians(float deg) { return deg * (3.1415926535897932f / 180.0f); }
+
+	// A rotation matrix, so one rotation can be applied to several vectors for a single sin/cos.
+	struct FRotation
+	{
+		float M[3][3];
+	};
+
+	// Same formula as FVector::RotateAngleAxis(), so results match the engine bit-for-bit given the same sin/cos.
+	inline FRotation MakeAngleAxisRotation(float angleDeg, const FVec3& axis)
+	{
+		const float rad = DegreesToRadians(angleDeg);
+		const float S = std::sin(rad);
+		const float C = std::cos(rad);
+
+		const float XX = axis.X * axis.X;
+		const float YY = axis.Y * axis.Y;
+		const float ZZ = axis.Z * axis.Z;
+		const float XY = axis.X * axis.Y;
+		const float YZ = axis.Y * axis.Z;
+		const float ZX = axis.Z * axis.X;
+		const float XS = axis.X * S;
+		const float YS = axis.Y * S;
+		const float ZS = axis.Z * S;
+		const float OMC = 1.0f - C;
+
+		FRotation r;
+		r.M[0][0] = OMC * XX + C;	r.M[0][1] = OMC * XY - ZS;	r.M[0][2] = OMC * ZX + YS;
+		r.M[1][0] = OMC * XY + ZS;	r.M[1][1] = OMC * YY + C;	r.M[1][2] = OMC * YZ - XS;
+		r.M[2][0] = OMC * ZX - YS;	r.M[2][1] = OMC * YZ + XS;	r.M[2][2] = OMC * ZZ + C;
+		return r;
+	}
+
+	inline FRotation IdentityRotation()
+	{
+		FRotation r = { { { 1.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, { 0.0f, 0.0f, 1.0f } } };
+		return r;
+	}
+
+	inline FVec3 Rotate(const FRotation& r, const FVec3& v)
+	{
+		return MakeVec3(
+			r.M[0][0] * v.X + r.M[0][1] * v.Y + r.M[0][2] * v.Z,
+			r.M[1][0] * v.X + r.M[1][1] * v.Y + r.M[1][2] * v.Z,
+			r.M[2][0] * v.X + r.M[2][1] * v.Y + r.M[2][2] * v.Z);
+	}
+
+	inline FVec3 RotateAngleAxis(const FVec3& v, float angleDeg, const FVec3& axis)
+	{
+		return Rotate(MakeAngleAxisRotation(angleDeg, axis), v);
+	}
+
+	///// Simulation state /////
+
+	// Tuning values, mirrored from USkateboardTune.
+	struct FBoardTune
+	{
+		float MaxSpeed;				// The maximum speed, in cm/second
+		float MinMaxTurnAngleDeg;	// The min/max turn angle, in degrees
+		float DeckHeight;			// The height of the deck off the ground, in cm
+		float TruckSpacing;			// The distance between the centers of the two trucks, in cm
+		float AxleLength;			// The distance between the two wheels on the same truck, in cm
+		float ForceScale;			// Force applied per unit of mass at full input, in cm/s^2
+	};
+
+	// Defaults, matching USkateboardTune's.
+	inline FBoardTune DefaultBoardTune()
+	{
+		FBoardTune tune;
+		tune.MaxSpeed = 600.0f;
+		tune.MinMaxTurnAngleDeg = 10.0f;
+		tune.DeckHeight = 10.0f;
+		tune.TruckSpacing = 55.0f;
+		tune.AxleLength = 20.0f;
+		tune.ForceScale = 800.0f;
+		return tune;
+	}
+
+	// Normalized movement input, each axis in [-1, 1].
+	struct FBoardInput
+	{
+		float Forward;
+		float Right;
+	};
+
+	// The result of the ground probe.
+	struct FGroundContact
+	{
+		bool IsOnGround;
+		FVec3 Position;
+		FVec3 Normal;
+	};
+
+	// Orientation and steering state carried from tick to tick.
+	struct FBoardState
+	{
+		FVec3 LateralVector;		// Perpendicular to LongitudinalVector; LongitudinalVector X LateralVector = ground normal.
+		FVec3 LongitudinalVector;	// Direction board is pointing; velocity is +/- this vector.
+		bool Reverse;				// If true, velocity is negative along LongitudinalVector.
+		float Steering;				// Normalized steering value
+		FVec3 PrevVelocity;			// Body velocity at the end of the previous tick
+	};
+
+	// What the caller should apply to the physics body this tick.  Force is in mass units (i.e. already scaled by mass),
+	// and the impulse is applied as-is.
+	struct FBoardOutput
+	{
+		FVec3 Force;
+		FVec3 Impulse;
+		bool HasForce;
+		bool HasImpulse;
+	};
+
+	// Everything a tick derives from the body's velocity and the board's orientation, worked out once and then read by
+	// each phase.  BeginFrame() fills in the velocity terms after the ground probe, UpdateOrientation() the basis, and
+	// UpdateSteering() the steering rotation.
+	struct FBoardFrame
+	{
+		FVec3 Velocity;
+		float Speed;
+		FVec3 PlanarVelocity;		// Velocity with the part along the ground normal removed
+		float PlanarSpeed;
+
+		FVec3 Forward;				// GetForwardVector(), GetRightVector() and GetUpVector() of the oriented board
+		FVec3 Right;
+		FVec3 Up;
+
+		float SteerAngleDeg;
+		FRotation SteerRotation;	// SteerAngleDeg around Up, if ComputeMovement() will use it; otherwise identity
+	};
+
+	inline void InitBoardState(FBoardState& state, const FVec3& forward, const FVec3& right)
+	{
+		state.LongitudinalVector = forward;
+		state.LateralVector = right;
+		state.Reverse = false;
+		state.Steering = 0.0f;
+		state.PrevVelocity = ZeroVec3();
+	}
+
+	///// Orientation /////
+
+	// Returns a unit vector pointing in the direction of travel.
+	// NOTE: this vector can abruptly reverse, e.g. at the apex of a slope.
+	inline FVec3 GetForwardVector(const FBoardState& state) { return (state.Reverse ? -state.LongitudinalVector : state.LongitudinalVector); }
+
+	// Returns a unit vector pointing perpendicular to the direction of travel.
+	// NOTE: this vector can abruptly reverse, e.g. at the apex of a slope.
+	inline FVec3 GetRightVector(const FBoardState& state) { return (state.Reverse ? -state.LateralVector : state.LateralVector); }
+
+	inline FVec3 GetUpVector(const FBoardState& state) { return Cross(GetForwardVector(state), GetRightVector(state)); }
+
+	// Start a tick's frame from the body velocity and this tick's ground contact.
+	inline void BeginFrame(FBoardFrame& frame, const FGroundContact& ground, const FVec3& velocity)
+	{
+		frame.Velocity = velocity;
+		frame.Speed = Size(velocity);
+
+		// Subtract out speed pointing toward the ground:
+		const float normalSpeed = Dot(velocity, ground.Normal);
+		frame.PlanarVelocity = velocity - ground.Normal * normalSpeed;
+		frame.PlanarSpeed = Size(frame.PlanarVelocity);
+	}
+
+	// Refresh the frame's basis from the board's orientation.
+	inline void UpdateFrameBasis(FBoardFrame& frame, const FBoardState& state)
+	{
+		frame.Forward = GetForwardVector(state);
+		frame.Right = GetRightVector(state);
+		frame.Up = Cross(frame.Forward, frame.Right);
+	}
+
+	// Re-align the board to the ground, based on the frame's body velocity, and update the frame's basis to match.
+	inline void UpdateOrientation(FBoardState& state, const FGroundContact& ground, FBoardFrame& frame)
+	{
+		if (ground.IsOnGround)
+		{
+			// NOTE: THIS NEEDS TO BE REVISITED!
+			// For now, pop the forward vector to point in the direction of motion, after
+			// subtracting out velocity toward ground normal.
+			const float speedThresh = 5.0f;
+			if (frame.PlanarSpeed > speedThresh)
+			{
+				// Use the dot product to determine whether we're moving in reverse
+				state.Reverse = (Dot(frame.PlanarVelocity, state.LongitudinalVector) < 0.0f);
+
+				state.LongitudinalVector = frame.PlanarVelocity * (1.0f / frame.PlanarSpeed);
+				if (state.Reverse)
+					state.LongitudinalVector = -state.LongitudinalVector;
+
+				state.LateralVector = Cross(ground.Normal, state.LongitudinalVector);
+			}
+			else
+			{
+				state.LongitudinalVector = Cross(state.LateralVector, ground.Normal);
+			}
+		}
+
+		UpdateFrameBasis(frame, state);
+	}
+
+	// Reset our orientation to something reasonable, using whichever vector has the smallest "up" amount.
+	inline void ResetOrientation(FBoardState& state, const FVec3& up)
+	{
+		if (std::fabs(state.LongitudinalVector.Z) > std::fabs(state.LateralVector.Z))
+		{
+			state.LongitudinalVector = Cross(state.LateralVector, up);
+			state.LateralVector = Cross(up, state.LongitudinalVector);
+		}
+		else
+		{
+			state.LateralVector = Cross(up, state.LongitudinalVector);
+			state.LongitudinalVector = Cross(state.LateralVector, up);
+		}
+	}
+
+	// Compute desired steering angle, in degrees
+	inline float ComputeSteerAngleDeg(const FBoardTune& tune, const FBoardInput& input)
+	{
+		return Lerp(-tune.MinMaxTurnAngleDeg, tune.MinMaxTurnAngleDeg, (input.Right + 1.0f) * 0.5f);
+	}
+
+	// Will ComputeMovement() rotate anything by the steering angle?  Mirrors its branches.
+	inline bool NeedsSteerRotation(const FGroundContact& ground, const FBoardTune& tune, const FBoardInput& input, const FBoardFrame& frame)
+	{
+		if (!ground.IsOnGround)
+			return false;
+		if (frame.Speed > tune.MaxSpeed)
+			return (frame.Speed > 1.0f);
+		return (input.Forward > 0.0f || ((input.Forward != 0.0f || input.Right != 0.0f) && frame.Speed > 1.0f));
+	}
+
+	// Update the steering, and the frame's steering rotation if this tick's forces will need it.  Call after
+	// UpdateOrientation().
+	inline void UpdateSteering(FBoardState& state, const FGroundContact& ground, const FBoardTune& tune, const FBoardInput& input, FBoardFrame& frame)
+	{
+		// TODO: approach desired steering over time.
+		state.Steering = Clamp(input.Right, -1.0f, 1.0f);
+
+		frame.SteerAngleDeg = ComputeSteerAngleDeg(tune, input);
+		if (NeedsSteerRotation(ground, tune, input, frame))
+			frame.SteerRotation = MakeAngleAxisRotation(frame.SteerAngleDeg, frame.Up);
+		else
+			frame.SteerRotation = IdentityRotation();
+	}
+
+	inline void UpdatePrevVelocity(FBoardState& state, const FVec3& velocity)
+	{
+		state.PrevVelocity = velocity;
+	}
+
+	///// Forces /////
+
+	// Compute unit force (mass==1) to apply in direction of GetForwardVector()
+	inline FVec3 ComputeForwardForce(const FGroundContact& ground, const FBoardInput& input, const FBoardFrame& frame)
+	{
+		if (ground.IsOnGround && input.Forward > 0.0f)
+		{
+			FVec3 newForward = Rotate(frame.SteerRotation, frame.Forward);
+			return newForward * Clamp(input.Forward, 0.0f, 1.0f);
+		}
+		return ZeroVec3();
+	}
+
+	// Compute unit force (mass==1) to apply in direction of GetRightVector()
+	inline FVec3 ComputeRightForce(const FGroundContact& ground, const FBoardFrame& frame, float deltaTime)
+	{
+		if (ground.IsOnGround && frame.Speed > 1.0f)
+		{
+			FVec3 tgtVel = Rotate(frame.SteerRotation, frame.Velocity);
+			return (tgtVel - frame.Velocity) * deltaTime;
+		}
+		return ZeroVec3();
+	}
+
+	// Compute the force/impulse to apply to a body of the given mass.
+	inline FBoardOutput ComputeMovement(const FGroundContact& ground, const FBoardTune& tune, const FBoardInput& input, const FBoardFrame& frame, float mass, float deltaTime)
+	{
+		FBoardOutput output;
+		output.Force = ZeroVec3();
+		output.Impulse = ZeroVec3();
+		output.HasForce = false;
+		output.HasImpulse = false;
+
+		float forceScale = tune.ForceScale * mass;
+
+		if (frame.Speed > tune.MaxSpeed)
+		{
+			FVec3 dir = frame.Velocity * (1.0f / frame.Speed);
+			output.Impulse = dir * (tune.MaxSpeed - frame.Speed);
+			output.HasImpulse = true;
+
+			// Still apply steering even if at max speed.
+			output.Force = ComputeRightForce(ground, frame, deltaTime) * forceScale;
+			output.HasForce = true;
+		}
+		else if (input.Forward != 0.0f || input.Right != 0.0f)
+		{
+			output.Force = (ComputeForwardForce(ground, input, frame) + ComputeRightForce(ground, frame, deltaTime)) * forceScale;
+			output.HasForce = true;
+		}
+
+		return output;
+	}
+
+	// Given previous and current velocity in cm/s, compute the vector from the board to the circular turn pivot.
+	// (The magnitude of the return value is the turn radius in cm.)
+	inline FVec3 ComputeTurnPivot(const FVec3& v1, const FVec3& v2)
+	{
+		float v1mag = Size(v1);
+		float v2mag = Size(v2);
+
+		// If either speed is less than threshold, consider the radius to be zero
+		const float thresh = 0.01f;
+		if (v1mag < thresh || v2mag < thresh)
+			return ZeroVec3();
+
+		float cosTheta = Clamp(Dot(v1, v2) / (v1mag * v2mag), -1.0f, 1.0f);
+		float theta = std::acos(cosTheta);
+		float sinHalfTheta = std::sin(theta * 0.5f);
+		if (sinHalfTheta < 1.e-6f)
+			return ZeroVec3();
+
+		// r = chordlength / 2 * sin (theta/2)
+		float radius = std::fabs(v2mag / (2.0f * sinHalfTheta));
+
+		FVec3 upDown = Cross(v1, v2);
+		Normalize(upDown);
+
+		FVec3 toCenter = Cross(upDown, v2);
+		Normalize(toCenter);
+		return toCenter * radius;
+	}
+
+	// Compute centripetal acceleration, in cm/s^2
+	inline FVec3 ComputeCentripetalAccel(const FBoardState& state, const FVec3& velocity)
+	{
+		FVec3 toCenter = ComputeTurnPivot(state.PrevVelocity, velocity);
+		float turnRadius = Size(toCenter);
+		if (turnRadius < 1.e-4f)
+			return ZeroVec3();
+
+		// A = v^2 / r
+		return toCenter * (SizeSquared(velocity) / (turnRadius * turnRadius));
+	}
+
+	///// Step /////
+
+	// Run one full simulation step: orientation, steering and movement.  The caller applies the returned
+	// force/impulse to its body and then calls UpdatePrevVelocity() with the velocity it used here.
+	inline FBoardOutput Step(FBoardState& state, const FGroundContact& ground, const FBoardTune& tune, const FBoardInput& input, const FVec3& velocity, float mass, float deltaTime)
+	{
+		FBoardFrame frame;
+		BeginFrame(frame, ground, velocity);
+		UpdateOrientation(state, ground, frame);
+		UpdateSteering(state, ground, tune, input, frame);
+		return ComputeMovement(ground, tune, input, frame, mass, deltaTime);
+	}
+}
@@ -0,0 +1,14 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+/**
+* Helpers for moving data between engine types and the engine-independent SkateSim core.
+*/
+namespace SkateSim
+{
+	FORCEINLINE FVec3 ToSim(const FVector& v) { return MakeVec3(v.X, v.Y, v.Z); }
+	FORCEINLINE FVector FromSim(const FVec3& v) { return FVector(v.X, v.Y, v.Z); }
+}
@@ -0,0 +1,85 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+#include <cmath>
+
+/**
+* Engine-independent half of predicting where an airborne board comes down.
+*
+* Once the board leaves the ground nothing but gravity acts on it until it lands or hits something, so its path is a
+* parabola known from the moment it takes off.  UGroundStateComponent follows that arc with a few straight queries
+* (chords short enough to stay within a set distance of the curve) to find where the probes will next reach the
+* ground, and skips probing until shortly before then.  Each tick the board's actual position and velocity are
+* checked against the arc, and it's predicted again if they've drifted (drag, an impulse) by enough to move the
+* landing.
+*/
+namespace SkateSim
+{
+	// A ballistic path: where the board was and how fast it was going when it was predicted, and gravity.
+	struct FFlightArc
+	{
+		FVec3 Origin;
+		FVec3 Velocity;
+		float GravityZ;
+
+		FVec3 PositionAt(float time) const
+		{
+			return MakeVec3(Origin.X + Velocity.X * time, Origin.Y + Velocity.Y * time, Origin.Z + (Velocity.Z + 0.5f * GravityZ * time) * time);
+		}
+
+		FVec3 VelocityAt(float time) const
+		{
+			return MakeVec3(Velocity.X, Velocity.Y, Velocity.Z + GravityZ * time);
+		}
+	};
+
+	// What one prediction found.  Times are from the start of the arc.
+	struct FFlightPrediction
+	{
+		FFlightArc Arc;
+		bool Lands;					// False if the arc didn't reach the ground within EndTime
+		float EndTime;				// When the probes reach the ground, or how far ahead we looked if they don't
+		FVec3 LandingPosition;		// Only valid if Lands
+		FVec3 LandingNormal;
+	};
+
+	// How long each chord along an arc can last and stay within maxError of it.  A parabola's chord of duration t
+	// bows |g| t^2 / 8 from the curve at its middle.
+	inline float GetFlightChordTime(float gravityZ, float maxError)
+	{
+		const float g = std::fabs(gravityZ);
+		return (g > 0.0f ? std::sqrt(8.0f * maxError / g) : 1.0f);
+	}
+
+	// How far from the predicted landing the board would come down, if it carried on from position and velocity at
+	// the given time on the arc.  To first order: today's position error plus the velocity error over the time left.
+	inline float GetFlightDrift(const FFlightPrediction& prediction, float time, const FVec3& position, const FVec3& velocity)
+	{
+		const float timeLeft = (prediction.EndTime > time ? prediction.EndTime - time : 0.0f);
+		return Size((position - prediction.Arc.PositionAt(time)) + (velocity - prediction.Arc.VelocityAt(time)) * timeLeft);
+	}
+
+	// Turn the board's up vector toward the surface it's about to land on, timeLeft before it lands, so it gets there
+	// as it touches down instead of being snapped round on impact.  Over the last alignTime, each call covers the
+	// fraction of the remaining turn that this step is of the remaining time.
+	inline void AlignForLanding(FBoardState& state, const FVec3& landingNormal, float timeLeft, float alignTime, float deltaTime)
+	{
+		// Nothing to line up with on the underside of something.
+		if (timeLeft > alignTime || alignTime <= 0.0f || landingNormal.Z <= 0.0f)
+			return;
+
+		const float fraction = (timeLeft > deltaTime ? deltaTime / timeLeft : 1.0f);
+		const FVec3 currentUp = GetUpVector(state);
+		FVec3 up = currentUp + (landingNormal - currentUp) * fraction;
+		if (!Normalize(up))
+			return;
+
+		// ResetOrientation() keeps whichever of our vectors is nearest level, but doesn't keep it unit length.
+		ResetOrientation(state, up);
+		Normalize(state.LongitudinalVector);
+		Normalize(state.LateralVector);
+	}
+}
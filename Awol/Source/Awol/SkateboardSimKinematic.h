@@ -0,0 +1,62 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+/**
+* Engine-independent pieces of moving a board without a rigid body.
+*
+* A board in kinematic mode (ASkateboardSimPawn::UseKinematicMovement) integrates its own velocity from the forces the
+* simulation computes, is held up by the ground it probed rather than by contact generation, and sweeps its capsule
+* along the rest of the move, sliding along whatever it hits.  The sweeps are the engine's; everything else is here,
+* and SkateSim::PredictBody() uses the same integration and ground support to stand in for the rigid body during
+* resimulation.
+*/
+namespace SkateSim
+{
+	// Apply a step's impulse and force, and gravity, to a velocity.
+	inline void IntegrateVelocity(FVec3& velocity, const FBoardOutput& output, float mass, float gravityZ, float deltaTime)
+	{
+		const float invMass = 1.0f / mass;
+		if (output.HasImpulse)
+			velocity += output.Impulse * invMass;
+		if (output.HasForce)
+			velocity += output.Force * (invMass * deltaTime);
+		velocity.Z += gravityZ * deltaTime;
+	}
+
+	// Keep a body at least rideHeight above the ground it's on, and stop it moving into the ground.  Returns true if
+	// the ground is holding the body up (it's less than rideHeight + tolerance above it).
+	inline bool SupportOnGround(FVec3& position, FVec3& velocity, const FGroundContact& ground, float rideHeight, float tolerance)
+	{
+		if (!ground.IsOnGround)
+			return false;
+
+		const float height = Dot(position - ground.Position, ground.Normal);
+		if (height >= rideHeight + tolerance)
+			return false;
+
+		if (height < rideHeight)
+			position += ground.Normal * (rideHeight - height);
+		const float intoGround = Dot(velocity, ground.Normal);
+		if (intoGround < 0.0f)
+			velocity -= ground.Normal * intoGround;
+		return true;
+	}
+
+	// Respond to hitting a surface: the part of the velocity into it is removed, or reflected by restitution.
+	inline void ResolveContact(FVec3& velocity, const FVec3& normal, float restitution)
+	{
+		const float intoSurface = Dot(velocity, normal);
+		if (intoSurface < 0.0f)
+			velocity -= normal * (intoSurface * (1.0f + restitution));
+	}
+
+	// What's left of a move after it was blocked hitTime of the way along, slid along the surface it hit.
+	inline FVec3 SlideAlongSurface(const FVec3& delta, float hitTime, const FVec3& normal)
+	{
+		const FVec3 remaining = delta * (1.0f - hitTime);
+		return remaining - normal * Dot(remaining, normal);
+	}
+}
@@ -0,0 +1,833 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "SkateboardSimManager.h"
+#include "SkateboardSimPawn.h"
+#include "SkateboardSimProfiler.h"
+#include "GroundStateComponent.h"
+#include "SkateboardSpringArmComponent.h"
+#include "ParallelFor.h"
+
+DEFINE_STAT(STAT_SkateboardTickDispatches);
+
+DECLARE_CYCLE_STAT(TEXT("Central Tick"), STAT_SkateboardCentralTick, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Central Tick: Ground Probes"), STAT_SkateboardCentralProbe, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Central Tick: Movement"), STAT_SkateboardCentralMovement, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Central Tick: Visuals"), STAT_SkateboardCentralVisuals, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Central Tick: Apply Forces"), STAT_SkateboardCentralApply, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Batch Step"), STAT_SkateboardBatchStep, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Batch Apply"), STAT_SkateboardBatchApply, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Batch Boards"), STAT_SkateboardBatchBoards, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Boards Simulated"), STAT_SkateboardBoardsSimulated, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Boards at Tier: Full"), STAT_SkateboardTierFull, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Boards at Tier: Reduced"), STAT_SkateboardTierReduced, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Boards at Tier: Low"), STAT_SkateboardTierLow, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Boards at Tier: Dormant"), STAT_SkateboardTierDormant, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Boards Stepped"), STAT_SkateboardBoardsStepped, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Pivot Writes Flush"), STAT_SkateboardPivotFlush, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pivot Writes"), STAT_SkateboardPivotWrites, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pivot Writes Skipped: Unchanged"), STAT_SkateboardPivotWritesUnchanged, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Camera Sweeps"), STAT_SkateboardCameraSweeps, STATGROUP_SkateboardSim);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Net Movement Bytes/s per Board"), STAT_SkateboardNetBytesPerBoard, STATGROUP_SkateboardSim);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Net Movement Bytes/s per Board (Full Precision)"), STAT_SkateboardNetRawBytesPerBoard, STATGROUP_SkateboardSim);
+
+static TAutoConsoleVariable<int32> CVarSkateboardCentralTick(
+	TEXT("skate.CentralTick"),
+	1,
+	TEXT("1: ASkateboardSimManager ticks every skateboard pawn from a single tick function (default).\n")
+	TEXT("0: each pawn ticks itself.  Compare 'Tick Functions Dispatched' and the tick cycle stats in 'stat SkateboardSim'."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarSkateboardParallelSim(
+	TEXT("skate.ParallelSim"),
+	1,
+	TEXT("1: when centrally ticked, fan ground probes and force computation out over the task graph (default).\n")
+	TEXT("0: run every phase on the game thread."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarSkateboardParallelChunkSize(
+	TEXT("skate.ParallelChunkSize"),
+	4,
+	TEXT("Number of boards per task when skate.ParallelSim is on.  Batched boards are chunked in multiples of four to keep SIMD lanes disjoint."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardNetFullRateDistance(
+	TEXT("skate.NetFullRateDistance"),
+	2000.0f,
+	TEXT("Boards within this distance (cm) of a player are replicated at their NetMaxUpdateRate."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardNetMinRateDistance(
+	TEXT("skate.NetMinRateDistance"),
+	15000.0f,
+	TEXT("Boards beyond this distance (cm) from every player are replicated at their NetMinUpdateRate."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<int32> CVarSkateboardSimLOD(
+	TEXT("skate.SimLOD"),
+	1,
+	TEXT("1: drop boards far from every player's view, or off screen, to cheaper simulation tiers (default).\n")
+	TEXT("0: simulate every board in full."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardSimLODFullDistance(
+	TEXT("skate.SimLODFullDistance"),
+	2000.0f,
+	TEXT("Boards within this distance (cm) of a player's view run the full four-probe simulation."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardSimLODReducedDistance(
+	TEXT("skate.SimLODReducedDistance"),
+	5000.0f,
+	TEXT("Boards within this distance (cm) of a player's view, and beyond skate.SimLODFullDistance, probe with two traces."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardSimLODLowDistance(
+	TEXT("skate.SimLODLowDistance"),
+	12000.0f,
+	TEXT("Boards within this distance (cm) of a player's view, and beyond skate.SimLODReducedDistance, step at their LowTierTickRate.  Beyond it they go dormant."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardSimLODOffscreenScale(
+	TEXT("skate.SimLODOffscreenScale"),
+	3.0f,
+	TEXT("Boards that haven't been rendered recently are treated as this many times further away."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardSimLODHysteresis(
+	TEXT("skate.SimLODHysteresis"),
+	0.15f,
+	TEXT("A board only drops a tier once it's this fraction past the tier's distance; it comes back as soon as it's inside."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardSimLODDropDelay(
+	TEXT("skate.SimLODDropDelay"),
+	1.0f,
+	TEXT("Seconds a board has to have wanted a cheaper tier before it drops to it.  Raising a tier is immediate."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardPivotUpdateThreshold(
+	TEXT("skate.PivotUpdateThreshold"),
+	0.1f,
+	TEXT("Board and rider model pivots aren't moved for rotations smaller than this, in degrees."),
+	ECVF_Default);
+
+// How often send rates are re-evaluated.
+static const float NetRateUpdateInterval = 0.25f;
+
+// How often simulation tiers are re-evaluated.
+static const float SimTierUpdateInterval = 0.25f;
+
+namespace
+{
+	// The tier for a board at the given (significance-scaled) distance, coming from the given tier.  Going down a
+	// tier takes being past its distance by the hysteresis fraction; coming back up only takes being inside it.
+	ESkateSimTier::Type SelectSimTier(ESkateSimTier::Type current, float distance, const float tierDistances[ESkateSimTier::Count - 1], float hysteresis)
+	{
+		int32 tier = 0;
+		while (tier < ESkateSimTier::Count - 1 && distance > tierDistances[tier] * (tier < current ? 1.0f : 1.0f + hysteresis))
+			++tier;
+		return (ESkateSimTier::Type)tier;
+	}
+}
+
+
+// Sets default values
+ASkateboardSimManager::ASkateboardSimManager()
+{
+	// Tick in the same group as the pawns; RegisterPawn() makes us tick after each of them.
+	PrimaryActorTick.bCanEverTick = true;
+	PrimaryActorTick.TickGroup = TG_PrePhysics;
+
+	m_CentralTick = (CVarSkateboardCentralTick.GetValueOnGameThread() != 0);
+	m_TriedLoadingRideableSurfaces = false;
+	m_TriedLoadingGrindRails = false;
+	m_NetRateTimer = 0.0f;
+	m_NetBandwidthTimer = 0.0f;
+	m_SimTierTimer = 0.0f;
+	m_PreReplayUseFixedTimeStep = false;
+	m_PreReplayFixedDeltaTime = 0.0;
+}
+
+ASkateboardSimManager* ASkateboardSimManager::Get(UWorld* world)
+{
+	if (world == nullptr)
+		return nullptr;
+
+	for (TActorIterator<ASkateboardSimManager> it(world); it; ++it)
+	{
+		if (!it->IsPendingKill())
+			return *it;
+	}
+
+	FActorSpawnParameters spawnParams;
+	spawnParams.SpawnCollisionHandlingOverride = ESpawnActorCollisionHandlingMethod::AlwaysSpawn;
+	spawnParams.ObjectFlags |= RF_Transient;
+	return world->SpawnActor<ASkateboardSimManager>(spawnParams);
+}
+
+void ASkateboardSimManager::BeginPlay()
+{
+	Super::BeginPlay();
+
+	// Load (or in the editor, extract) the level's surfaces and rails with the level, not at the first query.
+	GetRideableSurfaces();
+	GetGrindRails();
+}
+
+void ASkateboardSimManager::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	Super::EndPlay(EndPlayReason);
+
+	for (ASkateboardSimPawn* pawn : m_Pawns)
+	{
+		if (pawn != nullptr && pawn->GroundStateComp != nullptr)
+			pawn->GroundStateComp->SetBakedSurfaces(nullptr);
+	}
+	m_RideableSurfaces.Unload();
+	m_TriedLoadingRideableSurfaces = false;
+	m_GrindRails.Unload();
+	m_TriedLoadingGrindRails = false;
+
+	FSkateboardSimProfiler::Get().StopCapture();
+
+	m_PivotWrites.Empty();
+	m_CameraArms.Empty();
+	m_Pawns.Empty();
+	m_BatchPawns.Empty();
+	m_Batch = SkateSim::FBoardBatch();
+
+	// Pawns may outlive us; don't leave the engine stuck at their time step.
+	if (m_ReplayPawns.Num() > 0)
+	{
+		FApp::SetUseFixedTimeStep(m_PreReplayUseFixedTimeStep);
+		FApp::SetFixedDeltaTime(m_PreReplayFixedDeltaTime);
+		m_ReplayPawns.Empty();
+	}
+}
+
+// Called every frame
+void ASkateboardSimManager::Tick(float DeltaTime)
+{
+	Super::Tick(DeltaTime);
+
+	UpdateCentralTickSetting();
+
+	INC_DWORD_STAT_BY(STAT_SkateboardBatchBoards, m_Batch.Num());
+	SKATE_INC_COUNTER(BoardsSimulated, STAT_SkateboardBoardsSimulated, m_Pawns.Num());
+	for (const ASkateboardSimPawn* pawn : m_Pawns)
+	{
+		switch (pawn->GetSimTier())
+		{
+		case ESkateSimTier::Full:		INC_DWORD_STAT(STAT_SkateboardTierFull); break;
+		case ESkateSimTier::Reduced:	INC_DWORD_STAT(STAT_SkateboardTierReduced); break;
+		case ESkateSimTier::Low:		INC_DWORD_STAT(STAT_SkateboardTierLow); break;
+		default:						INC_DWORD_STAT(STAT_SkateboardTierDormant); break;
+		}
+	}
+
+	if (m_CentralTick && CVarSkateboardParallelSim.GetValueOnGameThread() != 0)
+	{
+		TickPawnsInParallel(DeltaTime);
+	}
+	else if (m_CentralTick)
+	{
+		TickPawnsCentrally(DeltaTime);
+	}
+	else
+	{
+		StepBatchForPerActorPawns(DeltaTime);
+	}
+
+	if (GetNetMode() == NM_DedicatedServer || GetNetMode() == NM_ListenServer)
+	{
+		UpdateNetUpdateRates(DeltaTime);
+		UpdateNetBandwidth(DeltaTime);
+	}
+
+	// Every pawn has had its visuals phase by now, whichever way it was ticked.
+	FlushPivotRotations();
+
+	UpdateCameraSweeps();
+
+	// After stepping, so pawns joining or leaving the batch do it between frames.
+	UpdateSimTiers(DeltaTime);
+
+	// We tick after every pawn, so the frame's simulation work is all in by now.
+	FSkateboardSimProfiler::Get().EndFrame(DeltaTime);
+}
+
+void ASkateboardSimManager::TickPawnsCentrally(float deltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardCentralTick);
+	INC_DWORD_STAT(STAT_SkateboardTickDispatches);
+
+	for (ASkateboardSimPawn* pawn : m_Pawns)
+	{
+		pawn->BeginSimTick(deltaTime);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SkateboardCentralProbe);
+		for (ASkateboardSimPawn* pawn : m_Pawns)
+		{
+			if (pawn->IsSteppingThisFrame())
+				pawn->UpdateGroundState();
+		}
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SkateboardCentralMovement);
+		for (ASkateboardSimPawn* pawn : m_Pawns)
+		{
+			if (!pawn->IsSteppingThisFrame())
+				continue;
+
+			INC_DWORD_STAT(STAT_SkateboardBoardsStepped);
+			if (pawn->IsBatched())
+			{
+				pawn->GatherBatchInput();
+			}
+			else
+			{
+				pawn->UpdateOrientation();
+				pawn->UpdateSteering(pawn->GetStepDeltaTime());
+				pawn->UpdateMovement(pawn->GetTickDeltaTime());
+			}
+		}
+
+		if (m_Batch.Num() > 0)
+		{
+			{
+				SCOPE_CYCLE_COUNTER(STAT_SkateboardBatchStep);
+				m_Batch.Step(deltaTime);
+			}
+
+			SCOPE_CYCLE_COUNTER(STAT_SkateboardBatchApply);
+			for (ASkateboardSimPawn* pawn : m_BatchPawns)
+			{
+				pawn->ApplyBatchOutput();
+			}
+			m_Batch.UpdatePrevVelocities();
+		}
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SkateboardCentralVisuals);
+		for (ASkateboardSimPawn* pawn : m_Pawns)
+		{
+			if (pawn->IsSteppingThisFrame())
+				pawn->EndSimTick();
+			else
+				pawn->EndSkippedTick(deltaTime);
+		}
+	}
+}
+
+void ASkateboardSimManager::TickPawnsInParallel(float deltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardCentralTick);
+	INC_DWORD_STAT(STAT_SkateboardTickDispatches);
+
+	const int32 numPawns = m_Pawns.Num();
+	const int32 chunkSize = FMath::Max(1, CVarSkateboardParallelChunkSize.GetValueOnGameThread());
+	const int32 numChunks = (numPawns + chunkSize - 1) / chunkSize;
+	// Not worth waking the workers for a single chunk.
+	const bool singleThread = (numChunks <= 1);
+
+	// Recording and replay touch files, the engine's time step and (for replay keyframes) bodies.
+	for (ASkateboardSimPawn* pawn : m_Pawns)
+	{
+		pawn->BeginSimTick(deltaTime);
+	}
+
+	// Ground probes.  Blocking probes are read-only scene queries, so they can run anywhere; async probes append to
+	// the world's trace buffer, which is game-thread only, but they don't block so we just issue them here first.
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SkateboardCentralProbe);
+		for (ASkateboardSimPawn* pawn : m_Pawns)
+		{
+			if (pawn->IsSteppingThisFrame() && UsesAsyncProbes(pawn))
+				pawn->UpdateGroundState();
+		}
+
+		ParallelFor(numChunks, [&](int32 chunk)
+		{
+			const int32 end = FMath::Min(numPawns, (chunk + 1) * chunkSize);
+			for (int32 i = chunk * chunkSize; i < end; ++i)
+			{
+				if (m_Pawns[i]->IsSteppingThisFrame() && !UsesAsyncProbes(m_Pawns[i]))
+					m_Pawns[i]->UpdateGroundState();
+			}
+		}, singleThread);
+	}
+
+	// Orientation, steering and force computation.  Each pawn only writes its own sim state, its own batch slot and
+	// its own entry in m_PendingOutputs; body velocities were read (under the physics scene's read lock) along with
+	// the ground probes, into each pawn's frame.
+	m_PendingOutputs.SetNumUninitialized(numPawns, false);
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SkateboardCentralMovement);
+		ParallelFor(numChunks, [&](int32 chunk)
+		{
+			const int32 end = FMath::Min(numPawns, (chunk + 1) * chunkSize);
+			for (int32 i = chunk * chunkSize; i < end; ++i)
+			{
+				ASkateboardSimPawn* pawn = m_Pawns[i];
+				if (!pawn->IsSteppingThisFrame())
+					continue;
+
+				if (pawn->IsBatched())
+				{
+					pawn->GatherBatchInput();
+				}
+				else
+				{
+					pawn->UpdateOrientation();
+					pawn->UpdateSteering(pawn->GetStepDeltaTime());
+					m_PendingOutputs[i] = pawn->ComputeMovement(pawn->GetTickDeltaTime());
+				}
+			}
+		}, singleThread);
+
+		if (m_Batch.Num() > 0)
+		{
+			SCOPE_CYCLE_COUNTER(STAT_SkateboardBatchStep);
+			const int32 batchChunkSize = Align(chunkSize, 4);
+			const int32 numBatchChunks = (m_Batch.Num() + batchChunkSize - 1) / batchChunkSize;
+			ParallelFor(numBatchChunks, [&](int32 chunk)
+			{
+				m_Batch.StepRange(chunk * batchChunkSize, FMath::Min(m_Batch.Num(), (chunk + 1) * batchChunkSize), deltaTime);
+			}, numBatchChunks <= 1);
+		}
+	}
+
+	// Everything that writes to bodies or scene components stays on the game thread.
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SkateboardCentralApply);
+		for (int32 i = 0; i < numPawns; ++i)
+		{
+			if (!m_Pawns[i]->IsSteppingThisFrame())
+				continue;
+
+			INC_DWORD_STAT(STAT_SkateboardBoardsStepped);
+			if (m_Pawns[i]->IsBatched())
+				m_Pawns[i]->ApplyBatchOutput();
+			else
+				m_Pawns[i]->ApplySimOutput(m_PendingOutputs[i]);
+		}
+		m_Batch.UpdatePrevVelocities();
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SkateboardCentralVisuals);
+		for (ASkateboardSimPawn* pawn : m_Pawns)
+		{
+			if (pawn->IsSteppingThisFrame())
+				pawn->EndSimTick();
+			else
+				pawn->EndSkippedTick(deltaTime);
+		}
+	}
+}
+
+bool ASkateboardSimManager::UsesAsyncProbes(const ASkateboardSimPawn* pawn)
+{
+	// Only the full tier probes asynchronously; the others use a few blocking traces.
+	return (pawn->GroundStateComp != nullptr && pawn->GroundStateComp->UseAsyncProbes && pawn->GetSimTier() == ESkateSimTier::Full);
+}
+
+void ASkateboardSimManager::StepBatchForPerActorPawns(float deltaTime)
+{
+	if (m_Batch.Num() == 0)
+		return;
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SkateboardBatchStep);
+		m_Batch.Step(deltaTime);
+	}
+
+	{
+		SCOPE_CYCLE_COUNTER(STAT_SkateboardBatchApply);
+		for (ASkateboardSimPawn* pawn : m_BatchPawns)
+		{
+			pawn->ApplyBatchStep();
+		}
+	}
+
+	m_Batch.UpdatePrevVelocities();
+}
+
+void ASkateboardSimManager::UpdateCentralTickSetting()
+{
+	bool centralTick = (CVarSkateboardCentralTick.GetValueOnGameThread() != 0);
+	if (centralTick == m_CentralTick)
+		return;
+
+	m_CentralTick = centralTick;
+	for (ASkateboardSimPawn* pawn : m_Pawns)
+	{
+		pawn->SetCentralTick(m_CentralTick);
+	}
+}
+
+void ASkateboardSimManager::RegisterPawn(ASkateboardSimPawn* pawn)
+{
+	if (pawn == nullptr || m_Pawns.Contains(pawn))
+		return;
+
+	m_Pawns.Add(pawn);
+
+	if (pawn->UseBatchSimulation)
+	{
+		AddToBatch(pawn);
+	}
+
+	// When pawns tick themselves, batched ones gather their inputs during their own tick, so we need to step
+	// after them.  When they're centrally ticked their tick is disabled and the prerequisite is ignored.
+	PrimaryActorTick.AddPrerequisite(pawn, pawn->PrimaryActorTick);
+
+	pawn->SetCentralTick(m_CentralTick);
+
+	if (pawn->GroundStateComp != nullptr)
+		pawn->GroundStateComp->SetBakedSurfaces(GetRideableSurfaces());
+}
+
+void ASkateboardSimManager::UnregisterPawn(ASkateboardSimPawn* pawn)
+{
+	if (m_Pawns.Remove(pawn) == 0)
+		return;
+
+	PrimaryActorTick.RemovePrerequisite(pawn, pawn->PrimaryActorTick);
+
+	if (pawn->GroundStateComp != nullptr)
+		pawn->GroundStateComp->SetBakedSurfaces(nullptr);
+
+	RemoveFromBatch(pawn);
+}
+
+void ASkateboardSimManager::RegisterCameraArm(USkateboardSpringArmComponent* arm)
+{
+	m_CameraArms.AddUnique(arm);
+}
+
+void ASkateboardSimManager::UnregisterCameraArm(USkateboardSpringArmComponent* arm)
+{
+	m_CameraArms.Remove(arm);
+}
+
+void ASkateboardSimManager::BeginReplay(ASkateboardSimPawn* pawn, float deltaTime)
+{
+	if (m_ReplayPawns.Contains(pawn))
+		return;
+
+	if (m_ReplayPawns.Num() == 0)
+	{
+		m_PreReplayUseFixedTimeStep = FApp::UseFixedTimeStep();
+		m_PreReplayFixedDeltaTime = FApp::GetFixedDeltaTime();
+		FApp::SetUseFixedTimeStep(true);
+	}
+	m_ReplayPawns.Add(pawn);
+	SetReplayDeltaTime(pawn, deltaTime);
+}
+
+void ASkateboardSimManager::EndReplay(ASkateboardSimPawn* pawn)
+{
+	if (m_ReplayPawns.Remove(pawn) == 0)
+		return;
+
+	// The next pawn in line takes over the time step with its next tick.
+	if (m_ReplayPawns.Num() == 0)
+	{
+		FApp::SetUseFixedTimeStep(m_PreReplayUseFixedTimeStep);
+		FApp::SetFixedDeltaTime(m_PreReplayFixedDeltaTime);
+	}
+}
+
+void ASkateboardSimManager::SetReplayDeltaTime(const ASkateboardSimPawn* pawn, float deltaTime)
+{
+	if (m_ReplayPawns.Num() > 0 && m_ReplayPawns[0] == pawn)
+	{
+		FApp::SetFixedDeltaTime(deltaTime);
+	}
+}
+
+void ASkateboardSimManager::AddToBatch(ASkateboardSimPawn* pawn)
+{
+	int32 index = m_Batch.Add(pawn->m_SimState, pawn->GetSimTune(SkateSim::ToSim(pawn->GetVelocity())));
+	check(index == m_BatchPawns.Num());
+	m_BatchPawns.Add(pawn);
+	pawn->SetBatchIndex(index);
+}
+
+void ASkateboardSimManager::RemoveFromBatch(ASkateboardSimPawn* pawn)
+{
+	int32 index = m_BatchPawns.Find(pawn);
+	if (index != INDEX_NONE)
+	{
+		int32 movedFrom = m_Batch.RemoveAtSwap(index);
+		m_BatchPawns.RemoveAtSwap(index);
+		if (movedFrom != INDEX_NONE)
+		{
+			m_BatchPawns[index]->SetBatchIndex(index);
+		}
+		pawn->SetBatchIndex(INDEX_NONE);
+	}
+}
+
+void ASkateboardSimManager::QueuePivotRotation(USceneComponent* pivot, const FQuat& rotation)
+{
+	// |q1 . q2| is the cosine of half the angle between two rotations, so compare that against the threshold rather
+	// than working the angle out.
+	const float halfThreshold = FMath::DegreesToRadians(CVarSkateboardPivotUpdateThreshold.GetValueOnGameThread()) * 0.5f;
+	if (FMath::Abs(pivot->GetComponentQuat() | rotation) >= FMath::Cos(halfThreshold))
+	{
+		// Back where it is: whatever was queued for it earlier this frame is out of date.
+		INC_DWORD_STAT(STAT_SkateboardPivotWritesUnchanged);
+		m_PivotWrites.Remove(pivot);
+		return;
+	}
+
+	m_PivotWrites.Add(pivot, rotation);
+}
+
+void ASkateboardSimManager::FlushPivotRotations()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardPivotFlush);
+	INC_DWORD_STAT_BY(STAT_SkateboardPivotWrites, m_PivotWrites.Num());
+
+	for (auto write = m_PivotWrites.CreateConstIterator(); write; ++write)
+	{
+		// A pawn may have been destroyed since it queued this.
+		USceneComponent* pivot = write.Key().Get();
+		if (pivot != nullptr)
+			pivot->SetWorldRotation(write.Value());
+	}
+	m_PivotWrites.Reset();
+}
+
+void ASkateboardSimManager::UpdateCameraSweeps()
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardCameraSweeps);
+
+	// Every result first, so one arm's new sweep never lands before another's old result is read.  We tick before
+	// physics and the arms after it, so these results are for the sweeps the arms asked for two frames ago, and they
+	// place their cameras from them later this frame.
+	for (USkateboardSpringArmComponent* arm : m_CameraArms)
+	{
+		arm->ConsumeCameraSweep();
+	}
+	for (USkateboardSpringArmComponent* arm : m_CameraArms)
+	{
+		arm->SubmitCameraSweep();
+	}
+}
+
+void ASkateboardSimManager::UpdateSimTiers(float deltaTime)
+{
+	const bool lodEnabled = (CVarSkateboardSimLOD.GetValueOnGameThread() != 0);
+	m_SimTierTimer -= deltaTime;
+	if (m_SimTierTimer > 0.0f && lodEnabled)
+		return;
+	const float elapsed = SimTierUpdateInterval - m_SimTierTimer;
+	m_SimTierTimer = SimTierUpdateInterval;
+
+	// Local players (one per splitscreen view) from their cameras; remote players, on a server, from their view targets.
+	TArray<FVector, TInlineAllocator<16>> viewLocations;
+	bool hasLocalView = false;
+	for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+	{
+		const APlayerController* controller = *it;
+		if (controller == nullptr)
+			continue;
+
+		if (controller->IsLocalController())
+		{
+			FVector location;
+			FRotator rotation;
+			controller->GetPlayerViewPoint(location, rotation);
+			viewLocations.Add(location);
+			hasLocalView = true;
+		}
+		else if (controller->GetViewTarget() != nullptr)
+		{
+			viewLocations.Add(controller->GetViewTarget()->GetActorLocation());
+		}
+	}
+
+	float tierDistances[ESkateSimTier::Count - 1];
+	tierDistances[ESkateSimTier::Full] = CVarSkateboardSimLODFullDistance.GetValueOnGameThread();
+	tierDistances[ESkateSimTier::Reduced] = FMath::Max(CVarSkateboardSimLODReducedDistance.GetValueOnGameThread(), tierDistances[ESkateSimTier::Full]);
+	tierDistances[ESkateSimTier::Low] = FMath::Max(CVarSkateboardSimLODLowDistance.GetValueOnGameThread(), tierDistances[ESkateSimTier::Reduced]);
+	const float offscreenScale = FMath::Max(CVarSkateboardSimLODOffscreenScale.GetValueOnGameThread(), 1.0f);
+	const float hysteresis = FMath::Max(CVarSkateboardSimLODHysteresis.GetValueOnGameThread(), 0.0f);
+	const float dropDelay = CVarSkateboardSimLODDropDelay.GetValueOnGameThread();
+
+	for (ASkateboardSimPawn* pawn : m_Pawns)
+	{
+		ESkateSimTier::Type tier = ESkateSimTier::Full;
+		if (lodEnabled && !pawn->RequiresFullSim() && viewLocations.Num() > 0)
+		{
+			float nearestSquared = BIG_NUMBER;
+			for (const FVector& viewLocation : viewLocations)
+			{
+				nearestSquared = FMath::Min(nearestSquared, FVector::DistSquared(viewLocation, pawn->GetActorLocation()));
+			}
+
+			// Without a local view (a dedicated server) there's no telling what's on screen, so only distance counts.
+			const bool onScreen = (!hasLocalView || pawn->WasRenderedRecently());
+			const float distance = FMath::Sqrt(nearestSquared) * (onScreen ? 1.0f : offscreenScale);
+			tier = SelectSimTier(pawn->GetSimTier(), distance, tierDistances, hysteresis);
+		}
+
+		// Come back up straight away, but only drop once we've wanted to for a while.
+		if (tier < pawn->GetSimTier())
+		{
+			pawn->m_SimTierDropTime = 0.0f;
+		}
+		else if (tier > pawn->GetSimTier())
+		{
+			pawn->m_SimTierDropTime += elapsed;
+			if (pawn->m_SimTierDropTime < dropDelay)
+				continue;
+			pawn->m_SimTierDropTime = 0.0f;
+		}
+		else
+		{
+			pawn->m_SimTierDropTime = 0.0f;
+			continue;
+		}
+
+		pawn->SetSimTier(tier);
+
+		// Low and Dormant boards step on their own schedule, so they can't share the batch's step.
+		const bool wantsBatch = (pawn->UseBatchSimulation && pawn->GetSimTier() <= ESkateSimTier::Reduced);
+		if (wantsBatch && !pawn->IsBatched())
+			AddToBatch(pawn);
+		else if (!wantsBatch && pawn->IsBatched())
+			RemoveFromBatch(pawn);
+	}
+}
+
+const FRideableSurfaceData* ASkateboardSimManager::GetRideableSurfaces()
+{
+	if (!m_TriedLoadingRideableSurfaces)
+	{
+		m_TriedLoadingRideableSurfaces = true;
+		m_RideableSurfaces.Load(FRideableSurfaceData::GetPathForWorld(GetWorld()), GetWorld());
+	}
+	return (m_RideableSurfaces.IsLoaded() ? &m_RideableSurfaces : nullptr);
+}
+
+const SkateSim::FGrindRailView* ASkateboardSimManager::GetGrindRails()
+{
+	if (!m_TriedLoadingGrindRails)
+	{
+		m_TriedLoadingGrindRails = true;
+		if (!m_GrindRails.Load(FGrindRailData::GetPathForWorld(GetWorld())))
+		{
+#if WITH_EDITOR
+			m_GrindRails.BuildFromWorld(GetWorld());
+#endif
+		}
+	}
+	return (m_GrindRails.IsLoaded() ? &m_GrindRails.GetIndex() : nullptr);
+}
+
+void ASkateboardSimManager::UpdateNetUpdateRates(float deltaTime)
+{
+	m_NetRateTimer -= deltaTime;
+	if (m_NetRateTimer > 0.0f)
+		return;
+	m_NetRateTimer = NetRateUpdateInterval;
+
+	TArray<FVector, TInlineAllocator<16>> viewLocations;
+	for (FConstPlayerControllerIterator it = GetWorld()->GetPlayerControllerIterator(); it; ++it)
+	{
+		const AActor* viewTarget = (*it != nullptr ? (*it)->GetViewTarget() : nullptr);
+		if (viewTarget != nullptr)
+			viewLocations.Add(viewTarget->GetActorLocation());
+	}
+
+	const float fullRateDistance = CVarSkateboardNetFullRateDistance.GetValueOnGameThread();
+	const float minRateDistance = FMath::Max(CVarSkateboardNetMinRateDistance.GetValueOnGameThread(), fullRateDistance + 1.0f);
+	for (ASkateboardSimPawn* pawn : m_Pawns)
+	{
+		float nearestSquared = BIG_NUMBER;
+		for (const FVector& viewLocation : viewLocations)
+		{
+			nearestSquared = FMath::Min(nearestSquared, FVector::DistSquared(viewLocation, pawn->GetActorLocation()));
+		}
+
+		const float alpha = FMath::Clamp((FMath::Sqrt(nearestSquared) - fullRateDistance) / (minRateDistance - fullRateDistance), 0.0f, 1.0f);
+		pawn->NetUpdateFrequency = FMath::Lerp(pawn->NetMaxUpdateRate, pawn->NetMinUpdateRate, alpha);
+	}
+}
+
+void ASkateboardSimManager::UpdateNetBandwidth(float deltaTime)
+{
+	m_NetBandwidthTimer += deltaTime;
+	if (m_NetBandwidthTimer >= 1.0f)
+	{
+		m_NetBandwidth.Reset();
+		for (ASkateboardSimPawn* pawn : m_Pawns)
+		{
+			int64 sentBits, rawBits;
+			pawn->ConsumeNetBitCounts(sentBits, rawBits);
+
+			FNetBandwidth bandwidth;
+			bandwidth.PawnName = pawn->GetName();
+			bandwidth.SentBytesPerSecond = sentBits / (8.0f * m_NetBandwidthTimer);
+			bandwidth.RawBytesPerSecond = rawBits / (8.0f * m_NetBandwidthTimer);
+			m_NetBandwidth.Add(bandwidth);
+		}
+		m_NetBandwidthTimer = 0.0f;
+	}
+
+	float sent = 0.0f, raw = 0.0f;
+	for (const FNetBandwidth& bandwidth : m_NetBandwidth)
+	{
+		sent += bandwidth.SentBytesPerSecond;
+		raw += bandwidth.RawBytesPerSecond;
+	}
+	const float numBoards = FMath::Max(m_NetBandwidth.Num(), 1);
+	SET_FLOAT_STAT(STAT_SkateboardNetBytesPerBoard, sent / numBoards);
+	SET_FLOAT_STAT(STAT_SkateboardNetRawBytesPerBoard, raw / numBoards);
+}
+
+void ASkateboardSimManager::LogNetReport() const
+{
+	if (GetNetMode() != NM_DedicatedServer && GetNetMode() != NM_ListenServer)
+	{
+		UE_LOG(LogSkateboardSim, Display, TEXT("skate.NetReport: movement bandwidth is only measured on the server"));
+		return;
+	}
+
+	// Payload only; the engine's packet, bunch and property headers come on top.
+	float sent = 0.0f, raw = 0.0f;
+	for (const FNetBandwidth& bandwidth : m_NetBandwidth)
+	{
+		UE_LOG(LogSkateboardSim, Display, TEXT("  %-40s %8.1f B/s (full precision %8.1f B/s)"), *bandwidth.PawnName, bandwidth.SentBytesPerSecond, bandwidth.RawBytesPerSecond);
+		sent += bandwidth.SentBytesPerSecond;
+		raw += bandwidth.RawBytesPerSecond;
+	}
+
+	const float numBoards = FMath::Max(m_NetBandwidth.Num(), 1);
+	UE_LOG(LogSkateboardSim, Display, TEXT("skate.NetReport: %d boards, %.1f B/s per board (full precision %.1f B/s, %.0f%%), all connections"),
+		m_NetBandwidth.Num(), sent / numBoards, raw / numBoards, (raw > 0.0f ? 100.0f * sent / raw : 0.0f));
+}
+
+static void LogSkateboardNetReport(UWorld* world)
+{
+	for (TActorIterator<ASkateboardSimManager> it(world); it; ++it)
+	{
+		it->LogNetReport();
+		return;
+	}
+	UE_LOG(LogSkateboardSim, Display, TEXT("skate.NetReport: no skateboard pawns in this world"));
+}
+
+static FAutoConsoleCommandWithWorld NetReportCommand(
+	TEXT("skate.NetReport"),
+	TEXT("Log the bandwidth each skateboard's replicated movement used over the last second, compressed and at full precision."),
+	FConsoleCommandWithWorldDelegate::CreateStatic(&LogSkateboardNetReport));
@@ -0,0 +1,189 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/Actor.h"
+#include "SkateboardSimBatch.h"
+#include "RideableSurfaceData.h"
+#include "GrindRailData.h"
+#include "SkateboardSimManager.generated.h"
+
+class ASkateboardSimPawn;
+class USkateboardSpringArmComponent;
+
+/**
+* Owns a single tick function for every ASkateboardSimPawn in the world.
+*
+* With central ticking on (skate.CentralTick 1, the default), the pawns' own ticks are disabled and this actor runs
+* each simulation phase across all pawns in turn: ground probes, orientation/steering/movement, then visuals.
+* Pawns with UseBatchSimulation set have their orientation/steering/movement stepped together in a
+* structure-of-arrays SkateSim::FBoardBatch instead of one at a time.  With skate.ParallelSim 1, the probe and
+* force phases are split into chunks of boards and run on the task graph.
+*
+* With central ticking off, pawns tick themselves as before, and this actor only steps the batch after all of
+* them have gathered their inputs into it.
+*
+* The manager also owns the level's baked rideable surfaces (if it has any), and hands them to each pawn's
+* ground state component as it registers, and the level's grind rails and ledges (see GetGrindRails()).  Both are
+* loaded at BeginPlay, as the level starts, so no query pays for them mid-game.
+*
+* Pawns' model pivot rotations are queued as the pawns update their visuals and written together once every pawn has
+* ticked, skipping any that haven't moved by more than skate.PivotUpdateThreshold degrees.
+*
+* Local players' camera collision sweeps (see USkateboardSpringArmComponent) are collected from last frame's batch and
+* submitted as this frame's, all together, at the end of the frame.
+*
+* Every quarter of a second it also picks each pawn's simulation tier (see ESkateSimTier) from its distance to the
+* nearest player's view and whether it's on screen, with hysteresis so boards near a boundary don't flip between
+* tiers.  Player-controlled boards always run in full.  skate.SimLOD 0 turns this off.
+*
+* On a server, it also adapts each pawn's NetUpdateFrequency to its distance from the nearest player, and measures the
+* bandwidth the pawns' replicated movement uses (skate.NetReport).
+*
+* One of these is spawned on demand per world by the first pawn that needs it.
+*
+* @see ASkateboardSimPawn
+*/
+UCLASS(NotPlaceable, Transient)
+class AWOL_API ASkateboardSimManager : public AActor
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this actor's properties
+	ASkateboardSimManager();
+
+	// Find this world's manager, spawning it if necessary.
+	static ASkateboardSimManager* Get(UWorld* world);
+
+	// Called when the game starts or when spawned
+	virtual void BeginPlay() override;
+
+	// Called when this actor is being removed from the level
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Called every frame, after every registered pawn has ticked
+	virtual void Tick(float DeltaSeconds) override;
+
+	// Start ticking a pawn, and give it a batch slot if it uses batch simulation.
+	void RegisterPawn(ASkateboardSimPawn* pawn);
+
+	// Stop ticking a pawn.  If it had a batch slot, the last pawn in the batch is moved into that slot.
+	void UnregisterPawn(ASkateboardSimPawn* pawn);
+
+	SkateSim::FBoardBatch& GetBatch() { return m_Batch; }
+
+	// Start or stop batching a camera arm's collision sweeps.
+	void RegisterCameraArm(USkateboardSpringArmComponent* arm);
+	void UnregisterCameraArm(USkateboardSpringArmComponent* arm);
+
+	// Replays run the engine at a fixed time step matching their recorded ticks, and the engine only has one.  The
+	// first pawn to start replaying sets it, and the engine's own settings are put back once the last one stops.
+	void BeginReplay(ASkateboardSimPawn* pawn, float deltaTime);
+	void EndReplay(ASkateboardSimPawn* pawn);
+
+	// Called by a replaying pawn with its next recorded tick's time step.  Ignored unless it's the pawn setting it.
+	void SetReplayDeltaTime(const ASkateboardSimPawn* pawn, float deltaTime);
+
+	// Set a pawn's model pivot to a new world rotation at the end of this frame's simulation, along with every other
+	// pawn's.  Rotations within skate.PivotUpdateThreshold degrees of the pivot's current one are dropped.  Queuing
+	// the same pivot again replaces its rotation, so each pivot is written at most once a frame.
+	void QueuePivotRotation(USceneComponent* pivot, const FQuat& rotation);
+
+	// Log the bandwidth each board's replicated movement used over the last measured second.
+	void LogNetReport() const;
+
+	// This level's grind rails, loaded from its bake at BeginPlay.  In the editor, a level without any baked has them
+	// extracted from its grindable meshes instead.  Null if it has none.
+	const SkateSim::FGrindRailView* GetGrindRails();
+
+private:
+	// Run every simulation phase for every pawn.
+	void TickPawnsCentrally(float deltaTime);
+
+	// Same phases as TickPawnsCentrally(), but with ground probes and force computation spread across worker
+	// threads.  Only applying forces and updating visuals stay on the game thread.
+	void TickPawnsInParallel(float deltaTime);
+
+	// Async probes have to be issued from the game thread.
+	static bool UsesAsyncProbes(const ASkateboardSimPawn* pawn);
+
+	// Step the batch and apply its results, for pawns that tick themselves.
+	void StepBatchForPerActorPawns(float deltaTime);
+
+	// Give a pawn a batch slot, or take its slot away (moving the last pawn in the batch into it).
+	void AddToBatch(ASkateboardSimPawn* pawn);
+	void RemoveFromBatch(ASkateboardSimPawn* pawn);
+
+	// Apply the pivot rotations queued this frame.
+	void FlushPivotRotations();
+
+	// Collect every camera arm's sweep result from last frame, then submit this frame's sweeps.
+	void UpdateCameraSweeps();
+
+	// Move each pawn to the simulation tier its distance from the players' views and visibility call for.
+	void UpdateSimTiers(float deltaTime);
+
+	// Pick up changes to skate.CentralTick.
+	void UpdateCentralTickSetting();
+
+	// Map this level's baked rideable surfaces the first time they're asked for.  Null if there aren't any, or they're
+	// out of date with the level.
+	const FRideableSurfaceData* GetRideableSurfaces();
+
+	// Server only: scale each pawn's NetUpdateFrequency between its NetMinUpdateRate and NetMaxUpdateRate with its
+	// distance from the nearest player's view target.
+	void UpdateNetUpdateRates(float deltaTime);
+
+	// Server only: collect the bits each pawn's replicated movement used, once a second.
+	void UpdateNetBandwidth(float deltaTime);
+
+private:
+	// Every registered pawn.
+	UPROPERTY()
+	TArray<ASkateboardSimPawn*> m_Pawns;
+
+	// Pawns using batch simulation, indexed by batch slot.
+	UPROPERTY()
+	TArray<ASkateboardSimPawn*> m_BatchPawns;
+
+	SkateSim::FBoardBatch m_Batch;
+
+	// Forces computed on worker threads for unbatched pawns, indexed like m_Pawns, waiting to be applied.
+	TArray<SkateSim::FBoardOutput> m_PendingOutputs;
+
+	// Model pivot rotations waiting for FlushPivotRotations(), one per pivot.  Emptied every frame; a pivot destroyed
+	// in the meantime is skipped.
+	TMap<TWeakObjectPtr<USceneComponent>, FQuat> m_PivotWrites;
+
+	// Camera arms whose sweeps we batch.
+	UPROPERTY()
+	TArray<USkateboardSpringArmComponent*> m_CameraArms;
+
+	bool m_CentralTick;
+
+	FRideableSurfaceData m_RideableSurfaces;
+	bool m_TriedLoadingRideableSurfaces;
+
+	FGrindRailData m_GrindRails;
+	bool m_TriedLoadingGrindRails;
+
+	// Each pawn's replicated movement bandwidth over the last second, in bytes/s: as sent, and at full precision.
+	struct FNetBandwidth
+	{
+		FString PawnName;
+		float SentBytesPerSecond;
+		float RawBytesPerSecond;
+	};
+	TArray<FNetBandwidth> m_NetBandwidth;
+	float m_NetRateTimer;
+	float m_NetBandwidthTimer;
+	float m_SimTierTimer;
+
+	// Pawns replaying a recording, the first of which sets the time step, and the engine's time step settings from
+	// before the first started.
+	UPROPERTY()
+	TArray<ASkateboardSimPawn*> m_ReplayPawns;
+	bool m_PreReplayUseFixedTimeStep;
+	double m_PreReplayFixedDeltaTime;
+};
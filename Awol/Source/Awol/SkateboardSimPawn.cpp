@@ -3,7 +3,111 @@
 #include "Awol.h"
 #include "SkateboardSimPawn.h"
 #include "SkateboardTune.h"
+#include "SkateboardLoadout.h"
 #include "GroundStateComponent.h"
+#include "SkateboardSimManager.h"
+#include "SkateboardSimProfiler.h"
+#include "SkateboardRiderAnimInstance.h"
+#include "SkateboardSpringArmComponent.h"
+#include "UnrealNetwork.h"
+
+DECLARE_CYCLE_STAT(TEXT("Per-Actor Pawn Tick"), STAT_SkateboardPerActorTick, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Phase: ProbeGround"), STAT_SkateboardPhaseProbeGround, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Phase: UpdateOrientation"), STAT_SkateboardPhaseOrientation, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Phase: UpdateSteering"), STAT_SkateboardPhaseSteering, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Phase: UpdateMovement"), STAT_SkateboardPhaseMovement, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Phase: ApplyForces"), STAT_SkateboardPhaseApplyForces, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Phase: UpdateCamera"), STAT_SkateboardPhaseCamera, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Phase: UpdateSkateboardModel"), STAT_SkateboardPhaseSkateboardModel, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Phase: UpdateRiderModel"), STAT_SkateboardPhaseRiderModel, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Phase: DebugDraw"), STAT_SkateboardPhaseDebugDraw, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Impulses Applied"), STAT_SkateboardImpulsesApplied, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Forces Applied"), STAT_SkateboardForcesApplied, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Net Movement Snaps"), STAT_SkateboardNetSnaps, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Rollback Save"), STAT_SkateboardRollbackSave, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Rollback Resimulate"), STAT_SkateboardRollbackResimulate, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Rollback Ticks Resimulated"), STAT_SkateboardRollbackTicks, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Pivot Writes Skipped: Off Screen"), STAT_SkateboardPivotWritesOffscreen, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Contacts Reported"), STAT_SkateboardContactsReported, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Contacts After Merging"), STAT_SkateboardContactsMerged, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Contacts Dropped"), STAT_SkateboardContactsDropped, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Kinematic Move"), STAT_SkateboardKinematicMove, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Kinematic Sweeps"), STAT_SkateboardKinematicSweeps, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Kinematic Contacts"), STAT_SkateboardKinematicContacts, STATGROUP_SkateboardSim);
+DECLARE_CYCLE_STAT(TEXT("Grind Rail Query"), STAT_SkateboardGrindRailQuery, STATGROUP_SkateboardSim);
+
+static TAutoConsoleVariable<int32> CVarSkateboardReplaySnapToKeyframes(
+	TEXT("skate.ReplaySnapToKeyframes"),
+	0,
+	TEXT("0: replays only place the pawn at the first keyframe, and log how far it drifts from the rest (default).\n")
+	TEXT("1: replays snap the pawn to every recorded keyframe, e.g. to profile a late section of a long run faithfully."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardOffscreenModelInterval(
+	TEXT("skate.OffscreenModelInterval"),
+	0.25f,
+	TEXT("Seconds between updates of the board and rider model pivots of boards that haven't been rendered recently."),
+	ECVF_Default);
+
+// See ASkateboardSimPawn::GetFirstBoardReadyTime().
+static double GFirstSkateboardReadyTime = -1.0;
+
+namespace
+{
+	void StoreFloats(float* out, const FVector& v) { out[0] = v.X; out[1] = v.Y; out[2] = v.Z; }
+	FVector LoadFVector(const float* f) { return FVector(f[0], f[1], f[2]); }
+	void StoreFloats(float* out, const SkateSim::FVec3& v) { out[0] = v.X; out[1] = v.Y; out[2] = v.Z; }
+
+	uint8 QuantizeInputAxis(float value) { return (uint8)(SkateSim::NetQuantize(value, SkateSim::NetAxisScale, SkateSim::NetAxisScale) + 128); }
+	float DequantizeInputAxis(uint8 value) { return FMath::Clamp(((int32)value - 128) / SkateSim::NetAxisScale, -1.0f, 1.0f); }
+
+	// Unchanged input is sent again this often, in case the last change was lost.
+	const float MoveInputResendInterval = 0.25f;
+
+	// How recently a board must have been rendered to count as on screen.
+	const float RecentlyRenderedTime = 0.5f;
+
+	// Kinematic movement: how far above its ride height the ground still holds a board up, how many times one move
+	// can be blocked and slide on, and how far to back out of anything a move starts inside.
+	const float KinematicGroundTolerance = 2.0f;
+	const int32 MaxKinematicSlides = 4;
+	const float KinematicPushOutDistance = 0.125f;
+
+	// Surfaces steeper than this (the Z of their normal) are walls, which the board bounces off by BoundPhysMtl's
+	// restitution, rather than ground it rides onto.
+	const float KinematicWallNormalZ = 0.5f;
+
+	// Contacts against the same primitive and surface with normals within about 10 degrees of each other are merged;
+	// those within 45 degrees of the board's up can hold it up.
+	const float ContactMergeCos = 0.985f;
+	const float ContactSupportCos = 0.7f;
+
+	// The world as resimulation sees it.  Probes go through the ground state component, but always block, and don't
+	// change its state.  The physics scene can't be stepped for one body, so the body is integrated by
+	// SkateSim::PredictBody() instead.
+	struct FResimWorld
+	{
+		UGroundStateComponent* GroundState;
+		float GravityZ;
+		float RideHeight;
+
+		SkateSim::FGroundContact Probe(const SkateSim::FBodyState& body, const SkateSim::FBoardState& state)
+		{
+			SkateSim::FGroundContact ground;
+			FVector groundPos, groundNormal;
+			ground.IsOnGround = (GroundState != nullptr && GroundState->QueryGround(SkateSim::FromSim(body.Position),
+				SkateSim::FromSim(SkateSim::GetForwardVector(state)), SkateSim::FromSim(SkateSim::GetRightVector(state)), groundPos, groundNormal));
+			ground.Position = (ground.IsOnGround ? SkateSim::ToSim(groundPos) : body.Position);
+			ground.Normal = (ground.IsOnGround ? SkateSim::ToSim(groundNormal) : SkateSim::UpVec3());
+			return ground;
+		}
+
+		void Integrate(SkateSim::FBodyState& body, const SkateSim::FBoardOutput& output, const SkateSim::FGroundContact& ground, float mass, float deltaTime)
+		{
+			SkateSim::PredictBody(body, output, ground, mass, GravityZ, RideHeight, deltaTime);
+		}
+	};
+}
 
 
 // Sets default values
@@ -12,20 +116,10 @@ ASkateboardSimPawn::ASkateboardSimPawn()
  	// Set this pawn to call Tick() every frame.  You can turn this off to improve performance if you don't need it.
 	PrimaryActorTick.bCanEverTick = true;
 
-	// Create root component, which will be a static mesh.
+	// Create root component, which will be a static mesh.  Its shape and physical material come from our loadout, once
+	// it's loaded.
 	MeshComp = CreateDefaultSubobject<UStaticMeshComponent>(TEXT("StaticMesh"));
-	// Set the shape:
-	const ConstructorHelpers::FObjectFinder<UStaticMesh> MeshObj(TEXT("/Game/StarterContent/Shapes/Shape_NarrowCapsule"));
-	MeshComp->SetStaticMesh(MeshObj.Object);
-	// Set the physical material:
-	const ConstructorHelpers::FObjectFinder<UPhysicalMaterial> physMtlObj(TEXT("/Game/AWOL/Character/Mover/MoverPhysMtl"));
-	BoundPhysMtl = physMtlObj.Object;
-	if (GetWorld())
-	{
-		// Wrapping this call inside if (GetWorld()) prevents an unhandled excption when launching the Unreal Editor.
-		// https://answers.unrealengine.com/questions/361842/ustaticmeshcomponent-setphysmaterialoverride-crash.html
-		MeshComp->SetPhysMaterialOverride(physMtlObj.Object);
-	}
+	BoundPhysMtl = nullptr;
 	// Turn on physics:
 	MeshComp->SetSimulatePhysics(true);
 	MeshComp->SetEnableGravity(true);
@@ -36,8 +130,8 @@ ASkateboardSimPawn::ASkateboardSimPawn()
 	// Set as our root component:
 	RootComponent = MeshComp;
 
-	// Create camera spring arm
-	SpringArm = CreateDefaultSubobject<USpringArmComponent>(TEXT("CameraSpringArm"));
+	// Create camera spring arm, whose collision sweeps are batched with every other player's
+	SpringArm = CreateDefaultSubobject<USkateboardSpringArmComponent>(TEXT("CameraSpringArm"));
 	SpringArm->SetupAttachment(RootComponent);
 	SpringArm->SetRelativeLocationAndRotation(FVector(0.0f, 0.0f, 80.0f), FRotator(-60.0f, 0.0f, 0.0f));
 	SpringArm->TargetArmLength = 300.0f;
@@ -47,13 +141,8 @@ ASkateboardSimPawn::ASkateboardSimPawn()
 	// Attach our camera to our spring arm.  Offset and rotate the camera
 	Camera->SetupAttachment(SpringArm, USpringArmComponent::SocketName);
 
-	// Create a SkateboardTune component
-	SkateboardTune = CreateDefaultSubobject<USkateboardTune>(TEXT("SkateboardTune"));
-	AddOwnedComponent(SkateboardTune);
-
 	// Create a GroundStateComponent:
 	GroundStateComp = CreateDefaultSubobject<UGroundStateComponent>(TEXT("GroundState"));
-	GroundStateComp->SetSkateboardTune(SkateboardTune);
 	AddOwnedComponent(GroundStateComp);
 
 	// Create visible skateboard pivot, which will drive its orientation:
@@ -69,6 +158,61 @@ ASkateboardSimPawn::ASkateboardSimPawn()
 	BindInputInCode = true;
 
 	DebugDrawEnabled = false;
+
+	UseBatchSimulation = false;
+	UseKinematicMovement = false;
+	LandingAlignTime = 0.25f;
+	m_KinematicVelocity = FVector::ZeroVector;
+	m_KinematicImpulse = FVector::ZeroVector;
+	RecordingKeyframeInterval = 60;
+	RecordingBufferKB = 256;
+	m_RecordedTicks = 0;
+	SkateboardTune = nullptr;
+	Loadout = nullptr;
+	m_AssetsLoaded = false;
+	m_AssetRequestTime = 0.0;
+	m_Profile = nullptr;
+	m_FrameGround.IsOnGround = false;
+	m_FrameGround.Position = SkateSim::ZeroVec3();
+	m_FrameGround.Normal = SkateSim::UpVec3();
+	m_FrameTune = USkateboardTune::GetDefaultProfile().Tune;
+	FMemory::Memzero(m_Frame);
+	m_FramePrevVelocity = SkateSim::ZeroVec3();
+	m_FrameDeltaTime = 0.0f;
+	m_FramePrevDeltaTime = 0.0f;
+	m_SimManager = nullptr;
+	m_BatchIndex = INDEX_NONE;
+	m_CentralTick = false;
+	EnableRollback = false;
+	m_SimTick = 0;
+	UseSimLOD = true;
+	LowTierTickRate = 15.0f;
+	DormantProbeInterval = 0.5f;
+	m_SimTier = ESkateSimTier::Full;
+	m_SimTierDropTime = 0.0f;
+	m_StepThisFrame = true;
+	m_StepDeltaTime = 0.0f;
+	m_TickDeltaTime = 0.0f;
+	m_StepAccumulatedTime = 0.0f;
+	m_StepForce = FVector::ZeroVector;
+	m_SkateboardModelFrom = m_SkateboardModelTo = FQuat::Identity;
+	m_RiderModelFrom = m_RiderModelTo = FQuat::Identity;
+	m_DormantVelocity = FVector::ZeroVector;
+	m_DormantRideHeight = 0.0f;
+	m_DormantProbeTimer = 0.0f;
+	m_NextOffscreenModelUpdate = 0.0f;
+
+	// Our own movement replication replaces the engine's.
+	bReplicates = true;
+	bReplicateMovement = false;
+	NetMaxUpdateRate = 30.0f;
+	NetMinUpdateRate = 4.0f;
+	NetSnapDistance = 200.0f;
+	NetCorrectionTime = 0.25f;
+	NetUpdateFrequency = NetMaxUpdateRate;
+	m_AppliedRepMovement = 0;
+	m_SentMoveInput[0] = m_SentMoveInput[1] = QuantizeInputAxis(0.0f);
+	m_MoveInputSendTime = -MoveInputResendInterval;
 }
 
 // Called when the game starts or when spawned
@@ -76,11 +220,115 @@ void ASkateboardSimPawn::BeginPlay()
 {
 	Super::BeginPlay();
 
-	m_PrevVelocity = FVector::ZeroVector;
+	// Nothing moves or shows until our assets are in.  Usually they already are (see
+	// USkateboardLoadout::PreloadDefaults()), and we start riding before this returns.
+	SetActorHiddenInGame(true);
+	if (MeshComp != nullptr)
+	{
+		MeshComp->SetSimulatePhysics(false);
+	}
+	m_AssetRequestTime = FPlatformTime::Seconds();
+
+	// Make sure the manager is up as the level starts, so it loads the level's surfaces and rails now, not when we
+	// first ride.  We register with it once we're riding.
+	ASkateboardSimManager::Get(GetWorld());
+
+	GetLoadout()->RequestLoad(FStreamableDelegate::CreateUObject(this, &ASkateboardSimPawn::OnAssetsLoaded));
+}
+
+const USkateboardLoadout* ASkateboardSimPawn::GetLoadout() const
+{
+	return (Loadout != nullptr ? Loadout : USkateboardLoadout::GetDefaultLoadout());
+}
+
+double ASkateboardSimPawn::GetFirstBoardReadyTime()
+{
+	return GFirstSkateboardReadyTime;
+}
+
+void ASkateboardSimPawn::OnAssetsLoaded()
+{
+	if (m_AssetsLoaded || IsPendingKill())
+		return;
+
+	ApplyLoadout(*GetLoadout());
+	StartRiding();
+
+	// Time to the first controllable board, for comparing cold starts (e.g. with skate.AsyncBoardAssets 0).
+	const double now = FPlatformTime::Seconds();
+	if (GFirstSkateboardReadyTime < 0.0)
+	{
+		GFirstSkateboardReadyTime = now - GStartTime;
+		UE_LOG(LogSkateboardSim, Display, TEXT("First board ready %.3fs after startup (%s waited %.1fms for its assets)"),
+			GFirstSkateboardReadyTime, *GetName(), (now - m_AssetRequestTime) * 1000.0);
+	}
+	UE_LOG(LogSkateboardSim, Verbose, TEXT("%s waited %.1fms for its assets"), *GetName(), (now - m_AssetRequestTime) * 1000.0);
+}
+
+void ASkateboardSimPawn::ApplyLoadout(const USkateboardLoadout& loadout)
+{
+	if (MeshComp != nullptr && MeshComp->StaticMesh == nullptr)
+	{
+		MeshComp->SetStaticMesh(loadout.BoundMesh.Get());
+	}
+	if (BoundPhysMtl == nullptr)
+	{
+		BoundPhysMtl = loadout.BoundPhysMtl.Get();
+	}
+	if (SkateboardTune == nullptr)
+	{
+		SkateboardTune = loadout.Tune.Get();
+	}
+
+	auto findModel = [](USceneComponent* pivot) -> USkeletalMeshComponent*
+	{
+		TArray<USceneComponent*> components;
+		if (pivot != nullptr)
+		{
+			pivot->GetChildrenComponents(true, components);
+		}
+		for (USceneComponent* component : components)
+		{
+			USkeletalMeshComponent* mesh = Cast<USkeletalMeshComponent>(component);
+			if (mesh != nullptr)
+				return mesh;
+		}
+		return nullptr;
+	};
+
+	USkeletalMeshComponent* boardModel = findModel(SkateboardModelPivot);
+	if (boardModel != nullptr && loadout.BoardMesh.Get() != nullptr)
+	{
+		boardModel->SetSkeletalMesh(loadout.BoardMesh.Get());
+	}
+
+	USkeletalMeshComponent* riderModel = findModel(RiderModelPivot);
+	if (riderModel != nullptr)
+	{
+		if (loadout.RiderMesh.Get() != nullptr)
+		{
+			riderModel->SetSkeletalMesh(loadout.RiderMesh.Get());
+		}
+		if (loadout.RiderAnimClass.Get() != nullptr)
+		{
+			riderModel->SetAnimInstanceClass(loadout.RiderAnimClass.Get());
+		}
+	}
+}
+
+void ASkateboardSimPawn::StartRiding()
+{
+	m_AssetsLoaded = true;
+	SetActorHiddenInGame(false);
+
+	m_Profile = (SkateboardTune != nullptr ? &SkateboardTune->GetProfile() : &USkateboardTune::GetDefaultProfile());
+	if (GroundStateComp != nullptr)
+	{
+		GroundStateComp->SetBoardProfile(m_Profile);
+	}
 
-	m_LongitudinalVector = GetActorForwardVector();
-	m_LateralVector = GetActorRightVector();
-	m_Reverse = false;
+	SkateSim::InitBoardState(m_SimState, SkateSim::ToSim(GetActorForwardVector()), SkateSim::ToSim(GetActorRightVector()));
+	m_FrameGround = GetSimGroundContact();
 	
 	if (MeshComp != nullptr)
 	{
@@ -89,112 +337,329 @@ void ASkateboardSimPawn::BeginPlay()
 			MeshComp->SetPhysMaterialOverride(BoundPhysMtl);
 		}
 
-		// Enable and add OnActorHit callback
+		// Report physics collisions, through NotifyHit()
 		MeshComp->SetNotifyRigidBodyCollision(true);
-		OnActorHit.AddUniqueDynamic(this, &ASkateboardSimPawn::OnActorBump);
 
 		// Hide the visible sphere model:
 		MeshComp->SetHiddenInGame(true);
 		MeshComp->SetVisibility(false);
+
+		MeshComp->SetSimulatePhysics(!UseKinematicMovement);
+	}
+
+	// Register with the manager, which either ticks us along with every other pawn or (if central ticking is off)
+	// only steps our batch slot, if we have one.
+	m_SimManager = ASkateboardSimManager::Get(GetWorld());
+	if (m_SimManager != nullptr)
+	{
+		m_SimManager->RegisterPawn(this);
+	}
+
+	// If the rider's anim instance solves their pose, the rider pivot follows it.  Its mesh ticks after the
+	// simulation, so each update starts from this frame's step.
+	TArray<USceneComponent*> riderComponents;
+	RiderModelPivot->GetChildrenComponents(true, riderComponents);
+	for (USceneComponent* component : riderComponents)
+	{
+		USkeletalMeshComponent* riderMesh = Cast<USkeletalMeshComponent>(component);
+		USkateboardRiderAnimInstance* riderAnim = (riderMesh != nullptr ? Cast<USkateboardRiderAnimInstance>(riderMesh->GetAnimInstance()) : nullptr);
+		if (riderAnim != nullptr)
+		{
+			m_RiderAnim = riderAnim;
+			riderMesh->PrimaryComponentTick.AddPrerequisite(this, PrimaryActorTick);
+			if (m_SimManager != nullptr)
+				riderMesh->PrimaryComponentTick.AddPrerequisite(m_SimManager, m_SimManager->PrimaryActorTick);
+			break;
+		}
 	}
 }
 
+void ASkateboardSimPawn::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	StopRecording();
+	StopReplay();
+
+	if (m_SimManager != nullptr)
+	{
+		m_SimManager->UnregisterPawn(this);
+		m_SimManager = nullptr;
+		m_BatchIndex = INDEX_NONE;
+	}
+
+	Super::EndPlay(EndPlayReason);
+}
+
 // Called every frame
 void ASkateboardSimPawn::Tick( float DeltaTime )
 {
 	Super::Tick( DeltaTime );
 
-	if (GroundStateComp != nullptr)
+	if (!m_AssetsLoaded)
+		return;
+
+	// When centrally ticked, we only get here to run Blueprint tick events; the manager does the simulation.
+	if (m_CentralTick)
+		return;
+
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardPerActorTick);
+	INC_DWORD_STAT(STAT_SkateboardTickDispatches);
+
+	BeginSimTick(DeltaTime);
+	if (!m_StepThisFrame)
 	{
-		FVector fwd = GetForwardVector();
-		FVector right = GetRightVector();
-		GroundStateComp->ProbeGround(GetActorLocation(), fwd, right);
+		EndSkippedTick(DeltaTime);
+		return;
+	}
+
+	UpdateGroundState();
+
+	if (IsBatched())
+	{
+		// The manager steps every batched pawn at once after we've all ticked, then calls ApplyBatchStep().
+		GatherBatchInput();
+		return;
 	}
 
 	UpdateOrientation();
-	UpdateSteering(DeltaTime);
-	UpdateMovement(DeltaTime);
-	UpdateCamera();
+	UpdateSteering(m_StepDeltaTime);
+	UpdateMovement(m_TickDeltaTime);
 
-	UpdateSkateboardModel();
-	UpdateRiderModel();
+	EndSimTick();
+}
 
-	UpdatePrevVelocity();
+void ASkateboardSimPawn::GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const
+{
+	Super::GetLifetimeReplicatedProps(OutLifetimeProps);
 
-	if (DebugDrawEnabled)
-		DebugDraw();
+	DOREPLIFETIME(ASkateboardSimPawn, m_RepMovement);
 }
 
-void ASkateboardSimPawn::UpdatePrevVelocity()
+void ASkateboardSimPawn::ApplyBatchStep()
 {
-	m_PrevVelocity = GetVelocity();
+	ApplyBatchOutput();
+	EndSimTick();
 }
 
-void ASkateboardSimPawn::UpdateOrientation()
+void ASkateboardSimPawn::SetCentralTick(bool centralTick)
+{
+	m_CentralTick = centralTick;
+
+	// Our own tick is only needed for per-actor simulation, or to run a Blueprint tick event.
+	SetActorTickEnabled(!centralTick || HasBlueprintTick());
+}
+
+bool ASkateboardSimPawn::HasBlueprintTick() const
 {
-	if (GroundStateComp != nullptr && GroundStateComp->IsOnGround())
+	// A Blueprint override of ReceiveTick lives in the Blueprint's generated class rather than in AActor.
+	UFunction* tickEvent = GetClass()->FindFunctionByName(GET_FUNCTION_NAME_CHECKED(AActor, ReceiveTick));
+	return (tickEvent != nullptr && tickEvent->GetOuter() != AActor::StaticClass());
+}
+
+void ASkateboardSimPawn::BeginSimTick(float deltaTime)
+{
+	UpdateStepSchedule(deltaTime);
+
+	if (m_Replay.IsValid())
+	{
+		FeedReplayInput();
+	}
+
+	if (m_Recorder.IsValid())
 	{
-		// NOTE: THIS NEEDS TO BE REVISITED!
-		// For now, pop the forward vector to point in the direction of motion, after
-		// subtracting out velocity toward ground normal.
+		SkateRecording::FKeyframe keyframe;
+		const bool wantKeyframe = (m_RecordedTicks == 0 || (RecordingKeyframeInterval > 0 && (m_RecordedTicks % RecordingKeyframeInterval) == 0));
+		if (wantKeyframe)
+		{
+			MakeKeyframe(keyframe);
+		}
+		m_Recorder->RecordTick(deltaTime, FVector2D(m_MovementInput), FVector2D(m_CameraInput), wantKeyframe ? &keyframe : nullptr);
+		++m_RecordedTicks;
+	}
 
-		FVector currVel = MeshComp->GetPhysicsLinearVelocity();
-		// What's our speed relative to the ground normal?
-		float normalSpeed = FVector::DotProduct(currVel, GroundStateComp->GetGroundNormal());
-		// Subtract out speed pointing toward the ground:
-		currVel -= GroundStateComp->GetGroundNormal() * normalSpeed;
+	if (Role == ROLE_AutonomousProxy)
+	{
+		SendMoveInput();
+	}
 
-		float speed = currVel.Size();
-		float speedThresh = 5.0f;
-		if (speed > speedThresh)
+	if (EnableRollback)
+	{
+		SaveSnapshot(deltaTime);
+	}
+	++m_SimTick;
+}
+
+void ASkateboardSimPawn::UpdateGroundState()
+{
+	SKATE_SCOPE_PHASE(ProbeGround, STAT_SkateboardPhaseProbeGround);
+
+	if (GroundStateComp != nullptr)
+	{
+		FVector fwd = GetForwardVector();
+		FVector right = GetRightVector();
+
+		// Everything we've bumped into since the last probe, boiled down.
+		SkateSim::FContactSummary contacts;
+		m_Contacts.Summarize(ContactMergeCos, SkateSim::GetUpVector(m_SimState), ContactSupportCos, contacts);
+		INC_DWORD_STAT_BY(STAT_SkateboardContactsReported, contacts.NumReported);
+		INC_DWORD_STAT_BY(STAT_SkateboardContactsMerged, contacts.NumContacts);
+		INC_DWORD_STAT_BY(STAT_SkateboardContactsDropped, m_Contacts.NumDropped());
+		m_Contacts.Reset();
+		GroundStateComp->NotifyContacts(contacts);
+
+		// On a predicted arc through the air, there's nothing for the probes to find until shortly before we land.
+		const FVector location = GetActorLocation();
+		const FVector velocity = GetBodyVelocity();
+		if (!GroundStateComp->SkipProbesInFlight(location, velocity))
 		{
-			// Use the dot product to determine whether we're moving in reverse
-			m_Reverse = (FVector::DotProduct(currVel, m_LongitudinalVector) < 0.0f);
+			if (m_SimTier == ESkateSimTier::Full)
+				GroundStateComp->ProbeGround(location, fwd, right, velocity);
+			else
+				GroundStateComp->ProbeGroundReduced(location, fwd, right, (m_SimTier == ESkateSimTier::Reduced ? 2 : 1));
 
-			m_LongitudinalVector = currVel;
-			m_LongitudinalVector.Normalize();
-			if (m_Reverse)
-				m_LongitudinalVector *= -1.0f;
+			GroundStateComp->ApplyContactSupport(contacts);
+			GroundStateComp->UpdateFlightPrediction(location, velocity);
+		}
 
-			m_LateralVector = FVector::CrossProduct(GroundStateComp->GetGroundNormal(), m_LongitudinalVector);
+		// In the air, right ourselves against whatever we hit hardest, or turn to meet what we're about to land on.
+		FVector landingPos, landingNormal;
+		float timeToLanding;
+		if (contacts.NumContacts > 0 && !GroundStateComp->IsOnGround())
+		{
+			ResetOrientation(SkateSim::FromSim(contacts.Strongest.Normal));
 		}
-		else
+		else if (!GroundStateComp->IsOnGround() && LandingAlignTime > 0.0f && GroundStateComp->GetPredictedLanding(landingPos, landingNormal, timeToLanding))
 		{
-			m_LongitudinalVector = FVector::CrossProduct(m_LateralVector, GroundStateComp->GetGroundNormal());
+			SkateSim::AlignForLanding(m_SimState, SkateSim::ToSim(landingNormal), timeToLanding, LandingAlignTime, m_StepDeltaTime);
+			PushSimStateToBatch();
 		}
 	}
+
+	BeginSimFrame();
 }
 
-void ASkateboardSimPawn::UpdateSteering(float deltaTime)
+void ASkateboardSimPawn::BeginSimFrame()
 {
-	// TODO: approach desired steering over time.
-	m_Steering = FMath::Clamp(m_MovementInput.Y, -1.0f, 1.0f);
+	const SkateSim::FVec3 velocity = SkateSim::ToSim(GetBodyVelocity());
+	m_FrameGround = GetSimGroundContact();
+	m_FrameTune = GetSimTune(velocity);
+	m_FramePrevVelocity = m_Frame.Velocity;
+	m_FramePrevDeltaTime = m_FrameDeltaTime;
+	m_FrameDeltaTime = m_StepDeltaTime;
+	SkateSim::BeginFrame(m_Frame, m_FrameGround, velocity);
+	SkateSim::UpdateFrameBasis(m_Frame, m_SimState);
 }
 
-void ASkateboardSimPawn::UpdateMovement(float deltaTime)
+void ASkateboardSimPawn::GetRiderSimSnapshot(SkateSim::FRiderSimSnapshot& snapshotOut) const
 {
-	FVector currVel = MeshComp->GetPhysicsLinearVelocity();
-	float speed = currVel.Size();
-	float forceScale = 800.0f * MeshComp->GetMass();
+	// The velocity changed from m_FramePrevVelocity to m_Frame.Velocity over the previous tick's step.
+	snapshotOut.Velocity = m_Frame.Velocity;
+	snapshotOut.PrevVelocity = m_FramePrevVelocity;
+	snapshotOut.StepDeltaTime = m_FramePrevDeltaTime;
+	snapshotOut.Position = SkateSim::ToSim(GetActorLocation());
+	snapshotOut.Forward = m_Frame.Forward;
+	snapshotOut.Right = m_Frame.Right;
+	snapshotOut.Ground = m_FrameGround;
+	snapshotOut.DeckHeight = GetBoardProfile().Tune.DeckHeight;
+}
+
+void ASkateboardSimPawn::GatherBatchInput()
+{
+	SkateSim::FBoardBatch& batch = m_SimManager->GetBatch();
+	batch.SetTune(m_BatchIndex, m_FrameTune);
+	batch.SetFrameInput(m_BatchIndex, m_FrameGround, GetSimInput(), m_Frame.Velocity, MeshComp->GetMass());
+}
+
+void ASkateboardSimPawn::ApplyBatchOutput()
+{
+	const SkateSim::FBoardBatch& batch = m_SimManager->GetBatch();
+	batch.GetState(m_BatchIndex, m_SimState);
+	ApplySimOutput(batch.GetOutput(m_BatchIndex));
+}
 
-	if (speed > SkateboardTune->MaxSpeed)
+void ASkateboardSimPawn::EndSimTick()
+{
+	UpdateVisuals();
+
+	UpdatePrevVelocity();
+
+	if (Role == ROLE_Authority && !IsNetMode(NM_Standalone))
 	{
-		currVel.Normalize();
-		currVel *= (SkateboardTune->MaxSpeed - speed);
-		MeshComp->AddImpulse(currVel);
+		UpdateRepMovement();
+	}
 
-		// Still apply steering even if at max speed.
-		FVector totalForce = ComputeRightForce(deltaTime) * forceScale;
-		MeshComp->AddForce(totalForce);
+	if (DebugDrawEnabled)
+		DebugDraw();
+
+	// Last, where the physics step would move a rigid body.  Only over this frame: a Low tier board has already been
+	// moved on each frame it skipped (see EndSkippedTick()).
+	if (UseKinematicMovement)
+		MoveKinematic(m_TickDeltaTime);
+}
+
+void ASkateboardSimPawn::EndSkippedTick(float deltaTime)
+{
+	if (m_SimTier == ESkateSimTier::Dormant)
+	{
+		UpdateDormant(deltaTime);
+	}
+	else
+	{
+		// Forces only last one physics step, so keep pushing with the last one until we step again.
+		if (UseKinematicMovement)
+			MoveKinematic(deltaTime);
+		else if (!m_StepForce.IsZero())
+			MeshComp->AddForce(m_StepForce);
+		UpdateInterpolatedModels();
+	}
+
+	if (Role == ROLE_Authority && !IsNetMode(NM_Standalone))
+	{
+		UpdateRepMovement();
 	}
-	else if (!m_MovementInput.IsZero())
+}
+
+void ASkateboardSimPawn::UpdateVisuals()
+{
+	UpdateCamera();
+
+	if (m_SimTier == ESkateSimTier::Low)
 	{
-		FVector totalForce = (ComputeForwardForce() + ComputeRightForce(deltaTime)) * forceScale;
+		// Blend from where the models are to where they should be now over the next step, instead of snapping them
+		// every few frames.
+		m_SkateboardModelFrom = SkateboardModelPivot->GetComponentQuat();
+		m_SkateboardModelTo = ComputeSkateboardModelRotation();
+		m_RiderModelFrom = RiderModelPivot->GetComponentQuat();
+		m_RiderModelTo = ComputeRiderModelRotation();
+		return;
+	}
 
-		// Apply force
-		MeshComp->AddForce(totalForce);
+	if (ShouldUpdateModels())
+	{
+		UpdateSkateboardModel();
+		UpdateRiderModel();
 	}
+}
+
+void ASkateboardSimPawn::UpdatePrevVelocity()
+{
+	SkateSim::UpdatePrevVelocity(m_SimState, SkateSim::ToSim(GetVelocity()));
+}
 
+void ASkateboardSimPawn::UpdateOrientation()
+{
+	SKATE_SCOPE_PHASE(UpdateOrientation, STAT_SkateboardPhaseOrientation);
+	SkateSim::UpdateOrientation(m_SimState, m_FrameGround, m_Frame);
+}
+
+void ASkateboardSimPawn::UpdateSteering(float deltaTime)
+{
+	SKATE_SCOPE_PHASE(UpdateSteering, STAT_SkateboardPhaseSteering);
+	SkateSim::UpdateSteering(m_SimState, m_FrameGround, m_FrameTune, GetSimInput(), m_Frame);
+}
+
+void ASkateboardSimPawn::UpdateMovement(float deltaTime)
+{
+	ApplySimOutput(ComputeMovement(deltaTime));
 
 	// TODO:
 	// [ ] Add drag for braking
@@ -203,130 +668,277 @@ void ASkateboardSimPawn::UpdateMovement(float deltaTime)
 
 }
 
-void ASkateboardSimPawn::UpdateCamera()
+// deltaTime is one frame's, not the step's: the force is applied on every frame the step covers (see
+// EndSkippedTick()), and the steering part of it scales with the time step it's given.
+SkateSim::FBoardOutput ASkateboardSimPawn::ComputeMovement(float deltaTime) const
 {
-	if (SpringArm != nullptr)
+	SKATE_SCOPE_PHASE(UpdateMovement, STAT_SkateboardPhaseMovement);
+	return SkateSim::ComputeMovement(m_FrameGround, m_FrameTune, GetSimInput(), m_Frame, MeshComp->GetMass(), deltaTime);
+}
+
+void ASkateboardSimPawn::ApplySimOutput(const SkateSim::FBoardOutput& output)
+{
+	SKATE_SCOPE_PHASE(ApplyForces, STAT_SkateboardPhaseApplyForces);
+
+	// In kinematic mode, both wait for MoveKinematic() at the end of the tick.
+	if (output.HasImpulse)
 	{
-		FRotator newRotation = SpringArm->GetComponentRotation();
-		newRotation.Yaw += m_CameraInput.X;
-		newRotation.Pitch = FMath::Clamp(newRotation.Pitch - m_CameraInput.Y, -80.0f, 10.0f);
-		SpringArm->SetWorldRotation(newRotation);
+		if (UseKinematicMovement)
+			m_KinematicImpulse += SkateSim::FromSim(output.Impulse);
+		else
+			MeshComp->AddImpulse(SkateSim::FromSim(output.Impulse));
+		SKATE_INC_COUNTER(ImpulsesApplied, STAT_SkateboardImpulsesApplied, 1);
+	}
+	if (output.HasForce)
+	{
+		if (!UseKinematicMovement)
+			MeshComp->AddForce(SkateSim::FromSim(output.Force));
+		SKATE_INC_COUNTER(ForcesApplied, STAT_SkateboardForcesApplied, 1);
 	}
+	m_StepForce = (output.HasForce ? SkateSim::FromSim(output.Force) : FVector::ZeroVector);
 }
 
-void ASkateboardSimPawn::UpdateSkateboardModel()
+void ASkateboardSimPawn::SetKinematicMovement(bool kinematic)
 {
-	FMatrix rotMatrix(GetForwardVector(), GetRightVector(), GetUpVector(), FVector::ZeroVector);
-	SkateboardModelPivot->SetWorldRotation(rotMatrix.Rotator());
+	if (MeshComp == nullptr || kinematic == UseKinematicMovement)
+		return;
+
+	const FVector velocity = GetBodyVelocity();
+	UseKinematicMovement = kinematic;
+	m_KinematicImpulse = FVector::ZeroVector;
+	// Dormant boards are already kinematic, and pick physics back up as they leave.
+	// Boards still waiting for their assets pick it up as they start riding.
+	if (m_SimTier != ESkateSimTier::Dormant && m_AssetsLoaded)
+		MeshComp->SetSimulatePhysics(!kinematic);
+	SetBodyVelocity(velocity);
 }
 
-void ASkateboardSimPawn::UpdateRiderModel()
+FVector ASkateboardSimPawn::GetBodyVelocity() const
 {
-	float deckHeight = 10.0f;
-	if (SkateboardTune != nullptr)
+	return (UseKinematicMovement ? m_KinematicVelocity : MeshComp->GetPhysicsLinearVelocity());
+}
+
+void ASkateboardSimPawn::SetBodyVelocity(const FVector& velocity)
+{
+	if (UseKinematicMovement)
 	{
-		deckHeight = SkateboardTune->DeckHeight;
+		m_KinematicVelocity = velocity;
+		// What GetVelocity() returns for a component that isn't simulating.
+		MeshComp->ComponentVelocity = velocity;
 	}
-	// For now, don't apply deckHeight offset, because it's baked into the
-	// animations.  Once the animations are fixed, we can change this back.
-	// m_RiderModelPivot->SetRelativeLocation(FVector(0.0f, 0.0f, deckHeight));
-	RiderModelPivot->SetRelativeLocation(FVector(0.0f, 0.0f, 0.0f));
+	else
+	{
+		MeshComp->SetPhysicsLinearVelocity(velocity);
+	}
+}
 
-	FVector riderForward = GetForwardVector();
-	FVector riderUp = GetRiderUpVector();
-	FVector riderRight = FVector::CrossProduct(riderUp, riderForward);
-	riderForward = FVector::CrossProduct(riderRight, riderUp);
-	FMatrix rotMatrix(riderForward, riderRight, riderUp, FVector::ZeroVector);
-	RiderModelPivot->SetWorldRotation(rotMatrix.Rotator());
+bool ASkateboardSimPawn::FindGrindRail(float radius, FVector& positionOut, FVector& tangentOut, bool& isRailOut) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardGrindRailQuery);
+
+	const SkateSim::FGrindRailView* rails = (m_SimManager != nullptr ? m_SimManager->GetGrindRails() : nullptr);
+	SkateSim::FGrindRailHit hit;
+	if (rails == nullptr || MeshComp == nullptr || !rails->FindNearest(SkateSim::ToSim(MeshComp->GetComponentLocation()), radius, hit))
+		return false;
+
+	positionOut = SkateSim::FromSim(hit.Position);
+	tangentOut = SkateSim::FromSim(hit.Tangent);
+	if (FVector::DotProduct(tangentOut, GetBodyVelocity()) < 0.0f)
+		tangentOut = -tangentOut;
+	isRailOut = (hit.Kind == SkateSim::EGrindRailKind::Rail);
+	return true;
 }
 
-float ASkateboardSimPawn::ComputeSteerAngleDeg() const
+void ASkateboardSimPawn::MoveKinematic(float deltaTime)
 {
-	float minMaxAngle = 10.0f;
-	if (SkateboardTune != nullptr)
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardKinematicMove);
+
+	if (deltaTime <= 0.0f)
+		return;
+
+	SkateSim::FBoardOutput output;
+	output.Impulse = SkateSim::ToSim(m_KinematicImpulse);
+	output.HasImpulse = !m_KinematicImpulse.IsZero();
+	output.Force = SkateSim::ToSim(m_StepForce);
+	output.HasForce = !m_StepForce.IsZero();
+	m_KinematicImpulse = FVector::ZeroVector;
+
+	SkateSim::FVec3 velocity = SkateSim::ToSim(m_KinematicVelocity);
+	SkateSim::IntegrateVelocity(velocity, output, MeshComp->GetMass(), GetWorld()->GetGravityZ(), deltaTime);
+
+	// The ground we probed holds us up, which is all the rigid body's ground contacts did.  With no velocity into
+	// it left, the sweep below usually runs clear.
+	const SkateSim::FVec3 startPosition = SkateSim::ToSim(GetActorLocation());
+	SkateSim::FVec3 position = startPosition;
+	SkateSim::SupportOnGround(position, velocity, m_FrameGround, MeshComp->Bounds.BoxExtent.Z, KinematicGroundTolerance);
+	if (!SkateSim::IsZero(position - startPosition))
+		MeshComp->SetWorldLocation(SkateSim::FromSim(position), false, nullptr, ETeleportType::TeleportPhysics);
+
+	// Sweep along the move, sliding along anything in the way.  Blocking hits reach NotifyHit() as they would
+	// from the rigid body.
+	const float restitution = (BoundPhysMtl != nullptr ? BoundPhysMtl->Restitution : 0.0f);
+	const FQuat rotation = MeshComp->GetComponentQuat();
+	FVector delta = SkateSim::FromSim(velocity) * deltaTime;
+	for (int32 slide = 0; slide < MaxKinematicSlides && !delta.IsNearlyZero(); ++slide)
 	{
-		minMaxAngle = SkateboardTune->MinMaxTurnAngleDeg;
+		FHitResult hit;
+		MeshComp->MoveComponent(delta, rotation, true, &hit);
+		SKATE_INC_COUNTER(TracesIssued, STAT_SkateboardKinematicSweeps, 1);
+		if (!hit.bBlockingHit)
+			break;
+
+		INC_DWORD_STAT(STAT_SkateboardKinematicContacts);
+		if (hit.bStartPenetrating)
+		{
+			// Started the move inside something: back out and try the move again.
+			MeshComp->MoveComponent(hit.Normal * (hit.PenetrationDepth + KinematicPushOutDistance), rotation, false);
+			continue;
+		}
+
+		const SkateSim::FVec3 normal = SkateSim::ToSim(hit.Normal);
+		SkateSim::ResolveContact(velocity, normal, (hit.Normal.Z < KinematicWallNormalZ ? restitution : 0.0f));
+		delta = SkateSim::FromSim(SkateSim::SlideAlongSurface(SkateSim::ToSim(delta), hit.Time, normal));
 	}
-	float rotDeg = FMath::Lerp(-minMaxAngle, minMaxAngle, (m_MovementInput.Y + 1.0f) * 0.5f);
-	return rotDeg;
+
+	SetBodyVelocity(SkateSim::FromSim(velocity));
 }
 
-FVector ASkateboardSimPawn::ComputeForwardForce() const
+void ASkateboardSimPawn::PushSimStateToBatch()
 {
-	if (GroundStateComp != nullptr && GroundStateComp->IsOnGround() && m_MovementInput.X > 0.0f)
+	if (m_SimManager != nullptr && IsBatched())
 	{
-		FVector newForward = GetForwardVector();
-		float rotDeg = ComputeSteerAngleDeg();
-		newForward = newForward.RotateAngleAxis(rotDeg, GetUpVector());
-		return newForward * FMath::Clamp(m_MovementInput.X, 0.0f, 1.0f);
+		m_SimManager->GetBatch().SetState(m_BatchIndex, m_SimState);
 	}
-	return FVector::ZeroVector;
 }
 
-FVector ASkateboardSimPawn::ComputeRightForce(float deltaTime) const
+SkateSim::FGroundContact ASkateboardSimPawn::GetSimGroundContact() const
 {
-	if (GroundStateComp != nullptr && GroundStateComp->IsOnGround())
-	{
-		FVector currVel = MeshComp->GetPhysicsLinearVelocity();
-		float speed = currVel.Size();
+	SkateSim::FGroundContact ground;
+	ground.IsOnGround = (GroundStateComp != nullptr && GroundStateComp->IsOnGround());
+	ground.Position = SkateSim::ToSim(ground.IsOnGround ? GroundStateComp->GetGroundPosition() : GetActorLocation());
+	ground.Normal = SkateSim::ToSim(ground.IsOnGround ? GroundStateComp->GetGroundNormal() : FVector::UpVector);
+	return ground;
+}
 
-		if (speed > 1.0f)
-		{
-			float rotDeg = ComputeSteerAngleDeg();
-			FVector tgtVel = currVel.RotateAngleAxis(rotDeg, GetUpVector());
-			return (tgtVel - currVel) * deltaTime;
-		}
+SkateSim::FBoardTune ASkateboardSimPawn::GetSimTune(const SkateSim::FVec3& velocity) const
+{
+	return SkateSim::EvaluateTune(GetBoardProfile(), SkateSim::Size(velocity));
+}
+
+const SkateSim::FBoardProfile& ASkateboardSimPawn::GetBoardProfile() const
+{
+	// Before BeginPlay (e.g. in the editor), go by the asset directly.
+	if (m_Profile != nullptr)
+		return *m_Profile;
+	return (SkateboardTune != nullptr ? SkateboardTune->GetProfile() : USkateboardTune::GetDefaultProfile());
+}
+
+SkateSim::FBoardInput ASkateboardSimPawn::GetSimInput() const
+{
+	SkateSim::FBoardInput input;
+	input.Forward = m_MovementInput.X;
+	input.Right = m_MovementInput.Y;
+	return input;
+}
+
+void ASkateboardSimPawn::UpdateCamera()
+{
+	SKATE_SCOPE_PHASE(UpdateCamera, STAT_SkateboardPhaseCamera);
+
+	if (SpringArm != nullptr)
+	{
+		FRotator newRotation = SpringArm->GetComponentRotation();
+		newRotation.Yaw += m_CameraInput.X;
+		newRotation.Pitch = FMath::Clamp(newRotation.Pitch - m_CameraInput.Y, -80.0f, 10.0f);
+		SpringArm->SetWorldRotation(newRotation);
 	}
-	return FVector::ZeroVector;
 }
 
-FVector ASkateboardSimPawn::ComputeCentripetalAccel() const
+void ASkateboardSimPawn::UpdateSkateboardModel()
 {
-	FVector currVel = GetVelocity();
-	FVector toCenter = ComputeTurnPivot(GetTopOfDeckPos(), m_PrevVelocity, currVel);
-	if (toCenter.IsNearlyZero())
-		return FVector::ZeroVector;
+	SKATE_SCOPE_PHASE(UpdateSkateboardModel, STAT_SkateboardPhaseSkateboardModel);
 
-	float turnRadius = toCenter.Size();
-	FVector centripAccel = toCenter;
-	centripAccel.Normalize();
+	SetModelRotation(SkateboardModelPivot, ComputeSkateboardModelRotation());
+}
 
-	// A = v^2 / r
-	centripAccel *= (currVel.SizeSquared() / turnRadius);
+void ASkateboardSimPawn::UpdateRiderModel()
+{
+	SKATE_SCOPE_PHASE(UpdateRiderModel, STAT_SkateboardPhaseRiderModel);
+
+	// For now, don't apply deckHeight offset, because it's baked into the
+	// animations.  Once the animations are fixed, we can change this back,
+	// with RiderModelPivot->SetRelativeLocation(FVector(0.0f, 0.0f, deckHeight)).
+	// Until then the pivot stays where the constructor put it.
 
-	return centripAccel;
+	SetModelRotation(RiderModelPivot, ComputeRiderModelRotation());
 }
 
-FVector ASkateboardSimPawn::ComputeTurnPivot(FVector pos, FVector v1, FVector v2) const
+void ASkateboardSimPawn::UpdateInterpolatedModels()
 {
-	float v1mag = v1.Size();
-	float v2mag = v2.Size();
-	
-	// If either speed is less than threshold, consider the radius to be zero
-	float thresh = 0.01f;
-	if (v1mag < thresh || v2mag < thresh)
-		return FVector::ZeroVector;
+	if (!ShouldUpdateModels())
+		return;
 
-	float dot = FVector::DotProduct(v1, v1);
-	float cosTheta = dot / (v1mag * v2mag);
+	const float alpha = FMath::Clamp(m_StepAccumulatedTime * LowTierTickRate, 0.0f, 1.0f);
+	SetModelRotation(SkateboardModelPivot, FQuat::Slerp(m_SkateboardModelFrom, m_SkateboardModelTo, alpha));
+	SetModelRotation(RiderModelPivot, FQuat::Slerp(m_RiderModelFrom, m_RiderModelTo, alpha));
+}
 
-	float theta = FMath::Acos(cosTheta);
+FQuat ASkateboardSimPawn::ComputeSkateboardModelRotation() const
+{
+	FMatrix rotMatrix(GetForwardVector(), GetRightVector(), GetUpVector(), FVector::ZeroVector);
+	return FQuat(rotMatrix);
+}
 
-	// r = chordlength / 2 * sin (theta/2)
+FQuat ASkateboardSimPawn::ComputeRiderModelRotation() const
+{
+	// Solved on the animation threads, if the rider's anim instance does it.
+	const USkateboardRiderAnimInstance* riderAnim = m_RiderAnim.Get();
+	if (riderAnim != nullptr && riderAnim->HasRiderPose())
+		return riderAnim->GetRiderRotation();
 
-	float radius = v2mag / (2.0f * FMath::Sin(theta * 0.5f));
-	radius = FMath::Abs(radius);
+	FVector riderForward = GetForwardVector();
+	FVector riderUp = GetRiderUpVector();
+	// Normalized, so the basis is orthonormal and converts straight to a quaternion.
+	FVector riderRight = FVector::CrossProduct(riderUp, riderForward).GetSafeNormal();
+	riderForward = FVector::CrossProduct(riderRight, riderUp);
+	FMatrix rotMatrix(riderForward, riderRight, riderUp, FVector::ZeroVector);
+	return FQuat(rotMatrix);
+}
 
-	FVector upDown = FVector::CrossProduct(v1, v2);
-	upDown.Normalize();
+bool ASkateboardSimPawn::WasRenderedRecently() const
+{
+	const UWorld* world = GetWorld();
+	return (world != nullptr && world->GetTimeSeconds() - GetLastRenderTime() <= RecentlyRenderedTime);
+}
 
-	FVector toCenter = FVector::CrossProduct(upDown, v2);
-	toCenter.Normalize();
-	toCenter *= radius;
+bool ASkateboardSimPawn::ShouldUpdateModels()
+{
+	// Off screen, the models only need to be about right for when we come back into view.
+	if (WasRenderedRecently())
+		return true;
 
-	return toCenter;
+	const float now = GetWorld()->GetTimeSeconds();
+	if (now < m_NextOffscreenModelUpdate)
+	{
+		INC_DWORD_STAT_BY(STAT_SkateboardPivotWritesOffscreen, 2);
+		return false;
+	}
+	m_NextOffscreenModelUpdate = now + CVarSkateboardOffscreenModelInterval.GetValueOnGameThread();
+	return true;
 }
 
+void ASkateboardSimPawn::SetModelRotation(USceneComponent* pivot, const FQuat& rotation)
+{
+	if (m_SimManager != nullptr)
+		m_SimManager->QueuePivotRotation(pivot, rotation);
+	else
+		pivot->SetWorldRotation(rotation);
+}
+
+FVector ASkateboardSimPawn::ComputeCentripetalAccel() const
+{
+	return SkateSim::FromSim(SkateSim::ComputeCentripetalAccel(m_SimState, SkateSim::ToSim(GetVelocity())));
+}
 
 FVector ASkateboardSimPawn::GetRiderUpVector() const
 {
@@ -343,19 +955,9 @@ FVector ASkateboardSimPawn::GetRiderUpVector() const
 
 FVector ASkateboardSimPawn::GetCenterOfMassPos() const
 {
-	// Compute an up vector, factoring in lean:
+	// Upright.  Lean and crouch are solved by USkateboardRiderAnimInstance, off the game thread; this is for riders
+	// without one.
 	FVector up = FVector::UpVector;
-	/*
-	// WIP : CENTRIPETAL FORCES AFFECTING LEAN
-	// Scale by gravity, so we can add lateral accel to find lean:
-	up *= 980.0f;
-	// Add centripetal acceleration:
-	FVector centripAccel = ComputeCentripetalAccel();
-	up += centripAccel;
-	// TODO: factor in crouch height based on vertical accel.
-	// For now, keep at a constant height:
-	up.Normalize();
-	*/
 	float comHeight = 100.0f;
 	return GetActorLocation() + (up * comHeight);
 }
@@ -363,38 +965,21 @@ FVector ASkateboardSimPawn::GetCenterOfMassPos() const
 FVector ASkateboardSimPawn::GetTopOfDeckPos() const
 {
 	// NOTE: This will eventually require more logic.  For now, just return a position above our actor location.
-	float deckHeight = 10.0f;
-	if (SkateboardTune != nullptr)
-	{
-		deckHeight = SkateboardTune->DeckHeight;
-	}
-	FVector groundPos = GetActorLocation();
-	FVector offsetVector = FVector::UpVector;
-	if (GroundStateComp != nullptr && GroundStateComp->IsOnGround())
-	{
-		offsetVector = GroundStateComp->GetGroundNormal();
-		groundPos = GroundStateComp->GetGroundPosition();
-	}
-	return groundPos + (offsetVector * deckHeight);
+	const float deckHeight = GetBoardProfile().Tune.DeckHeight;
+	// m_FrameGround falls back to our location and straight up when we're not on the ground.
+	return SkateSim::FromSim(m_FrameGround.Position + m_FrameGround.Normal * deckHeight);
 }
 
 void ASkateboardSimPawn::ResetOrientation(const FVector up)
 {
-	// Reset our orientation to something reasonable, using whichever vector has the smallest "up" amount:
-	if (FMath::Abs(m_LongitudinalVector.Z) > FMath::Abs(m_LateralVector.Z))
-	{
-		m_LongitudinalVector = FVector::CrossProduct(m_LateralVector, up);
-		m_LateralVector = FVector::CrossProduct(up, m_LongitudinalVector);
-	}
-	else
-	{
-		m_LateralVector = FVector::CrossProduct(up, m_LongitudinalVector);
-		m_LongitudinalVector = FVector::CrossProduct(m_LateralVector, up);
-	}
+	SkateSim::ResetOrientation(m_SimState, SkateSim::ToSim(up));
+	PushSimStateToBatch();
 }
 
 void ASkateboardSimPawn::DebugDraw() const
 {
+	SKATE_SCOPE_PHASE(DebugDraw, STAT_SkateboardPhaseDebugDraw);
+
 	const UWorld* pWorld = GetWorld();
 	if (pWorld != nullptr)
 	{
@@ -450,17 +1035,13 @@ void ASkateboardSimPawn::Input_CameraPitch(float AxisValue)
 	m_CameraInput.Y = AxisValue;
 }
 
-void ASkateboardSimPawn::OnActorBump(AActor* SelfActor, AActor* OtherActor, FVector NormalImpulse, const FHitResult& Hit)
+void ASkateboardSimPawn::NotifyHit(UPrimitiveComponent* MyComp, AActor* Other, UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit)
 {
-	if (GroundStateComp)
-	{
-		GroundStateComp->NotifyCollision(SelfActor, OtherActor, NormalImpulse, Hit);
+	Super::NotifyHit(MyComp, Other, OtherComp, bSelfMoved, HitLocation, HitNormal, NormalImpulse, Hit);
 
-		if (!GroundStateComp->IsOnGround())
-		{
-			ResetOrientation(Hit.Normal);
-		}
-	}
+	const UPhysicalMaterial* surface = Hit.PhysMaterial.Get();
+	m_Contacts.Add(SkateSim::ToSim(Hit.Normal), SkateSim::ToSim(Hit.ImpactPoint), NormalImpulse.Size(),
+		(OtherComp != nullptr ? OtherComp->GetUniqueID() : 0), (surface != nullptr ? surface->GetUniqueID() : 0), ContactMergeCos);
 }
 
 void ASkateboardSimPawn::SetCameraBoomWorldRotation(FRotator cameraBoomWorldRotation)
@@ -476,9 +1057,10 @@ FRotator ASkateboardSimPawn::GetCameraBoomWorldRotation() const
 
 void ASkateboardSimPawn::SetForwardVector(FVector forwardVector)
 {
-	m_LongitudinalVector = forwardVector;
-	m_LateralVector = FVector::CrossProduct(FVector::UpVector, m_LongitudinalVector);
-	m_Reverse = false;
+	m_SimState.LongitudinalVector = SkateSim::ToSim(forwardVector);
+	m_SimState.LateralVector = SkateSim::ToSim(FVector::CrossProduct(FVector::UpVector, forwardVector));
+	m_SimState.Reverse = false;
+	PushSimStateToBatch();
 }
 
 FVector ASkateboardSimPawn::GetForwardVector2D() const
@@ -496,3 +1078,518 @@ FVector ASkateboardSimPawn::GetForwardVector2D() const
 
 	return fwd;
 }
+
+bool ASkateboardSimPawn::StartRecording(const FString& path)
+{
+	StopRecording();
+
+	m_Recorder.Reset(new FSkateboardRecorder());
+	if (!m_Recorder->Start(path, RecordingBufferKB * 1024, (uint32)FMath::Max(RecordingKeyframeInterval, 0)))
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("Couldn't open %s for recording"), *path);
+		m_Recorder.Reset();
+		return false;
+	}
+	m_RecordedTicks = 0;
+	return true;
+}
+
+void ASkateboardSimPawn::StopRecording()
+{
+	// Joins the flush thread and closes the file.
+	m_Recorder.Reset();
+}
+
+bool ASkateboardSimPawn::StartReplay(const FString& path)
+{
+	StopReplay();
+
+	// The manager owns the engine's time step.
+	if (m_SimManager == nullptr)
+		return false;
+
+	TUniquePtr<FSkateboardReplay> replay(new FSkateboardReplay());
+	if (!replay->Load(path))
+		return false;
+
+	m_Replay = MoveTemp(replay);
+
+	// Run the engine at the recorded time steps.  The first tick's step applies to the coming frame.
+	m_SimManager->BeginReplay(this, m_Replay->Peek()->DeltaTime);
+
+	UE_LOG(LogSkateboardSim, Display, TEXT("Replaying %d ticks from %s on %s"), m_Replay->GetNumTicks(), *path, *GetName());
+	return true;
+}
+
+void ASkateboardSimPawn::StopReplay()
+{
+	if (!m_Replay.IsValid())
+		return;
+
+	m_Replay.Reset();
+	if (m_SimManager != nullptr)
+	{
+		m_SimManager->EndReplay(this);
+	}
+}
+
+void ASkateboardSimPawn::FeedReplayInput()
+{
+	const SkateRecording::FTick* tick = m_Replay->Next();
+	if (tick == nullptr)
+	{
+		UE_LOG(LogSkateboardSim, Display, TEXT("Replay finished on %s"), *GetName());
+		StopReplay();
+		return;
+	}
+
+	if (tick->KeyframeIndex != INDEX_NONE)
+	{
+		const SkateRecording::FKeyframe& keyframe = m_Replay->GetKeyframe(tick->KeyframeIndex);
+		if (tick->KeyframeIndex == 0 || CVarSkateboardReplaySnapToKeyframes.GetValueOnGameThread() != 0)
+		{
+			ApplyKeyframe(keyframe);
+		}
+		else
+		{
+			const float drift = FVector::Dist(GetActorLocation(), LoadFVector(keyframe.Location));
+			UE_LOG(LogSkateboardSim, Log, TEXT("Replay on %s: tick %u is %.2f cm from the recording"), *GetName(), keyframe.Tick, drift);
+		}
+	}
+
+	// Overrides anything the player controller fed us this frame.
+	Input_MoveForward(tick->Move.X);
+	Input_MoveRight(tick->Move.Y);
+	Input_CameraYaw(tick->Camera.X);
+	Input_CameraPitch(tick->Camera.Y);
+
+	const SkateRecording::FTick* nextTick = m_Replay->Peek();
+	if (nextTick != nullptr && m_SimManager != nullptr)
+	{
+		m_SimManager->SetReplayDeltaTime(this, nextTick->DeltaTime);
+	}
+}
+
+void ASkateboardSimPawn::MakeKeyframe(SkateRecording::FKeyframe& keyframeOut) const
+{
+	FMemory::Memzero(keyframeOut);
+	keyframeOut.Tick = m_RecordedTicks;
+
+	const FQuat rotation = GetActorQuat();
+	StoreFloats(keyframeOut.Location, GetActorLocation());
+	keyframeOut.Rotation[0] = rotation.X;
+	keyframeOut.Rotation[1] = rotation.Y;
+	keyframeOut.Rotation[2] = rotation.Z;
+	keyframeOut.Rotation[3] = rotation.W;
+	StoreFloats(keyframeOut.LinearVelocity, GetBodyVelocity());
+	StoreFloats(keyframeOut.AngularVelocity, MeshComp->GetPhysicsAngularVelocity());
+
+	StoreFloats(keyframeOut.LongitudinalVector, m_SimState.LongitudinalVector);
+	StoreFloats(keyframeOut.LateralVector, m_SimState.LateralVector);
+	StoreFloats(keyframeOut.PrevVelocity, m_SimState.PrevVelocity);
+	keyframeOut.Steering = m_SimState.Steering;
+	keyframeOut.Reverse = (m_SimState.Reverse ? 1 : 0);
+
+	keyframeOut.IsOnGround = (GroundStateComp != nullptr && GroundStateComp->IsOnGround()) ? 1 : 0;
+	if (GroundStateComp != nullptr)
+	{
+		StoreFloats(keyframeOut.GroundPosition, GroundStateComp->GetGroundPosition());
+		StoreFloats(keyframeOut.GroundNormal, GroundStateComp->GetGroundNormal());
+	}
+}
+
+void ASkateboardSimPawn::ApplyKeyframe(const SkateRecording::FKeyframe& keyframe)
+{
+	const FQuat rotation(keyframe.Rotation[0], keyframe.Rotation[1], keyframe.Rotation[2], keyframe.Rotation[3]);
+	SetActorLocationAndRotation(LoadFVector(keyframe.Location), rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	SetBodyVelocity(LoadFVector(keyframe.LinearVelocity));
+	MeshComp->SetPhysicsAngularVelocity(LoadFVector(keyframe.AngularVelocity));
+
+	// The ground state is re-probed from here this tick, so only the simulation state needs restoring.
+	m_SimState.LongitudinalVector = SkateSim::ToSim(LoadFVector(keyframe.LongitudinalVector));
+	m_SimState.LateralVector = SkateSim::ToSim(LoadFVector(keyframe.LateralVector));
+	m_SimState.PrevVelocity = SkateSim::ToSim(LoadFVector(keyframe.PrevVelocity));
+	m_SimState.Steering = keyframe.Steering;
+	m_SimState.Reverse = (keyframe.Reverse != 0);
+	PushSimStateToBatch();
+}
+
+bool ASkateboardSimPawn::RequiresFullSim() const
+{
+	return (!UseSimLOD || IsPlayerControlled() || IsRecording() || IsReplaying() || EnableRollback);
+}
+
+void ASkateboardSimPawn::SetSimTier(ESkateSimTier::Type tier)
+{
+	// Coasting needs ground to coast on, and on a client it would fight the corrections from the server.
+	if (tier == ESkateSimTier::Dormant && (!m_FrameGround.IsOnGround || Role != ROLE_Authority || MeshComp == nullptr))
+		tier = ESkateSimTier::Low;
+
+	if (tier == m_SimTier)
+		return;
+
+	if (m_SimTier == ESkateSimTier::Dormant)
+		LeaveDormant();
+
+	m_SimTier = tier;
+	m_StepForce = FVector::ZeroVector;
+
+	if (tier == ESkateSimTier::Dormant)
+	{
+		EnterDormant();
+	}
+	else if (tier == ESkateSimTier::Low)
+	{
+		// Start somewhere random in the step interval, so boards that drop together don't all step on the same frame.
+		m_StepAccumulatedTime = FMath::FRand() / FMath::Max(LowTierTickRate, 1.0f);
+		m_SkateboardModelFrom = m_SkateboardModelTo = SkateboardModelPivot->GetComponentQuat();
+		m_RiderModelFrom = m_RiderModelTo = RiderModelPivot->GetComponentQuat();
+	}
+}
+
+void ASkateboardSimPawn::UpdateStepSchedule(float deltaTime)
+{
+	m_TickDeltaTime = deltaTime;
+	if (m_SimTier == ESkateSimTier::Dormant)
+	{
+		m_StepThisFrame = false;
+		m_StepDeltaTime = 0.0f;
+	}
+	else if (m_SimTier == ESkateSimTier::Low)
+	{
+		m_StepAccumulatedTime += deltaTime;
+		m_StepThisFrame = (m_StepAccumulatedTime * FMath::Max(LowTierTickRate, 1.0f) >= 1.0f);
+		m_StepDeltaTime = m_StepAccumulatedTime;
+		if (m_StepThisFrame)
+			m_StepAccumulatedTime = 0.0f;
+	}
+	else
+	{
+		m_StepThisFrame = true;
+		m_StepDeltaTime = deltaTime;
+	}
+}
+
+void ASkateboardSimPawn::EnterDormant()
+{
+	// Carry on along the ground at the speed we're going, without physics.
+	const FVector normal = SkateSim::FromSim(m_FrameGround.Normal);
+	const FVector velocity = GetBodyVelocity();
+	m_DormantVelocity = velocity - normal * FVector::DotProduct(velocity, normal);
+	m_DormantRideHeight = FVector::DotProduct(GetActorLocation() - SkateSim::FromSim(m_FrameGround.Position), normal);
+	m_DormantProbeTimer = GetDormantProbeInterval();
+	m_Contacts.Reset();
+
+	MeshComp->SetSimulatePhysics(false);
+}
+
+void ASkateboardSimPawn::LeaveDormant()
+{
+	MeshComp->SetSimulatePhysics(!UseKinematicMovement);
+	SetBodyVelocity(m_DormantVelocity);
+}
+
+void ASkateboardSimPawn::UpdateDormant(float deltaTime)
+{
+	// Coast in a straight line along the ground plane, re-fitted to the ground every GetDormantProbeInterval().  The
+	// move is swept, so we never end up inside anything for physics to throw us out of when we wake.
+	const FVector start = GetActorLocation();
+	FHitResult hit;
+	SetActorLocation(start + m_DormantVelocity * deltaTime, true, &hit, ETeleportType::TeleportPhysics);
+	if (hit.bBlockingHit)
+	{
+		if (hit.bStartPenetrating)
+		{
+			// Started inside something (e.g. scraping the ground at our ride height): back out, and move on next tick.
+			SetActorLocation(start + hit.Normal * (hit.PenetrationDepth + KinematicPushOutDistance), false, nullptr, ETeleportType::TeleportPhysics);
+		}
+		else if (hit.Normal.Z < KinematicWallNormalZ || Cast<APawn>(hit.GetActor()) != nullptr)
+		{
+			// A wall or another board: stop against it, and wait there.
+			m_DormantVelocity = FVector::ZeroVector;
+		}
+		else
+		{
+			// The ground rising ahead of us, e.g. a ramp: turn onto it, and re-fit to it straight away.
+			const float speed = m_DormantVelocity.Size();
+			m_DormantVelocity = FVector::VectorPlaneProject(m_DormantVelocity, hit.Normal).GetSafeNormal() * speed;
+			m_DormantProbeTimer = 0.0f;
+		}
+	}
+
+	m_DormantProbeTimer -= deltaTime;
+	if (m_DormantProbeTimer <= 0.0f && GroundStateComp != nullptr)
+	{
+		m_DormantProbeTimer = GetDormantProbeInterval();
+
+		// Probe down from where we are, which the sweep has just found clear, so ground that's risen under us since
+		// the last fit is still found above the probe's end.
+		const FVector location = GetActorLocation();
+		const FVector normal = SkateSim::FromSim(m_FrameGround.Normal);
+		const FVector probeEnd = location - normal * (m_DormantRideHeight + 0.5f * GetBoardProfile().ProbeLength);
+		FHitResult groundHit;
+		if (GroundStateComp->ProbeRideable(location, probeEnd, groundHit))
+		{
+			const FVector groundNormal = groundHit.ImpactNormal;
+			const float speed = m_DormantVelocity.Size();
+			m_DormantVelocity = FVector::VectorPlaneProject(m_DormantVelocity, groundNormal).GetSafeNormal() * speed;
+			GroundStateComp->SetGroundState(true, groundHit.ImpactPoint, groundNormal);
+
+			// Back up to our ride height, swept, in case that's blocked.
+			const FVector fitted = location + groundNormal * (m_DormantRideHeight - FVector::DotProduct(location - groundHit.ImpactPoint, groundNormal));
+			SetActorLocation(fitted, true, nullptr, ETeleportType::TeleportPhysics);
+		}
+		else
+		{
+			// Run out of ground, e.g. at a ledge: wait where we last had some rather than float off.  We were there
+			// last tick, so it's clear.
+			SetActorLocation(start, false, nullptr, ETeleportType::TeleportPhysics);
+			m_DormantVelocity = FVector::ZeroVector;
+			GroundStateComp->SetGroundState(m_FrameGround.IsOnGround, SkateSim::FromSim(m_FrameGround.Position), SkateSim::FromSim(m_FrameGround.Normal));
+		}
+		m_FrameGround = GetSimGroundContact();
+	}
+}
+
+float ASkateboardSimPawn::GetDormantProbeInterval() const
+{
+	// No further than one probe length between fits, or the ground could rise or fall out of the probe's reach.
+	const float speed = m_DormantVelocity.Size();
+	const float probeLength = GetBoardProfile().ProbeLength;
+	return (speed * DormantProbeInterval > probeLength ? probeLength / speed : DormantProbeInterval);
+}
+
+void ASkateboardSimPawn::SaveSnapshot(float deltaTime)
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardRollbackSave);
+
+	SkateSim::FBoardSnapshot snapshot;
+	MakeSnapshot(snapshot);
+	snapshot.Tick = m_SimTick;
+	snapshot.Input = GetSimInput();
+	snapshot.DeltaTime = deltaTime;
+	m_Snapshots.Save(snapshot);
+}
+
+void ASkateboardSimPawn::MakeSnapshot(SkateSim::FBoardSnapshot& snapshotOut) const
+{
+	const FQuat rotation = GetActorQuat();
+	snapshotOut.Body.Position = SkateSim::ToSim(GetActorLocation());
+	snapshotOut.Body.Velocity = SkateSim::ToSim(GetBodyVelocity());
+	snapshotOut.Body.AngularVelocity = SkateSim::ToSim(MeshComp->GetPhysicsAngularVelocity());
+	snapshotOut.Body.Rotation[0] = rotation.X;
+	snapshotOut.Body.Rotation[1] = rotation.Y;
+	snapshotOut.Body.Rotation[2] = rotation.Z;
+	snapshotOut.Body.Rotation[3] = rotation.W;
+	snapshotOut.State = m_SimState;
+	snapshotOut.Ground = GetSimGroundContact();
+}
+
+void ASkateboardSimPawn::ApplySnapshot(const SkateSim::FBoardSnapshot& snapshot)
+{
+	const SkateSim::FBodyState& body = snapshot.Body;
+	const FQuat rotation(body.Rotation[0], body.Rotation[1], body.Rotation[2], body.Rotation[3]);
+	SetActorLocationAndRotation(SkateSim::FromSim(body.Position), rotation, false, nullptr, ETeleportType::TeleportPhysics);
+	SetBodyVelocity(SkateSim::FromSim(body.Velocity));
+	MeshComp->SetPhysicsAngularVelocity(SkateSim::FromSim(body.AngularVelocity));
+
+	m_SimState = snapshot.State;
+	PushSimStateToBatch();
+
+	if (GroundStateComp != nullptr)
+	{
+		GroundStateComp->SetGroundState(snapshot.Ground.IsOnGround, SkateSim::FromSim(snapshot.Ground.Position), SkateSim::FromSim(snapshot.Ground.Normal));
+	}
+	m_FrameGround = snapshot.Ground;
+}
+
+bool ASkateboardSimPawn::RestoreSnapshot(uint32 tick)
+{
+	const SkateSim::FBoardSnapshot* snapshot = m_Snapshots.Find(tick);
+	if (snapshot == nullptr || MeshComp == nullptr)
+		return false;
+
+	ApplySnapshot(*snapshot);
+	m_MovementInput.X = snapshot->Input.Forward;
+	m_MovementInput.Y = snapshot->Input.Right;
+	m_SimTick = tick;
+	return true;
+}
+
+int32 ASkateboardSimPawn::ResimulateFrom(uint32 fromTick, const SkateSim::FBoardSnapshot* correction)
+{
+	SkateSim::FBoardSnapshot* from = m_Snapshots.Find(fromTick);
+	if (from == nullptr || MeshComp == nullptr || !m_Snapshots.Holds(fromTick, m_SimTick))
+		return INDEX_NONE;
+
+	if (correction != nullptr)
+	{
+		from->State = correction->State;
+		from->Body = correction->Body;
+		from->Ground = correction->Ground;
+	}
+
+	SkateSim::FBoardSnapshot result;
+	RunResimulation(m_Snapshots, fromTick, result);
+	ApplySnapshot(result);
+	return (int32)(m_SimTick - fromTick);
+}
+
+int32 ASkateboardSimPawn::Resimulate(int32 numTicks)
+{
+	if (numTicks <= 0 || (uint32)numTicks > m_SimTick)
+		return INDEX_NONE;
+	return ResimulateFrom(m_SimTick - (uint32)numTicks);
+}
+
+int32 ASkateboardSimPawn::ResimulateCopy(int32 numTicks) const
+{
+	if (numTicks <= 0 || (uint32)numTicks > m_SimTick || MeshComp == nullptr)
+		return INDEX_NONE;
+
+	const uint32 fromTick = m_SimTick - (uint32)numTicks;
+	if (!m_Snapshots.Holds(fromTick, m_SimTick))
+		return INDEX_NONE;
+
+	// Resimulation rewrites the snapshots it runs over, so give it a copy, and throw away where it ends up.
+	SkateSim::FBoardSnapshotRing snapshots = m_Snapshots;
+	SkateSim::FBoardSnapshot result;
+	RunResimulation(snapshots, fromTick, result);
+	return numTicks;
+}
+
+void ASkateboardSimPawn::RunResimulation(SkateSim::FBoardSnapshotRing& snapshots, uint32 fromTick, SkateSim::FBoardSnapshot& resultOut) const
+{
+	SCOPE_CYCLE_COUNTER(STAT_SkateboardRollbackResimulate);
+
+	// Rotation is locked, so the body keeps whatever it had at fromTick.
+	FResimWorld world;
+	world.GroundState = GroundStateComp;
+	world.GravityZ = GetWorld()->GetGravityZ();
+	world.RideHeight = MeshComp->Bounds.BoxExtent.Z;
+
+	SkateSim::Resimulate(snapshots, fromTick, m_SimTick, GetBoardProfile(), MeshComp->GetMass(), world, resultOut);
+	INC_DWORD_STAT_BY(STAT_SkateboardRollbackTicks, (int32)(m_SimTick - fromTick));
+}
+
+void ASkateboardSimPawn::UpdateRepMovement()
+{
+	SkateSim::FNetBoardSample sample;
+	sample.Position = SkateSim::ToSim(GetActorLocation());
+	sample.Velocity = SkateSim::ToSim(GetBodyVelocity());
+	sample.LongitudinalVector = m_SimState.LongitudinalVector;
+	sample.LateralVector = m_SimState.LateralVector;
+	sample.Reverse = m_SimState.Reverse;
+	sample.IsOnGround = (GroundStateComp != nullptr && GroundStateComp->IsOnGround());
+	sample.Steering = m_SimState.Steering;
+	sample.InputForward = m_MovementInput.X;
+	m_RepMovement.SetState(sample);
+}
+
+void ASkateboardSimPawn::SendMoveInput()
+{
+	const uint8 forward = QuantizeInputAxis(m_MovementInput.X);
+	const uint8 right = QuantizeInputAxis(m_MovementInput.Y);
+	const float now = GetWorld()->GetTimeSeconds();
+	if (forward == m_SentMoveInput[0] && right == m_SentMoveInput[1] && now - m_MoveInputSendTime < MoveInputResendInterval)
+		return;
+
+	ServerSetMoveInput(forward, right);
+	m_SentMoveInput[0] = forward;
+	m_SentMoveInput[1] = right;
+	m_MoveInputSendTime = now;
+}
+
+bool ASkateboardSimPawn::ServerSetMoveInput_Validate(uint8 forward, uint8 right)
+{
+	return true;
+}
+
+void ASkateboardSimPawn::ServerSetMoveInput_Implementation(uint8 forward, uint8 right)
+{
+	Input_MoveForward(DequantizeInputAxis(forward));
+	Input_MoveRight(DequantizeInputAxis(right));
+}
+
+void ASkateboardSimPawn::OnRep_RepMovement()
+{
+	if (Role == ROLE_Authority || m_RepMovement.GetNumReceived() == m_AppliedRepMovement)
+		return;
+	m_AppliedRepMovement = m_RepMovement.GetNumReceived();
+
+	const SkateSim::FNetBoardSample& state = m_RepMovement.GetState();
+	const FVector serverLocation = SkateSim::FromSim(state.Position);
+	const FVector serverVelocity = SkateSim::FromSim(state.Velocity);
+	const FVector error = serverLocation - GetActorLocation();
+
+	if (error.SizeSquared() > FMath::Square(NetSnapDistance))
+	{
+		SetActorLocation(serverLocation, false, nullptr, ETeleportType::TeleportPhysics);
+		SetBodyVelocity(serverVelocity);
+		INC_DWORD_STAT(STAT_SkateboardNetSnaps);
+	}
+	else if (Role == ROLE_SimulatedProxy)
+	{
+		// Steer back over NetCorrectionTime rather than popping.  The owning client is ahead of the server by its
+		// round trip, so it only ever snaps.
+		SetBodyVelocity(serverVelocity + error / FMath::Max(NetCorrectionTime, 0.01f));
+	}
+
+	// The owning client steers with its own input; everyone else simulates the server's.
+	if (Role == ROLE_SimulatedProxy)
+	{
+		m_SimState.LongitudinalVector = state.LongitudinalVector;
+		m_SimState.LateralVector = state.LateralVector;
+		m_SimState.Reverse = state.Reverse;
+		m_SimState.Steering = state.Steering;
+		PushSimStateToBatch();
+
+		m_MovementInput.X = state.InputForward;
+		m_MovementInput.Y = state.Steering;
+	}
+}
+
+
+// Console commands.
+
+static void ResimulateAllPawns(const TArray<FString>& args, UWorld* world)
+{
+	if (args.Num() == 0)
+	{
+		UE_LOG(LogSkateboardSim, Display, TEXT("Usage: skate.Resimulate <ticks> [repeats]"));
+		return;
+	}
+
+	const int32 numTicks = FCString::Atoi(*args[0]);
+	const int32 repeats = FMath::Max(args.Num() > 1 ? FCString::Atoi(*args[1]) : 1, 1);
+
+	int32 numPawns = 0;
+	int64 totalTicks = 0;
+	const double startTime = FPlatformTime::Seconds();
+	for (TActorIterator<ASkateboardSimPawn> it(world); it; ++it)
+	{
+		for (int32 i = 0; i < repeats; ++i)
+		{
+			const int32 resimulated = it->ResimulateCopy(numTicks);
+			if (resimulated == INDEX_NONE)
+				break;
+			totalTicks += resimulated;
+			numPawns += (i == 0 ? 1 : 0);
+		}
+	}
+	const double elapsedMs = (FPlatformTime::Seconds() - startTime) * 1000.0;
+
+	if (totalTicks == 0)
+	{
+		UE_LOG(LogSkateboardSim, Display, TEXT("skate.Resimulate: no skateboard pawn has %d ticks of snapshots (is EnableRollback set?)"), numTicks);
+		return;
+	}
+	UE_LOG(LogSkateboardSim, Display, TEXT("Resimulated %lld ticks on %d pawns in %.3f ms (%.2f us per tick)"),
+		totalTicks, numPawns, elapsedMs, elapsedMs * 1000.0 / totalTicks);
+}
+
+static FAutoConsoleCommandWithWorldAndArgs ResimulateCommand(
+	TEXT("skate.Resimulate"),
+	TEXT("skate.Resimulate <ticks> [repeats]: re-run the last <ticks> ticks of every skateboard pawn with EnableRollback set, on a copy of its\n")
+	TEXT("snapshots so the pawn itself is left alone, and log how long it took."),
+	FConsoleCommandWithWorldAndArgsDelegate::CreateStatic(&ResimulateAllPawns));
@@ -3,10 +3,33 @@
 #pragma once
 
 #include "GameFramework/Pawn.h"
+#include "SkateboardSimCoreConversions.h"
+#include "SkateboardSimRollback.h"
+#include "SkateboardRecording.h"
+#include "SkateboardNetMovement.h"
+#include "SkateboardRiderPose.h"
+#include "SkateboardSimContacts.h"
 #include "SkateboardSimPawn.generated.h"
 
 class UGroundStateComponent;
 class USkateboardTune;
+class USkateboardLoadout;
+class ASkateboardSimManager;
+class USkateboardRiderAnimInstance;
+
+// How much of the simulation a board runs, picked by ASkateboardSimManager from how much the board matters to the
+// players right now.  Ordered from most to least work.
+namespace ESkateSimTier
+{
+	enum Type
+	{
+		Full,		// Four ground probes and every phase, every frame
+		Reduced,	// Two ground probes (front and rear), every frame
+		Low,		// One ground probe, stepped at LowTierTickRate; the models are interpolated in between
+		Dormant,	// No forces: physics is off, and the board coasts along its heading, swept, re-fitted to the ground
+		Count
+	};
+}
 
 /**
 * The high-level pawn that handles the skateboard simulation.
@@ -16,6 +39,9 @@ class AWOL_API ASkateboardSimPawn : public APawn
 {
 	GENERATED_BODY()
 
+	// The manager drives our simulation phases directly when ticking centrally.
+	friend class ASkateboardSimManager;
+
 public:
 	// Sets default values for this pawn's properties
 	ASkateboardSimPawn();
@@ -23,9 +49,127 @@ public:
 	// Called when the game starts or when spawned
 	virtual void BeginPlay() override;
 	
+	// Called when the pawn is being removed from the level
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
 	// Called every frame
 	virtual void Tick( float DeltaSeconds ) override;
 
+	virtual void GetLifetimeReplicatedProps(TArray<FLifetimeProperty>& OutLifetimeProps) const override;
+
+	// Called by ASkateboardSimManager once the batch has been stepped, to apply our results (per-actor ticking only).
+	void ApplyBatchStep();
+
+	// Called by ASkateboardSimManager when our slot in the batch changes.
+	void SetBatchIndex(int32 index) { m_BatchIndex = index; }
+
+	// Called by ASkateboardSimManager to switch between being ticked by it and ticking ourselves.
+	void SetCentralTick(bool centralTick);
+
+	// Is our orientation/force math stepped in the manager's batch?
+	bool IsBatched() const { return m_BatchIndex != INDEX_NONE; }
+
+	// Start recording our inputs each tick (plus a state keyframe every RecordingKeyframeInterval ticks) to the given
+	// file.  Also available for every pawn at once through the skate.Record console command.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Recording")
+	bool StartRecording(const FString& path);
+
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Recording")
+	void StopRecording();
+
+	// Move to the start of a recording and feed its inputs back through Input_*, one recorded tick per tick.  While
+	// replaying, the engine runs at a fixed time step matching each recorded tick's delta time; with several pawns
+	// replaying, the first to start sets it (see ASkateboardSimManager::BeginReplay).  Returns false if the recording
+	// can't be loaded, or we haven't begun play.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Recording")
+	bool StartReplay(const FString& path);
+
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Recording")
+	void StopReplay();
+
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Recording")
+	bool IsRecording() const { return m_Recorder.IsValid(); }
+
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Recording")
+	bool IsReplaying() const { return m_Replay.IsValid(); }
+
+	// How many ticks we've simulated.  While EnableRollback is set, we keep a snapshot of the start of each of the
+	// last SkateSim::FBoardSnapshotRing::Capacity ticks, numbered by this.
+	uint32 GetSimTick() const { return m_SimTick; }
+
+	// Put our body, simulation state, ground state and input back as they were at the start of the given tick, and
+	// carry on from there.  Returns false, changing nothing, if we don't have that tick's snapshot.
+	bool RestoreSnapshot(uint32 tick);
+
+	// Go back to the start of fromTick, optionally replacing our state there with a correction (its Tick, Input and
+	// DeltaTime are ignored), and re-run every tick since with the inputs recorded at the time.  The camera, models,
+	// recording and replication aren't touched along the way; the next tick updates them as usual.
+	// Returns the number of ticks resimulated, or INDEX_NONE if we don't have snapshots for all of them.
+	int32 ResimulateFrom(uint32 fromTick, const SkateSim::FBoardSnapshot* correction = nullptr);
+
+	// Re-run the last numTicks ticks from their snapshots.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Rollback")
+	int32 Resimulate(int32 numTicks);
+
+	// Re-run the last numTicks ticks on a copy of their snapshots, and throw the result away, leaving us (and our
+	// snapshots) exactly as we were.  For timing resimulation on live pawns; skate.Resimulate uses it.
+	int32 ResimulateCopy(int32 numTicks) const;
+
+	// The simulation tier we're running at.  Always Full unless ASkateboardSimManager has moved us.
+	ESkateSimTier::Type GetSimTier() const { return m_SimTier; }
+
+	// Called by ASkateboardSimManager to move us to another tier.  Takes effect from our next tick.
+	void SetSimTier(ESkateSimTier::Type tier);
+
+	// Has any of our components been rendered in the last half second?
+	bool WasRenderedRecently() const;
+
+	// Must we stay at full detail, whatever the manager thinks?  True for player-controlled boards, and while
+	// recording, replaying or keeping rollback snapshots, all of which need every tick simulated in full.
+	bool RequiresFullSim() const;
+
+	// Did BeginSimTick() decide to run the simulation phases this frame, and with what time step?  Low tier boards
+	// only step every few frames, with the time accumulated since their last step.
+	bool IsSteppingThisFrame() const { return m_StepThisFrame; }
+	float GetStepDeltaTime() const { return m_StepDeltaTime; }
+
+	// This frame's time step, whether or not we step.  Movement forces are worked out for this rather than the step's
+	// time, since a Low tier board holds its force on every frame until its next step.
+	float GetTickDeltaTime() const { return m_TickDeltaTime; }
+
+	// Switch between being moved by a simulating rigid body and moving ourselves (see UseKinematicMovement), keeping
+	// our velocity.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Movement")
+	void SetKinematicMovement(bool kinematic);
+
+	// Our Loadout, or the default one if we have none.
+	const USkateboardLoadout* GetLoadout() const;
+
+	// Seconds from process start (GStartTime) until the first board of this run had its assets and started riding,
+	// or a negative number if none has yet.  The cold start cost of a board, loading included.
+	static double GetFirstBoardReadyTime();
+
+	// Have our loadout's assets arrived?  Until they have, we're hidden, frozen and not simulated.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim")
+	bool HasLoadedAssets() const { return m_AssetsLoaded; }
+
+	// Our body's linear velocity, whichever way we're being moved.
+	FVector GetBodyVelocity() const;
+	void SetBodyVelocity(const FVector& velocity);
+
+	// The nearest grindable rail or ledge edge within radius of our board, from the level's rail index (see
+	// ASkateboardSimManager::GetGrindRails()).  The tangent points the way we're heading along it.  Returns false if
+	// there's none in reach.
+	UFUNCTION(BlueprintCallable, Category = "SkateboardSim|Grind")
+	bool FindGrindRail(float radius, FVector& positionOut, FVector& tangentOut, bool& isRailOut) const;
+
+	// What USkateboardRiderAnimInstance needs to solve the rider's pose, as of our last step.  Game thread only.
+	void GetRiderSimSnapshot(SkateSim::FRiderSimSnapshot& snapshotOut) const;
+
+	// Server: bits of movement updates written for this pawn since the last call, and what the same updates would
+	// have cost at full precision.
+	void ConsumeNetBitCounts(int64& sentBitsOut, int64& rawBitsOut) { m_RepMovement.ConsumeBitCounts(sentBitsOut, rawBitsOut); }
+
 	// Called to bind functionality to input
 	virtual void SetupPlayerInputComponent(class UInputComponent* InputComponent) override;
 
@@ -42,9 +186,9 @@ public:
 	UFUNCTION(BlueprintCallable, Category = "SkateboardSim")
 	void Input_CameraPitch(float AxisValue);
 
-	// Physics OnHit callback
-	UFUNCTION()
-	void OnActorBump(AActor* SelfActor, AActor* OtherActor, FVector NormalImpulse, const FHitResult& Hit);
+	// Collision callback, from physics or our own kinematic sweeps.  Only records the contact; they're all dealt with
+	// together at our next ground probe.
+	virtual void NotifyHit(UPrimitiveComponent* MyComp, AActor* Other, UPrimitiveComponent* OtherComp, bool bSelfMoved, FVector HitLocation, FVector HitNormal, FVector NormalImpulse, const FHitResult& Hit) override;
 
 	// Set the world rotation of the camera's spring arm (to match the previous camera)
 	UFUNCTION(BlueprintCallable, Category = "SkateboardSim")
@@ -84,14 +228,20 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	USceneComponent* RiderModelPivot;
 
-	// The physics material to use for our collision bound:
+	// The physics material to use for our collision bound.  If none, the loadout's.
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	UPhysicalMaterial* BoundPhysMtl;
 
-	// Tuning values that pertain to the skateboard.
-	UPROPERTY(EditAnywhere, BlueprintReadWrite)
+	// Tuning values that pertain to the skateboard, shared with every other board using the same asset.  If none, the
+	// loadout's, and failing that USkateboardTune's defaults.  Only read once our assets have loaded.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
 	USkateboardTune* SkateboardTune;
 
+	// Our bound, tuning and models, all soft-referenced and streamed in at BeginPlay if they aren't in memory already
+	// (see USkateboardLoadout).  If none, USkateboardLoadout's defaults.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly)
+	USkateboardLoadout* Loadout;
+
 	// Our ground state component, which keeps track of our interaction with the ground:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	UGroundStateComponent* GroundStateComp;
@@ -100,44 +250,154 @@ public:
 	UPROPERTY(EditAnywhere, BlueprintReadWrite)
 	bool DebugDrawEnabled;
 
+	// If true, our orientation, steering and forces are computed together with every other batched pawn by
+	// ASkateboardSimManager, rather than one pawn at a time.  Only read at BeginPlay.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SkateboardSim")
+	bool UseBatchSimulation;
+
+	// If true, our capsule doesn't simulate physics: we integrate our own velocity from the simulation's forces, are
+	// held up by the ground we probed, and sweep along the rest of each move, sliding along whatever we hit.  Saves a
+	// dynamic rigid body and its contact generation per board.  Use SetKinematicMovement() to change it in play.
+	UPROPERTY(EditAnywhere, BlueprintReadOnly, Category = "SkateboardSim|Movement")
+	bool UseKinematicMovement;
+
+	// In the air, how many seconds before our predicted landing (see UGroundStateComponent::UseFlightPrediction) to
+	// start turning to match the surface we'll land on.  0 to leave our orientation alone until we touch down.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Movement")
+	float LandingAlignTime;
+
+	// How many ticks apart recorded state keyframes are.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Recording")
+	int32 RecordingKeyframeInterval;
+
+	// Size of the in-memory buffer recordings are written to before being flushed to disk.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Recording")
+	int32 RecordingBufferKB;
+
+	// If true, a snapshot of our state is saved at the start of every tick, so that recent ticks can be restored and
+	// resimulated.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Rollback")
+	bool EnableRollback;
+
+	// If true, ASkateboardSimManager may drop this board to cheaper simulation tiers when it's far from every player
+	// or off screen.  Player-controlled boards always run in full.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|LOD")
+	bool UseSimLOD;
+
+	// Simulation steps per second at the Low tier.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|LOD")
+	float LowTierTickRate;
+
+	// The most seconds between the ground probes that keep a Dormant board on the ground.  Faster boards probe more
+	// often, so they never coast more than a probe length between them.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|LOD")
+	float DormantProbeInterval;
+
+	// Movement updates per second to players close to this board.  ASkateboardSimManager scales our
+	// NetUpdateFrequency between this and NetMinUpdateRate with distance from the nearest player.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Network")
+	float NetMaxUpdateRate;
+
+	// Movement updates per second to players far from this board.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Network")
+	float NetMinUpdateRate;
+
+	// On clients, how far this board can be from the server's position before it's teleported there rather than
+	// steered there.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Network")
+	float NetSnapDistance;
+
+	// On clients, how long other players' boards take to be steered back to the server's position.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = "SkateboardSim|Network")
+	float NetCorrectionTime;
+
 private:
+	// Our loadout's assets have arrived: apply them, and start riding.
+	void OnAssetsLoaded();
+
+	// Fill in whatever of our bound, tuning and models the loadout has and we don't.
+	void ApplyLoadout(const USkateboardLoadout& loadout);
+
+	// What BeginPlay() would do if we didn't have to wait for our assets: pick our profile, start simulating, and
+	// register with the manager.
+	void StartRiding();
+
+	// Simulation phases, in the order they run each tick.
+	void BeginSimTick(float deltaTime);
+	void UpdateGroundState();
 	void UpdateOrientation();
 	void UpdateSteering(float deltaTime);
 	void UpdateMovement(float deltaTime);
 	void UpdateCamera();
 	void UpdateSkateboardModel();
 	void UpdateRiderModel();
+	void UpdateInterpolatedModels();
 	void UpdatePrevVelocity();
+	void UpdateVisuals();
+
+	// Visuals, previous velocity and debug draw; the tail end of every tick.
+	void EndSimTick();
+
+	// The tail end of a tick that didn't step (see IsSteppingThisFrame()): hold the last force and interpolate the
+	// models, or coast if we're dormant.
+	void EndSkippedTick(float deltaTime);
+
+	// Batched equivalents of UpdateOrientation/UpdateSteering/UpdateMovement: write our inputs into the batch,
+	// then read back the stepped state and apply the resulting force/impulse.
+	void GatherBatchInput();
+	void ApplyBatchOutput();
+
+	// Read this tick's ground contact, velocity and tuning into m_Frame*, once the ground has been probed.  Every
+	// later phase of the tick reads these rather than going back to the ground state component or the body.
+	void BeginSimFrame();
+
+	// Does a Blueprint subclass implement the Tick event?
+	bool HasBlueprintTick() const;
+
+	// The read-only half of UpdateMovement(): compute the force/impulse to apply this tick, without touching our body.
+	SkateSim::FBoardOutput ComputeMovement(float deltaTime) const;
+
+	// Apply the force/impulse computed by the simulation core to our body.
+	void ApplySimOutput(const SkateSim::FBoardOutput& output);
 
-	// Compute desired steering angle, in degrees
-	float ComputeSteerAngleDeg() const;
+	// Copy m_SimState into our batch slot, after changing it outside of the simulation step.
+	void PushSimStateToBatch();
 
-	// Compute unit force (mass==1) to apply in direction of GetForwardVector()
-	FVector ComputeForwardForce() const;
+	// Gather our ground state, tuning and input in the form the simulation core expects.  The tuning depends on how
+	// fast we're going, through the profile's response curves.
+	SkateSim::FGroundContact GetSimGroundContact() const;
+	SkateSim::FBoardTune GetSimTune(const SkateSim::FVec3& velocity) const;
+	SkateSim::FBoardInput GetSimInput() const;
 
-	// Compute unit force (mass==1) to apply in direction of GetRightVector()
-	FVector ComputeRightForce(float deltaTime) const;
+	// Our compiled tuning profile.
+	const SkateSim::FBoardProfile& GetBoardProfile() const;
 
 	// Compute centripetal acceleration, in cm/s^2
 	FVector ComputeCentripetalAccel() const;
 
-	// Given current position, and previous and current velocity in cm/s,
-	// compute the circular turn pivot.  (The magnitude of the return value is
-	// the turn radius in cm.)
-	FVector ComputeTurnPivot(FVector pos, FVector v1, FVector v2) const;
-
 	// Returns a unit vector pointing in the direction of travel.
 	// NOTE: this vector can abruptly reverse, e.g. at the apex of a slope.
-	FVector GetForwardVector() const { return (m_Reverse ? -m_LongitudinalVector : m_LongitudinalVector); }
+	FVector GetForwardVector() const { return SkateSim::FromSim(SkateSim::GetForwardVector(m_SimState)); }
 
 	// Returns a unit vector pointing perpendicular to the direction of travel.
 	// NOTE: this vector can abruptly reverse, e.g. at the apex of a slope.
-	FVector GetRightVector() const { return (m_Reverse ? -m_LateralVector : m_LateralVector); }
+	FVector GetRightVector() const { return SkateSim::FromSim(SkateSim::GetRightVector(m_SimState)); }
 
-	FVector GetUpVector() const { return FVector::CrossProduct(GetForwardVector(), GetRightVector()); }
+	FVector GetUpVector() const { return SkateSim::FromSim(SkateSim::GetUpVector(m_SimState)); }
 
 	FVector GetRiderUpVector() const;
 
+	// Where UpdateSkateboardModel() and UpdateRiderModel() point the pivots.
+	FQuat ComputeSkateboardModelRotation() const;
+	FQuat ComputeRiderModelRotation() const;
+
+	// Should the model pivots be updated this frame?  Always while we're on screen; otherwise every
+	// skate.OffscreenModelInterval seconds.
+	bool ShouldUpdateModels();
+
+	// Set a model pivot's world rotation, through the manager's batched, dirty-checked pivot writes.
+	void SetModelRotation(USceneComponent* pivot, const FQuat& rotation);
+
 	FVector GetCenterOfMassPos() const;
 
 	FVector GetTopOfDeckPos() const;
@@ -146,20 +406,125 @@ private:
 
 	void DebugDraw() const;
 
+	// Replay: feed the next recorded tick's inputs, and place us at (or check us against) its keyframe.
+	void FeedReplayInput();
+
+	void MakeKeyframe(SkateRecording::FKeyframe& keyframeOut) const;
+	void ApplyKeyframe(const SkateRecording::FKeyframe& keyframe);
+
+	// Simulation LOD: decide whether this tick steps, and move in and out of the kinematic Dormant tier.
+	void UpdateStepSchedule(float deltaTime);
+	void EnterDormant();
+	void LeaveDormant();
+	void UpdateDormant(float deltaTime);
+	float GetDormantProbeInterval() const;
+
+	// Kinematic movement: integrate the pending impulse and m_StepForce over deltaTime, and sweep the capsule along.
+	void MoveKinematic(float deltaTime);
+
+	// Rollback: save the start of this tick, and convert between snapshots and our current state.
+	void SaveSnapshot(float deltaTime);
+	void MakeSnapshot(SkateSim::FBoardSnapshot& snapshotOut) const;
+	void ApplySnapshot(const SkateSim::FBoardSnapshot& snapshot);
+
+	// Re-run ticks from fromTick up to now over the given snapshots, rewriting them, and return where we'd be now.
+	void RunResimulation(SkateSim::FBoardSnapshotRing& snapshots, uint32 fromTick, SkateSim::FBoardSnapshot& resultOut) const;
+
+	// Networking: the server publishes our state at the end of every tick, the owning client sends its input, and
+	// everyone else corrects towards the server's state as it arrives.
+	void UpdateRepMovement();
+	void SendMoveInput();
+
+	UFUNCTION()
+	void OnRep_RepMovement();
+
+	// Stick input from the owning client, quantized with SkateSim::NetAxisScale and offset by 128.
+	UFUNCTION(Server, Unreliable, WithValidation)
+	void ServerSetMoveInput(uint8 forward, uint8 right);
+
 private:
 
 	// Input variables
 	FVector m_MovementInput;
 	FVector m_CameraInput;
 
-	// Physics state
-	FVector m_PrevVelocity;
-
-	// Orientation state
-	FVector m_LateralVector; // Perpendicular to m_LongitudinalVector; m_LongitudinalVector X m_LateralVector = ground normal.
-	FVector m_LongitudinalVector; // Direction board is pointing; velocity is +/- this vector.
-	bool m_Reverse; // If true, velocity is negative along m_LongitudinalVector.
-
-	// Normalized steering value
-	float m_Steering;
+	// The profile compiled from SkateboardTune (or the defaults), picked at BeginPlay.  Not ours.
+	const SkateSim::FBoardProfile* m_Profile;
+
+	// Orientation, steering and previous-velocity state, owned by the simulation core.
+	// When batched, the batch holds the authoritative copy and this mirrors it after every step.
+	SkateSim::FBoardState m_SimState;
+
+	// Collision contacts reported since our last ground probe.
+	SkateSim::FContactBuffer m_Contacts;
+
+	// This tick's ground contact, tuning and kinematic frame; see BeginSimFrame().
+	SkateSim::FGroundContact m_FrameGround;
+	SkateSim::FBoardTune m_FrameTune;
+	SkateSim::FBoardFrame m_Frame;
+
+	// The previous tick's frame velocity and the time steps of both ticks, for the rider's acceleration estimate.
+	SkateSim::FVec3 m_FramePrevVelocity;
+	float m_FrameDeltaTime;
+	float m_FramePrevDeltaTime;
+
+	// The rider's anim instance, if it solves the rider's pose (see USkateboardRiderAnimInstance).
+	TWeakObjectPtr<USkateboardRiderAnimInstance> m_RiderAnim;
+
+	// Simulation LOD state.  m_StepForce is the last force applied, held on the frames a Low tier board doesn't step.
+	ESkateSimTier::Type m_SimTier;
+	float m_SimTierDropTime;	// How long the manager has wanted to drop us a tier
+	bool m_StepThisFrame;
+	float m_StepDeltaTime;
+	float m_TickDeltaTime;
+	float m_StepAccumulatedTime;
+	FVector m_StepForce;
+
+	// Low tier: the pivots' rotations at the last two steps; the models are blended from one to the other.
+	FQuat m_SkateboardModelFrom;
+	FQuat m_SkateboardModelTo;
+	FQuat m_RiderModelFrom;
+	FQuat m_RiderModelTo;
+
+	// Kinematic movement state: our velocity, and the impulse waiting to be applied at the end of the tick.
+	FVector m_KinematicVelocity;
+	FVector m_KinematicImpulse;
+
+	// When the model pivots are next updated while we're off screen.
+	float m_NextOffscreenModelUpdate;
+
+	// Dormant tier: our velocity along the ground, our height above it, and the time until we next probe for it.
+	FVector m_DormantVelocity;
+	float m_DormantRideHeight;
+	float m_DormantProbeTimer;
+
+	// The manager that ticks or steps us, and our slot in its batch (INDEX_NONE unless UseBatchSimulation is set).
+	UPROPERTY(Transient)
+	ASkateboardSimManager* m_SimManager;
+	int32 m_BatchIndex;
+
+	// If true, ASkateboardSimManager runs our simulation phases and our own Tick() does no simulation work.
+	bool m_CentralTick;
+
+	// Whether our loadout's assets have arrived, and when (in platform seconds) we asked for them.
+	bool m_AssetsLoaded;
+	double m_AssetRequestTime;
+
+	// Input recording and replay, when active.
+	TUniquePtr<FSkateboardRecorder> m_Recorder;
+	TUniquePtr<FSkateboardReplay> m_Replay;
+	uint32 m_RecordedTicks;
+
+	// Rollback snapshots, and the number of the tick about to start.
+	SkateSim::FBoardSnapshotRing m_Snapshots;
+	uint32 m_SimTick;
+
+	// Replicated body and simulation state; bReplicateMovement is off in favour of this.
+	UPROPERTY(Transient, ReplicatedUsing = OnRep_RepMovement)
+	FSkateboardRepMovement m_RepMovement;
+	uint32 m_AppliedRepMovement;
+
+	// The input last sent to the server, and when.
+	uint8 m_SentMoveInput[2];
+	float m_MoveInputSendTime;
 };
@@ -0,0 +1,88 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimCore.h"
+
+/**
+* Engine-independent runtime tuning profile.
+*
+* A profile is compiled once from a set of tuning values and response curves (see USkateboardTune), and then shared
+* read-only by every board using it.  It holds the tuning itself, the constants derived from it that used to be
+* worked out every tick, and the response curves sampled into small lookup tables, so a board never evaluates a
+* curve while it's simulating.
+*
+* Responses scale the tuned steering angle and force by speed, as a fraction of MaxSpeed.  A flat curve at 1 (the
+* default) leaves the tuning exactly as it is.
+*/
+namespace SkateSim
+{
+	// Samples per response curve, evenly spaced from standing still to MaxSpeed.
+	const int ResponseLUTSize = 32;
+
+	// Aligned to a cache line, so the hot part of a profile (the tune and derived constants) is one line.
+	struct alignas(64) FBoardProfile
+	{
+		FBoardTune Tune;
+
+		// Derived from Tune
+		float ProbeLength;			// Total length of each ground probe, in cm
+		float HalfTruckSpacing;		// Front/rear probe offset from the board's center, in cm
+		float HalfAxleLength;		// Left/right probe offset from the board's center, in cm
+		float SpeedToResponseIndex;	// Multiply a speed in cm/s by this to index the response tables
+
+		// Response curves, sampled
+		float SteerResponse[ResponseLUTSize];	// Scale on MinMaxTurnAngleDeg
+		float ForceResponse[ResponseLUTSize];	// Scale on ForceScale
+	};
+
+	// Compile a profile.  The curves are callables taking a speed fraction in [0, 1] and returning a scale.
+	template<typename TSteerCurve, typename TForceCurve>
+	inline void CompileBoardProfile(const FBoardTune& tune, const TSteerCurve& steerCurve, const TForceCurve& forceCurve, FBoardProfile& profileOut)
+	{
+		profileOut.Tune = tune;
+		profileOut.ProbeLength = tune.DeckHeight * 6.0f;
+		profileOut.HalfTruckSpacing = tune.TruckSpacing * 0.5f;
+		profileOut.HalfAxleLength = tune.AxleLength * 0.5f;
+		profileOut.SpeedToResponseIndex = (tune.MaxSpeed > 0.0f ? (float)(ResponseLUTSize - 1) / tune.MaxSpeed : 0.0f);
+
+		for (int i = 0; i < ResponseLUTSize; ++i)
+		{
+			const float speedFraction = (float)i / (float)(ResponseLUTSize - 1);
+			profileOut.SteerResponse[i] = steerCurve(speedFraction);
+			profileOut.ForceResponse[i] = forceCurve(speedFraction);
+		}
+	}
+
+	// A response curve that leaves the tuning alone.
+	struct FUnitResponse
+	{
+		float operator()(float /*speedFraction*/) const { return 1.0f; }
+	};
+
+	inline void CompileBoardProfile(const FBoardTune& tune, FBoardProfile& profileOut)
+	{
+		CompileBoardProfile(tune, FUnitResponse(), FUnitResponse(), profileOut);
+	}
+
+	// Linearly interpolate a response table at a (fractional) index, clamped to the table.
+	inline float SampleResponse(const float* table, float index)
+	{
+		if (index <= 0.0f)
+			return table[0];
+		if (index >= (float)(ResponseLUTSize - 1))
+			return table[ResponseLUTSize - 1];
+		const int i = (int)index;
+		return Lerp(table[i], table[i + 1], index - (float)i);
+	}
+
+	// The tuning to step a board with at the given speed, with the response curves applied.
+	inline FBoardTune EvaluateTune(const FBoardProfile& profile, float speed)
+	{
+		const float index = speed * profile.SpeedToResponseIndex;
+		FBoardTune tune = profile.Tune;
+		tune.MinMaxTurnAngleDeg *= SampleResponse(profile.SteerResponse, index);
+		tune.ForceScale *= SampleResponse(profile.ForceResponse, index);
+		return tune;
+	}
+}
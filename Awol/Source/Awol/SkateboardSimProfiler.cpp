@@ -0,0 +1,175 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "SkateboardSimProfiler.h"
+
+static TAutoConsoleVariable<int32> CVarSkateboardProfileCsv(
+	TEXT("skate.ProfileCsv"),
+	0,
+	TEXT("1: write per-frame skateboard sim phase timings and counters to Saved/Profiling/SkateboardSim/*.csv.\n")
+	TEXT("0: stop writing (default)."),
+	ECVF_Default);
+
+static const TCHAR* const PhaseNames[ESkateProfilePhase::Count] =
+{
+	TEXT("ProbeGround"),
+	TEXT("ProbeTrace"),
+	TEXT("UpdateOrientation"),
+	TEXT("UpdateSteering"),
+	TEXT("UpdateMovement"),
+	TEXT("ApplyForces"),
+	TEXT("UpdateCamera"),
+	TEXT("UpdateSkateboardModel"),
+	TEXT("UpdateRiderModel"),
+	TEXT("DebugDraw"),
+};
+
+static const TCHAR* const CounterNames[ESkateProfileCounter::Count] =
+{
+	TEXT("TracesIssued"),
+	TEXT("ImpulsesApplied"),
+	TEXT("ForcesApplied"),
+	TEXT("BoardsSimulated"),
+};
+
+
+FSkateboardSimProfiler& FSkateboardSimProfiler::Get()
+{
+	static FSkateboardSimProfiler profiler;
+	return profiler;
+}
+
+FSkateboardSimProfiler::FSkateboardSimProfiler()
+	: m_Capturing(false)
+	, m_Writer(nullptr)
+	, m_FrameIndex(0)
+{
+	FMemory::Memzero(m_LastFrame);
+}
+
+const TCHAR* FSkateboardSimProfiler::GetPhaseName(ESkateProfilePhase::Type phase)
+{
+	return PhaseNames[phase];
+}
+
+const TCHAR* FSkateboardSimProfiler::GetCounterName(ESkateProfileCounter::Type counter)
+{
+	return CounterNames[counter];
+}
+
+void FSkateboardSimProfiler::AddPhaseCycles(ESkateProfilePhase::Type phase, uint32 cycles)
+{
+	m_PhaseCycles[phase].Add(cycles);
+	m_PhaseCalls[phase].Increment();
+}
+
+void FSkateboardSimProfiler::AddCount(ESkateProfileCounter::Type counter, int32 amount)
+{
+	m_Counts[counter].Add(amount);
+}
+
+void FSkateboardSimProfiler::EndFrame(float deltaSeconds)
+{
+	check(IsInGameThread());
+
+	const bool wantCapture = (CVarSkateboardProfileCsv.GetValueOnGameThread() != 0);
+	if (m_Capturing)
+	{
+		SnapshotFrame();
+		WriteRow(deltaSeconds);
+	}
+
+	if (wantCapture && !m_Capturing)
+	{
+		StartCapture();
+	}
+	else if (!wantCapture && m_Capturing)
+	{
+		StopCapture();
+	}
+
+	for (int32 i = 0; i < ESkateProfilePhase::Count; ++i)
+	{
+		m_PhaseCycles[i].Reset();
+		m_PhaseCalls[i].Reset();
+	}
+	for (int32 i = 0; i < ESkateProfileCounter::Count; ++i)
+	{
+		m_Counts[i].Reset();
+	}
+}
+
+void FSkateboardSimProfiler::StartCapture()
+{
+	const FString path = FPaths::ProfilingDir() / TEXT("SkateboardSim") / FString::Printf(TEXT("SkateboardSim-%s.csv"), *FDateTime::Now().ToString());
+	m_Writer = IFileManager::Get().CreateFileWriter(*path);
+	if (m_Writer == nullptr)
+	{
+		UE_LOG(LogSkateboardSim, Error, TEXT("skate.ProfileCsv: couldn't open %s"), *path);
+		// Don't retry every frame.
+		CVarSkateboardProfileCsv->Set(TEXT("0"));
+		return;
+	}
+
+	FString header = TEXT("Frame,DeltaMs");
+	for (int32 i = 0; i < ESkateProfilePhase::Count; ++i)
+	{
+		header += FString::Printf(TEXT(",%sMs,%sCalls"), PhaseNames[i], PhaseNames[i]);
+	}
+	for (int32 i = 0; i < ESkateProfileCounter::Count; ++i)
+	{
+		header += FString::Printf(TEXT(",%s"), CounterNames[i]);
+	}
+	header += TEXT("\n");
+
+	FTCHARToUTF8 utf8(*header);
+	m_Writer->Serialize((void*)utf8.Get(), utf8.Length());
+
+	m_Capturing = true;
+	m_FrameIndex = 0;
+	UE_LOG(LogSkateboardSim, Display, TEXT("skate.ProfileCsv: writing %s"), *path);
+}
+
+void FSkateboardSimProfiler::StopCapture()
+{
+	m_Capturing = false;
+	if (m_Writer != nullptr)
+	{
+		m_Writer->Close();
+		delete m_Writer;
+		m_Writer = nullptr;
+	}
+}
+
+void FSkateboardSimProfiler::SnapshotFrame()
+{
+	for (int32 i = 0; i < ESkateProfilePhase::Count; ++i)
+	{
+		m_LastFrame.PhaseMs[i] = m_PhaseCycles[i].GetValue() * FPlatformTime::GetSecondsPerCycle() * 1000.0;
+		m_LastFrame.PhaseCalls[i] = m_PhaseCalls[i].GetValue();
+	}
+	for (int32 i = 0; i < ESkateProfileCounter::Count; ++i)
+	{
+		m_LastFrame.Counts[i] = m_Counts[i].GetValue();
+	}
+}
+
+void FSkateboardSimProfiler::WriteRow(float deltaSeconds)
+{
+	if (m_Writer == nullptr)
+		return;
+
+	FString row = FString::Printf(TEXT("%llu,%.3f"), m_FrameIndex++, deltaSeconds * 1000.0f);
+	for (int32 i = 0; i < ESkateProfilePhase::Count; ++i)
+	{
+		row += FString::Printf(TEXT(",%.4f,%d"), m_LastFrame.PhaseMs[i], m_LastFrame.PhaseCalls[i]);
+	}
+	for (int32 i = 0; i < ESkateProfileCounter::Count; ++i)
+	{
+		row += FString::Printf(TEXT(",%d"), m_LastFrame.Counts[i]);
+	}
+	row += TEXT("\n");
+
+	FTCHARToUTF8 utf8(*row);
+	m_Writer->Serialize((void*)utf8.Get(), utf8.Length());
+}
@@ -0,0 +1,137 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimStats.h"
+
+// Timed phases of a board's simulation tick.
+namespace ESkateProfilePhase
+{
+	enum Type
+	{
+		ProbeGround,			// UpdateGroundState: the whole four-probe ground query, including cache lookups
+		ProbeTrace,				// A single rideable trace (baked or PhysX)
+		UpdateOrientation,
+		UpdateSteering,
+		UpdateMovement,			// Force computation (unbatched boards; batched boards show up as Batch Step instead)
+		ApplyForces,			// Adding the computed forces and impulses to the body
+		UpdateCamera,
+		UpdateSkateboardModel,
+		UpdateRiderModel,
+		DebugDraw,
+		Count
+	};
+}
+
+// Per-frame event counts.
+namespace ESkateProfileCounter
+{
+	enum Type
+	{
+		TracesIssued,			// Scene queries sent to PhysX, sync or async
+		ImpulsesApplied,
+		ForcesApplied,
+		BoardsSimulated,
+		Count
+	};
+}
+
+/**
+* Mirrors the skateboard stat group into a per-frame CSV so numbers can be compared across builds.
+*
+* Set skate.ProfileCsv 1 to start a capture (written to Saved/Profiling/SkateboardSim/) and 0 to stop it.  Each
+* row is one frame: the time and call count of every phase, then every counter.  Phases and counters may be
+* recorded from worker threads.  While no capture is running, recording costs a single branch.
+*
+* Use the SKATE_SCOPE_PHASE and SKATE_INC_COUNTER macros rather than calling this directly, so the stat overlay
+* and the CSV always agree.
+*/
+class AWOL_API FSkateboardSimProfiler
+{
+public:
+	static FSkateboardSimProfiler& Get();
+
+	bool IsCapturing() const { return m_Capturing; }
+
+	void AddPhaseCycles(ESkateProfilePhase::Type phase, uint32 cycles);
+	void AddCount(ESkateProfileCounter::Type counter, int32 amount);
+
+	// Called once per frame from the game thread: picks up skate.ProfileCsv, writes the frame just finished and
+	// resets the accumulators.
+	void EndFrame(float deltaSeconds);
+
+	// Close the current capture, if any.
+	void StopCapture();
+
+	// Totals for the last frame passed to EndFrame() while capturing.
+	struct FFrameTotals
+	{
+		double PhaseMs[ESkateProfilePhase::Count];
+		int32 PhaseCalls[ESkateProfilePhase::Count];
+		int32 Counts[ESkateProfileCounter::Count];
+	};
+	const FFrameTotals& GetLastFrame() const { return m_LastFrame; }
+
+	static const TCHAR* GetPhaseName(ESkateProfilePhase::Type phase);
+	static const TCHAR* GetCounterName(ESkateProfileCounter::Type counter);
+
+	// Times the enclosing scope into one phase, and into a cycle stat.
+	class FScopedPhase
+	{
+	public:
+		FScopedPhase(ESkateProfilePhase::Type phase, TStatId stat)
+			:
+#if STATS
+			m_CycleCounter(stat),
+#endif
+			m_Phase(phase)
+			, m_StartCycles(FSkateboardSimProfiler::Get().IsCapturing() ? FPlatformTime::Cycles() : 0)
+		{
+		}
+
+		~FScopedPhase()
+		{
+			if (m_StartCycles != 0)
+				FSkateboardSimProfiler::Get().AddPhaseCycles(m_Phase, FPlatformTime::Cycles() - m_StartCycles);
+		}
+
+	private:
+#if STATS
+		FScopeCycleCounter m_CycleCounter;
+#endif
+		ESkateProfilePhase::Type m_Phase;
+		uint32 m_StartCycles;
+	};
+
+private:
+	FSkateboardSimProfiler();
+
+	void StartCapture();
+	void SnapshotFrame();
+	void WriteRow(float deltaSeconds);
+
+	// Read by every thread that records a phase or counter.
+	FThreadSafeBool m_Capturing;
+	FArchive* m_Writer;
+	uint64 m_FrameIndex;
+
+	FThreadSafeCounter64 m_PhaseCycles[ESkateProfilePhase::Count];
+	FThreadSafeCounter m_PhaseCalls[ESkateProfilePhase::Count];
+	FThreadSafeCounter m_Counts[ESkateProfileCounter::Count];
+
+	FFrameTotals m_LastFrame;
+};
+
+// Time the rest of this scope into both the given cycle stat and the CSV phase.  One declaration, so it can't be split
+// by an unbraced if.
+#define SKATE_SCOPE_PHASE(Phase, Stat) \
+	FSkateboardSimProfiler::FScopedPhase ANONYMOUS_VARIABLE(SkatePhase_)(ESkateProfilePhase::Phase, GET_STATID(Stat))
+
+// Add to both the given counter stat and the CSV counter.
+#define SKATE_INC_COUNTER(Counter, Stat, Amount) \
+	do \
+	{ \
+		INC_DWORD_STAT_BY(Stat, Amount); \
+		if (FSkateboardSimProfiler::Get().IsCapturing()) \
+			FSkateboardSimProfiler::Get().AddCount(ESkateProfileCounter::Counter, Amount); \
+	} while (0)
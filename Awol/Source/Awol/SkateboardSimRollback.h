@@ -0,0 +1,148 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "SkateboardSimProfile.h"
+#include "SkateboardSimKinematic.h"
+
+#include <stdint.h>
+
+/**
+* Engine-independent snapshot, restore and resimulation of a board, for rollback.
+*
+* Each tick starts by saving an FBoardSnapshot (everything the tick reads: simulation state, body, the last ground
+* contact, and the tick's input and time step) into a fixed-size ring.  To correct a past tick, overwrite its
+* snapshot and call Resimulate(), which re-runs every tick from there with the recorded inputs, rewriting their
+* snapshots as it goes, and returns where the board is now.  Nothing is allocated after construction.
+*
+* The world a board runs in is a template parameter, so the pawn can probe through its ground state component and
+* the headless bench through its analytic terrain.  A world needs:
+*
+*   FGroundContact Probe(const FBodyState& body, const FBoardState& state);
+*   void Integrate(FBodyState& body, const FBoardOutput& output, const FGroundContact& ground, float mass, float deltaTime);
+*
+* @see ASkateboardSimPawn::ResimulateFrom
+*/
+namespace SkateSim
+{
+	// The physics body, as far as the simulation is concerned.
+	struct FBodyState
+	{
+		FVec3 Position;
+		FVec3 Velocity;
+		FVec3 AngularVelocity;
+		float Rotation[4];		// Quaternion X, Y, Z, W
+	};
+
+	// A board as it was at the start of a tick, plus what that tick was run with.
+	struct FBoardSnapshot
+	{
+		uint32_t Tick;
+		FBoardState State;
+		FBodyState Body;
+		FGroundContact Ground;	// The previous tick's probe; each tick probes again before stepping
+		FBoardInput Input;
+		float DeltaTime;
+	};
+
+	// The last Capacity ticks' snapshots, each in the slot for its tick number.
+	class FBoardSnapshotRing
+	{
+	public:
+		enum { Capacity = 64 };	// A power of two; just over a second at 60Hz
+
+		FBoardSnapshotRing() { Reset(); }
+
+		void Reset()
+		{
+			for (int i = 0; i < Capacity; ++i)
+				m_Slots[i].Tick = InvalidTick;
+		}
+
+		// Store a snapshot, replacing whichever one held its slot.
+		void Save(const FBoardSnapshot& snapshot) { m_Slots[snapshot.Tick & (Capacity - 1)] = snapshot; }
+
+		// The snapshot for the given tick, or null if it's been overwritten or was never saved.
+		FBoardSnapshot* Find(uint32_t tick)
+		{
+			FBoardSnapshot& slot = m_Slots[tick & (Capacity - 1)];
+			return (slot.Tick == tick && tick != InvalidTick ? &slot : nullptr);
+		}
+
+		const FBoardSnapshot* Find(uint32_t tick) const { return const_cast<FBoardSnapshotRing*>(this)->Find(tick); }
+
+		// Do we have a snapshot for every tick in [fromTick, toTick)?
+		bool Holds(uint32_t fromTick, uint32_t toTick) const
+		{
+			if ((uint32_t)(toTick - fromTick) > (uint32_t)Capacity)
+				return false;
+			for (uint32_t tick = fromTick; tick != toTick; ++tick)
+			{
+				if (Find(tick) == nullptr)
+					return false;
+			}
+			return true;
+		}
+
+	private:
+		static const uint32_t InvalidTick = 0xffffffffu;
+
+		FBoardSnapshot m_Slots[Capacity];
+	};
+
+	// Stand-in for the rigid body when it can't be stepped on its own: apply the force/impulse and gravity, move, and
+	// keep the body at least rideHeight above the ground plane it was probed against.
+	inline void PredictBody(FBodyState& body, const FBoardOutput& output, const FGroundContact& ground, float mass, float gravityZ, float rideHeight, float deltaTime)
+	{
+		IntegrateVelocity(body.Velocity, output, mass, gravityZ, deltaTime);
+		body.Position += body.Velocity * deltaTime;
+		SupportOnGround(body.Position, body.Velocity, ground, rideHeight, 0.0f);
+	}
+
+	// One full tick: probe, step, integrate.  Returns the ground contact the tick was stepped with.
+	template<typename TWorld>
+	inline FGroundContact SimulateTick(FBoardState& state, FBodyState& body, const FBoardInput& input, const FBoardProfile& profile, float mass, float deltaTime, TWorld& world)
+	{
+		const FGroundContact ground = world.Probe(body, state);
+		const FBoardTune tune = EvaluateTune(profile, Size(body.Velocity));
+		const FBoardOutput output = Step(state, ground, tune, input, body.Velocity, mass, deltaTime);
+		const FVec3 stepVelocity = body.Velocity;
+		world.Integrate(body, output, ground, mass, deltaTime);
+		UpdatePrevVelocity(state, stepVelocity);
+		return ground;
+	}
+
+	// Re-run ticks [fromTick, toTick) from fromTick's snapshot, with their recorded inputs and time steps, rewriting
+	// the snapshots after fromTick with the new results.  resultOut receives the board as of the start of toTick
+	// (its Input and DeltaTime are left alone).  Returns false, without doing anything, unless the ring holds
+	// fromTick's snapshot and every one after it in the range.
+	template<typename TWorld>
+	inline bool Resimulate(FBoardSnapshotRing& ring, uint32_t fromTick, uint32_t toTick, const FBoardProfile& profile, float mass, TWorld& world, FBoardSnapshot& resultOut)
+	{
+		if (ring.Find(fromTick) == nullptr || !ring.Holds(fromTick, toTick))
+			return false;
+
+		const FBoardSnapshot* from = ring.Find(fromTick);
+		FBoardState state = from->State;
+		FBodyState body = from->Body;
+		FGroundContact ground = from->Ground;
+
+		for (uint32_t tick = fromTick; tick != toTick; ++tick)
+		{
+			FBoardSnapshot* snapshot = ring.Find(tick);
+			if (tick != fromTick)
+			{
+				snapshot->State = state;
+				snapshot->Body = body;
+				snapshot->Ground = ground;
+			}
+			ground = SimulateTick(state, body, snapshot->Input, profile, mass, snapshot->DeltaTime, world);
+		}
+
+		resultOut.Tick = toTick;
+		resultOut.State = state;
+		resultOut.Body = body;
+		resultOut.Ground = ground;
+		return true;
+	}
+}
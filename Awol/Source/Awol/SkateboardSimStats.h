@@ -0,0 +1,12 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+/**
+* Stat group shared by the skateboard simulation.  Individual stats are declared in the .cpp files that update them.
+* Use "stat SkateboardSim" in the console to view them.
+*/
+DECLARE_STATS_GROUP(TEXT("SkateboardSim"), STATGROUP_SkateboardSim, STATCAT_Advanced);
+
+// Number of tick functions run on behalf of skateboard pawns: per-actor pawn and component ticks, or the manager's single central tick.
+DECLARE_DWORD_COUNTER_STAT_EXTERN(TEXT("Tick Functions Dispatched"), STAT_SkateboardTickDispatches, STATGROUP_SkateboardSim, );
@@ -0,0 +1,212 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#include "Awol.h"
+#include "SkateboardSpringArmComponent.h"
+#include "SkateboardSimManager.h"
+#include "SkateboardSimStats.h"
+
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Camera: Player 1 (ms)"), STAT_SkateboardCameraPlayer1, STATGROUP_SkateboardSim);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Camera: Player 2 (ms)"), STAT_SkateboardCameraPlayer2, STATGROUP_SkateboardSim);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Camera: Player 3 (ms)"), STAT_SkateboardCameraPlayer3, STATGROUP_SkateboardSim);
+DECLARE_FLOAT_COUNTER_STAT(TEXT("Camera: Player 4 (ms)"), STAT_SkateboardCameraPlayer4, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Camera Sweeps Submitted"), STAT_SkateboardCameraSweepsSubmitted, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Camera Sweeps Reused"), STAT_SkateboardCameraSweepsReused, STATGROUP_SkateboardSim);
+DECLARE_DWORD_COUNTER_STAT(TEXT("Camera Sweep Results Missed"), STAT_SkateboardCameraSweepsMissed, STATGROUP_SkateboardSim);
+
+static TAutoConsoleVariable<int32> CVarSkateboardAsyncCameraSweeps(
+	TEXT("skate.AsyncCameraSweeps"),
+	1,
+	TEXT("1: camera spring arms sweep asynchronously, batched by ASkateboardSimManager (default).\n")
+	TEXT("0: each arm does the engine's blocking sweep every frame."),
+	ECVF_Default);
+
+static TAutoConsoleVariable<float> CVarSkateboardCameraSweepReuseDistance(
+	TEXT("skate.CameraSweepReuseDistance"),
+	1.0f,
+	TEXT("A camera sweep whose ends have both moved less than this (cm) since the last one reuses its result."),
+	ECVF_Default);
+
+namespace
+{
+	const FName CameraSweepTag(TEXT("SkateboardCameraSweep"));
+
+	// Times the enclosing scope into a local player's camera cost stat.
+	class FScopedCameraCost
+	{
+	public:
+		explicit FScopedCameraCost(int32 playerIndex)
+			: m_PlayerIndex(playerIndex)
+			, m_StartCycles(FPlatformTime::Cycles())
+		{
+		}
+
+		~FScopedCameraCost()
+		{
+			const float ms = FPlatformTime::ToMilliseconds(FPlatformTime::Cycles() - m_StartCycles);
+			switch (m_PlayerIndex)
+			{
+			case 0: INC_FLOAT_STAT_BY(STAT_SkateboardCameraPlayer1, ms); break;
+			case 1: INC_FLOAT_STAT_BY(STAT_SkateboardCameraPlayer2, ms); break;
+			case 2: INC_FLOAT_STAT_BY(STAT_SkateboardCameraPlayer3, ms); break;
+			case 3: INC_FLOAT_STAT_BY(STAT_SkateboardCameraPlayer4, ms); break;
+			default: break;
+			}
+		}
+
+	private:
+		int32 m_PlayerIndex;
+		uint32 m_StartCycles;
+	};
+}
+
+
+// Sets default values for this component's properties
+USkateboardSpringArmComponent::USkateboardSpringArmComponent()
+{
+	bWantsBeginPlay = true;
+
+	ArmRecoverySpeed = 4.0f;
+	m_SweepStart = m_SweepEnd = FVector::ZeroVector;
+	m_HasSweep = false;
+	m_PlayerIndex = INDEX_NONE;
+	m_SubmittedStart = m_SubmittedEnd = FVector::ZeroVector;
+	m_HasPendingSweep = false;
+	m_ResultFraction = 1.0f;
+	m_ResultStart = m_ResultEnd = FVector::ZeroVector;
+	m_HasResult = false;
+	m_ArmFraction = 1.0f;
+	m_SimManager = nullptr;
+}
+
+// Called when the game starts
+void USkateboardSpringArmComponent::BeginPlay()
+{
+	Super::BeginPlay();
+
+	m_SimManager = ASkateboardSimManager::Get(GetWorld());
+	if (m_SimManager != nullptr)
+	{
+		m_SimManager->RegisterCameraArm(this);
+	}
+}
+
+void USkateboardSpringArmComponent::EndPlay(const EEndPlayReason::Type EndPlayReason)
+{
+	if (m_SimManager != nullptr)
+	{
+		m_SimManager->UnregisterCameraArm(this);
+		m_SimManager = nullptr;
+	}
+	m_HasSweep = false;
+	m_HasPendingSweep = false;
+	m_HasResult = false;
+
+	Super::EndPlay(EndPlayReason);
+}
+
+int32 USkateboardSpringArmComponent::GetLocalPlayerIndex() const
+{
+	const APawn* pawn = Cast<APawn>(GetOwner());
+	const APlayerController* controller = (pawn != nullptr ? Cast<APlayerController>(pawn->GetController()) : nullptr);
+	const ULocalPlayer* player = (controller != nullptr ? controller->GetLocalPlayer() : nullptr);
+	return (player != nullptr ? player->GetControllerId() : INDEX_NONE);
+}
+
+void USkateboardSpringArmComponent::UpdateDesiredArmLocation(bool bDoTrace, bool bDoLocationLag, bool bDoRotationLag, float DeltaTime)
+{
+	m_HasSweep = false;
+	m_PlayerIndex = GetLocalPlayerIndex();
+	FScopedCameraCost cost(m_PlayerIndex);
+
+	if (!bDoTrace || m_SimManager == nullptr || CVarSkateboardAsyncCameraSweeps.GetValueOnGameThread() == 0)
+	{
+		m_HasPendingSweep = false;
+		m_HasResult = false;
+		m_ArmFraction = 1.0f;
+		Super::UpdateDesiredArmLocation(bDoTrace && m_PlayerIndex != INDEX_NONE, bDoLocationLag, bDoRotationLag, DeltaTime);
+		return;
+	}
+
+	if (m_PlayerIndex == INDEX_NONE)
+	{
+		// Nobody's looking through this camera.
+		m_ArmFraction = 1.0f;
+		Super::UpdateDesiredArmLocation(false, bDoLocationLag, bDoRotationLag, DeltaTime);
+		return;
+	}
+
+	// The sweep the engine would have done: from the arm's origin to the camera at full length.
+	const FRotator desiredRot = GetComponentRotation();
+	m_SweepStart = GetComponentLocation() + TargetOffset;
+	m_SweepEnd = m_SweepStart - desiredRot.Vector() * TargetArmLength + FRotationMatrix(desiredRot).TransformVector(SocketOffset);
+	m_HasSweep = true;
+
+	// Place the camera from the last result.
+	const float targetFraction = (m_HasResult ? m_ResultFraction : 1.0f);
+	m_ArmFraction = (targetFraction < m_ArmFraction ? targetFraction : FMath::FInterpTo(m_ArmFraction, targetFraction, DeltaTime, ArmRecoverySpeed));
+
+	// Shortening the arm and the socket offset together keeps the camera on the line we swept.
+	const float fullArmLength = TargetArmLength;
+	const FVector fullSocketOffset = SocketOffset;
+	TargetArmLength = fullArmLength * m_ArmFraction;
+	SocketOffset = fullSocketOffset * m_ArmFraction;
+	Super::UpdateDesiredArmLocation(false, bDoLocationLag, bDoRotationLag, DeltaTime);
+	TargetArmLength = fullArmLength;
+	SocketOffset = fullSocketOffset;
+}
+
+void USkateboardSpringArmComponent::ConsumeCameraSweep()
+{
+	if (!m_HasPendingSweep)
+		return;
+
+	FScopedCameraCost cost(m_PlayerIndex);
+	m_HasPendingSweep = false;
+
+	// Results are only kept for a frame.  If we missed ours, we keep the last result, which is for an older sweep;
+	// SubmitCameraSweep() knows that from its ends, and sweeps again unless we're back where that one was.
+	FTraceDatum datum;
+	if (!GetWorld()->QueryTraceData(m_PendingSweep, datum) || !datum.Start.Equals(m_SubmittedStart) || !datum.End.Equals(m_SubmittedEnd))
+	{
+		INC_DWORD_STAT(STAT_SkateboardCameraSweepsMissed);
+		return;
+	}
+
+	const bool hit = (datum.OutHits.Num() > 0 && datum.OutHits[0].bBlockingHit);
+	m_ResultFraction = (hit ? datum.OutHits[0].Time : 1.0f);
+	m_ResultStart = m_SubmittedStart;
+	m_ResultEnd = m_SubmittedEnd;
+	m_HasResult = true;
+}
+
+bool USkateboardSpringArmComponent::SubmitCameraSweep()
+{
+	if (!m_HasSweep)
+		return false;
+
+	FScopedCameraCost cost(m_PlayerIndex);
+	m_HasSweep = false;
+
+	// A sweep in flight stands for where it was submitted; otherwise the last result stands for where it was swept.
+	const float reuseDistance = CVarSkateboardCameraSweepReuseDistance.GetValueOnGameThread();
+	const float reuseDistanceSq = reuseDistance * reuseDistance;
+	const FVector& lastStart = (m_HasPendingSweep ? m_SubmittedStart : m_ResultStart);
+	const FVector& lastEnd = (m_HasPendingSweep ? m_SubmittedEnd : m_ResultEnd);
+	if ((m_HasResult || m_HasPendingSweep)
+		&& FVector::DistSquared(m_SweepStart, lastStart) <= reuseDistanceSq
+		&& FVector::DistSquared(m_SweepEnd, lastEnd) <= reuseDistanceSq)
+	{
+		INC_DWORD_STAT(STAT_SkateboardCameraSweepsReused);
+		return false;
+	}
+
+	// Same query as the engine's own sweep.
+	FCollisionQueryParams queryParams(CameraSweepTag, false, GetOwner());
+	m_PendingSweep = GetWorld()->AsyncSweepByChannel(EAsyncTraceType::Single, m_SweepStart, m_SweepEnd, ProbeChannel, FCollisionShape::MakeSphere(ProbeSize), queryParams);
+	m_HasPendingSweep = true;
+	m_SubmittedStart = m_SweepStart;
+	m_SubmittedEnd = m_SweepEnd;
+
+	INC_DWORD_STAT(STAT_SkateboardCameraSweepsSubmitted);
+	return true;
+}
@@ -0,0 +1,83 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+#pragma once
+
+#include "GameFramework/SpringArmComponent.h"
+#include "SkateboardSpringArmComponent.generated.h"
+
+class ASkateboardSimManager;
+
+/**
+* A camera spring arm whose collision sweep is asynchronous, and issued along with every other player's.
+*
+* Instead of a blocking sweep every frame, the arm works out the sweep it wants (from its origin to the camera at full
+* length) and ASkateboardSimManager submits every arm's sweep together as one async batch, collecting the results the
+* next frame.  The arm length follows the last result: it pulls in as soon as something comes between the camera and
+* the board, and grows back out at ArmRecoverySpeed.  While neither end of the sweep has moved more than
+* skate.CameraSweepReuseDistance since the one the last result (or the sweep in flight) is for, that result stands and
+* nothing is submitted.
+*
+* The arm runs about two frames behind its sweeps.  The manager ticks before physics and the arm after it, so the
+* sweep the arm asks for in one frame is submitted at the start of the next, and its result collected at the start of
+* the one after, for the arm to use later that frame.  At speed, that's where the camera pulls in late against a wall
+* it's passing; the sphere's ProbeSize is the margin for it.
+*
+* Only arms belonging to a local player's pawn sweep at all; other cameras sit at full length.  skate.AsyncCameraSweeps 0
+* goes back to the engine's blocking sweep.  'stat SkateboardSim' shows each local player's camera cost.
+*/
+UCLASS(ClassGroup = Camera, meta = (BlueprintSpawnableComponent))
+class AWOL_API USkateboardSpringArmComponent : public USpringArmComponent
+{
+	GENERATED_BODY()
+
+public:
+	// Sets default values for this component's properties
+	USkateboardSpringArmComponent();
+
+	// Called when the game starts
+	virtual void BeginPlay() override;
+
+	// Called when the component is being removed from the level
+	virtual void EndPlay(const EEndPlayReason::Type EndPlayReason) override;
+
+	// Called by ASkateboardSimManager once a frame, for every arm: first to pick up the last batch's result, then to
+	// submit this frame's sweep (unless the last one still stands).  SubmitCameraSweep() returns true if it did.
+	void ConsumeCameraSweep();
+	bool SubmitCameraSweep();
+
+	// The controller id of the local player looking through this arm's camera, or INDEX_NONE if nobody is.
+	int32 GetLocalPlayerIndex() const;
+
+	// How quickly the arm grows back to full length once an obstruction clears (see FMath::FInterpTo).  Pulling in
+	// is immediate.
+	UPROPERTY(EditAnywhere, BlueprintReadWrite, Category = CameraCollision, meta = (ClampMin = "0.0"))
+	float ArmRecoverySpeed;
+
+protected:
+	virtual void UpdateDesiredArmLocation(bool bDoTrace, bool bDoLocationLag, bool bDoRotationLag, float DeltaTime) override;
+
+private:
+	// The sweep this frame's camera placement wants, if any, and whose camera it is.
+	FVector m_SweepStart;
+	FVector m_SweepEnd;
+	bool m_HasSweep;
+	int32 m_PlayerIndex;
+
+	// The last sweep submitted, and its handle until the result is collected.
+	FVector m_SubmittedStart;
+	FVector m_SubmittedEnd;
+	FTraceHandle m_PendingSweep;
+	bool m_HasPendingSweep;
+
+	// The fraction of the full arm length that was clear at the last result, and the sweep it was for.
+	float m_ResultFraction;
+	FVector m_ResultStart;
+	FVector m_ResultEnd;
+	bool m_HasResult;
+
+	// The fraction of the full arm length the arm is at now.
+	float m_ArmFraction;
+
+	UPROPERTY(Transient)
+	ASkateboardSimManager* m_SimManager;
+};
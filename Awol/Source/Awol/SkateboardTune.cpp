@@ -3,30 +3,76 @@
 #include "Awol.h"
 #include "SkateboardTune.h"
 
+namespace
+{
+	// Evaluates a response curve for SkateSim::CompileBoardProfile(); a curve with no keys is a flat 1.
+	struct FResponseCurve
+	{
+		explicit FResponseCurve(const FRuntimeFloatCurve& curve) : Curve(curve.GetRichCurveConst()) {}
+
+		float operator()(float speedFraction) const
+		{
+			return (Curve != nullptr && Curve->GetNumKeys() > 0 ? Curve->Eval(speedFraction) : 1.0f);
+		}
+
+		const FRichCurve* Curve;
+	};
+}
+
 
-// Sets default values for this component's properties
+// Sets default values for this asset's properties
 USkateboardTune::USkateboardTune()
 {
-	// Set this component to be initialized when the game starts, and to be ticked every frame.  You can turn these features
-	// off to improve performance if you don't need them.
-	bWantsBeginPlay = true;
-	PrimaryComponentTick.bCanEverTick = false;
-
 	// Set reasonable default values
 	MaxSpeed = 600.0f;
 	MinMaxTurnAngleDeg = 10.0f;
 	DeckHeight = 10.0f;
 	TruckSpacing = 55.0f;
 	AxleLength = 20.0f;
+	ForceScale = 800.0f;
+
+	m_Profile = static_cast<SkateSim::FBoardProfile*>(FMemory::Malloc(sizeof(SkateSim::FBoardProfile), ALIGNOF(SkateSim::FBoardProfile)));
+	SkateSim::CompileBoardProfile(SkateSim::DefaultBoardTune(), *m_Profile);
 }
 
+USkateboardTune::~USkateboardTune()
+{
+	FMemory::Free(m_Profile);
+	m_Profile = nullptr;
+}
 
-// Called when the game starts
-void USkateboardTune::BeginPlay()
+void USkateboardTune::PostInitProperties()
 {
-	Super::BeginPlay();
+	Super::PostInitProperties();
 
-	// ...
-	
+	CompileProfile();
 }
 
+void USkateboardTune::PostLoad()
+{
+	Super::PostLoad();
+
+	CompileProfile();
+}
+
+#if WITH_EDITOR
+void USkateboardTune::PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent)
+{
+	Super::PostEditChangeProperty(PropertyChangedEvent);
+
+	// Boards pick this up on their next tick, since they only hold a pointer to the profile.
+	CompileProfile();
+}
+#endif
+
+void USkateboardTune::CompileProfile()
+{
+	SkateSim::FBoardTune tune = SkateSim::DefaultBoardTune();
+	tune.MaxSpeed = MaxSpeed;
+	tune.MinMaxTurnAngleDeg = MinMaxTurnAngleDeg;
+	tune.DeckHeight = DeckHeight;
+	tune.TruckSpacing = TruckSpacing;
+	tune.AxleLength = AxleLength;
+	tune.ForceScale = ForceScale;
+	SkateSim::CompileBoardProfile(tune, FResponseCurve(SteerResponse), FResponseCurve(ForceResponse), *m_Profile);
+}
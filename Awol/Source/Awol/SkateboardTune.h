@@ -2,26 +2,42 @@
 
 #pragma once
 
-#include "Components/ActorComponent.h"
+#include "Engine/DataAsset.h"
+#include "Curves/CurveFloat.h"
+#include "SkateboardSimProfile.h"
 #include "SkateboardTune.generated.h"
 
 
 /**
-* This component holds all tuning information having to do with the the skateboard.
+* This asset holds all tuning information having to do with the the skateboard.
+*
+* It's shared, read-only, by every board that uses it.  When it's loaded (or edited), it's compiled into a
+* SkateSim::FBoardProfile holding the derived constants and sampled response curves the simulation needs, and
+* boards keep a pointer to that.  Boards without an asset share the class defaults' profile.
 *
 * @see ASkateboardSimPawn
 */
-UCLASS( ClassGroup=(Custom), HideCategories=(ComponentTick, Tags, Activation, Variable, Collision))
-class AWOL_API USkateboardTune : public UActorComponent
+UCLASS(BlueprintType)
+class AWOL_API USkateboardTune : public UDataAsset
 {
 	GENERATED_BODY()
 
 public:	
-	// Sets default values for this component's properties
+	// Sets default values for this asset's properties
 	USkateboardTune();
+	virtual ~USkateboardTune();
+
+	virtual void PostInitProperties() override;
+	virtual void PostLoad() override;
+#if WITH_EDITOR
+	virtual void PostEditChangeProperty(FPropertyChangedEvent& PropertyChangedEvent) override;
+#endif
+
+	// The compiled profile.  Stays at the same address for the asset's lifetime, even when it's recompiled.
+	const SkateSim::FBoardProfile& GetProfile() const { return *m_Profile; }
 
-	// Called when the game starts
-	virtual void BeginPlay() override;
+	// The profile of the class defaults, for boards without an asset.
+	static const SkateSim::FBoardProfile& GetDefaultProfile() { return GetDefault<USkateboardTune>()->GetProfile(); }
 
 	// The maximum speed, in cm/second
 	UPROPERTY(EditAnywhere)
@@ -42,4 +58,23 @@ public:
 	// The length of the axle, in cm.  Or, the distance between the two wheels on the same truck.
 	UPROPERTY(EditAnywhere)
 	float AxleLength;
+
+	// Force applied per unit of mass at full input, in cm/s^2.
+	UPROPERTY(EditAnywhere)
+	float ForceScale;
+
+	// Scale on MinMaxTurnAngleDeg (Y) by speed as a fraction of MaxSpeed (X).  Empty means 1 at every speed.
+	UPROPERTY(EditAnywhere)
+	FRuntimeFloatCurve SteerResponse;
+
+	// Scale on ForceScale (Y) by speed as a fraction of MaxSpeed (X).  Empty means 1 at every speed.
+	UPROPERTY(EditAnywhere)
+	FRuntimeFloatCurve ForceResponse;
+
+private:
+	// Rebuild m_Profile from our properties.
+	void CompileProfile();
+
+	// Allocated once, aligned to a cache line.
+	SkateSim::FBoardProfile* m_Profile;
 };
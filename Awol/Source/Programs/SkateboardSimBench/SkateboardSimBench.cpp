@@ -0,0 +1,1533 @@
+// Fill out your copyright notice in the Description page of Project Settings.
+
+/**
+* Headless benchmark for the skateboard simulation core (SkateboardSimCore.h).
+*
+* Steps a set of boards over an analytic terrain with a toy integrator standing in for PhysX, driven by a seeded
+* input pattern, and reports board-steps per second plus a checksum of the final state.  The checksum only depends
+* on the seed and arguments, so it doubles as a quick regression check when changing the sim math.
+*
+* This is not part of the UBT build; it has no engine dependencies and is built directly, e.g. on Linux:
+*
+*   g++ -O2 -std=c++11 -I../../Awol SkateboardSimBench.cpp -o SkateboardSimBench
+*   ./SkateboardSimBench -boards=64 -steps=100000 -seed=1 -terrain=ramps -mode=batch
+*
+* Modes:
+*   scalar  - one board at a time through SkateSim::Step() (what each ASkateboardSimPawn does)
+*   batch   - all boards at once through SkateSim::FBoardBatch (SIMD where available)
+*   verify  - batch mode, but every step is also run through the scalar reference and the largest difference is reported
+*   net     - scalar mode, with every board's state sent to a simulated client through the replication codec
+*             (SkateboardNetCodec.h) at -netrate=<Hz>, over a link with -netlatency=<round trip steps> and
+*             -netloss=<percent> packet loss.  Reports bytes/s per board compressed and at full precision, and the
+*             largest error the client sees.
+*   rollback  - scalar mode, saving a snapshot (SkateboardSimRollback.h) of every board each step, then rolling every
+*             board back -rollback=<ticks> and resimulating up to the present, as a client correcting a misprediction
+*             every frame would.  Reports the cost of a save, a restore and a resimulated tick, how many rollback
+*             ticks per board fit in -rollbackbudget=<ms> of each frame, and checks every resimulated tick
+*             reproduces the one the scalar step recorded the first time round, exactly.
+*   step    - microbenchmark of SkateSim::Step() alone, on inputs recorded from the scalar mode, against the
+*             pre-frame-cache implementation kept below as a reference.  Reports ns per step and sin/cos calls per
+*             step for each, and checks they agree bit-for-bit.
+*   rider   - microbenchmark of the rider pose (SkateboardRiderPose.h) on frames recorded from the scalar mode, against
+*             the turn-radius lean ASkateboardSimPawn used to compute on the game thread.  Reports ns per board and
+*             transcendental calls per board for each, and how far apart their unfiltered lean directions are.
+*   rails   - microbenchmark of the grind rail index (GrindRailIndex.h): a field of -rails=<N> box ledges, round bar
+*             meshes and bent bars is extracted and indexed, then queried within -railradius=<cm> of board positions
+*             recorded from the scalar mode.  Reports ns per query against a linear scan of every segment, and checks
+*             they agree and that each round bar was extracted as one rail along its crown.
+*   flight  - scalar mode, with airborne boards predicting their arc (SkateboardSimFlight.h) against the terrain and
+*             skipping ground probes until -flightlead=<s> before they land, as UGroundStateComponent does.  Reports
+*             the probes skipped, how many predictions each flight took, how far off the predicted landing times were,
+*             and checks no skipped probe would have found the ground.
+*/
+
+#include "SkateboardSimCore.h"
+#include "SkateboardSimBatch.h"
+#include "SkateboardNetCodec.h"
+#include "SkateboardSimRollback.h"
+#include "SkateboardRiderPose.h"
+#include "GrindRailIndex.h"
+#include "SkateboardSimFlight.h"
+
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <algorithm>
+#include <vector>
+
+namespace
+{
+	enum EBenchMode
+	{
+		Mode_Scalar,
+		Mode_Batch,
+		Mode_Verify,
+		Mode_Net,
+		Mode_Rollback,
+		Mode_Step,
+		Mode_Rider,
+		Mode_Rails,
+		Mode_Flight
+	};
+
+	const char* ModeNames[] = { "scalar", "batch", "verify", "net", "rollback", "step", "rider", "rails", "flight" };
+
+	struct FBenchArgs
+	{
+		int Boards;
+		int Steps;
+		unsigned int Seed;
+		bool Ramps;
+		float DeltaTime;
+		EBenchMode Mode;
+		float NetRate;
+		int NetLatency;
+		int NetLoss;
+		int RollbackTicks;
+		float RollbackBudgetMs;
+		int Rails;
+		float RailRadius;
+		float FlightLead;
+	};
+
+	// Simple deterministic PRNG, so results are identical on every platform.
+	struct FXorShift
+	{
+		unsigned int State;
+
+		unsigned int Next()
+		{
+			State ^= State << 13;
+			State ^= State >> 17;
+			State ^= State << 5;
+			return State;
+		}
+
+		// Uniform in [-1, 1]
+		float NextSigned()
+		{
+			return (float)(Next() & 0xffffff) / (float)0x7fffff - 1.0f;
+		}
+	};
+
+	// Stand-in for the physics body and the world it lives in.
+	struct FBenchBoard
+	{
+		SkateSim::FBoardState State;
+		SkateSim::FBoardInput Input;
+		SkateSim::FVec3 Position;
+		SkateSim::FVec3 Velocity;
+		float Mass;
+		int InputStepsLeft;
+		FXorShift Rng;
+	};
+
+	const float Gravity = -980.0f;
+
+	// Terrain height and normal at (x, y): either flat, or rolling quarter-pipe-sized bumps.
+	void SampleTerrain(bool ramps, float x, float y, float& heightOut, SkateSim::FVec3& normalOut)
+	{
+		if (!ramps)
+		{
+			heightOut = 0.0f;
+			normalOut = SkateSim::UpVec3();
+			return;
+		}
+
+		const float amplitude = 80.0f;
+		const float wavelength = 1.0f / 600.0f;
+		heightOut = amplitude * std::sin(x * wavelength) * std::cos(y * wavelength);
+		float dhdx = amplitude * wavelength * std::cos(x * wavelength) * std::cos(y * wavelength);
+		float dhdy = -amplitude * wavelength * std::sin(x * wavelength) * std::sin(y * wavelength);
+		normalOut = SkateSim::MakeVec3(-dhdx, -dhdy, 1.0f);
+		SkateSim::Normalize(normalOut);
+	}
+
+	bool ParseArgs(int argc, char** argv, FBenchArgs& args)
+	{
+		args.Boards = 64;
+		args.Steps = 100000;
+		args.Seed = 1;
+		args.Ramps = true;
+		args.DeltaTime = 1.0f / 60.0f;
+		args.Mode = Mode_Scalar;
+		args.NetRate = 30.0f;
+		args.NetLatency = 6;
+		args.NetLoss = 0;
+		args.RollbackTicks = 8;
+		args.RollbackBudgetMs = 2.0f;
+		args.Rails = 256;
+		args.RailRadius = 100.0f;
+		args.FlightLead = 0.1f;
+
+		for (int i = 1; i < argc; ++i)
+		{
+			const char* arg = argv[i];
+			if (std::strncmp(arg, "-boards=", 8) == 0)
+				args.Boards = std::atoi(arg + 8);
+			else if (std::strncmp(arg, "-steps=", 7) == 0)
+				args.Steps = std::atoi(arg + 7);
+			else if (std::strncmp(arg, "-seed=", 6) == 0)
+				args.Seed = (unsigned int)std::strtoul(arg + 6, nullptr, 10);
+			else if (std::strcmp(arg, "-terrain=flat") == 0)
+				args.Ramps = false;
+			else if (std::strcmp(arg, "-terrain=ramps") == 0)
+				args.Ramps = true;
+			else if (std::strcmp(arg, "-mode=scalar") == 0)
+				args.Mode = Mode_Scalar;
+			else if (std::strcmp(arg, "-mode=batch") == 0)
+				args.Mode = Mode_Batch;
+			else if (std::strcmp(arg, "-mode=verify") == 0)
+				args.Mode = Mode_Verify;
+			else if (std::strcmp(arg, "-mode=net") == 0)
+				args.Mode = Mode_Net;
+			else if (std::strncmp(arg, "-netrate=", 9) == 0)
+				args.NetRate = (float)std::atof(arg + 9);
+			else if (std::strncmp(arg, "-netlatency=", 12) == 0)
+				args.NetLatency = std::atoi(arg + 12);
+			else if (std::strncmp(arg, "-netloss=", 9) == 0)
+				args.NetLoss = std::atoi(arg + 9);
+			else if (std::strcmp(arg, "-mode=rollback") == 0)
+				args.Mode = Mode_Rollback;
+			else if (std::strcmp(arg, "-mode=step") == 0)
+				args.Mode = Mode_Step;
+			else if (std::strcmp(arg, "-mode=rider") == 0)
+				args.Mode = Mode_Rider;
+			else if (std::strcmp(arg, "-mode=rails") == 0)
+				args.Mode = Mode_Rails;
+			else if (std::strncmp(arg, "-rails=", 7) == 0)
+				args.Rails = std::atoi(arg + 7);
+			else if (std::strncmp(arg, "-railradius=", 12) == 0)
+				args.RailRadius = (float)std::atof(arg + 12);
+			else if (std::strcmp(arg, "-mode=flight") == 0)
+				args.Mode = Mode_Flight;
+			else if (std::strncmp(arg, "-flightlead=", 12) == 0)
+				args.FlightLead = (float)std::atof(arg + 12);
+			else if (std::strncmp(arg, "-rollback=", 10) == 0)
+				args.RollbackTicks = std::atoi(arg + 10);
+			else if (std::strncmp(arg, "-rollbackbudget=", 16) == 0)
+				args.RollbackBudgetMs = (float)std::atof(arg + 16);
+			else
+			{
+				std::fprintf(stderr, "Unknown argument '%s'\n", arg);
+				std::fprintf(stderr, "Usage: %s [-boards=N] [-steps=N] [-seed=N] [-terrain=flat|ramps] [-mode=scalar|batch|verify|net|rollback|step|rider|rails|flight] [-netrate=Hz] [-netlatency=steps] [-netloss=percent] [-rollback=ticks] [-rollbackbudget=ms] [-rails=N] [-railradius=cm] [-flightlead=s]\n", argv[0]);
+				return false;
+			}
+		}
+
+		return (args.Boards > 0 && args.Steps > 0 && args.Seed != 0 && args.NetRate > 0.0f && args.NetLatency >= 0
+			&& args.RollbackTicks > 0 && args.RollbackTicks < SkateSim::FBoardSnapshotRing::Capacity && args.Rails > 0 && args.RailRadius > 0.0f && args.FlightLead >= 0.0f);
+	}
+
+	void InitBoards(const FBenchArgs& args, std::vector<FBenchBoard>& boards)
+	{
+		boards.resize(args.Boards);
+		for (int i = 0; i < args.Boards; ++i)
+		{
+			FBenchBoard& board = boards[i];
+			board.Rng.State = args.Seed * 2654435761u + (unsigned int)i + 1u;
+			board.Position = SkateSim::MakeVec3((float)(i % 16) * 200.0f, (float)(i / 16) * 200.0f, 0.0f);
+			board.Velocity = SkateSim::ZeroVec3();
+			board.Mass = 60.0f;
+			board.Input.Forward = 0.0f;
+			board.Input.Right = 0.0f;
+			board.InputStepsLeft = 0;
+			SkateSim::InitBoardState(board.State, SkateSim::MakeVec3(1.0f, 0.0f, 0.0f), SkateSim::MakeVec3(0.0f, 1.0f, 0.0f));
+		}
+	}
+
+	// Scripted input: hold a random stick position for a random number of steps, mostly pushing forward.
+	void UpdateInput(FBenchBoard& board)
+	{
+		if (--board.InputStepsLeft > 0)
+			return;
+
+		board.InputStepsLeft = 15 + (int)(board.Rng.Next() % 90);
+		board.Input.Forward = SkateSim::Clamp(board.Rng.NextSigned() + 0.6f, -1.0f, 1.0f);
+		board.Input.Right = board.Rng.NextSigned();
+	}
+
+	// Ground probe stand-in: the board is on the ground if it's within probe reach of the terrain.
+	SkateSim::FGroundContact ProbeGround(const FBenchArgs& args, const SkateSim::FVec3& position, const SkateSim::FBoardTune& tune)
+	{
+		SkateSim::FGroundContact ground;
+		float height;
+		SampleTerrain(args.Ramps, position.X, position.Y, height, ground.Normal);
+		ground.Position = SkateSim::MakeVec3(position.X, position.Y, height);
+		ground.IsOnGround = (position.Z - height < tune.DeckHeight * 3.0f);
+		return ground;
+	}
+
+	SkateSim::FGroundContact ProbeGround(const FBenchArgs& args, const FBenchBoard& board, const SkateSim::FBoardTune& tune)
+	{
+		return ProbeGround(args, board.Position, tune);
+	}
+
+	// Toy integrator standing in for the rigid body: apply force/impulse and gravity, and keep the board on the terrain.
+	void Integrate(const FBenchArgs& args, SkateSim::FVec3& position, SkateSim::FVec3& velocity, float mass, const SkateSim::FBoardOutput& output, float dt)
+	{
+		const float invMass = 1.0f / mass;
+
+		if (output.HasImpulse)
+			velocity += output.Impulse * invMass;
+		if (output.HasForce)
+			velocity += output.Force * (invMass * dt);
+		velocity.Z += Gravity * dt;
+
+		position += velocity * dt;
+
+		float height;
+		SkateSim::FVec3 normal;
+		SampleTerrain(args.Ramps, position.X, position.Y, height, normal);
+		if (position.Z < height)
+		{
+			position.Z = height;
+			float intoGround = SkateSim::Dot(velocity, normal);
+			if (intoGround < 0.0f)
+				velocity -= normal * intoGround;
+		}
+	}
+
+	void Integrate(const FBenchArgs& args, FBenchBoard& board, const SkateSim::FBoardOutput& output)
+	{
+		Integrate(args, board.Position, board.Velocity, board.Mass, output, args.DeltaTime);
+	}
+
+	double Checksum(const std::vector<FBenchBoard>& boards)
+	{
+		double sum = 0.0;
+		for (size_t i = 0; i < boards.size(); ++i)
+		{
+			const FBenchBoard& board = boards[i];
+			sum += board.Position.X + board.Position.Y + board.Position.Z;
+			sum += board.State.LongitudinalVector.X + board.State.LongitudinalVector.Y + board.State.LongitudinalVector.Z;
+		}
+		return sum;
+	}
+
+	void RunScalar(const FBenchArgs& args, const SkateSim::FBoardTune& tune, std::vector<FBenchBoard>& boards)
+	{
+		for (int step = 0; step < args.Steps; ++step)
+		{
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				FBenchBoard& board = boards[i];
+				UpdateInput(board);
+
+				SkateSim::FGroundContact ground = ProbeGround(args, board, tune);
+				SkateSim::FBoardOutput output = SkateSim::Step(board.State, ground, tune, board.Input, board.Velocity, board.Mass, args.DeltaTime);
+				SkateSim::FVec3 stepVelocity = board.Velocity;
+				Integrate(args, board, output);
+				SkateSim::UpdatePrevVelocity(board.State, stepVelocity);
+			}
+		}
+	}
+
+	// Largest component-wise difference between two vectors.
+	float MaxDiff(const SkateSim::FVec3& a, const SkateSim::FVec3& b)
+	{
+		float dx = std::fabs(a.X - b.X);
+		float dy = std::fabs(a.Y - b.Y);
+		float dz = std::fabs(a.Z - b.Z);
+		return (dx > dy ? (dx > dz ? dx : dz) : (dy > dz ? dy : dz));
+	}
+
+	// Returns the largest difference seen between the batch kernel and the scalar reference (0 if not verifying).
+	float RunBatch(const FBenchArgs& args, const SkateSim::FBoardTune& tune, std::vector<FBenchBoard>& boards)
+	{
+		SkateSim::FBoardBatch batch;
+		for (size_t i = 0; i < boards.size(); ++i)
+			batch.Add(boards[i].State, tune);
+
+		float maxError = 0.0f;
+
+		for (int step = 0; step < args.Steps; ++step)
+		{
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				FBenchBoard& board = boards[i];
+				UpdateInput(board);
+				batch.SetFrameInput((int)i, ProbeGround(args, board, tune), board.Input, board.Velocity, board.Mass);
+			}
+
+			if (args.Mode == Mode_Verify)
+			{
+				SkateSim::FBoardBatch reference = batch;
+				reference.StepScalar(args.DeltaTime);
+				batch.Step(args.DeltaTime);
+
+				for (int i = 0; i < batch.Num(); ++i)
+				{
+					// Forces scale with mass, so compare them relative to the force scale.
+					const float forceNorm = 1.0f / (tune.ForceScale * boards[i].Mass);
+					SkateSim::FBoardOutput expected = reference.GetOutput(i);
+					SkateSim::FBoardOutput actual = batch.GetOutput(i);
+					float err = MaxDiff(expected.Force * forceNorm, actual.Force * forceNorm);
+					err = std::max(err, MaxDiff(expected.Impulse, actual.Impulse) / tune.MaxSpeed);
+
+					SkateSim::FBoardState expectedState, actualState;
+					reference.GetState(i, expectedState);
+					batch.GetState(i, actualState);
+					err = std::max(err, MaxDiff(expectedState.LongitudinalVector, actualState.LongitudinalVector));
+					err = std::max(err, MaxDiff(expectedState.LateralVector, actualState.LateralVector));
+					if (expected.HasForce != actual.HasForce || expected.HasImpulse != actual.HasImpulse || expectedState.Reverse != actualState.Reverse)
+						err = 1.0f;
+
+					maxError = std::max(maxError, err);
+				}
+			}
+			else
+			{
+				batch.Step(args.DeltaTime);
+			}
+
+			for (size_t i = 0; i < boards.size(); ++i)
+				Integrate(args, boards[i], batch.GetOutput((int)i));
+			batch.UpdatePrevVelocities();
+		}
+
+		for (size_t i = 0; i < boards.size(); ++i)
+			batch.GetState((int)i, boards[i].State);
+
+		return maxError;
+	}
+
+	// A replication update on its way to the client.
+	struct FNetSend
+	{
+		int ArriveStep;		// When the client gets it (half the round trip)
+		int AckStep;		// When the sender finds out whether it arrived (the full round trip)
+		bool Lost;
+		SkateSim::FNetBitPacker Packet;
+		SkateSim::FNetBoardSample SentSample;
+		SkateSim::FNetSenderState PrevSender;	// To go back to if it's lost, as the engine does for custom delta properties
+	};
+
+	// One board's replication to one client.  Every step is one packet, numbered by the step it's sent in.
+	struct FNetLink
+	{
+		SkateSim::FNetBoardQuantized Current;
+		uint16_t Sequence;
+		SkateSim::FNetSenderState Sender;
+		bool RolledBack;		// A send was lost since the last one; see FSkateboardRepMovement::NetDeltaSerialize()
+		std::vector<FNetSend> InFlight;
+		SkateSim::FNetReceivedStates Received;
+		FXorShift Rng;
+	};
+
+	struct FNetResults
+	{
+		double CompressedBits;
+		double RawBits;
+		int Sends;
+		int Discarded;		// Arrived, but encoded against a base the client never got
+		float MaxPositionError;
+		float MaxVelocityError;
+		float MaxAngleErrorDeg;	// Between the sent and received board axes
+	};
+
+	SkateSim::FNetBoardSample MakeNetSample(const FBenchBoard& board, bool isOnGround)
+	{
+		SkateSim::FNetBoardSample sample;
+		sample.Position = board.Position;
+		sample.Velocity = board.Velocity;
+		sample.LongitudinalVector = board.State.LongitudinalVector;
+		sample.LateralVector = board.State.LateralVector;
+		sample.Reverse = board.State.Reverse;
+		sample.IsOnGround = isOnGround;
+		sample.Steering = board.State.Steering;
+		sample.InputForward = board.Input.Forward;
+		return sample;
+	}
+
+	float AngleBetweenDeg(SkateSim::FVec3 a, SkateSim::FVec3 b)
+	{
+		SkateSim::Normalize(a);
+		SkateSim::Normalize(b);
+		return std::acos(SkateSim::Clamp(SkateSim::Dot(a, b), -1.0f, 1.0f)) * (180.0f / 3.1415926535897932f);
+	}
+
+	void ReceiveNetSend(FNetLink& link, const FNetSend& send, FNetResults& results)
+	{
+		SkateSim::FNetBitUnpacker reader(send.Packet.GetData(), send.Packet.GetNumBits());
+		SkateSim::FNetBoardSample received;
+		SkateSim::FNetUpdateHeader header;
+		if (!SkateSim::NetReadUpdate(reader, link.Received, received, header))
+		{
+			++results.Discarded;
+			return;
+		}
+
+		// The sim only keeps the lateral axis perpendicular to the ground normal while it's on the ground, so compare
+		// the up axis the receiver rebuilds rather than the raw lateral vector.
+		const SkateSim::FNetBoardSample& sent = send.SentSample;
+		results.MaxPositionError = std::max(results.MaxPositionError, SkateSim::Size(received.Position - sent.Position));
+		results.MaxVelocityError = std::max(results.MaxVelocityError, SkateSim::Size(received.Velocity - sent.Velocity));
+		results.MaxAngleErrorDeg = std::max(results.MaxAngleErrorDeg, AngleBetweenDeg(received.LongitudinalVector, sent.LongitudinalVector));
+		results.MaxAngleErrorDeg = std::max(results.MaxAngleErrorDeg,
+			AngleBetweenDeg(SkateSim::Cross(received.LongitudinalVector, received.LateralVector), SkateSim::Cross(sent.LongitudinalVector, sent.LateralVector)));
+	}
+
+	FNetResults RunNet(const FBenchArgs& args, const SkateSim::FBoardTune& tune, std::vector<FBenchBoard>& boards)
+	{
+		FNetResults results;
+		std::memset(&results, 0, sizeof(results));
+
+		std::vector<FNetLink> links(boards.size());
+		for (size_t i = 0; i < links.size(); ++i)
+		{
+			links[i].Current = SkateSim::ZeroNetBoard();
+			links[i].Sequence = 0;
+			SkateSim::NetInitSenderState(links[i].Sender);
+			links[i].RolledBack = false;
+			links[i].Rng.State = args.Seed * 2246822519u + (unsigned int)i + 1u;
+		}
+
+		const int sendInterval = std::max(1, (int)(1.0f / (args.NetRate * args.DeltaTime) + 0.5f));
+		const int halfTrip = args.NetLatency / 2;
+
+		for (int step = 0; step < args.Steps; ++step)
+		{
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				FBenchBoard& board = boards[i];
+				FNetLink& link = links[i];
+				UpdateInput(board);
+
+				SkateSim::FGroundContact ground = ProbeGround(args, board, tune);
+				SkateSim::FBoardOutput output = SkateSim::Step(board.State, ground, tune, board.Input, board.Velocity, board.Mass, args.DeltaTime);
+				SkateSim::FVec3 stepVelocity = board.Velocity;
+				Integrate(args, board, output);
+				SkateSim::UpdatePrevVelocity(board.State, stepVelocity);
+
+				// Every distinct quantized state gets a new sequence number.
+				const SkateSim::FNetBoardSample sample = MakeNetSample(board, ground.IsOnGround);
+				SkateSim::FNetBoardQuantized quantized;
+				SkateSim::NetQuantize(sample, quantized);
+				if (quantized != link.Current || step == 0)
+				{
+					link.Current = quantized;
+					++link.Sequence;
+				}
+
+				// Deliver whatever is due, then hear back about it.
+				for (size_t s = 0; s < link.InFlight.size(); ++s)
+				{
+					if (link.InFlight[s].ArriveStep == step && !link.InFlight[s].Lost)
+						ReceiveNetSend(link, link.InFlight[s], results);
+				}
+				while (!link.InFlight.empty() && link.InFlight.front().AckStep <= step)
+				{
+					if (link.InFlight.front().Lost)
+					{
+						link.Sender = link.InFlight.front().PrevSender;
+						link.RolledBack = true;
+					}
+					link.InFlight.erase(link.InFlight.begin());
+				}
+
+				// Send, staggered across boards.
+				if ((step + (int)i) % sendInterval != 0)
+					continue;
+
+				FNetSend send;
+				send.ArriveStep = step + halfTrip;
+				send.AckStep = step + args.NetLatency;
+				send.Lost = ((int)(link.Rng.Next() % 100) < args.NetLoss);
+				send.SentSample = sample;
+				if (link.RolledBack)
+					SkateSim::NetForgetPending(link.Sender);
+				link.RolledBack = false;
+				send.PrevSender = link.Sender;
+				if (!SkateSim::NetWriteUpdate(send.Packet, link.Sender, step - args.NetLatency, step, link.Sequence, link.Current, nullptr))
+					continue;
+
+				results.CompressedBits += send.Packet.GetNumBits();
+				results.RawBits += 1 + 16 + SkateSim::NetRawSampleBits;
+				++results.Sends;
+
+				if (halfTrip == 0 && !send.Lost)
+					ReceiveNetSend(link, send, results);
+				link.InFlight.push_back(send);
+			}
+		}
+
+		return results;
+	}
+
+	// The bench's terrain and integrator, as seen by SkateSim::Resimulate().
+	struct FBenchWorld
+	{
+		const FBenchArgs& Args;
+		const SkateSim::FBoardTune& Tune;
+
+		FBenchWorld(const FBenchArgs& args, const SkateSim::FBoardTune& tune) : Args(args), Tune(tune) {}
+
+		SkateSim::FGroundContact Probe(const SkateSim::FBodyState& body, const SkateSim::FBoardState& /*state*/)
+		{
+			return ProbeGround(Args, body.Position, Tune);
+		}
+
+		void Integrate(SkateSim::FBodyState& body, const SkateSim::FBoardOutput& output, const SkateSim::FGroundContact& /*ground*/, float mass, float deltaTime)
+		{
+			::Integrate(Args, body.Position, body.Velocity, mass, output, deltaTime);
+		}
+	};
+
+	struct FRollbackResults
+	{
+		double SaveSeconds;
+		double RestoreSeconds;
+		double ResimSeconds;
+		double ForwardSeconds;
+		long long Saves;
+		long long Restores;
+		long long ResimTicks;
+		float MaxError;		// Between each resimulated tick and the same tick as it was first stepped
+	};
+
+	// Largest difference between two snapshots' bodies and simulation state.
+	float SnapshotError(const SkateSim::FBoardSnapshot& a, const SkateSim::FBoardSnapshot& b)
+	{
+		float err = std::max(MaxDiff(a.Body.Position, b.Body.Position), MaxDiff(a.Body.Velocity, b.Body.Velocity));
+		err = std::max(err, MaxDiff(a.State.LongitudinalVector, b.State.LongitudinalVector));
+		err = std::max(err, MaxDiff(a.State.LateralVector, b.State.LateralVector));
+		err = std::max(err, MaxDiff(a.State.PrevVelocity, b.State.PrevVelocity));
+		if (a.State.Reverse != b.State.Reverse || a.State.Steering != b.State.Steering)
+			err = std::max(err, 1.0f);
+		return err;
+	}
+
+	FRollbackResults RunRollback(const FBenchArgs& args, const SkateSim::FBoardTune& tune, std::vector<FBenchBoard>& boards)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		FRollbackResults results;
+		std::memset(&results, 0, sizeof(results));
+
+		// Resimulation rewrites rings as it goes; recorded keeps each tick as the scalar step first produced it.
+		std::vector<SkateSim::FBoardSnapshotRing> rings(boards.size());
+		std::vector<SkateSim::FBoardSnapshotRing> recorded(boards.size());
+		std::vector<SkateSim::FGroundContact> lastGround(boards.size());
+		std::vector<SkateSim::FBoardSnapshot> restored(boards.size());
+		for (size_t i = 0; i < boards.size(); ++i)
+			lastGround[i] = ProbeGround(args, boards[i], tune);
+
+		FBenchWorld world(args, tune);
+		SkateSim::FBoardProfile profile;
+		SkateSim::CompileBoardProfile(tune, profile);
+		const uint32_t rollbackTicks = (uint32_t)args.RollbackTicks;
+
+		for (int step = 0; step < args.Steps; ++step)
+		{
+			for (size_t i = 0; i < boards.size(); ++i)
+				UpdateInput(boards[i]);
+
+			// Save: the start of this step, and the input it runs with.
+			Clock::time_point start = Clock::now();
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				const FBenchBoard& board = boards[i];
+				SkateSim::FBoardSnapshot snapshot;
+				snapshot.Tick = (uint32_t)step;
+				snapshot.State = board.State;
+				snapshot.Body.Position = board.Position;
+				snapshot.Body.Velocity = board.Velocity;
+				snapshot.Body.AngularVelocity = SkateSim::ZeroVec3();
+				snapshot.Body.Rotation[0] = snapshot.Body.Rotation[1] = snapshot.Body.Rotation[2] = 0.0f;
+				snapshot.Body.Rotation[3] = 1.0f;
+				snapshot.Ground = lastGround[i];
+				snapshot.Input = board.Input;
+				snapshot.DeltaTime = args.DeltaTime;
+				rings[i].Save(snapshot);
+				recorded[i].Save(snapshot);
+			}
+			results.SaveSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+			results.Saves += (long long)boards.size();
+
+			// Step forward exactly as the scalar mode does (so the checksum matches it), not through SkateSim::SimulateTick(),
+			// so resimulation is checked against the real thing rather than against itself.
+			start = Clock::now();
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				FBenchBoard& board = boards[i];
+				lastGround[i] = ProbeGround(args, board, tune);
+				const SkateSim::FBoardOutput output = SkateSim::Step(board.State, lastGround[i], tune, board.Input, board.Velocity, board.Mass, args.DeltaTime);
+				const SkateSim::FVec3 stepVelocity = board.Velocity;
+				Integrate(args, board, output);
+				SkateSim::UpdatePrevVelocity(board.State, stepVelocity);
+			}
+			results.ForwardSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+
+			const uint32_t now = (uint32_t)step + 1;
+			if (now < rollbackTicks)
+				continue;
+			const uint32_t fromTick = now - rollbackTicks;
+
+			// Restore: read the oldest snapshot back out, as a pawn does before being corrected.
+			start = Clock::now();
+			for (size_t i = 0; i < boards.size(); ++i)
+				restored[i] = *rings[i].Find(fromTick);
+			results.RestoreSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+			results.Restores += (long long)boards.size();
+
+			// Resimulate back up to the present.  No correction is applied, so every tick it rewrites must match the
+			// recorded one, and it must land exactly where we are.
+			start = Clock::now();
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				SkateSim::FBoardSnapshot result;
+				SkateSim::Resimulate(rings[i], fromTick, now, profile, boards[i].Mass, world, result);
+				restored[i] = result;
+			}
+			results.ResimSeconds += std::chrono::duration<double>(Clock::now() - start).count();
+			results.ResimTicks += (long long)boards.size() * rollbackTicks;
+
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				const FBenchBoard& board = boards[i];
+				SkateSim::FBoardSnapshot present = restored[i];
+				present.State = board.State;
+				present.Body.Position = board.Position;
+				present.Body.Velocity = board.Velocity;
+				results.MaxError = std::max(results.MaxError, SnapshotError(restored[i], present));
+				for (uint32_t tick = fromTick + 1; tick != now; ++tick)
+				{
+					results.MaxError = std::max(results.MaxError, SnapshotError(*rings[i].Find(tick), *recorded[i].Find(tick)));
+				}
+			}
+		}
+
+		return results;
+	}
+
+	// SkateSim::Step() as it was before FBoardFrame: every phase re-derives the speed, basis and steering rotation it
+	// needs, and the forward and right forces each build their own rotation.  Counts its sin/cos calls.
+	namespace Legacy
+	{
+		long long TrigCalls = 0;
+
+		SkateSim::FVec3 CountedRotateAngleAxis(const SkateSim::FVec3& v, float angleDeg, const SkateSim::FVec3& axis)
+		{
+			TrigCalls += 2;
+			return SkateSim::RotateAngleAxis(v, angleDeg, axis);
+		}
+
+		void UpdateOrientation(SkateSim::FBoardState& state, const SkateSim::FGroundContact& ground, const SkateSim::FVec3& velocity)
+		{
+			if (!ground.IsOnGround)
+				return;
+
+			float normalSpeed = SkateSim::Dot(velocity, ground.Normal);
+			SkateSim::FVec3 currVel = velocity - ground.Normal * normalSpeed;
+
+			float speed = SkateSim::Size(currVel);
+			const float speedThresh = 5.0f;
+			if (speed > speedThresh)
+			{
+				state.Reverse = (SkateSim::Dot(currVel, state.LongitudinalVector) < 0.0f);
+
+				state.LongitudinalVector = currVel;
+				SkateSim::Normalize(state.LongitudinalVector);
+				if (state.Reverse)
+					state.LongitudinalVector = -state.LongitudinalVector;
+
+				state.LateralVector = SkateSim::Cross(ground.Normal, state.LongitudinalVector);
+			}
+			else
+			{
+				state.LongitudinalVector = SkateSim::Cross(state.LateralVector, ground.Normal);
+			}
+		}
+
+		SkateSim::FVec3 ComputeForwardForce(const SkateSim::FBoardState& state, const SkateSim::FGroundContact& ground, const SkateSim::FBoardTune& tune, const SkateSim::FBoardInput& input)
+		{
+			if (ground.IsOnGround && input.Forward > 0.0f)
+			{
+				SkateSim::FVec3 newForward = CountedRotateAngleAxis(SkateSim::GetForwardVector(state), SkateSim::ComputeSteerAngleDeg(tune, input), SkateSim::GetUpVector(state));
+				return newForward * SkateSim::Clamp(input.Forward, 0.0f, 1.0f);
+			}
+			return SkateSim::ZeroVec3();
+		}
+
+		SkateSim::FVec3 ComputeRightForce(const SkateSim::FBoardState& state, const SkateSim::FGroundContact& ground, const SkateSim::FBoardTune& tune, const SkateSim::FBoardInput& input, const SkateSim::FVec3& velocity, float deltaTime)
+		{
+			if (ground.IsOnGround)
+			{
+				float speed = SkateSim::Size(velocity);
+				if (speed > 1.0f)
+				{
+					SkateSim::FVec3 tgtVel = CountedRotateAngleAxis(velocity, SkateSim::ComputeSteerAngleDeg(tune, input), SkateSim::GetUpVector(state));
+					return (tgtVel - velocity) * deltaTime;
+				}
+			}
+			return SkateSim::ZeroVec3();
+		}
+
+		SkateSim::FBoardOutput Step(SkateSim::FBoardState& state, const SkateSim::FGroundContact& ground, const SkateSim::FBoardTune& tune, const SkateSim::FBoardInput& input, const SkateSim::FVec3& velocity, float mass, float deltaTime)
+		{
+			UpdateOrientation(state, ground, velocity);
+			state.Steering = SkateSim::Clamp(input.Right, -1.0f, 1.0f);
+
+			SkateSim::FBoardOutput output;
+			output.Force = SkateSim::ZeroVec3();
+			output.Impulse = SkateSim::ZeroVec3();
+			output.HasForce = false;
+			output.HasImpulse = false;
+
+			float speed = SkateSim::Size(velocity);
+			float forceScale = tune.ForceScale * mass;
+
+			if (speed > tune.MaxSpeed)
+			{
+				SkateSim::FVec3 dir = velocity;
+				SkateSim::Normalize(dir);
+				output.Impulse = dir * (tune.MaxSpeed - speed);
+				output.HasImpulse = true;
+				output.Force = ComputeRightForce(state, ground, tune, input, velocity, deltaTime) * forceScale;
+				output.HasForce = true;
+			}
+			else if (input.Forward != 0.0f || input.Right != 0.0f)
+			{
+				output.Force = (ComputeForwardForce(state, ground, tune, input) + ComputeRightForce(state, ground, tune, input, velocity, deltaTime)) * forceScale;
+				output.HasForce = true;
+			}
+
+			return output;
+		}
+	}
+
+	// One Step() call's inputs, recorded from a scalar run.
+	struct FStepSample
+	{
+		SkateSim::FBoardState State;
+		SkateSim::FGroundContact Ground;
+		SkateSim::FBoardInput Input;
+		SkateSim::FVec3 Velocity;
+		float Mass;
+	};
+
+	struct FStepResults
+	{
+		double LegacyNs;
+		double CachedNs;
+		double LegacyTrigPerStep;
+		double CachedTrigPerStep;
+		int Mismatches;
+	};
+
+	bool SameBits(const SkateSim::FVec3& a, const SkateSim::FVec3& b) { return std::memcmp(&a, &b, sizeof(a)) == 0; }
+
+	FStepResults RunStepMicro(const FBenchArgs& args, const SkateSim::FBoardTune& tune, std::vector<FBenchBoard>& boards)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		// Record a window of steps, then time each implementation over it until we've done -steps worth.
+		const int recordSteps = std::min(args.Steps, 2048);
+		std::vector<FStepSample> samples;
+		samples.reserve((size_t)recordSteps * boards.size());
+		for (int step = 0; step < recordSteps; ++step)
+		{
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				FBenchBoard& board = boards[i];
+				UpdateInput(board);
+
+				FStepSample sample;
+				sample.State = board.State;
+				sample.Ground = ProbeGround(args, board, tune);
+				sample.Input = board.Input;
+				sample.Velocity = board.Velocity;
+				sample.Mass = board.Mass;
+				samples.push_back(sample);
+
+				SkateSim::FBoardOutput output = SkateSim::Step(board.State, sample.Ground, tune, board.Input, board.Velocity, board.Mass, args.DeltaTime);
+				SkateSim::FVec3 stepVelocity = board.Velocity;
+				Integrate(args, board, output);
+				SkateSim::UpdatePrevVelocity(board.State, stepVelocity);
+			}
+		}
+
+		FStepResults results;
+		std::memset(&results, 0, sizeof(results));
+		results.Mismatches = 0;
+		const int repeats = std::max(1, args.Steps / recordSteps);
+		const double numSteps = (double)samples.size() * repeats;
+
+		// Consume the results, so the optimizer can't drop the work.
+		float sink = 0.0f;
+
+		Legacy::TrigCalls = 0;
+		Clock::time_point start = Clock::now();
+		for (int r = 0; r < repeats; ++r)
+		{
+			for (size_t i = 0; i < samples.size(); ++i)
+			{
+				const FStepSample& sample = samples[i];
+				SkateSim::FBoardState state = sample.State;
+				SkateSim::FBoardOutput output = Legacy::Step(state, sample.Ground, tune, sample.Input, sample.Velocity, sample.Mass, args.DeltaTime);
+				sink += output.Force.X + state.LongitudinalVector.Y;
+			}
+		}
+		results.LegacyNs = std::chrono::duration<double>(Clock::now() - start).count() * 1.e9 / numSteps;
+		results.LegacyTrigPerStep = (double)Legacy::TrigCalls / numSteps;
+
+		start = Clock::now();
+		for (int r = 0; r < repeats; ++r)
+		{
+			for (size_t i = 0; i < samples.size(); ++i)
+			{
+				const FStepSample& sample = samples[i];
+				SkateSim::FBoardState state = sample.State;
+				SkateSim::FBoardOutput output = SkateSim::Step(state, sample.Ground, tune, sample.Input, sample.Velocity, sample.Mass, args.DeltaTime);
+				sink += output.Force.X + state.LongitudinalVector.Y;
+			}
+		}
+		results.CachedNs = std::chrono::duration<double>(Clock::now() - start).count() * 1.e9 / numSteps;
+
+		// Check, and count the cached version's sin/cos: one pair per step that needs the steering rotation.
+		long long cachedTrig = 0;
+		for (size_t i = 0; i < samples.size(); ++i)
+		{
+			const FStepSample& sample = samples[i];
+			SkateSim::FBoardState legacyState = sample.State;
+			SkateSim::FBoardState cachedState = sample.State;
+			SkateSim::FBoardOutput legacy = Legacy::Step(legacyState, sample.Ground, tune, sample.Input, sample.Velocity, sample.Mass, args.DeltaTime);
+			SkateSim::FBoardOutput cached = SkateSim::Step(cachedState, sample.Ground, tune, sample.Input, sample.Velocity, sample.Mass, args.DeltaTime);
+			if (!SameBits(legacy.Force, cached.Force) || !SameBits(legacy.Impulse, cached.Impulse)
+				|| legacy.HasForce != cached.HasForce || legacy.HasImpulse != cached.HasImpulse
+				|| !SameBits(legacyState.LongitudinalVector, cachedState.LongitudinalVector)
+				|| !SameBits(legacyState.LateralVector, cachedState.LateralVector)
+				|| legacyState.Reverse != cachedState.Reverse || legacyState.Steering != cachedState.Steering)
+			{
+				++results.Mismatches;
+			}
+			SkateSim::FBoardFrame frame;
+			SkateSim::BeginFrame(frame, sample.Ground, sample.Velocity);
+			cachedTrig += (SkateSim::NeedsSteerRotation(sample.Ground, tune, sample.Input, frame) ? 2 : 0);
+		}
+		results.CachedTrigPerStep = (double)cachedTrig / (double)samples.size();
+
+		if (sink == 12345.0f)
+			std::printf(" ");
+		return results;
+	}
+
+	// The rider's up vector the way ASkateboardSimPawn used to work it out: center of mass along gravity plus the
+	// centripetal acceleration of the turn through the last two velocities (an acos and a sin).  ComputeTurnPivot()
+	// treats the speed as the chord length, so that acceleration comes out per step rather than per second; it's
+	// scaled by 1/dt here to compare like with like.
+	SkateSim::FVec3 LegacyRiderUp(const SkateSim::FBoardState& state, const SkateSim::FRiderSimSnapshot& sim)
+	{
+		SkateSim::FVec3 up = SkateSim::UpVec3() * -Gravity + SkateSim::ComputeCentripetalAccel(state, sim.Velocity) * (1.0f / sim.StepDeltaTime);
+		SkateSim::Normalize(up);
+		const SkateSim::FVec3 centerOfMass = sim.Position + up * 100.0f;
+		SkateSim::FVec3 riderUp = centerOfMass - (sim.Ground.Position + sim.Ground.Normal * sim.DeckHeight);
+		if (!SkateSim::Normalize(riderUp))
+			riderUp = SkateSim::UpVec3();
+		return riderUp;
+	}
+
+	struct FRiderResults
+	{
+		double LegacyNs;
+		double EstimatorNs;
+		double LegacyTrigPerBoard;
+		double MeanAngleDeg;
+		double P99AngleDeg;
+	};
+
+	FRiderResults RunRiderMicro(const FBenchArgs& args, const SkateSim::FBoardTune& tune, std::vector<FBenchBoard>& boards)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		// Record a window of frames, as each board's pawn would hand them to its rider.
+		const int recordSteps = std::min(args.Steps, 2048);
+		std::vector<SkateSim::FRiderSimSnapshot> frames;
+		std::vector<SkateSim::FBoardState> states;
+		frames.reserve((size_t)recordSteps * boards.size());
+		states.reserve((size_t)recordSteps * boards.size());
+		for (int step = 0; step < recordSteps; ++step)
+		{
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				FBenchBoard& board = boards[i];
+				UpdateInput(board);
+
+				const SkateSim::FGroundContact ground = ProbeGround(args, board, tune);
+				SkateSim::FBoardOutput output = SkateSim::Step(board.State, ground, tune, board.Input, board.Velocity, board.Mass, args.DeltaTime);
+
+				SkateSim::FRiderSimSnapshot frame;
+				frame.Velocity = board.Velocity;
+				frame.PrevVelocity = board.State.PrevVelocity;
+				frame.StepDeltaTime = args.DeltaTime;
+				frame.Position = board.Position;
+				frame.Forward = SkateSim::GetForwardVector(board.State);
+				frame.Right = SkateSim::GetRightVector(board.State);
+				frame.Ground = ground;
+				frame.DeckHeight = tune.DeckHeight;
+				frames.push_back(frame);
+				states.push_back(board.State);
+
+				SkateSim::FVec3 stepVelocity = board.Velocity;
+				Integrate(args, board, output);
+				SkateSim::UpdatePrevVelocity(board.State, stepVelocity);
+			}
+		}
+
+		FRiderResults results;
+		std::memset(&results, 0, sizeof(results));
+		const int repeats = std::max(1, args.Steps / recordSteps);
+		const double numFrames = (double)frames.size() * repeats;
+		float sink = 0.0f;
+
+		Clock::time_point start = Clock::now();
+		for (int r = 0; r < repeats; ++r)
+		{
+			for (size_t i = 0; i < frames.size(); ++i)
+			{
+				const SkateSim::FVec3 up = LegacyRiderUp(states[i], frames[i]);
+				sink += up.X;
+			}
+		}
+		results.LegacyNs = std::chrono::duration<double>(Clock::now() - start).count() * 1.e9 / numFrames;
+
+		const SkateSim::FRiderPoseTune poseTune = SkateSim::DefaultRiderPoseTune();
+		std::vector<SkateSim::FRiderPoseState> poseStates(boards.size());
+		for (size_t b = 0; b < poseStates.size(); ++b)
+			SkateSim::ResetRiderPose(poseStates[b]);
+		start = Clock::now();
+		for (int r = 0; r < repeats; ++r)
+		{
+			for (size_t i = 0; i < frames.size(); ++i)
+			{
+				SkateSim::FRiderPose pose;
+				SkateSim::UpdateRiderPose(poseStates[i % boards.size()], frames[i], poseTune, args.DeltaTime, pose);
+				sink += pose.Up.X;
+			}
+		}
+		results.EstimatorNs = std::chrono::duration<double>(Clock::now() - start).count() * 1.e9 / numFrames;
+
+		// Compare the two unfiltered and unclamped, so only the acceleration estimates differ.  The legacy path takes
+		// an acos and a sin whenever both velocities are above its threshold.
+		SkateSim::FRiderPoseTune rawTune = poseTune;
+		rawTune.LeanTimeConstant = 0.0f;
+		rawTune.MaxLeanTan = 1.e6f;
+		rawTune.CrouchPerG = 0.0f;
+		long long legacyTrig = 0;
+		double sumAngle = 0.0;
+		std::vector<double> angles;
+		angles.reserve(frames.size());
+		for (size_t i = 0; i < frames.size(); ++i)
+		{
+			const SkateSim::FRiderSimSnapshot& frame = frames[i];
+			if (SkateSim::Size(frame.Velocity) >= 0.01f && SkateSim::Size(frame.PrevVelocity) >= 0.01f)
+				legacyTrig += 2;
+
+			SkateSim::FRiderPoseState rawState;
+			SkateSim::ResetRiderPose(rawState);
+			SkateSim::FRiderPose pose;
+			SkateSim::UpdateRiderPose(rawState, frame, rawTune, args.DeltaTime, pose);
+			const SkateSim::FVec3 legacyUp = LegacyRiderUp(states[i], frame);
+			const double angle = std::acos(SkateSim::Clamp(SkateSim::Dot(legacyUp, pose.Up), -1.0f, 1.0f)) * (180.0 / 3.14159265358979);
+			angles.push_back(angle);
+			sumAngle += angle;
+		}
+		results.LegacyTrigPerBoard = (double)legacyTrig / (double)frames.size();
+		results.MeanAngleDeg = sumAngle / (double)frames.size();
+		std::nth_element(angles.begin(), angles.begin() + angles.size() * 99 / 100, angles.end());
+		results.P99AngleDeg = angles[angles.size() * 99 / 100];
+
+		if (sink == 12345.0f)
+			std::printf(" ");
+		return results;
+	}
+
+	struct FRailsResults
+	{
+		int Rails;
+		int Segments;
+		int BlobBytes;
+		double BuildMs;
+		double IndexNs;
+		double ScanNs;
+		double HitFraction;
+		int Mismatches;
+		int BarsOffCrown;
+	};
+
+	// A box ledge, as a level's mesh would give it to the rail extraction: 12 triangles, outward facing.
+	void AddBenchLedge(SkateSim::FGrindRailBuilder& builder, const SkateSim::FVec3& center, float yaw, float length, float width, float height)
+	{
+		const SkateSim::FVec3 along = SkateSim::MakeVec3(std::cos(yaw), std::sin(yaw), 0.0f);
+		const SkateSim::FVec3 across = SkateSim::MakeVec3(-along.Y, along.X, 0.0f);
+		SkateSim::FVec3 vertices[8];
+		for (int i = 0; i < 8; ++i)
+		{
+			vertices[i] = center + along * ((i & 1) ? length * 0.5f : -length * 0.5f) + across * ((i & 2) ? width * 0.5f : -width * 0.5f)
+				+ SkateSim::UpVec3() * ((i & 4) ? height : 0.0f);
+		}
+		const uint32_t indices[] = { 4, 7, 5, 4, 6, 7, 0, 3, 2, 0, 1, 3, 0, 5, 1, 0, 4, 5, 2, 7, 6, 2, 3, 7, 0, 6, 4, 0, 2, 6, 1, 7, 3, 1, 5, 7 };
+		builder.AddMesh(vertices, 8, indices, 36, SkateSim::EGrindRailKind::Ledge);
+	}
+
+	// A round bar, as a level's mesh would give it: sides facets around its axis, which runs along yaw at height.
+	void AddBenchBar(SkateSim::FGrindRailBuilder& builder, const SkateSim::FVec3& center, float yaw, float length, float radius, float height, int sides)
+	{
+		const SkateSim::FVec3 along = SkateSim::MakeVec3(std::cos(yaw), std::sin(yaw), 0.0f);
+		const SkateSim::FVec3 across = SkateSim::MakeVec3(-along.Y, along.X, 0.0f);
+		std::vector<SkateSim::FVec3> vertices;
+		for (int end = 0; end < 2; ++end)
+		{
+			for (int side = 0; side < sides; ++side)
+			{
+				const float angle = 2.0f * 3.14159265f * side / sides;
+				vertices.push_back(center + along * (end ? length * 0.5f : -length * 0.5f) + across * (radius * std::sin(angle))
+					+ SkateSim::UpVec3() * (height + radius * std::cos(angle)));
+			}
+		}
+		std::vector<uint32_t> indices;
+		for (int side = 0; side < sides; ++side)
+		{
+			const uint32_t a = side, b = (side + 1) % sides, c = sides + side, d = sides + (side + 1) % sides;
+			const uint32_t quad[6] = { a, b, d, a, d, c };
+			indices.insert(indices.end(), quad, quad + 6);
+		}
+		for (int side = 1; side + 1 < sides; ++side)
+		{
+			const uint32_t caps[6] = { 0, (uint32_t)side + 1, (uint32_t)side, (uint32_t)sides, (uint32_t)(sides + side), (uint32_t)(sides + side + 1) };
+			indices.insert(indices.end(), caps, caps + 6);
+		}
+		builder.AddMesh(&vertices[0], (uint32_t)vertices.size(), &indices[0], (uint32_t)indices.size(), SkateSim::EGrindRailKind::Rail);
+	}
+
+	// The nearest point on any segment, the slow way.
+	bool ScanRails(const SkateSim::FGrindRailView& view, const SkateSim::FVec3& point, float radius, float& distanceOut)
+	{
+		float best = radius * radius;
+		bool found = false;
+		for (uint32_t i = 0; i < view.NumSegments(); ++i)
+		{
+			const SkateSim::FGrindSegment& segment = view.GetSegment(i);
+			const SkateSim::FVec3 start = SkateSim::MakeVec3(segment.Start[0], segment.Start[1], segment.Start[2]);
+			const SkateSim::FVec3 direction = SkateSim::MakeVec3(segment.Direction[0], segment.Direction[1], segment.Direction[2]);
+			const float along = SkateSim::Clamp(SkateSim::Dot(point - start, direction), 0.0f, segment.Length);
+			const float distanceSquared = SkateSim::SizeSquared(point - (start + direction * along));
+			if (distanceSquared <= best)
+			{
+				best = distanceSquared;
+				found = true;
+			}
+		}
+		distanceOut = std::sqrt(best);
+		return found;
+	}
+
+	struct FFlightResults
+	{
+		long long Probes;
+		long long Skipped;
+		long long AirborneSteps;
+		long long Flights;
+		long long Predictions;
+		long long Drifted;
+		long long ChordQueries;
+		long long Landings;
+		long long MissedLandings;	// Skipped probes that would have found the ground
+		double LandingErrorSum;
+		double MaxLandingError;
+	};
+
+	// Where the bench's probes reach: ProbeGround() finds the ground within this height of the board.
+	float GetProbeReach(const SkateSim::FBoardTune& tune)
+	{
+		return tune.DeckHeight * 3.0f;
+	}
+
+	// Follow the arc's probe reach down through the terrain, one chord at a time, as UGroundStateComponent does with
+	// its queries.  A chord that ends under the terrain is bisected for where it went in.
+	void PredictBenchFlight(const FBenchArgs& args, const SkateSim::FBoardTune& tune, const SkateSim::FVec3& position, const SkateSim::FVec3& velocity,
+		SkateSim::FFlightPrediction& predictionOut, FFlightResults& results)
+	{
+		const float maxTime = 2.0f;
+		const float chordTime = SkateSim::GetFlightChordTime(Gravity, 5.0f);
+		const float reach = GetProbeReach(tune);
+		predictionOut.Arc.Origin = position;
+		predictionOut.Arc.Velocity = velocity;
+		predictionOut.Arc.GravityZ = Gravity;
+		predictionOut.Lands = false;
+		predictionOut.EndTime = maxTime;
+		++results.Predictions;
+
+		float height;
+		SkateSim::FVec3 normal;
+		for (float chordStartTime = 0.0f; chordStartTime < maxTime; chordStartTime += chordTime)
+		{
+			float chordEndTime = std::min(chordStartTime + chordTime, maxTime);
+			++results.ChordQueries;
+			SkateSim::FVec3 end = predictionOut.Arc.PositionAt(chordEndTime);
+			SampleTerrain(args.Ramps, end.X, end.Y, height, normal);
+			if (end.Z - reach >= height)
+				continue;
+
+			float lo = chordStartTime;
+			for (int i = 0; i < 16; ++i)
+			{
+				const float mid = (lo + chordEndTime) * 0.5f;
+				const SkateSim::FVec3 p = predictionOut.Arc.PositionAt(mid);
+				SampleTerrain(args.Ramps, p.X, p.Y, height, normal);
+				if (p.Z - reach < height)
+					chordEndTime = mid;
+				else
+					lo = mid;
+			}
+			end = predictionOut.Arc.PositionAt(chordEndTime);
+			SampleTerrain(args.Ramps, end.X, end.Y, height, normal);
+			predictionOut.Lands = true;
+			predictionOut.EndTime = chordEndTime;
+			predictionOut.LandingPosition = SkateSim::MakeVec3(end.X, end.Y, height);
+			predictionOut.LandingNormal = normal;
+			return;
+		}
+	}
+
+	FFlightResults RunFlight(const FBenchArgs& args, const SkateSim::FBoardTune& tune, std::vector<FBenchBoard>& boards)
+	{
+		FFlightResults results;
+		std::memset(&results, 0, sizeof(results));
+
+		const float driftTolerance = 10.0f;
+		std::vector<SkateSim::FFlightPrediction> predictions(boards.size());
+		std::vector<bool> inFlight(boards.size(), false);
+		std::vector<float> flightTime(boards.size(), 0.0f);
+		for (int step = 0; step < args.Steps; ++step)
+		{
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				FBenchBoard& board = boards[i];
+				UpdateInput(board);
+
+				// Skip the probe if we're flying an arc that doesn't reach the ground until after the lead time.
+				bool skip = false;
+				if (inFlight[i])
+				{
+					flightTime[i] += args.DeltaTime;
+					if (SkateSim::GetFlightDrift(predictions[i], flightTime[i], board.Position, board.Velocity) > driftTolerance)
+					{
+						++results.Drifted;
+						PredictBenchFlight(args, tune, board.Position, board.Velocity, predictions[i], results);
+						flightTime[i] = 0.0f;
+					}
+					skip = (flightTime[i] + args.FlightLead < predictions[i].EndTime);
+				}
+
+				SkateSim::FGroundContact ground = ProbeGround(args, board, tune);
+				if (skip)
+				{
+					// The probe is only made to check we were right to skip it; the step sees what the pawn would.
+					++results.Skipped;
+					++results.AirborneSteps;
+					if (ground.IsOnGround)
+						++results.MissedLandings;
+					ground.IsOnGround = false;
+					ground.Position = board.Position;
+					ground.Normal = SkateSim::UpVec3();
+				}
+				else
+				{
+					++results.Probes;
+					if (ground.IsOnGround && inFlight[i])
+					{
+						// Landed: how far off was the time we predicted?
+						if (predictions[i].Lands)
+						{
+							const double error = std::fabs(predictions[i].EndTime - flightTime[i]);
+							results.LandingErrorSum += error;
+							results.MaxLandingError = std::max(results.MaxLandingError, error);
+							++results.Landings;
+						}
+						inFlight[i] = false;
+					}
+					else if (!ground.IsOnGround)
+					{
+						++results.AirborneSteps;
+						if (!inFlight[i] || flightTime[i] >= predictions[i].EndTime)
+						{
+							results.Flights += (inFlight[i] ? 0 : 1);
+							PredictBenchFlight(args, tune, board.Position, board.Velocity, predictions[i], results);
+							inFlight[i] = true;
+							flightTime[i] = 0.0f;
+						}
+					}
+				}
+
+				SkateSim::FBoardOutput output = SkateSim::Step(board.State, ground, tune, board.Input, board.Velocity, board.Mass, args.DeltaTime);
+				SkateSim::FVec3 stepVelocity = board.Velocity;
+				Integrate(args, board, output);
+				SkateSim::UpdatePrevVelocity(board.State, stepVelocity);
+			}
+		}
+		return results;
+	}
+
+	FRailsResults RunRailsMicro(const FBenchArgs& args, const SkateSim::FBoardTune& tune, std::vector<FBenchBoard>& boards)
+	{
+		typedef std::chrono::high_resolution_clock Clock;
+
+		// Record where the boards go, to query from and to scatter the rails over.
+		const int recordSteps = std::min(args.Steps, 2048);
+		std::vector<SkateSim::FVec3> points;
+		points.reserve((size_t)recordSteps * boards.size());
+		SkateSim::FVec3 lo = boards[0].Position, hi = boards[0].Position;
+		for (int step = 0; step < recordSteps; ++step)
+		{
+			for (size_t i = 0; i < boards.size(); ++i)
+			{
+				FBenchBoard& board = boards[i];
+				UpdateInput(board);
+
+				const SkateSim::FGroundContact ground = ProbeGround(args, board, tune);
+				SkateSim::FBoardOutput output = SkateSim::Step(board.State, ground, tune, board.Input, board.Velocity, board.Mass, args.DeltaTime);
+				SkateSim::FVec3 stepVelocity = board.Velocity;
+				Integrate(args, board, output);
+				SkateSim::UpdatePrevVelocity(board.State, stepVelocity);
+
+				points.push_back(board.Position);
+				lo = SkateSim::MakeVec3(std::min(lo.X, board.Position.X), std::min(lo.Y, board.Position.Y), 0.0f);
+				hi = SkateSim::MakeVec3(std::max(hi.X, board.Position.X), std::max(hi.Y, board.Position.Y), 0.0f);
+			}
+		}
+
+		// Half ledges, half bars bent once in the middle, sitting on the terrain.
+		FRailsResults results;
+		std::memset(&results, 0, sizeof(results));
+		FXorShift rng;
+		rng.State = args.Seed * 2246822519u + 1u;
+		Clock::time_point start = Clock::now();
+		SkateSim::FGrindRailBuilder builder;
+		std::vector<SkateSim::FVec3> barCrowns;
+		for (int i = 0; i < args.Rails; ++i)
+		{
+			const float x = lo.X + (hi.X - lo.X) * (rng.NextSigned() * 0.5f + 0.5f);
+			const float y = lo.Y + (hi.Y - lo.Y) * (rng.NextSigned() * 0.5f + 0.5f);
+			const float yaw = rng.NextSigned() * 3.14159265f;
+			const float length = 300.0f + 250.0f * (rng.NextSigned() + 1.0f);
+			float height;
+			SkateSim::FVec3 normal;
+			SampleTerrain(args.Ramps, x, y, height, normal);
+			const SkateSim::FVec3 center = SkateSim::MakeVec3(x, y, height);
+			if (i % 4 == 3)
+			{
+				const float radius = 3.0f, barHeight = 50.0f;
+				AddBenchBar(builder, center, yaw, length, radius, barHeight, 12);
+				barCrowns.push_back(center + SkateSim::UpVec3() * (barHeight + radius));
+			}
+			else if (i & 1)
+			{
+				const SkateSim::FVec3 along = SkateSim::MakeVec3(std::cos(yaw), std::sin(yaw), 0.0f);
+				const SkateSim::FVec3 bend = SkateSim::MakeVec3(std::cos(yaw + 0.5f), std::sin(yaw + 0.5f), 0.0f);
+				const SkateSim::FVec3 railPoints[3] = { center - along * (length * 0.5f) + SkateSim::UpVec3() * 60.0f,
+					center + SkateSim::UpVec3() * 60.0f, center + bend * (length * 0.5f) + SkateSim::UpVec3() * 30.0f };
+				builder.AddPolyline(railPoints, 3, SkateSim::EGrindRailKind::Rail);
+			}
+			else
+			{
+				AddBenchLedge(builder, center, yaw, length, 60.0f, 45.0f);
+			}
+		}
+		std::vector<uint8_t> blob;
+		SkateSim::FGrindRailView view;
+		if (!builder.Build(blob) || !view.Init(&blob[0], blob.size()))
+		{
+			results.Mismatches = -1;
+			return results;
+		}
+		results.BuildMs = std::chrono::duration<double>(Clock::now() - start).count() * 1.e3;
+		results.Rails = (int)view.NumRails();
+		results.Segments = (int)view.NumSegments();
+		results.BlobBytes = (int)blob.size();
+
+		const int repeats = std::max(1, args.Steps / recordSteps);
+		const double numQueries = (double)points.size() * repeats;
+		float sink = 0.0f;
+		long long hits = 0;
+
+		start = Clock::now();
+		for (int r = 0; r < repeats; ++r)
+		{
+			for (size_t i = 0; i < points.size(); ++i)
+			{
+				SkateSim::FGrindRailHit hit;
+				if (view.FindNearest(points[i], args.RailRadius, hit))
+				{
+					sink += hit.Distance;
+					++hits;
+				}
+			}
+		}
+		results.IndexNs = std::chrono::duration<double>(Clock::now() - start).count() * 1.e9 / numQueries;
+		results.HitFraction = (double)hits / numQueries;
+
+		// The scan is much slower, so only time it over one pass.
+		start = Clock::now();
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			float distance;
+			if (ScanRails(view, points[i], args.RailRadius, distance))
+				sink += distance;
+		}
+		results.ScanNs = std::chrono::duration<double>(Clock::now() - start).count() * 1.e9 / (double)points.size();
+
+		for (size_t i = 0; i < points.size(); ++i)
+		{
+			SkateSim::FGrindRailHit hit;
+			float distance;
+			const bool indexed = view.FindNearest(points[i], args.RailRadius, hit);
+			const bool scanned = ScanRails(view, points[i], args.RailRadius, distance);
+			if (indexed != scanned || (indexed && std::fabs(hit.Distance - distance) > 1.e-2f))
+				++results.Mismatches;
+		}
+
+		// A bar whose crown isn't on a rail was left as the pair of edges either side of it.
+		for (size_t i = 0; i < barCrowns.size(); ++i)
+		{
+			SkateSim::FGrindRailHit hit;
+			if (!view.FindNearest(barCrowns[i], 5.0f, hit, 1u << SkateSim::EGrindRailKind::Rail) || hit.Distance > 0.5f)
+				++results.BarsOffCrown;
+		}
+
+		if (sink == 12345.0f)
+			std::printf(" ");
+		return results;
+	}
+}
+
+int main(int argc, char** argv)
+{
+	FBenchArgs args;
+	if (!ParseArgs(argc, argv, args))
+		return 1;
+
+	const SkateSim::FBoardTune tune = SkateSim::DefaultBoardTune();
+	std::vector<FBenchBoard> boards;
+	InitBoards(args, boards);
+
+	std::chrono::high_resolution_clock::time_point start = std::chrono::high_resolution_clock::now();
+
+	float maxError = 0.0f;
+	FNetResults netResults;
+	FRollbackResults rollbackResults;
+	FStepResults stepResults;
+	FRiderResults riderResults;
+	FRailsResults railsResults;
+	FFlightResults flightResults;
+	std::memset(&flightResults, 0, sizeof(flightResults));
+	std::memset(&railsResults, 0, sizeof(railsResults));
+	std::memset(&riderResults, 0, sizeof(riderResults));
+	std::memset(&rollbackResults, 0, sizeof(rollbackResults));
+	std::memset(&stepResults, 0, sizeof(stepResults));
+	if (args.Mode == Mode_Scalar)
+		RunScalar(args, tune, boards);
+	else if (args.Mode == Mode_Net)
+		netResults = RunNet(args, tune, boards);
+	else if (args.Mode == Mode_Rollback)
+		rollbackResults = RunRollback(args, tune, boards);
+	else if (args.Mode == Mode_Step)
+		stepResults = RunStepMicro(args, tune, boards);
+	else if (args.Mode == Mode_Rider)
+		riderResults = RunRiderMicro(args, tune, boards);
+	else if (args.Mode == Mode_Rails)
+		railsResults = RunRailsMicro(args, tune, boards);
+	else if (args.Mode == Mode_Flight)
+		flightResults = RunFlight(args, tune, boards);
+	else
+		maxError = RunBatch(args, tune, boards);
+
+	std::chrono::high_resolution_clock::time_point end = std::chrono::high_resolution_clock::now();
+	double seconds = std::chrono::duration<double>(end - start).count();
+	double boardSteps = (double)args.Boards * (double)args.Steps;
+
+	std::printf("boards=%d steps=%d terrain=%s seed=%u mode=%s simd=%d\n", args.Boards, args.Steps, (args.Ramps ? "ramps" : "flat"), args.Seed, ModeNames[args.Mode], SKATESIM_USE_SSE);
+	std::printf("time=%.3fs board-steps/s=%.0f ns/board-step=%.1f\n", seconds, boardSteps / seconds, seconds * 1.e9 / boardSteps);
+	std::printf("checksum=%.6f\n", Checksum(boards));
+
+	if (args.Mode == Mode_Verify)
+	{
+		// The SIMD kernel uses a polynomial sin/cos, so allow a little slack over exact equality.
+		const float tolerance = 1.e-4f;
+		std::printf("max-error=%g (tolerance %g)\n", maxError, tolerance);
+		return (maxError <= tolerance ? 0 : 2);
+	}
+
+	if (args.Mode == Mode_Net)
+	{
+		// Payload only: the engine adds its own bunch and property headers on top of both.
+		const double simSeconds = args.Steps * (double)args.DeltaTime;
+		const double compressedRate = netResults.CompressedBits / 8.0 / simSeconds / args.Boards;
+		const double rawRate = netResults.RawBits / 8.0 / simSeconds / args.Boards;
+		std::printf("net: rate=%gHz latency=%d steps loss=%d%% sends=%d\n", args.NetRate, args.NetLatency, args.NetLoss, netResults.Sends);
+		std::printf("net: bytes/s per board compressed=%.1f raw=%.1f (%.1f%%), bytes per update compressed=%.2f raw=%.2f\n",
+			compressedRate, rawRate, 100.0 * compressedRate / rawRate,
+			netResults.CompressedBits / 8.0 / std::max(1, netResults.Sends), netResults.RawBits / 8.0 / std::max(1, netResults.Sends));
+		std::printf("net: max error position=%.3fcm velocity=%.3fcm/s angle=%.3fdeg discarded=%d\n",
+			netResults.MaxPositionError, netResults.MaxVelocityError, netResults.MaxAngleErrorDeg, netResults.Discarded);
+	}
+
+	if (args.Mode == Mode_Step)
+	{
+		std::printf("step: ns per step legacy=%.1f cached=%.1f (%.1f%%)\n", stepResults.LegacyNs, stepResults.CachedNs, 100.0 * stepResults.CachedNs / stepResults.LegacyNs);
+		std::printf("step: sin/cos calls per step legacy=%.2f cached=%.2f\n", stepResults.LegacyTrigPerStep, stepResults.CachedTrigPerStep);
+		std::printf("step: mismatches=%d\n", stepResults.Mismatches);
+		return (stepResults.Mismatches == 0 ? 0 : 2);
+	}
+
+	if (args.Mode == Mode_Rider)
+	{
+		std::printf("rider: ns per board legacy=%.1f estimator=%.1f (%.1f%%)\n", riderResults.LegacyNs, riderResults.EstimatorNs, 100.0 * riderResults.EstimatorNs / riderResults.LegacyNs);
+		std::printf("rider: acos/sin calls per board legacy=%.2f estimator=0.00\n", riderResults.LegacyTrigPerBoard);
+		std::printf("rider: unfiltered lean difference mean=%.3fdeg p99=%.3fdeg\n", riderResults.MeanAngleDeg, riderResults.P99AngleDeg);
+	}
+
+	if (args.Mode == Mode_Flight)
+	{
+		std::printf("flight: lead=%gs board-steps=%lld probes skipped=%lld (%.1f%% of all, %.1f%% of airborne)\n", args.FlightLead, flightResults.Probes + flightResults.Skipped,
+			flightResults.Skipped, 100.0 * flightResults.Skipped / std::max(1LL, flightResults.Probes + flightResults.Skipped),
+			100.0 * flightResults.Skipped / std::max(1LL, flightResults.AirborneSteps));
+		std::printf("flight: flights=%lld predictions=%lld (%.2f per flight, %lld redone for drift) chord queries=%lld\n", flightResults.Flights, flightResults.Predictions,
+			(double)flightResults.Predictions / std::max(1LL, flightResults.Flights), flightResults.Drifted, flightResults.ChordQueries);
+		std::printf("flight: landing time error mean=%.2fms max=%.2fms over %lld landings\n", flightResults.LandingErrorSum * 1.e3 / std::max(1LL, flightResults.Landings),
+			flightResults.MaxLandingError * 1.e3, flightResults.Landings);
+		std::printf("flight: missed landings=%lld\n", flightResults.MissedLandings);
+		return (flightResults.MissedLandings == 0 ? 0 : 2);
+	}
+
+	if (args.Mode == Mode_Rails)
+	{
+		std::printf("rails: rails=%d segments=%d bytes=%d built in %.2fms\n", railsResults.Rails, railsResults.Segments, railsResults.BlobBytes, railsResults.BuildMs);
+		std::printf("rails: ns per query within %gcm index=%.1f scan=%.1f (%.1f%%), hits=%.1f%%\n", args.RailRadius,
+			railsResults.IndexNs, railsResults.ScanNs, 100.0 * railsResults.IndexNs / railsResults.ScanNs, 100.0 * railsResults.HitFraction);
+		std::printf("rails: mismatches=%d bars off crown=%d\n", railsResults.Mismatches, railsResults.BarsOffCrown);
+		return (railsResults.Mismatches == 0 && railsResults.BarsOffCrown == 0 ? 0 : 2);
+	}
+
+	if (args.Mode == Mode_Rollback)
+	{
+		// The forward steps are the ones the checksum covers; compare a resimulated tick against them.
+		const double saveNs = rollbackResults.SaveSeconds * 1.e9 / std::max(1LL, rollbackResults.Saves);
+		const double restoreNs = rollbackResults.RestoreSeconds * 1.e9 / std::max(1LL, rollbackResults.Restores);
+		const double forwardNs = rollbackResults.ForwardSeconds * 1.e9 / boardSteps;
+		const double resimNs = rollbackResults.ResimSeconds * 1.e9 / std::max(1LL, rollbackResults.ResimTicks);
+		const double budgetNs = args.RollbackBudgetMs * 1.e6;
+		std::printf("rollback: ticks=%d snapshot=%d bytes ring=%d bytes per board\n", args.RollbackTicks,
+			(int)sizeof(SkateSim::FBoardSnapshot), (int)sizeof(SkateSim::FBoardSnapshotRing));
+		std::printf("rollback: ns save=%.1f restore=%.1f forward tick=%.1f resimulated tick=%.1f\n", saveNs, restoreNs, forwardNs, resimNs);
+		std::printf("rollback: in %.2fms per frame, %.0f ticks per board per frame (%d boards), or %.0f boards at %d ticks each\n",
+			args.RollbackBudgetMs, (budgetNs - restoreNs * args.Boards) / (resimNs * args.Boards), args.Boards,
+			budgetNs / (restoreNs + resimNs * args.RollbackTicks), args.RollbackTicks);
+		std::printf("rollback: max error=%g\n", rollbackResults.MaxError);
+		return (rollbackResults.MaxError == 0.0f ? 0 : 2);
+	}
+
+	return 0;
+}